@@ -342,6 +342,36 @@ const ChartUtils = {
  * Handles fetching, processing, and displaying sensor data
  */
 const SensorManager = {
+    /**
+     * Submit an on-demand bus command and wait for it to finish
+     * Returns the final command status from /api/command
+     */
+    async runCommand(path, body) {
+        const response = await fetch(path, {
+            method: 'POST',
+            credentials: 'include',
+            headers: { 'Content-Type': 'application/json' },
+            body: body ? JSON.stringify(body) : undefined
+        });
+        if (!response.ok) {
+            throw new Error(`Command failed: ${response.status}`);
+        }
+
+        const { handle } = await response.json();
+        for (let attempt = 0; attempt < 60; attempt++) {
+            await new Promise(resolve => setTimeout(resolve, 250));
+            const status = await fetch(`/api/command?handle=${handle}`, { credentials: 'include' });
+            if (!status.ok) {
+                throw new Error(`Command status failed: ${status.status}`);
+            }
+            const result = await status.json();
+            if (!['pending', 'running'].includes(result.state)) {
+                return result;
+            }
+        }
+        throw new Error('Command timed out');
+    },
+
     /**
      * Fetch sensor data from the server
      */
@@ -464,10 +494,11 @@ const SensorManager = {
                         ${sensor.name || `Sensor ${sensor.address.slice(-4)}`}
                     </div>
                     <div class="text-lg font-bold ${sensor.valid ? 'text-blue-600' : 'text-red-600'}">
-                        ${sensor.valid ? sensor.temperature.toFixed(1) + '°C' : 'Error'}
+                        ${sensor.valid ? sensor.temperature.toFixed(1) + '°C' : sensor.health === 'offline' ? 'Offline' : 'Error'}
                     </div>
                 </div>
-                ${!sensor.valid ? '<div class="text-xs text-red-500 mt-1">Invalid reading</div>' : ''}
+                ${sensor.health === 'offline' ? '<div class="text-xs text-red-500 mt-1">Not responding, retrying</div>'
+                    : !sensor.valid ? '<div class="text-xs text-red-500 mt-1">Invalid reading</div>' : ''}
             `;
 
             // Add click event to toggle sensor selection
@@ -574,6 +605,7 @@ async function initializeDashboard() {
             const ui = {
                 sensorSelect: document.getElementById('sensorSelect'),
                 refreshButton: document.getElementById('refreshButton'),
+                scanButton: document.getElementById('scanButton'),
                 logoutButton: document.getElementById('logoutButton')
             };
 
@@ -588,14 +620,37 @@ async function initializeDashboard() {
             }
 
             if (ui.refreshButton) {
-                ui.refreshButton.addEventListener('click', () => {
+                ui.refreshButton.addEventListener('click', async () => {
                     Logger.log('Manual refresh triggered');
+                    try {
+                        // Fresh conversion first; joins one already in progress
+                        await SensorManager.runCommand('/api/read', {});
+                    } catch (error) {
+                        Logger.warn('On-demand read failed, showing cached values', error);
+                    }
                     fetchSensors();
                 });
             } else {
                 Logger.warn('Refresh button not found');
             }
 
+            if (ui.scanButton) {
+                ui.scanButton.addEventListener('click', async () => {
+                    Logger.log('Bus scan triggered');
+                    ui.scanButton.disabled = true;
+                    try {
+                        const result = await SensorManager.runCommand('/api/scan');
+                        Logger.log('Bus scan finished', result);
+                        await fetchSensors();
+                    } catch (error) {
+                        Logger.error('Bus scan failed', error);
+                        AuthUtils.showError('Bus scan failed');
+                    } finally {
+                        ui.scanButton.disabled = false;
+                    }
+                });
+            }
+
             if (ui.logoutButton) {
                 ui.logoutButton.addEventListener('click', () => {
                     Logger.log('Logout initiated');
@@ -0,0 +1,66 @@
+// AnomalyDetector.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-sensor online anomaly detection run in the OneWire task right after
+// filtering. Three detectors share O(1) state per sensor:
+//   rate      |dT/dt| of the filtered value above a threshold (°C/min)
+//   flatline  identical raw bus value for N consecutive cycles
+//   z-score   deviation from an exponentially weighted rolling mean/variance
+// Events are reported on transitions only (raised/cleared), so a persistent
+// condition produces one event instead of one per cycle.
+
+enum class AnomalyType : uint8_t {
+    RATE = 0x01,
+    FLATLINE = 0x02,
+    ZSCORE = 0x04
+};
+
+constexpr size_t ANOMALY_TYPE_COUNT = 3;
+
+struct AnomalyConfig {
+    float maxRatePerMin;      // Rate threshold in °C/min, 0 = disabled
+    uint16_t flatlineCycles;  // Identical raw readings before flagging, 0 = disabled
+    float zScoreThreshold;    // Z-score threshold, 0 = disabled
+    uint16_t zScoreWindow;    // Effective rolling window in samples
+};
+
+struct AnomalyState {
+    bool havePrevious;
+    float lastValue;
+    uint32_t lastTime;
+    int32_t lastRaw;
+    uint16_t flatlineCount;
+    uint16_t samples;         // Samples in the rolling baseline (saturates at window)
+    float mean;               // Exponentially weighted mean
+    float variance;           // Exponentially weighted variance
+    uint8_t activeMask;       // Currently active AnomalyType bits
+};
+
+struct AnomalyEvent {
+    uint8_t address[8];
+    AnomalyType type;
+    bool raised;              // true = condition started, false = cleared
+    float value;              // Sensor value at the transition (°C)
+    float metric;             // Rate (°C/min), identical cycles or z-score
+    uint32_t timestamp;       // millis() of the reading
+};
+
+class AnomalyDetector {
+public:
+    static AnomalyConfig defaultConfig();
+    static void reset(AnomalyState& state);
+
+    // Process one valid reading. Transition events are written to events
+    // (capacity ANOMALY_TYPE_COUNT) without an address; returns their count.
+    static size_t process(const AnomalyConfig& config, AnomalyState& state,
+                          float value, int32_t raw, uint32_t now,
+                          AnomalyEvent* events);
+
+    static const char* typeToString(AnomalyType type);
+
+private:
+    static constexpr float MIN_STDDEV = 0.1f;  // Keeps z-scores sane for very steady sensors
+};
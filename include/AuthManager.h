@@ -6,6 +6,7 @@
 #include <mbedtls/md.h>
 #include "PreferencesManager.h"
 #include "Logger.h"
+#include "FixedString.h"
 
 class AuthManager {
 public:
@@ -19,8 +20,8 @@ public:
     
     // Session management
     static String createSession(const String& username);
-    static bool validateSession(const String& token);
-    static void revokeSession(const String& token);
+    static bool validateSession(const char* token);
+    static void revokeSession(const char* token);
     static void revokeAllSessions();
     
     // Add these public methods
@@ -41,6 +42,8 @@ public:
     static const size_t MAX_PASSWORD_LENGTH = 64;
     static const size_t SESSION_TOKEN_LENGTH = 32;
     static const uint32_t SESSION_LIFETIME = 24 * 60 * 60;  // 24 hours in seconds
+    
+    using SessionToken = FixedString<SESSION_TOKEN_LENGTH>;
 
 private:
     struct Session {
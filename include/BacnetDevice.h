@@ -0,0 +1,185 @@
+// BacnetDevice.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorSlots.h"
+
+// BACnet/IP device served by the BACnet task: the Device object, an Analog
+// Input per sensor and a Binary Output per relay. Analog Input n is sensor
+// slot n (see SensorSlots), so a point keeps its instance across rescans and
+// restarts; a sensor that disappears keeps its object with Reliability
+// no-sensor. Binary Output n is relay n and is read-only.
+//
+// Services executed: Who-Is, ReadProperty, ReadPropertyMultiple and
+// SubscribeCOV (Present_Value and Status_Flags, confirmed or unconfirmed
+// notifications; confirmed ones are not retried). Segmentation is not
+// supported: a response larger than the client's maximum APDU is aborted, and
+// Object_List can then be read element by element.
+//
+// Packets are decoded and answered in fixed buffers and sent through a
+// callback; nothing here allocates or depends on the platform, so the same
+// code runs in tools/bacnet_host_server.cpp.
+
+constexpr size_t BACNET_SENSOR_OBJECTS = SensorSlots::CAPACITY;
+constexpr size_t BACNET_MAX_BINARY_OUTPUTS = 8;
+constexpr size_t BACNET_MAX_SUBSCRIPTIONS = 16;
+constexpr size_t BACNET_MAX_APDU = 1476;
+constexpr size_t BACNET_MAX_PACKET = 1500;   // BVLC, NPDU with a routed destination, APDU
+constexpr size_t BACNET_MAX_NAME = 32;
+
+struct BacnetAddress {
+    uint8_t ip[4];
+    uint16_t port;
+    uint16_t network;         // Remote network behind a router, 0 if local
+    uint8_t macLength;        // Station on that network, 0 for its broadcast
+    uint8_t mac[7];
+};
+
+// One sensor as handed to refresh(), filled from the OneWireManager snapshot
+struct BacnetSensorSample {
+    uint8_t address[8];
+    float temperature;        // Filtered value, last valid one while invalid (°C)
+    SensorHealth health;
+    uint8_t consecutiveErrors;
+    uint8_t anomalyMask;
+    bool valid;
+};
+
+// Vendor, model and firmware must outlive the device (string literals)
+struct BacnetIdentity {
+    uint32_t instance;
+    const char* name;
+    const char* vendorName;
+    uint16_t vendorId;
+    const char* modelName;
+    const char* firmware;
+};
+
+class BacnetDevice {
+public:
+    // Sends one BVLC frame; broadcast frames go to the local broadcast address
+    using Sender = void (*)(const BacnetAddress& destination, bool broadcast,
+                            const uint8_t* frame, size_t length, void* context);
+
+    static constexpr uint32_t WILDCARD_INSTANCE = 4194303;
+
+    BacnetDevice();
+
+    void configure(const BacnetIdentity& identity, float covIncrement);
+    void setSender(Sender sender, void* context);
+
+    // Slot assignment by ROM; all-zero entries are free slots
+    void setSlots(const uint8_t (*addresses)[8], size_t count) { slots.set(addresses, count); }
+    size_t getSlots(uint8_t (*addresses)[8], size_t capacity) const { return slots.get(addresses, capacity); }
+
+    // Object_Name of a sensor or relay; an empty name falls back to the ROM or relay number
+    void setSensorName(size_t slot, const char* name);
+    void setRelayName(uint8_t relay, const char* name);
+
+    // Update the objects from a sensor snapshot and the relay states, and send
+    // the COV notifications that are due. now is in milliseconds. Returns true
+    // if a ROM was given a slot, so the caller can persist the assignment.
+    bool refresh(const BacnetSensorSample* samples, size_t count,
+                 const bool* relayStates, uint8_t relayCount, uint32_t now);
+
+    void handleFrame(const uint8_t* frame, size_t length, const BacnetAddress& source, uint32_t now);
+
+    // Broadcast I-Am, e.g. once after startup
+    void announce();
+
+    uint32_t getInstance() const { return instance; }
+    uint8_t getSubscriptionCount() const;
+
+private:
+    struct Writer;
+    struct Reader;
+
+    // Reply to a confirmed request; not ACK/ERROR, which platform headers may define
+    enum class Result : uint8_t {
+        SEND_ACK,
+        SEND_ERROR,
+        SEND_REJECT
+    };
+
+    struct AnalogInput {
+        float presentValue;
+        uint8_t reliability;
+        uint8_t statusFlags;      // Encoded BACnetStatusFlags byte
+        char name[BACNET_MAX_NAME + 1];
+    };
+
+    struct BinaryOutput {
+        bool presentValue;
+        char name[BACNET_MAX_NAME + 1];
+    };
+
+    struct Subscription {
+        bool active;
+        bool confirmed;
+        bool indefinite;
+        BacnetAddress subscriber;
+        uint32_t processId;
+        uint16_t objectType;
+        uint32_t objectInstance;
+        uint32_t expiry;          // millis() at which the subscription lapses
+        float lastValue;
+        uint8_t lastFlags;
+    };
+
+    struct PropertyError {
+        uint8_t errorClass;
+        uint8_t errorCode;
+    };
+
+    bool objectExists(uint16_t type, uint32_t objectInstance) const;
+    size_t objectCount() const;
+    bool objectAt(size_t index, uint16_t& type, uint32_t& objectInstance) const;
+    bool currentValue(uint16_t type, uint32_t objectInstance, float& value, uint8_t& flags) const;
+
+    bool encodeProperty(uint16_t type, uint32_t objectInstance, uint32_t property,
+                        bool hasIndex, uint32_t index, Writer& out, PropertyError& error) const;
+    bool encodePropertyList(uint16_t type, bool hasIndex, uint32_t index, Writer& out, PropertyError& error) const;
+    bool encodeDevice(uint32_t property, bool hasIndex, uint32_t index, Writer& out, PropertyError& error) const;
+    void encodeAnalogInput(uint32_t slot, uint32_t property, Writer& out) const;
+    bool encodeBinaryOutput(uint32_t relay, uint32_t property, bool hasIndex, uint32_t index,
+                            Writer& out, PropertyError& error) const;
+    void appendResult(uint16_t type, uint32_t objectInstance, uint32_t property,
+                      bool hasIndex, uint32_t index, Writer& out) const;
+
+    void handleConfirmed(const uint8_t* apdu, size_t length, const BacnetAddress& source, uint32_t now);
+    void handleWhoIs(const uint8_t* data, size_t length, const BacnetAddress& source);
+    Result readProperty(Reader& in, Writer& out, PropertyError& error, uint8_t& rejectReason) const;
+    Result readPropertyMultiple(Reader& in, Writer& out, uint8_t& rejectReason) const;
+    Result subscribeCov(Reader& in, const BacnetAddress& source, uint32_t now,
+                        int& created, PropertyError& error, uint8_t& rejectReason);
+
+    void sendIAm(const BacnetAddress& destination, bool broadcast);
+    void sendNotification(Subscription& subscription, uint32_t now);
+    size_t beginFrame(const BacnetAddress& destination, bool broadcast, bool expectingReply);
+    void sendFrame(const BacnetAddress& destination, bool broadcast, size_t length);
+
+    void updateDatabaseRevision();
+    void formatSensorName(size_t slot, char* out) const;
+
+    SensorSlots slots;
+    AnalogInput inputs[BACNET_SENSOR_OBJECTS];
+    BinaryOutput outputs[BACNET_MAX_BINARY_OUTPUTS];
+    Subscription subscriptions[BACNET_MAX_SUBSCRIPTIONS];
+    uint8_t outputCount;
+
+    uint32_t instance;
+    char deviceName[BACNET_MAX_NAME + 1];
+    const char* vendorName;
+    uint16_t vendorId;
+    const char* modelName;
+    const char* firmware;
+    float covIncrement;
+    uint32_t databaseRevision;
+    bool objectsChanged;
+    uint8_t nextInvokeId;
+
+    Sender sender;
+    void* senderContext;
+    uint8_t frameBuffer[BACNET_MAX_PACKET];
+};
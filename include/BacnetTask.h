@@ -0,0 +1,41 @@
+// BacnetTask.h
+#pragma once
+
+#include <Arduino.h>
+#include "SystemTypes.h"
+#include "Config.h"
+#include "BacnetDevice.h"
+
+// BACnet/IP device for building management systems. One task owns the UDP
+// socket, answers requests as they arrive and, once per
+// BACNET_REFRESH_INTERVAL, updates the Analog and Binary objects from the
+// sensor snapshot and relay states, which is also when COV notifications
+// go out (object model in BacnetDevice.h). All buffers are static.
+class BacnetTask {
+public:
+    static void init();
+    static void start();
+
+    static bool isRunning();
+    static uint32_t getDeviceInstance();
+    static uint8_t getSubscriptionCount();
+
+private:
+    static BacnetConfig config;
+    static BacnetDevice device;
+    static TemperatureSensor snapshot[SENSOR_TABLE_CAPACITY];
+    static BacnetSensorSample samples[SENSOR_TABLE_CAPACITY];
+    static uint8_t packet[BACNET_MAX_PACKET];
+    static int udpSocket;
+    static volatile bool running;
+
+    static void taskFunction(void* parameter);
+    static bool openSocket();
+    static void receivePacket();
+    static bool refreshObjects();
+    static void loadNames();
+    static void saveSlots();
+    static uint32_t defaultInstance();
+    static void sendFrame(const BacnetAddress& destination, bool broadcast,
+                          const uint8_t* frame, size_t length, void* context);
+};
@@ -0,0 +1,52 @@
+// BeaconTask.h
+#pragma once
+
+#include <Arduino.h>
+#include "SystemTypes.h"
+#include "Config.h"
+#include "TelemetryBeacon.h"
+
+struct pbuf;
+struct udp_pcb;
+struct tcpip_api_call_data;
+
+// Multicast telemetry beacon (datagram format in TelemetryBeacon.h). The
+// OneWire task signals each completed read cycle with notifyReadingsUpdated();
+// the beacon task then encodes the sensor table straight into one pbuf that is
+// allocated at startup and reused for every send, and multicasts it through
+// the raw lwIP UDP API. Nothing is allocated per datagram.
+class BeaconTask {
+public:
+    static void init();
+    static void start();
+
+    // Called by the OneWire task after each collection; never blocks
+    static void notifyReadingsUpdated();
+
+    static bool isRunning();
+    static uint32_t getSentCount();
+    static uint32_t getFailedCount();
+
+private:
+    static BeaconConfig config;
+    static SensorHot sensors[SENSOR_TABLE_CAPACITY];
+    static pbuf* buffer;
+    static void* payloadStart;        // buffer->payload as allocated, ahead of any headers
+    static udp_pcb* pcb;
+    static TaskHandle_t taskHandle;
+    static volatile uint32_t collectedAt;
+    static uint32_t sequence;
+    static volatile uint32_t sentCount;
+    static volatile uint32_t failedCount;
+    static bool lastSendFailed;
+    static volatile bool running;
+
+    static void taskFunction(void* parameter);
+    static bool openPcb();
+    static void publish();
+    static uint8_t relayBits();
+
+    // Run on the lwIP thread through tcpip_api_call(); return an lwIP err_t
+    static int8_t openInLwip(tcpip_api_call_data* call);
+    static int8_t sendInLwip(tcpip_api_call_data* call);
+};
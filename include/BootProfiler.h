@@ -0,0 +1,48 @@
+// BootProfiler.h
+#pragma once
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+// Records the duration of each boot phase, from setup() and from the
+// background network bring-up task, so slow or failing steps are visible
+// through /api/boot and the boot log.
+class BootProfiler {
+public:
+    enum class PhaseState : uint8_t {
+        RUNNING = 0,
+        OK = 1,
+        FAILED = 2
+    };
+    
+    struct Phase {
+        const char* name;         // Static string literal
+        uint32_t startUs;         // micros() at phase start
+        uint32_t durationUs;      // 0 while running
+        PhaseState state;
+    };
+    
+    static constexpr uint8_t MAX_PHASES = 16;
+    static constexpr uint8_t INVALID_PHASE = 0xFF;
+    
+    static void begin();
+    static uint8_t startPhase(const char* name);
+    static void endPhase(uint8_t phase, bool success = true);
+    
+    // Milestones: local subsystems running / network bring-up finished
+    static void markLocalReady();
+    static void markNetworkReady();
+    static uint32_t getLocalReadyMs() { return localReadyMs; }
+    static uint32_t getNetworkReadyMs() { return networkReadyMs; }
+    
+    static uint8_t getPhases(Phase* out, uint8_t maxCount);
+    static void logSummary();
+    static const char* stateToString(PhaseState state);
+    
+private:
+    static Phase phases[MAX_PHASES];
+    static uint8_t phaseCount;
+    static uint32_t localReadyMs;
+    static uint32_t networkReadyMs;
+    static SemaphoreHandle_t mutex;
+};
@@ -0,0 +1,30 @@
+// CborWriter.h
+#pragma once
+
+#include "PayloadWriter.h"
+
+// Writes CBOR (RFC 8949) into a caller-provided buffer. Containers have
+// definite lengths, so the caller states the item count up front. Floats use
+// the shortest encoding that keeps the value exactly, which turns most sensor
+// readings into three bytes. Writes that do not fit set the overflowed() flag
+// and are dropped, so the encoded prefix is never torn mid-item.
+class CborWriter : public PayloadWriter {
+public:
+    CborWriter(uint8_t* buffer, size_t capacity);
+
+    void beginArray(size_t count) override;
+    void beginMap(size_t pairs) override;
+    void addUnsigned(uint64_t value) override;
+    void addInt(int64_t value) override;
+    void addBool(bool value) override;
+    void addNull() override;
+    void addFloat(float value) override;
+    void addText(const char* text, size_t length) override;
+    void addBytes(const uint8_t* data, size_t length) override;
+    void addHex(const uint8_t* data, size_t length) override;
+
+    using PayloadWriter::addText;
+
+private:
+    bool writeHead(uint8_t major, uint64_t value, size_t payload = 0);
+};
@@ -0,0 +1,134 @@
+// CoapServer.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorTable.h"
+
+// CoAP (RFC 7252) endpoint served by the CoAP task for constrained clients.
+// Resources, all GET-only and CBOR (content format 60):
+//
+//   /.well-known/core   CoRE link format listing of the resources below
+//   /sensors            array of sensor maps, block-wise (RFC 7959) when large
+//   /sensors/<rom>      {"rom", "temp", "valid", "health", "anomalies"}
+//   /relays/<id>        {"id", "state"}
+//
+// temp is null until a sensor has a reading; health is "active", "suspect"
+// or "quarantined". Every 2.05 carries an ETag of the representation so
+// block-wise readers can tell when it changed between blocks.
+//
+// Observe (RFC 7641) works on every resource. refresh() re-encodes each
+// observed resource and notifies when its representation changed; a sensor
+// that disappears gets a final 4.04 that ends the observation. Notifications
+// are non-confirmable except every COAP_CONFIRM_EVERY-th one; a client that
+// has not acknowledged the previous confirmable one, or answers with a reset,
+// loses its observation. Confirmable notifications are not retransmitted.
+// Notifications of a large resource carry its first block only, as RFC 7959
+// section 2.6 describes. When the observer table is full, requests are served
+// without registering.
+//
+// Messages are parsed and answered in member buffers; nothing here allocates
+// or depends on the platform, so the same code runs in tools/coap_host_server.cpp.
+
+constexpr size_t COAP_MAX_OBSERVERS = 8;
+constexpr size_t COAP_MAX_RELAYS = 8;
+constexpr size_t COAP_BLOCK_SIZE = 512;            // Largest block served (SZX 5)
+constexpr size_t COAP_MAX_MESSAGE = COAP_BLOCK_SIZE + 64;
+constexpr size_t COAP_MAX_REPRESENTATION = 2560;   // Full /sensors list
+constexpr uint8_t COAP_CONFIRM_EVERY = 10;
+
+struct CoapEndpoint {
+    uint8_t ip[4];
+    uint16_t port;
+};
+
+// One sensor as handed to refresh(), filled from the OneWireManager snapshot
+struct CoapSensorSample {
+    uint8_t address[8];
+    float temperature;        // Filtered value, SensorTable::NO_READING_C before the first reading
+    SensorHealth health;
+    uint8_t anomalyMask;
+    bool valid;
+};
+
+class CoapServer {
+public:
+    using Sender = void (*)(const CoapEndpoint& destination, const uint8_t* message,
+                            size_t length, void* context);
+
+    CoapServer();
+
+    // messageIdSeed should differ between boots so IDs are not reused across restarts
+    void begin(Sender sender, void* context, uint16_t messageIdSeed);
+
+    // Replace the sensor and relay state and notify observers whose resource changed
+    void refresh(const CoapSensorSample* samples, size_t count,
+                 const bool* relayStates, uint8_t relayCount);
+
+    void handleMessage(const uint8_t* message, size_t length, const CoapEndpoint& source);
+
+    uint8_t getObserverCount() const;
+
+private:
+    enum class Resource : uint8_t {
+        NONE,
+        DISCOVERY,
+        SENSOR_LIST,
+        SENSOR,
+        RELAY
+    };
+
+    struct Target {
+        Resource resource;
+        uint8_t address[8];       // SENSOR
+        uint8_t relay;            // RELAY
+    };
+
+    struct Request;
+
+    struct Observer {
+        bool active;
+        bool awaitingAck;
+        CoapEndpoint endpoint;
+        uint8_t token[8];
+        uint8_t tokenLength;
+        uint8_t blockSzx;         // Block size of the registration
+        Target target;
+        uint32_t etag;            // Representation last sent
+        uint16_t lastMessageId;   // Latest notification, which a reset cancels
+        uint16_t confirmableId;   // Message ID of the unacknowledged confirmable notification
+        uint8_t sinceConfirmable;
+    };
+
+    // Encodes the target into representation and returns the response code
+    uint8_t encode(const Target& target, size_t& length, uint16_t& contentFormat);
+    size_t encodeDiscovery();
+    bool resolve(const Request& request, Target& target) const;
+    int findSensor(const uint8_t* address) const;
+
+    void handleRequest(const Request& request, const CoapEndpoint& source);
+    void handleReply(uint8_t type, uint16_t messageId, const CoapEndpoint& source);
+    Observer* registerObserver(const Request& request, const CoapEndpoint& source, const Target& target);
+    Observer* findObserver(const CoapEndpoint& endpoint, const uint8_t* token, uint8_t tokenLength);
+    void notify(Observer& observer);
+
+    size_t writeResponse(uint8_t type, uint8_t code, uint16_t messageId,
+                         const uint8_t* token, uint8_t tokenLength,
+                         const int32_t* observe, uint16_t contentFormat, uint8_t szx, uint32_t block,
+                         size_t representationLength);
+    void send(const CoapEndpoint& destination, size_t length);
+
+    CoapSensorSample sensors[SENSOR_TABLE_CAPACITY];
+    size_t sensorCount;
+    bool relays[COAP_MAX_RELAYS];
+    uint8_t relayCount;
+
+    Observer observers[COAP_MAX_OBSERVERS];
+    uint32_t observeSequence;
+    uint16_t nextMessageId;
+
+    Sender sender;
+    void* senderContext;
+    uint8_t representation[COAP_MAX_REPRESENTATION];
+    uint8_t message[COAP_MAX_MESSAGE];
+};
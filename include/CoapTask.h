@@ -0,0 +1,44 @@
+// CoapTask.h
+#pragma once
+
+#include <Arduino.h>
+#include "SystemTypes.h"
+#include "Config.h"
+#include "CoapServer.h"
+
+// CoAP endpoint for constrained gateways (resources in CoapServer.h). One
+// task owns the UDP socket. The OneWire task signals each new snapshot with
+// notifyReadingsUpdated(), and the task then refreshes the server, which
+// notifies observers whose resource changed; relay changes are picked up
+// the same way. The server, snapshot and buffers are all static.
+class CoapTask {
+public:
+    static void init();
+    static void start();
+
+    // Called by the OneWire task after each collection; never blocks
+    static void notifyReadingsUpdated();
+
+    static bool isRunning();
+    static uint8_t getObserverCount();
+
+private:
+    static CoapConfig config;
+    static CoapServer server;
+    static TemperatureSensor snapshot[SENSOR_TABLE_CAPACITY];
+    static CoapSensorSample samples[SENSOR_TABLE_CAPACITY];
+    static size_t sampleCount;
+    static bool relays[RELAY_COUNT];
+    static uint8_t packet[COAP_MAX_MESSAGE];
+    static TaskHandle_t taskHandle;
+    static int udpSocket;
+    static volatile bool running;
+
+    static void taskFunction(void* parameter);
+    static bool openSocket();
+    static void receivePacket();
+    static void takeSnapshot();
+    static bool relaysChanged();
+    static void sendMessage(const CoapEndpoint& destination, const uint8_t* message,
+                            size_t length, void* context);
+};
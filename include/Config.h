@@ -19,22 +19,52 @@
 #define MQTT_AVAILABILITY_TOPIC "availability"
 #define MQTT_SET_TOPIC "set"
 #define MQTT_AUX_DISPLAY_TOPIC "sensors/BabelSensor"
+#define MQTT_EVENT_TOPIC "events/anomaly"  // Priority topic for edge anomaly events
+#define MQTT_DISCOVERY_PREFIX "homeassistant"  // Home Assistant MQTT discovery
 // Pin Configuration
 constexpr uint8_t ONE_WIRE_BUS = 4;
 
 // System Configuration
 constexpr size_t MAX_ONEWIRE_SENSORS = 16;
+constexpr size_t MAX_PENDING_COMMANDS = 8;    // OneWire command slots, pending and finished
+constexpr size_t MAX_COMMAND_WAITERS = 4;     // Callbacks per (coalesced) command
 constexpr uint32_t WATCHDOG_TIMEOUT = 30000;  // 30 seconds
 
 // Task Stack Sizes
 constexpr uint32_t ONEWIRE_TASK_STACK_SIZE = 4096;
-constexpr uint32_t NETWORK_TASK_STACK_SIZE = 8192;
+constexpr uint32_t NETWORK_TASK_STACK_SIZE = 16384;     // TLS handshakes run on this stack
 constexpr uint32_t CONTROL_TASK_STACK_SIZE = 4096;
+constexpr uint32_t NETWORK_BOOT_TASK_STACK_SIZE = 8192;  // Link wait, SSL self-test, network start
+constexpr uint32_t MODBUS_TASK_STACK_SIZE = 4096;
+constexpr uint32_t BACNET_TASK_STACK_SIZE = 4096;
+constexpr uint32_t COAP_TASK_STACK_SIZE = 4096;
+constexpr uint32_t BEACON_TASK_STACK_SIZE = 3072;
+
+// Upper bound for statically allocated task stacks, queues and RTOS control blocks
+constexpr size_t RTOS_STATIC_RAM_BUDGET = 64 * 1024;
 
 // Task Priorities
 constexpr uint8_t ONEWIRE_TASK_PRIORITY = 3;
 constexpr uint8_t NETWORK_TASK_PRIORITY = 2;
 constexpr uint8_t CONTROL_TASK_PRIORITY = 2;
+constexpr uint8_t MODBUS_TASK_PRIORITY = 2;
+constexpr uint8_t BACNET_TASK_PRIORITY = 2;
+constexpr uint8_t COAP_TASK_PRIORITY = 2;
+constexpr uint8_t BEACON_TASK_PRIORITY = 2;
+
+// Default core affinity. AsyncTCP runs on core 1 (CONFIG_ASYNC_TCP_RUNNING_CORE),
+// so the bus and control tasks stay on core 0 and network/web/TLS on core 1.
+// Each can be overridden at runtime through the "tasks" preferences section.
+constexpr int8_t TASK_CORE_ANY = -1;
+constexpr int8_t ONEWIRE_TASK_CORE = 0;
+constexpr int8_t CONTROL_TASK_CORE = 0;
+constexpr int8_t NETWORK_TASK_CORE = 1;
+constexpr int8_t NETWORK_BOOT_TASK_CORE = 1;
+constexpr int8_t MODBUS_TASK_CORE = 1;
+constexpr int8_t BACNET_TASK_CORE = 1;
+constexpr int8_t COAP_TASK_CORE = 1;
+constexpr int8_t BEACON_TASK_CORE = 1;
+constexpr uint16_t BUS_BENCHMARK_MAX_ROUNDS = 200;  // Keeps one run under ~40 s on a full bus
 
 // Timing Intervals (ms)
 constexpr uint32_t SCAN_INTERVAL = 30000;           // Scan for new sensors every 30 seconds
@@ -42,7 +72,37 @@ constexpr uint32_t READ_INTERVAL = 10000;           // Read temperatures every 1
 constexpr uint32_t WEB_UPDATE_INTERVAL = 2000;      // Update web interface every 2 seconds
 constexpr uint32_t MQTT_PUBLISH_INTERVAL = 5000;    // Update web interface every 2 seconds
 constexpr uint32_t TASK_INTERVAL = 1000;            // Task loop interval 1 second
+constexpr uint32_t CONVERSION_TIME_MS = 750;        // 12-bit DS18B20 conversion
+
+// Missing sensor handling
+constexpr uint8_t SENSOR_QUARANTINE_AFTER = 3;                // Failed readings before quarantine
+constexpr uint32_t SENSOR_PROBE_BACKOFF_MIN = 5000;           // First re-probe after 5 seconds
+constexpr uint32_t SENSOR_PROBE_BACKOFF_MAX = 600000;         // Doubling up to every 10 minutes
+constexpr uint32_t SENSOR_FORGET_AFTER = 86400000;            // Dropped by a scan after 24 hours offline
 constexpr uint32_t DISPLAY_UPDATE_INTERVAL = 1000;
+constexpr uint32_t WARM_START_NVS_INTERVAL = 1800000; // Persist last readings to flash every 30 minutes
+
+// Modbus TCP server (off by default: Modbus has no authentication)
+constexpr uint16_t MODBUS_TCP_PORT = 502;
+constexpr uint8_t MODBUS_MAX_CLIENTS = 4;
+constexpr uint32_t MODBUS_IDLE_TIMEOUT = 60000;     // Close connections silent for a minute
+constexpr uint32_t MODBUS_REFRESH_INTERVAL = 1000;  // Register image rebuilt every second
+
+// BACnet/IP device (off by default: BACnet/IP has no authentication)
+constexpr uint16_t BACNET_UDP_PORT = 47808;              // 0xBAC0
+constexpr uint32_t BACNET_REFRESH_INTERVAL = 1000;       // Objects updated and COV checked every second
+constexpr uint32_t BACNET_NAME_REFRESH_INTERVAL = 60000; // Object names re-read from preferences
+constexpr uint16_t BACNET_VENDOR_ID = 0;                 // ASHRAE; replace with an assigned vendor id
+constexpr float BACNET_COV_INCREMENT = 0.1f;             // Default Analog Input COV_Increment (°C)
+
+// CoAP endpoint (off by default: plain CoAP has no authentication)
+constexpr uint16_t COAP_UDP_PORT = 5683;
+constexpr uint32_t COAP_POLL_INTERVAL = 100;        // Snapshot events and relay changes picked up within 100 ms
+
+// Multicast telemetry beacon (off by default)
+constexpr uint32_t BEACON_MULTICAST_GROUP = 0xEFFF4801;  // 239.255.72.1, organization-local scope
+constexpr uint16_t BEACON_UDP_PORT = 47201;
+constexpr uint8_t BEACON_MULTICAST_TTL = 1;              // Stays on the local segment
 
 // System Requirements
 constexpr size_t MINIMUM_REQUIRED_HEAP = 32768;
@@ -51,6 +111,29 @@ constexpr size_t MINIMUM_REQUIRED_HEAP = 32768;
 #ifndef MQTT_MAX_PACKET_SIZE
 constexpr size_t MQTT_MAX_PACKET_SIZE = 512;
 #endif
+constexpr size_t MQTT_DISCOVERY_PER_PASS = 2;   // Discovery configs sent per 100 ms network loop pass
+
+// esp-mqtt transport; the client runs its own task outside the static RTOS tables
+constexpr size_t MQTT_IN_BUFFER_SIZE = 1024;            // Inbound packets: commands and relay sets
+constexpr size_t MQTT_OUT_BUFFER_SIZE = 2048;           // Largest outbound packet, a discovery config
+constexpr size_t MQTT_INFLIGHT_WINDOW = 8;              // QoS 1 publishes awaiting PUBACK
+constexpr uint32_t MQTT_WINDOW_WAIT = 2000;             // publish() waits this long for a free slot
+constexpr size_t MQTT_INBOUND_SLOTS = 4;                // Received messages waiting for the network task
+constexpr size_t MQTT_INBOUND_PAYLOAD = 256;
+constexpr uint32_t MQTT_CONNECT_TIMEOUT = 10000;
+constexpr uint16_t MQTT_KEEPALIVE = 15;                 // Seconds, as PubSubClient
+constexpr uint32_t MQTT_CLIENT_TASK_STACK_SIZE = 6144;  // TLS runs on this stack
+constexpr uint8_t MQTT_CLIENT_TASK_PRIORITY = 3;        // Above the network task, so acks are not held up
+
+// MQTT 5 sessions (esp-mqtt built with CONFIG_MQTT_PROTOCOL_5)
+constexpr uint16_t MQTT_TOPIC_ALIAS_MAX = 96;           // Four per sensor slot; the broker may allow fewer
+constexpr uint32_t MQTT_TELEMETRY_EXPIRY = 300;         // Seconds a retained sensor reading stays valid
+constexpr uint32_t MQTT_SESSION_EXPIRY = 3600;          // Seconds the broker keeps the session after a disconnect
+
+// Sparkplug B mode (off by default); the node id is DEVICE_ID
+#define SPARKPLUG_DEFAULT_GROUP SYSTEM_NAME
+#define SNTP_SERVER "pool.ntp.org"                  // Sparkplug timestamps are UTC milliseconds
+constexpr size_t SPARKPLUG_GROUP_LENGTH = 32;
 
 // System Configuration
 #define MAX_FRIENDLY_NAME_LENGTH 32
@@ -61,6 +144,7 @@ constexpr size_t MQTT_MAX_PACKET_SIZE = 512;
 #define DISPLAY_CLK  17   // CS - safe if not using SPI
 
 // pins for the relays
+constexpr uint8_t RELAY_COUNT = 2;
 #define RELAY_1_PIN 32
 #define RELAY_2_PIN 33
 
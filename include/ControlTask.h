@@ -10,6 +10,8 @@
 #include "SystemTypes.h"
 #include "Config.h"
 #include "Logger.h"
+#include "ThermostatController.h"
+#include "RuleEngine.h"
 
 
 class ControlTask {
@@ -20,12 +22,32 @@ public:
     static void updateDisplayValue(float temperature);
     static bool getRelayState(uint8_t relayId);
     
+    // Closed-loop control
+    static void notifyReadingsUpdated();
+    static void reloadControlConfig();
+    static bool getControlLoopStatus(uint8_t loopId, ControlLoopConfig& config, 
+                                     ControlLoopStats& stats);
+    static void reloadRules();
+    static bool getRuleStatus(uint8_t ruleId, RuleStats& stats);
+    
+    // Display selection and playlist are cached; call after changing them
+    static void reloadDisplayConfig();
+    
 private:
     static void taskFunction(void* parameter);
-    static String addressToString(const uint8_t* address);
+    static void loadControlConfig();
+    static void evaluateControlLoops(bool newReadings);
+    static void applyRelayStates();
+    static void loadRules();
+    static void evaluateRules(bool newReadings);
+    static void applyRuleAction(uint8_t relay, bool state, uint8_t ruleId, void* context);
+    static void loadDisplayConfig(uint8_t* displaySensorAddr);
     
     static DisplayManager display;
     static RelayState relayStates[2];
+    static ThermostatController controlLoops[2];
+    static ControlLoopStats loopStats[2];
+    static RuleEngine rules;
     static QueueHandle_t controlQueue;
     static SemaphoreHandle_t stateMutex;
 };
\ No newline at end of file
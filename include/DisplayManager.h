@@ -2,9 +2,22 @@
 #pragma once
 #include <Arduino.h>
 #include <TM1637.h>
+#include <vector>
+#include "SystemTypes.h"
 
+// 4-digit TM1637 display with a segment cache. Text is rendered into segment
+// patterns locally and only transmitted when the patterns differ from what
+// the display already shows, so refreshing an unchanged value costs no bus
+// traffic. Temporary messages expire on a deadline serviced by the caller's
+// loop instead of blocking with delay().
+//
+// With a playlist configured the display rotates through several sensors.
+// Frames are rendered when a new sensor snapshot arrives, so a rotation step
+// only swaps precomputed segment buffers.
 class DisplayManager {
 public:
+    static constexpr uint8_t DIGIT_COUNT = 4;
+
     DisplayManager(uint8_t clkPin, uint8_t dioPin);
     void init();
     void update();
@@ -13,7 +26,51 @@ public:
     void clear();
     void showMessage(const char* text);  // New method for text display
     
+    // Show text for durationMs, then return to the regular content
+    void showTemporary(const char* text, uint32_t durationMs);
+    
+    // Expire temporary messages and flush pending changes; cheap when idle
+    void service(uint32_t now);
+    
+    // Milliseconds until service() has work to do, UINT32_MAX if nothing is scheduled
+    uint32_t msUntilNextEvent(uint32_t now) const;
+    
+    uint32_t getTransmitCount() const { return transmitCount; }
+    
+    // Playlist rotation; an empty playlist returns to single-sensor mode
+    void setPlaylist(const DisplayPlaylistEntry* entries, uint8_t count);
+    bool isPlaylistActive() const { return playlistCount > 0; }
+    void updateSnapshot(const std::vector<TemperatureSensor>& sensors);
+    
+    // Render text into segment patterns ('.' sets the previous digit's point)
+    static void renderText(const char* text, uint8_t* segments);
+    static void renderTemperature(float temp, uint8_t* segments);
+    
 private:
     TM1637 display;      // The TM1637 driver instance
     float currentTemp;   // Current temperature value
-};
\ No newline at end of file
+    bool haveTemp;       // Whether currentTemp has been rendered yet
+    
+    uint8_t baseSegments[DIGIT_COUNT];       // Regular content
+    uint8_t temporarySegments[DIGIT_COUNT];  // Content of the active temporary message
+    uint8_t shownSegments[DIGIT_COUNT];      // Last patterns sent to the display
+    bool temporaryActive;
+    uint32_t temporaryUntil;
+    bool shownValid;                         // False until the first transmission
+    uint32_t transmitCount;
+    
+    // Playlist state: one label frame and one value frame per entry
+    static constexpr uint32_t LABEL_DURATION_MS = 1000;
+    DisplayPlaylistEntry playlist[MAX_PLAYLIST_ENTRIES];
+    uint8_t labelFrames[MAX_PLAYLIST_ENTRIES][DIGIT_COUNT];
+    uint8_t valueFrames[MAX_PLAYLIST_ENTRIES][DIGIT_COUNT];
+    uint8_t playlistCount;
+    uint8_t playlistIndex;
+    bool showingLabel;
+    uint32_t nextRotation;
+    
+    void showPlaylistStep(uint32_t now);
+    void setBase(const uint8_t* segments);
+    void flush();
+    static uint8_t encodeChar(char c);
+};
@@ -0,0 +1,133 @@
+// EspMqttTransport.h
+#pragma once
+
+#include <Arduino.h>
+#include <mqtt_client.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "MqttTransport.h"
+#include "FixedString.h"
+#include "SharedDefinitions.h"
+#include "SystemTypes.h"
+#include "Config.h"
+
+// The esp-mqtt backend. esp-mqtt runs its own task, which owns the socket,
+// sends queued publishes and reports connection changes, acknowledgements and
+// received messages as events. Everything those events touch is guarded by a
+// spinlock: the in-flight window, the inbound slots and the counters.
+//
+// A QoS 1 publish takes a window slot until its PUBACK arrives; with the
+// window full, publish() waits up to MQTT_WINDOW_WAIT ms for one to free up.
+// The slot is reserved under the lock that checks the window, because
+// NetworkTask and ControlTask publish concurrently.
+// Auto-reconnect is off, so a new session always starts from connect() with
+// the will MqttManager passes (Sparkplug needs a new bdSeq each time).
+//
+// MQTT 5 needs esp-mqtt built with CONFIG_MQTT_PROTOCOL_5 (ESP-IDF 5). Each
+// connection binds a topic alias to the first topic published with it, and
+// later publishes with that alias send an empty topic. An alias above the
+// broker's Topic Alias Maximum is refused by esp-mqtt; that alias and the
+// ones above it then go out with the full topic until the next connection.
+// The "unit" user property lists are built once per unit and reused.
+//
+// esp-mqtt holds one set of properties for the next publish, and the alias
+// bindings are shared by every publishing task, so a mutex makes setting
+// the properties, enqueueing and binding the alias one step. It also keeps
+// publishes off the client while connect() replaces it.
+class EspMqttTransport : public MqttTransport {
+public:
+    EspMqttTransport();
+    ~EspMqttTransport() override;
+
+    // Before the first connect(). sessionExpiry 0 asks for a clean start.
+    // False if this build of esp-mqtt has no MQTT 5; 3.1.1 is used then.
+    bool setProtocol(MqttProtocol protocol, uint32_t sessionExpiry);
+
+    const char* name() const override { return "esp-mqtt"; }
+    void begin(const char* caCert) override;
+    void setServer(const char* host, uint16_t port) override;
+    bool connect(const char* clientId, const char* username, const char* password, const Will& will) override;
+    bool connected() override;
+    void loop() override;
+    bool publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain,
+                 const PublishProperties* properties) override;
+    bool subscribe(const char* topic, uint8_t qos) override;
+    void setMessageHandler(MessageHandler handler, void* context) override;
+    bool sessionPresent() override;
+    int state() override;
+    void getStats(Stats& stats) override;
+
+private:
+    enum class Session : uint8_t {
+        IDLE,
+        CONNECTING,
+        CONNECTED,
+        DISCONNECTED
+    };
+
+    struct InFlight {
+        int msgId;
+        uint32_t sentAt;
+    };
+
+    // A message received on the client task, waiting for loop()
+    struct Inbound {
+        char topic[TopicString::capacity() + 1];
+        uint8_t payload[MQTT_INBOUND_PAYLOAD];
+        uint16_t length;
+    };
+
+    static void onEvent(void* arg, esp_event_base_t base, int32_t eventId, void* eventData);
+    void handleEvent(esp_mqtt_event_handle_t event);
+    void acknowledge(int msgId);
+    void endSession();
+    void fillConfig(esp_mqtt_client_config_t& config, const char* clientId, const char* username,
+                    const char* password, const Will& will) const;
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    size_t setPublishProperties(const char* topic, const PublishProperties* properties, const char*& wireTopic,
+                                uint16_t& binding);
+    mqtt5_user_property_handle_t unitProperty(const char* unit);
+#endif
+
+    esp_mqtt_client_handle_t client;
+    const char* caCert;
+    FixedString<MAX_MQTT_SERVER_LENGTH> host;
+    uint16_t port;
+    bool started;
+    volatile Session session;
+    volatile int lastError;
+    volatile bool resumed;
+    portMUX_TYPE lock;
+    SemaphoreHandle_t publishMutex;
+    MqttProtocol protocol;
+    uint32_t sessionExpiry;
+
+    InFlight inFlight[MQTT_INFLIGHT_WINDOW];
+    size_t inFlightCount;
+    // Slots taken by publish() calls that have not enqueued yet
+    size_t reservedCount;
+    // PUBACKs that overtook the publish() that queued them
+    int earlyAcks[MQTT_INFLIGHT_WINDOW];
+    size_t earlyAckCount;
+
+    Inbound inbound[MQTT_INBOUND_SLOTS];
+    size_t inboundHead;
+    size_t inboundCount;
+
+    Stats stats;
+    MessageHandler handler;
+    void* handlerContext;
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    struct UnitProperty {
+        const char* unit;
+        mqtt5_user_property_handle_t list;
+    };
+
+    // Hash of the topic each outbound alias is bound to on this connection, 0 while unbound
+    uint32_t aliasTopics[MQTT_TOPIC_ALIAS_MAX + 1];
+    uint16_t aliasLimit;
+    UnitProperty units[4];
+    size_t unitCount;
+#endif
+};
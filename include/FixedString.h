@@ -0,0 +1,161 @@
+// FixedString.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Fixed-capacity string with inline storage for topics, log lines and keys
+// built on hot paths. Holds up to N characters plus the terminator and never
+// allocates. Appends that do not fit are cut at the capacity and set the
+// truncated() flag instead of failing, so the result is always a valid,
+// terminated string.
+template <size_t N>
+class FixedString {
+public:
+    FixedString() : len(0), overflow(false) { buffer[0] = '\0'; }
+
+    explicit FixedString(const char* text) : FixedString() { append(text); }
+
+    static constexpr size_t capacity() { return N; }
+    size_t length() const { return len; }
+    bool empty() const { return len == 0; }
+    bool truncated() const { return overflow; }
+    const char* c_str() const { return buffer; }
+
+    // Mutable access; ArduinoJson copies char* values but stores const char* by pointer
+    char* data() { return buffer; }
+
+    void clear() {
+        len = 0;
+        overflow = false;
+        buffer[0] = '\0';
+    }
+
+    FixedString& append(const char* text, size_t count) {
+        if (!text) return *this;
+        size_t room = N - len;
+        if (count > room) {
+            count = room;
+            overflow = true;
+        }
+        memcpy(buffer + len, text, count);
+        len += count;
+        buffer[len] = '\0';
+        return *this;
+    }
+
+    FixedString& append(const char* text) {
+        return text ? append(text, strlen(text)) : *this;
+    }
+
+    FixedString& append(char c) {
+        return append(&c, 1);
+    }
+
+    template <size_t M>
+    FixedString& append(const FixedString<M>& other) {
+        return append(other.c_str(), other.length());
+    }
+
+    // Uppercase hex, two characters per byte
+    FixedString& appendHex(const uint8_t* bytes, size_t count) {
+        static const char digits[] = "0123456789ABCDEF";
+        for (size_t i = 0; i < count; i++) {
+            char pair[2] = {digits[bytes[i] >> 4], digits[bytes[i] & 0x0F]};
+            append(pair, 2);
+        }
+        return *this;
+    }
+
+    FixedString& appendf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        appendv(format, args);
+        va_end(args);
+        return *this;
+    }
+
+    FixedString& appendv(const char* format, va_list args) {
+        size_t room = N - len;
+        int written = vsnprintf(buffer + len, room + 1, format, args);
+        if (written < 0) {
+            buffer[len] = '\0';
+            return *this;
+        }
+        if (static_cast<size_t>(written) > room) {
+            written = static_cast<int>(room);
+            overflow = true;
+        }
+        len += static_cast<size_t>(written);
+        return *this;
+    }
+
+    FixedString& assign(const char* text) {
+        clear();
+        return append(text);
+    }
+
+    FixedString& operator+=(const char* text) { return append(text); }
+    FixedString& operator+=(char c) { return append(c); }
+
+    bool operator==(const char* other) const {
+        return other && strcmp(buffer, other) == 0;
+    }
+    bool operator!=(const char* other) const { return !(*this == other); }
+
+private:
+    char buffer[N + 1];
+    size_t len;
+    bool overflow;
+};
+
+// Printf-style construction in one expression
+template <size_t N>
+FixedString<N> makeFixedString(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+template <size_t N>
+FixedString<N> makeFixedString(const char* format, ...) {
+    FixedString<N> result;
+    va_list args;
+    va_start(args, format);
+    result.appendv(format, args);
+    va_end(args);
+    return result;
+}
+
+// OneWire ROM codes as 16 uppercase hex characters
+using AddressString = FixedString<16>;
+
+inline AddressString formatAddress(const uint8_t* address) {
+    AddressString result;
+    if (address) {
+        result.appendHex(address, 8);
+    }
+    return result;
+}
+
+// MQTT topics: SYSTEM/DEVICE/base/ROM/leaf fits with room to spare
+using TopicString = FixedString<127>;
+
+#ifdef ARDUINO
+// Concatenation with Arduino String for log lines that already build a String
+template <size_t N>
+inline String operator+(const String& lhs, const FixedString<N>& rhs) {
+    String result(lhs);
+    result += rhs.c_str();
+    return result;
+}
+
+template <size_t N>
+inline String operator+(const char* lhs, const FixedString<N>& rhs) {
+    String result(lhs);
+    result += rhs.c_str();
+    return result;
+}
+#endif
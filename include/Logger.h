@@ -35,6 +35,16 @@ public:
     static void debug(const String& message, Category category = Category::GENERAL);
     static void trace(const String& message, Category category = Category::GENERAL);
     
+    // Overloads for literals and stack buffers; these never touch the heap
+    static void error(const char* message, Category category = Category::GENERAL);
+    static void warning(const char* message, Category category = Category::GENERAL);
+    static void info(const char* message, Category category = Category::GENERAL);
+    static void debug(const char* message, Category category = Category::GENERAL);
+    static void trace(const char* message, Category category = Category::GENERAL);
+    
+    // Lets callers skip formatting messages that would be filtered anyway
+    static bool isEnabled(Level level, Category category = Category::GENERAL);
+    
 private:
     static Level currentLevel;                // Current logging level
     static uint8_t enabledCategories;         // Bitfield of enabled categories
@@ -42,7 +52,7 @@ private:
     static constexpr unsigned int MEMORY_LOG_INTERVAL = 5000;  // 5 seconds between memory logs
     
     // Internal helper methods
-    static void logMessage(Level level, Category category, const String& message);
+    static void logMessage(Level level, Category category, const char* message);
     static const char* getLevelString(Level level);
     static const char* getCategoryString(Category category);
     static bool isCategoryEnabled(Category category);
@@ -0,0 +1,111 @@
+// ModbusRegisterMap.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorSlots.h"
+
+// Register image served by the Modbus TCP server. Each sensor owns a fixed
+// block of registers chosen by ROM (see SensorSlots), and the assignment is
+// persisted so it also survives a restart. Requests are answered from the
+// image alone, so serving a client neither takes the sensor mutex nor allocates.
+//
+// Input registers (function 04; also readable with 03 as holding registers):
+//   0        layout version
+//   1        sensor slots
+//   2        sensors present
+//   3        relays
+//   4-5      uptime in seconds, high word first
+//   6        image sequence, incremented on every refresh
+//   8 + 8n   sensor slot n:
+//            +0      status: bit 0 present, bit 1 valid, bits 2-3 health
+//                    (0 active, 1 suspect, 2 quarantined), bit 4 virtual,
+//                    bits 8-10 active anomalies
+//            +1      raw reading, signed 1/128 °C, before calibration and filtering
+//            +2      temperature, signed 1/100 °C, filtered
+//            +3      seconds since the last good reading, 65535 if none
+//            +4..+7  ROM, two bytes per register, first byte high
+// Coils (functions 01, 05 and 15): one per relay
+
+constexpr size_t MODBUS_SENSOR_SLOTS = SensorSlots::CAPACITY;
+constexpr size_t MODBUS_MAX_COILS = 8;
+constexpr size_t MODBUS_MAX_ADU = 260;   // 7-byte MBAP header + 253-byte PDU
+
+// One sensor as handed to refresh(), filled from the OneWireManager snapshot
+struct ModbusSensorSample {
+    uint8_t address[8];
+    int16_t raw;              // 1/128 °C, SensorTable::NO_READING_RAW if none
+    float temperature;        // Filtered value (°C)
+    uint32_t ageSeconds;      // Since the last good reading, UINT32_MAX if none
+    SensorHealth health;
+    uint8_t anomalyMask;
+    bool valid;
+    bool isVirtual;
+};
+
+class ModbusRegisterMap {
+public:
+    static constexpr uint16_t LAYOUT_VERSION = 1;
+    static constexpr uint16_t HEADER_REGISTERS = 8;
+    static constexpr uint16_t REGISTERS_PER_SENSOR = 8;
+    static constexpr uint16_t REGISTER_COUNT = HEADER_REGISTERS + MODBUS_SENSOR_SLOTS * REGISTERS_PER_SENSOR;
+
+    static constexpr uint16_t STATUS_PRESENT = 0x0001;
+    static constexpr uint16_t STATUS_VALID = 0x0002;
+    static constexpr uint16_t STATUS_HEALTH_SHIFT = 2;
+    static constexpr uint16_t STATUS_VIRTUAL = 0x0010;
+    static constexpr uint16_t STATUS_ANOMALY_SHIFT = 8;
+
+    static constexpr size_t INVALID_FRAME = SIZE_MAX;
+
+    // Applies a client's coil write; false rejects it with a device failure
+    using CoilWriter = bool (*)(uint16_t coil, bool state, void* context);
+
+    ModbusRegisterMap();
+
+    // Slot assignment by ROM; all-zero entries are free slots
+    void setSlots(const uint8_t (*addresses)[8], size_t count) { slots.set(addresses, count); }
+    size_t getSlots(uint8_t (*addresses)[8], size_t capacity) const { return slots.get(addresses, capacity); }
+
+    // Rebuild the image from a sensor snapshot and the relay states. Returns
+    // true if a ROM was given a slot, so the caller can persist the assignment.
+    bool refresh(const ModbusSensorSample* samples, size_t count,
+                 const bool* relayStates, uint8_t relayCount, uint32_t uptimeSeconds);
+
+    // Length of the ADU at the start of buffer: 0 while incomplete,
+    // INVALID_FRAME if the header cannot be Modbus TCP
+    static size_t frameLength(const uint8_t* buffer, size_t length);
+
+    // Answer one complete ADU into response (MODBUS_MAX_ADU bytes). Returns the
+    // response length, or 0 when nothing should be sent back.
+    size_t handleRequest(const uint8_t* request, size_t length, uint8_t* response,
+                         bool allowWrites, CoilWriter writer, void* context);
+
+    uint16_t getRegister(uint16_t index) const { return index < REGISTER_COUNT ? registers[index] : 0; }
+    uint8_t getCoilCount() const { return coilCount; }
+
+private:
+    enum Exception : uint8_t {
+        ILLEGAL_FUNCTION = 0x01,
+        ILLEGAL_ADDRESS = 0x02,
+        ILLEGAL_VALUE = 0x03,
+        DEVICE_FAILURE = 0x04
+    };
+
+    void writeSensor(size_t slot, const ModbusSensorSample& sample);
+    void clearSensor(size_t slot);
+
+    size_t readCoils(const uint8_t* pdu, size_t length, uint8_t* out);
+    size_t readRegisters(const uint8_t* pdu, size_t length, uint8_t* out);
+    size_t writeCoil(const uint8_t* pdu, size_t length, uint8_t* out,
+                     bool allowWrites, CoilWriter writer, void* context);
+    size_t writeCoils(const uint8_t* pdu, size_t length, uint8_t* out,
+                      bool allowWrites, CoilWriter writer, void* context);
+    static size_t exception(uint8_t function, Exception code, uint8_t* out);
+
+    uint16_t registers[REGISTER_COUNT];
+    SensorSlots slots;
+    bool coils[MODBUS_MAX_COILS];
+    uint8_t coilCount;
+    uint16_t sequence;
+};
@@ -0,0 +1,48 @@
+// ModbusTask.h
+#pragma once
+
+#include <Arduino.h>
+#include "SystemTypes.h"
+#include "Config.h"
+#include "ModbusRegisterMap.h"
+
+// Modbus TCP server for PLCs and SCADA. One task multiplexes up to
+// MODBUS_MAX_CLIENTS connections with select() and answers every request
+// from a register image it rebuilds from the sensor snapshot once per
+// MODBUS_REFRESH_INTERVAL (layout in ModbusRegisterMap.h). Connection
+// buffers, the snapshot and the image are all static.
+class ModbusTask {
+public:
+    static void init();
+    static void start();
+
+    static bool isRunning();
+    static uint8_t getClientCount();
+
+private:
+    struct Client {
+        int socket;
+        uint32_t lastActivity;
+        size_t length;
+        uint8_t buffer[MODBUS_MAX_ADU];
+    };
+
+    static ModbusConfig config;
+    static ModbusRegisterMap registerMap;
+    static Client clients[MODBUS_MAX_CLIENTS];
+    static TemperatureSensor snapshot[SENSOR_TABLE_CAPACITY];
+    static ModbusSensorSample samples[SENSOR_TABLE_CAPACITY];
+    static uint8_t response[MODBUS_MAX_ADU];
+    static int listenSocket;
+    static volatile uint8_t clientCount;
+    static volatile bool running;
+
+    static void taskFunction(void* parameter);
+    static bool openListener();
+    static void acceptClient();
+    static void serviceClient(Client& client);
+    static void closeClient(Client& client);
+    static void refreshImage();
+    static void saveSlots();
+    static bool writeCoil(uint16_t coil, bool state, void* context);
+};
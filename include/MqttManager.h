@@ -1,14 +1,18 @@
 #pragma once
 
 #include <Arduino.h>
-#include <WiFiClientSecure.h>
-#include <PubSubClient.h>
 #include <ETH.h>
+#include <vector>
 #include "Logger.h"
 #include "PreferencesManager.h"
 #include "Config.h"
 #include "certificates.h"
 #include "SystemTypes.h"
+#include "FixedString.h"
+#include "SparkplugNode.h"
+#include "MqttTransport.h"
+#include "EspMqttTransport.h"
+#include "PubSubClientTransport.h"
 
 class MqttManager {
 public:
@@ -20,16 +24,42 @@ public:
     bool connected();
     
     // Publishing methods
-    bool publish(const char* topic, const char* payload, bool retained = true);
+    bool publish(const char* topic, const char* payload, bool retained = true,
+                 const MqttTransport::PublishProperties* properties = nullptr);
+    bool publish(const char* topic, const uint8_t* payload, size_t length, bool retained = true,
+                 const MqttTransport::PublishProperties* properties = nullptr);
     void publishSensorData(const TemperatureSensor& sensor);
     void publishRelayState(uint8_t relayId, bool state);  // New method
     void publishAuxDisplayData(const TemperatureSensor& sensor);  // New method
+    bool publishRollup(const RollupReport& report);
     void setServer(const IPAddress& ip);  // Add this line
+    
+    // Home Assistant discovery: retained configs for every sensor, relay and
+    // health topic, generated from the topic table. updateDiscovery() works out
+    // which configs changed when the sensor set, a name or the broker session
+    // did; publishDiscovery() sends at most maxMessages of them, so the network
+    // task can pace them behind telemetry. Returns how many were sent.
+    void updateDiscovery(const std::vector<TemperatureSensor>& sensors);
+    size_t publishDiscovery(size_t maxMessages);
+    
+    // Sparkplug B mode (see SparkplugNode): births, deaths and changed metrics
+    // on spBv1.0 topics replace the per-topic sensor and relay payloads and
+    // discovery. publishSparkplug() hands over one cycle's readings;
+    // serviceSparkplug() answers a Rebirth command or a new session from the
+    // last ones. Nothing is born until SNTP has set the clock.
+    bool isSparkplug() const { return sparkplugEnabled; }
+    void publishSparkplug(const std::vector<TemperatureSensor>& sensors, const bool* relays, uint8_t relayCount);
+    void serviceSparkplug();
+    
+    // Publish, acknowledgement, drop and wire byte counts of the transport, at debug level
+    void logTransportStats();
 
 private:
-    // Network clients
-    WiFiClientSecure wifiClient;  // Use WiFiClientSecure since you're using setCACert
-    PubSubClient mqtt;
+    // Both backends exist; begin() picks the configured one
+    EspMqttTransport espMqttTransport;
+    PubSubClientTransport pubSubClientTransport;
+    MqttTransport* transport;
+    MqttProtocol protocol;   // As negotiated with the backend, not only as configured
     
     // Connection configuration
     String mqttBroker;
@@ -41,9 +71,74 @@ private:
     unsigned long lastReconnectAttempt;
     unsigned long lastPublishAttempt;
     unsigned int currentReconnectDelay;
+    
+    // Payload format of each topic class (text, CBOR or MessagePack)
+    MqttFormatConfig formats;
 
+    // Rows of the topic table in MqttManager.cpp
+    enum class Topic : uint8_t {
+        SENSOR_TEMPERATURE = 0,
+        SENSOR_RAW,
+        SENSOR_STATUS,
+        SENSOR_LAST_UPDATE,
+        RELAY_STATE,
+        RELAY_AVAILABILITY,
+        HUB_STATUS,
+        COUNT
+    };
+    
+    // One announced entity. A config is pending while published != wanted.
+    struct DiscoveryEntry {
+        uint8_t address[8];   // Sensor ROM, zeros for relay and hub entities
+        Topic topic;
+        uint8_t relay;        // Relay index of relay entities
+        bool inUse;
+        uint32_t published;   // Hash of the config on the broker, 0 if none
+        uint32_t wanted;      // Hash of the config it should have, 0 to remove it
+    };
+    
+    // Three entities per sensor, one per relay, one for the hub
+    static constexpr size_t MAX_DISCOVERY_ENTRIES = SENSOR_TABLE_CAPACITY * 3 + RELAY_COUNT + 1;
+    using DiscoveryConfig = FixedString<1023>;
+    
+    DiscoveryEntry discovery[MAX_DISCOVERY_ENTRIES];
+    uint32_t discoverySensorHash;     // ROMs of the last update
+    uint32_t discoveryNameGeneration;
+    bool discoveryUpdated;            // updateDiscovery() has run since boot
+    bool discoveryNewSession;         // Connected since the last update
+    
+    // MQTT 5 topic aliases: a block of one per sensor topic for each sensor,
+    // handed out in publication order from every new connection
+    uint8_t aliasSensors[SENSOR_TABLE_CAPACITY][8];
+    size_t aliasSensorCount;
+    
+    // Sparkplug B node and the last readings handed over
+    bool sparkplugEnabled;
+    SparkplugNode sparkplug;
+    SparkplugSensorSample sparkplugSamples[SENSOR_TABLE_CAPACITY];
+    size_t sparkplugSampleCount;
+    bool sparkplugRelays[SPARKPLUG_MAX_RELAYS];
+    uint8_t sparkplugRelayCount;
+    bool sparkplugHasData;
+    bool sparkplugClockWarned;
+    
     // Private methods
-    void setupSecureClient();
+    TopicString stateTopic(Topic topic, const uint8_t* address, uint8_t relay) const;
+    TopicString discoveryTopic(const DiscoveryEntry& entry) const;
+    void buildDiscoveryConfig(const DiscoveryEntry& entry, DiscoveryConfig& config) const;
+    void wantDiscovery(Topic topic, const uint8_t* address, uint8_t relay, bool announce);
+    bool publishFloat(const char* topic, PayloadFormat format, float value,
+                      const MqttTransport::PublishProperties* properties = nullptr);
+    bool publishUnsigned(const char* topic, PayloadFormat format, uint32_t value,
+                         const MqttTransport::PublishProperties* properties = nullptr);
+    bool publishText(const char* topic, PayloadFormat format, const char* text,
+                     const MqttTransport::PublishProperties* properties = nullptr);
+    uint16_t sensorAlias(const uint8_t* address);
+    const MqttTransport::PublishProperties* sensorProperties(Topic topic, uint16_t firstAlias,
+                                                             MqttTransport::PublishProperties& properties) const;
+    bool sendSparkplug();
+    static bool publishSparkplugMessage(const char* topic, const uint8_t* payload, size_t length, void* context);
+    static void onMessage(const char* topic, const uint8_t* payload, size_t length, void* context);
     void loadConfiguration();
     bool reconnect();
     unsigned int getReconnectDelay();
@@ -54,4 +149,5 @@ private:
     static constexpr unsigned int PUBLISH_RATE_LIMIT = 100;
     static constexpr unsigned int RECONNECT_INTERVAL = 5000;
     static constexpr uint8_t MQTT_QOS = 1;
+    static constexpr uint16_t ALIASES_PER_SENSOR = static_cast<uint16_t>(Topic::SENSOR_LAST_UPDATE) + 1;
 };
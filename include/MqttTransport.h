@@ -0,0 +1,71 @@
+// MqttTransport.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Broker connection as MqttManager uses it, with two backends:
+//
+//   EspMqttTransport       Event-driven on ESP-IDF's esp-mqtt client task.
+//                          Publishes are queued and sent by that task; QoS 1
+//                          acknowledgements arrive asynchronously, with up to
+//                          MQTT_INFLIGHT_WINDOW outstanding. Inbound and
+//                          outbound packets have separate, small buffers.
+//   PubSubClientTransport  Polled: loop() must run for keepalives and inbound
+//                          messages, publishes go out QoS 0 one at a time, and
+//                          both directions share one 8 KB buffer.
+//
+// connect() blocks until the session is up or has failed with either backend,
+// so MqttManager's reconnect and backoff logic does not depend on which one
+// runs. Received messages are handed to the handler from loop(), on the task
+// that calls it, never from the client's own task.
+//
+// Only esp-mqtt speaks MQTT 5. Its sessions carry the PublishProperties that
+// MqttManager passes; 3.1.1 sessions send the same message without them.
+class MqttTransport {
+public:
+    struct Will {
+        const char* topic;
+        const uint8_t* payload;   // NUL-terminated as well: PubSubClient takes a C string
+        size_t length;
+        uint8_t qos;
+        bool retain;
+    };
+
+    // MQTT 5 properties of one publish
+    struct PublishProperties {
+        uint16_t topicAlias;       // 0 for none. Bound to the topic by its first use on a connection
+        uint32_t messageExpiry;    // Seconds, 0 for none
+        const char* unit;          // Value of a "unit" user property, nullptr for none
+    };
+
+    struct Stats {
+        uint32_t published;        // Accepted by publish()
+        uint32_t acknowledged;     // QoS 1 publishes the broker acknowledged
+        uint32_t dropped;          // Refused, or unacknowledged when the session ended
+        uint32_t inFlight;         // Awaiting acknowledgement now
+        uint32_t ackTimeAverage;   // ms from publish() to PUBACK, moving average
+        uint32_t ackTimeMax;
+        uint32_t inboundDropped;   // Received messages too large or arriving too fast
+        uint32_t bytesSent;        // PUBLISH packets as sent, fixed header included
+        uint32_t publishTimeAverage;   // us in publish() past the window wait, moving average
+    };
+
+    using MessageHandler = void (*)(const char* topic, const uint8_t* payload, size_t length, void* context);
+
+    virtual ~MqttTransport() {}
+
+    virtual const char* name() const = 0;
+    virtual void begin(const char* caCert) = 0;
+    virtual void setServer(const char* host, uint16_t port) = 0;
+    virtual bool connect(const char* clientId, const char* username, const char* password, const Will& will) = 0;
+    virtual bool connected() = 0;
+    virtual void loop() = 0;
+    virtual bool publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain,
+                         const PublishProperties* properties) = 0;
+    virtual bool subscribe(const char* topic, uint8_t qos) = 0;
+    virtual void setMessageHandler(MessageHandler handler, void* context) = 0;
+    virtual bool sessionPresent() = 0;   // The broker resumed the last session, subscriptions included
+    virtual int state() = 0;   // Backend-specific cause of the last failure, for the log
+    virtual void getStats(Stats& stats) = 0;
+};
@@ -0,0 +1,31 @@
+// MqttWire.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MqttTransport.h"
+
+// Sizes of MQTT PUBLISH packets as they go on the wire, for the transports'
+// byte counters and the host comparison of MQTT 3.1.1 and 5
+// (tools/mqtt5_wire_bench.cpp). Platform independent.
+class MqttWire {
+public:
+    // Key of the user property that carries a reading's unit
+    static constexpr const char* UNIT_PROPERTY = "unit";
+
+    // Property identifiers of an MQTT 5 PUBLISH
+    static constexpr uint8_t PROPERTY_MESSAGE_EXPIRY = 0x02;
+    static constexpr uint8_t PROPERTY_TOPIC_ALIAS = 0x23;
+    static constexpr uint8_t PROPERTY_USER = 0x26;
+
+    // Bytes of a variable byte integer: remaining and property lengths
+    static size_t varIntLength(size_t value);
+
+    // Property block of an MQTT 5 PUBLISH, its length prefix included.
+    // Without properties it is the single zero length byte.
+    static size_t publishPropertiesLength(const MqttTransport::PublishProperties* properties);
+
+    // Whole PUBLISH packet. propertiesLength is 0 for MQTT 3.1.1, which has
+    // no property block; topicLength is 0 for a topic sent as an alias only.
+    static size_t publishLength(size_t topicLength, size_t payloadLength, uint8_t qos, size_t propertiesLength);
+};
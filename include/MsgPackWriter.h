@@ -0,0 +1,33 @@
+// MsgPackWriter.h
+#pragma once
+
+#include "PayloadWriter.h"
+
+// Writes MessagePack into a caller-provided buffer, item for item like
+// CborWriter. Integers and lengths take the smallest representation the
+// format has. MessagePack has no half-precision floats, so every float is a
+// five-byte float 32.
+class MsgPackWriter : public PayloadWriter {
+public:
+    MsgPackWriter(uint8_t* buffer, size_t capacity);
+
+    void beginArray(size_t count) override;
+    void beginMap(size_t pairs) override;
+    void addUnsigned(uint64_t value) override;
+    void addInt(int64_t value) override;
+    void addBool(bool value) override;
+    void addNull() override;
+    void addFloat(float value) override;
+    void addText(const char* text, size_t length) override;
+    void addBytes(const uint8_t* data, size_t length) override;
+    void addHex(const uint8_t* data, size_t length) override;
+
+    using PayloadWriter::addText;
+
+private:
+    // Type byte, then the low bytes of value big-endian; payload bytes are reserved with it
+    bool writeTyped(uint8_t type, uint64_t value, uint8_t bytes, size_t payload = 0);
+    // Fixed form below fixLimit, else the 8-, 16- or 32-bit length form from typeBase
+    bool writeLength(uint8_t fixType, size_t fixLimit, uint8_t typeBase, bool hasLength8,
+                     size_t value, size_t payload);
+};
@@ -20,15 +20,19 @@ public:
     static void publishSensorBatch(const std::vector<TemperatureSensor>& sensors, size_t startIdx, size_t count);
     static bool maintainConnection();  // Add this line
     
+    // Priority events bypass the batch publish cycle
+    static bool queueAnomalyEvent(const AnomalyEvent& event);
+    
 private:
     static MqttManager mqttManager;
     static OneWireManager& owManager;
     static WebServer webServer;
     static QueueHandle_t publishQueue;
     static QueueHandle_t controlQueue;
+    static QueueHandle_t eventQueue;
     static unsigned long lastPublishTime;  // Changed from TickType_t to unsigned long
     
     static void taskFunction(void* parameter);
+    static void drainPriorityEvents();
     static bool publishSensorData(const TemperatureSensor& sensor);
-    static String addressToString(const uint8_t* address);
 };
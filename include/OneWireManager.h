@@ -7,6 +7,27 @@
 #include <vector>
 #include "SystemTypes.h"
 #include "Config.h"
+#include "VirtualSensors.h"
+#include "SensorTable.h"
+
+// Result of a bus timing benchmark: each transaction is a reset, a ROM select
+// and a 9-byte scratchpad read. Transactions stretched by more than one bit slot
+// beyond the fastest one are counted as late; CRC failures show corrupted slots.
+struct BusTimingReport {
+    uint32_t startTime;        // millis() when the run started, 0 if never run
+    uint16_t rounds;
+    uint16_t sensors;
+    uint32_t transactions;
+    uint32_t presenceErrors;   // Reset without a presence pulse
+    uint32_t crcErrors;
+    uint32_t lateTransactions;
+    uint32_t minUs;
+    uint32_t maxUs;
+    float meanUs;
+    float stddevUs;
+    int8_t core;               // Core the bus task ran on
+    bool running;
+};
 
 class OneWireManager {
 public:
@@ -15,7 +36,7 @@ public:
     // Temperature reading methods
     void startTemperatureConversion();
     bool checkAndCollectTemperatures();
-    bool readTemperature(const uint8_t* address, float& temperature);
+    bool readTemperature(const uint8_t* address, float& temperature);  // Blocks for one conversion
     
     // Device scanning methods
     bool scanDevices();
@@ -27,17 +48,49 @@ public:
     bool isConversionInProgress() const;
     bool isBusBusy() const;
     
-    // Data access
-    const std::vector<TemperatureSensor>& getSensorList() const;
-    String addressToString(const uint8_t* address) const;
+    // Missing sensors: re-probe quarantined devices that are due; returns how many answered
+    uint8_t probeQuarantinedSensors();
+    static const char* healthToString(SensorHealth health);
+    
+    // Data access. getSensorList() returns a copy taken under the sensor mutex.
+    std::vector<TemperatureSensor> getSensorList() const;
+    size_t getSensors(TemperatureSensor* out, size_t capacity) const;  // Allocation-free variant
+    size_t getHotEntries(SensorHot* out, size_t capacity) const;       // ROM, value, raw and flags only
+    bool getSensorStatistics(const uint8_t* address, SensorStatistics& stats) const;
     float getCachedTemperature(const uint8_t* address);
+    
+    // Signal processing configuration
+    void reloadFilterConfig();
+    FilterConfig getFilterConfig() const;
+    
+    // Virtual sensor configuration
+    void reloadVirtualSensors();
+    
+    // Anomaly detection: configuration and events raised since the last call
+    void reloadAnomalyConfig();
+    size_t takeAnomalyEvents(std::vector<AnomalyEvent>& events);
+    
+    // Rollup statistics: moves windows completed since the last call into reports
+    size_t takeCompletedRollups(std::vector<RollupReport>& reports);
+    
+    // Warm start: reinstate the last known sensor list, confirm those devices
+    // are still present, and persist the current state for the next boot
+    uint8_t restoreWarmStart();
+    uint8_t verifyKnownDevices();
+    void saveWarmStart();
+    
+    // Bus timing benchmark; runs on the caller's task and holds the bus meanwhile
+    void runTimingBenchmark(uint16_t rounds);
+    BusTimingReport getTimingReport() const;
 
 private:
     static constexpr int MAX_RETRIES = 3;
+    static constexpr size_t MAX_PENDING_ANOMALIES = 32;
+    static constexpr uint32_t SLOT_TIME_US = 70;          // One write-0 slot incl. recovery
     
     OneWire oneWire;
     DallasTemperature sensors;
-    std::vector<TemperatureSensor> sensorList;
+    SensorTable table;
     
     bool busyFlag;
     mutable SemaphoreHandle_t sensorMutex;
@@ -48,8 +101,27 @@ private:
     uint32_t conversionStartTime;
     bool conversionInProgress;
     
+    // Signal processing chain configuration (cached from preferences)
+    FilterConfig filterConfig;
+    
+    // Derived sensors, kept at the end of the table under synthetic ROMs
+    VirtualSensorSet virtualSensors;
+    
+    // Anomaly detection configuration and events awaiting dispatch
+    AnomalyConfig anomalyConfig;
+    std::vector<AnomalyEvent> pendingAnomalies;
+    
+    BusTimingReport timingReport;
+    
     // Private helper methods
     void setBusBusy(bool busy);
     bool verifyMutex() const;
     bool processFoundDevices(uint8_t deviceCount, std::vector<TemperatureSensor>& tempList);
+    bool applyReading(size_t index, int32_t raw, uint32_t now);
+    void quarantine(size_t index, uint32_t now);
+    void syncVirtualSensors();
+    void refreshVirtualSensors(uint32_t now);
+    void loadSensor(size_t index, const TemperatureSensor& sensor, bool withReading);
+    void copySensor(size_t index, TemperatureSensor& sensor) const;
+    void storeTimingReport(const BusTimingReport& report);
 };
\ No newline at end of file
@@ -9,25 +9,123 @@
 
 class OneWireTask {
 public:
-    enum class MessageType {
-        SENSOR_SCAN_REQUEST,
-        TEMPERATURE_READ_REQUEST
+    // On-demand bus commands. submit() returns a handle that identifies the
+    // command until its slot is reused by a later one. A request equal to one
+    // that is still pending is merged into it: both callers share the handle,
+    // and the command keeps the higher priority and the earlier deadline.
+    enum class CommandType : uint8_t {
+        SCAN,          // Full bus search
+        READ_ALL,      // Convert and collect every sensor; joins a running conversion
+        READ_ONE,      // Convert and read a single sensor
+        BENCHMARK      // Bus timing benchmark, see OneWireManager::runTimingBenchmark
     };
-    
-    struct TaskMessage {
-        MessageType type;
+
+    // Not LOW/HIGH: Arduino.h defines those as macros
+    enum class CommandPriority : uint8_t {
+        BACKGROUND = 0,
+        NORMAL,
+        URGENT
+    };
+
+    enum class CommandState : uint8_t {
+        UNKNOWN = 0,   // Handle never issued or slot since reused
+        PENDING,
+        RUNNING,
+        DONE,
+        FAILED,
+        EXPIRED        // Deadline passed before the command could start
+    };
+
+    using CommandHandle = uint32_t;
+    static constexpr CommandHandle INVALID_COMMAND = 0;
+
+    struct CommandResult {
+        CommandHandle handle;
+        CommandType type;
+        CommandState state;
+        uint8_t address[8];        // READ_ONE target
+        float temperature;         // READ_ONE reading
+        uint32_t count;            // Sensors found (SCAN), read (READ_ALL) or transactions (BENCHMARK)
+        uint8_t requests;          // Callers merged into this command
+        uint32_t submitTime;
+        uint32_t completeTime;
     };
-    
+
+    // Runs on the OneWire task once the command reaches a final state; keep it short
+    using CommandCallback = void (*)(const CommandResult& result, void* context);
+
+    struct CommandRequest {
+        CommandType type;
+        CommandPriority priority;
+        uint32_t deadlineMs;       // Must start within this many ms, 0 for no deadline
+        uint8_t address[8];        // READ_ONE only
+        uint16_t rounds;           // BENCHMARK only
+        CommandCallback callback;  // Optional
+        void* context;
+    };
+
     static void init();
     static void start();
-    
+
+    static CommandHandle submit(const CommandRequest& request);
+    static CommandHandle requestScan(CommandPriority priority = CommandPriority::NORMAL, uint32_t deadlineMs = 0);
+    static CommandHandle requestRead(CommandPriority priority = CommandPriority::NORMAL, uint32_t deadlineMs = 0);
+    static CommandHandle requestReadSensor(const uint8_t* address,
+                                           CommandPriority priority = CommandPriority::NORMAL,
+                                           uint32_t deadlineMs = 0);
+    static CommandHandle requestBenchmark(uint16_t rounds);
+
+    // Latest state of a command; false once the handle is unknown
+    static bool getResult(CommandHandle handle, CommandResult& result);
+
+    // Blocks the calling task until the command finishes or the timeout passes.
+    // Not for use on the OneWire task itself or the AsyncTCP task.
+    static bool waitFor(CommandHandle handle, CommandResult& result, TickType_t timeout);
+
+    static bool isFinal(CommandState state);
+    static const char* typeToString(CommandType type);
+    static const char* stateToString(CommandState state);
+
     // Make manager public for access by other tasks
     static OneWireManager manager;
 
 private:
-    static QueueHandle_t commandQueue;
-    static SemaphoreHandle_t dataMutex;
-    
+    struct Waiter {
+        CommandCallback callback;
+        void* context;
+    };
+
+    struct CommandSlot {
+        CommandResult result;
+        CommandPriority priority;
+        uint32_t deadline;         // Absolute millis(), 0 for none
+        uint16_t rounds;
+        Waiter waiters[MAX_COMMAND_WAITERS];
+        uint8_t waiterCount;
+    };
+
+    static QueueHandle_t commandQueue;   // Carries handles; only used to wake the task
+    static SemaphoreHandle_t dataMutex;  // Guards slots and nextHandle
+    static CommandSlot slots[MAX_PENDING_COMMANDS];
+    static CommandHandle nextHandle;
+
+    // Bus schedule, owned by the task loop
+    static bool conversionStarted;
+    static uint32_t conversionStartTime;
+    static uint32_t lastScanTime;
+    static uint32_t lastReadTime;
+
     static void taskFunction(void* parameter);
-    static void processCommand(const TaskMessage& msg);
-};
\ No newline at end of file
+    static void processCommands();
+    static void execute(const CommandSlot& slot);
+    static void startConversion();
+    static void onCollectionComplete();
+    static void complete(CommandHandle handle, CommandState state, float temperature, uint32_t count);
+    static void finish(CommandSlot& slot, CommandState state, Waiter* waiters, uint8_t& waiterCount);
+    static void notifyWaiters(const CommandResult& result, const Waiter* waiters, uint8_t count);
+    static bool addWaiter(CommandHandle handle, CommandCallback callback, void* context);
+    static bool removeWaiter(CommandHandle handle, CommandCallback callback, void* context);
+    static CommandSlot* findSlot(CommandHandle handle);
+    static CommandSlot* allocateSlot();
+    static void signalWaiter(const CommandResult& result, void* context);
+};
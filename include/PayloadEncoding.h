@@ -0,0 +1,71 @@
+// PayloadEncoding.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorTable.h"
+#include "SensorStatistics.h"
+
+// Encoding of MQTT payloads and API responses. TEXT is what they always were:
+// ASCII values on the MQTT topics, ArduinoJson documents on the API.
+enum class PayloadFormat : uint8_t {
+    TEXT = 0,
+    CBOR,
+    MSGPACK
+};
+
+// One /api/sensors entry, filled by the caller from the sensor snapshot and
+// the preferences
+struct SensorRecord {
+    uint8_t address[8];
+    const char* name;           // nullptr when the sensor has none
+    float temperature;          // Filtered value
+    float rawTemperature;
+    uint32_t lastReadTime;
+    uint32_t offlineSince;
+    SensorHealth health;
+    uint8_t anomalyMask;        // Active AnomalyType bits
+    bool valid;
+    bool isVirtual;
+    bool displaySensor;         // Shown on the display ("isBabelSensor")
+};
+
+// Binary (CBOR or MessagePack) encoders for the sensor, relay and statistics
+// model, written once over PayloadWriter. Maps carry the same keys and values
+// as the JSON the API and MQTT send, so a binary document decodes to what
+// the JSON parses to. Each encoder writes one complete item into out and
+// returns its length, or 0 for TEXT or when the item does not fit. Arrays are
+// sent as encodeArrayHead() followed by their items, so a list is streamed
+// item by item and never needs a buffer for the whole of it.
+//
+// Platform independent; tools/payload_encoding_bench.cpp runs it on the host.
+class PayloadEncoding {
+public:
+    // Enough for any sensor item, with a name of MAX_FRIENDLY_NAME_LENGTH
+    static constexpr size_t MAX_SENSOR_ITEM = 320;
+    static constexpr size_t MAX_RELAY_ITEM = 96;
+    static constexpr size_t MAX_ROLLUP_ITEM = 96;
+
+    // Media type of an API response; TEXT is application/json
+    static const char* contentType(PayloadFormat format);
+    // "text", "cbor" or "msgpack" as used in the preferences
+    static const char* formatName(PayloadFormat format);
+    static bool parseFormat(const char* name, PayloadFormat& format);
+
+    // Highest-q media range of an Accept header among CBOR, MessagePack and
+    // JSON (including wildcards); JSON wins ties, then the earlier range.
+    // TEXT when there is no header or nothing in it is accepted.
+    static PayloadFormat fromAccept(const char* accept);
+
+    static size_t encodeArrayHead(PayloadFormat format, size_t count, uint8_t* out, size_t capacity);
+    static size_t encodeSensor(PayloadFormat format, const SensorRecord& sensor, uint8_t* out, size_t capacity);
+    static size_t encodeRelay(PayloadFormat format, uint8_t relayId, bool state, const char* name,
+                              uint8_t* out, size_t capacity);
+    static size_t encodeRollup(PayloadFormat format, const RollupWindow& rollup, uint8_t* out, size_t capacity);
+
+    // Single values, for the MQTT topics that carry one reading each
+    static size_t encodeFloat(PayloadFormat format, float value, uint8_t* out, size_t capacity);
+    static size_t encodeUnsigned(PayloadFormat format, uint32_t value, uint8_t* out, size_t capacity);
+    static size_t encodeBool(PayloadFormat format, bool value, uint8_t* out, size_t capacity);
+    static size_t encodeText(PayloadFormat format, const char* text, uint8_t* out, size_t capacity);
+};
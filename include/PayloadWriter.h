@@ -0,0 +1,48 @@
+// PayloadWriter.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Common interface of the binary payload writers (CborWriter, MsgPackWriter),
+// so the sensor, relay and statistics encoders in PayloadEncoding are written
+// once for both formats. Output goes into a caller-provided buffer; containers
+// have definite lengths, so the caller states the item count up front. Writes
+// that do not fit set the overflowed() flag and are dropped, so the encoded
+// prefix is never torn mid-item.
+class PayloadWriter {
+public:
+    virtual ~PayloadWriter() = default;
+
+    virtual void beginArray(size_t count) = 0;
+    virtual void beginMap(size_t pairs) = 0;
+    virtual void addUnsigned(uint64_t value) = 0;
+    virtual void addInt(int64_t value) = 0;
+    virtual void addBool(bool value) = 0;
+    virtual void addNull() = 0;
+    virtual void addFloat(float value) = 0;
+    virtual void addText(const char* text, size_t length) = 0;
+    virtual void addBytes(const uint8_t* data, size_t length) = 0;
+
+    // Upper-case hex of a ROM or other short identifier, as text
+    virtual void addHex(const uint8_t* data, size_t length) = 0;
+
+    void addText(const char* text);
+
+    const uint8_t* data() const { return buffer; }
+    size_t size() const { return length; }
+    bool overflowed() const { return overflow; }
+
+    // Start over at the beginning of the buffer
+    void reset();
+
+protected:
+    PayloadWriter(uint8_t* buffer, size_t capacity);
+
+    bool reserve(size_t count);
+
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+};
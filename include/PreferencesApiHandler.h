@@ -16,6 +16,9 @@ public:
         
     String handleGet();
     bool handlePost(const String& jsonData);
+    
+    // Shared with the /api/control status endpoint
+    static void addControlLoopToJson(JsonObject& obj, const ControlLoopConfig& config);
 
 private:
     OneWireManager& oneWireManager;
@@ -23,6 +26,18 @@ private:
     bool validateMqttConfig(JsonObject& mqtt);
     bool validateScanningConfig(JsonObject& scanning);
     bool validateDisplayConfig(JsonObject& display);
+    bool validateFilterConfig(JsonObject& filter);
+    bool validateControlConfig(JsonVariant control);
+    bool validateVirtualSensors(JsonVariant virtualSensors);
+    bool validateAnomalyConfig(JsonObject& anomaly);
+    bool validateTaskAffinity(JsonVariant tasks);
+    bool validateModbusConfig(JsonObject& modbus);
+    bool validateBacnetConfig(JsonObject& bacnet);
+    bool validateCoapConfig(JsonObject& coap);
+    bool validateBeaconConfig(JsonObject& beacon);
+    bool validateMqttFormatConfig(JsonObject& formats);
+    bool validateSparkplugConfig(JsonObject& sparkplug);
+    bool validateMqttTransportConfig(JsonObject& transport);
     bool validateSensorName(const char* name);
     bool validateHostname(const char* hostname);
 
@@ -30,9 +45,34 @@ private:
     void addScanningConfigToJson(JsonObject& root);
     void addDisplayConfigToJson(JsonObject& root);
     void addSensorNamesToJson(JsonObject& root);
+    void addFilterConfigToJson(JsonObject& root);
+    void addControlConfigToJson(JsonObject& root);
+    void addVirtualSensorsToJson(JsonObject& root);
+    void addAnomalyConfigToJson(JsonObject& root);
+    void addTaskAffinityToJson(JsonObject& root);
+    void addModbusConfigToJson(JsonObject& root);
+    void addBacnetConfigToJson(JsonObject& root);
+    void addCoapConfigToJson(JsonObject& root);
+    void addBeaconConfigToJson(JsonObject& root);
+    void addMqttFormatConfigToJson(JsonObject& root);
+    void addSparkplugConfigToJson(JsonObject& root);
+    void addMqttTransportConfigToJson(JsonObject& root);
 
     bool updateMqttConfig(JsonObject& mqtt);
     bool updateScanningConfig(JsonObject& scanning);
     bool updateDisplayConfig(JsonObject& display);
     bool updateSensorNames(JsonVariant sensors);
+    bool updateFilterConfig(JsonObject& filter);
+    bool updateSensorCalibration(JsonVariant calibration);
+    bool updateControlConfig(JsonVariant control);
+    bool updateVirtualSensors(JsonVariant virtualSensors);
+    bool updateAnomalyConfig(JsonObject& anomaly);
+    bool updateTaskAffinity(JsonVariant tasks);
+    bool updateModbusConfig(JsonObject& modbus);
+    bool updateBacnetConfig(JsonObject& bacnet);
+    bool updateCoapConfig(JsonObject& coap);
+    bool updateBeaconConfig(JsonObject& beacon);
+    bool updateMqttFormatConfig(JsonObject& formats);
+    bool updateSparkplugConfig(JsonObject& sparkplug);
+    bool updateMqttTransportConfig(JsonObject& transport);
 };
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "Logger.h"
+#include "SensorFilter.h"
+#include "ThermostatController.h"
+#include "RuleEngine.h"
+#include "VirtualSensors.h"
+#include "SystemTypes.h"
 
 class PreferencesManager {
 public:
@@ -39,8 +44,68 @@ public:
     static String getSensorName(const uint8_t* address);
     static bool setDisplaySensor(const uint8_t* address);
     static void getDisplaySensor(uint8_t* address);
+    static bool setDisplayPlaylist(const DisplayPlaylistEntry* entries, uint8_t count);
+    static uint8_t getDisplayPlaylist(DisplayPlaylistEntry* entries, uint8_t maxCount);
+    static bool setTaskCore(uint8_t taskIndex, int8_t core);
+    static bool clearTaskCore(uint8_t taskIndex);
+    static int8_t getTaskCore(uint8_t taskIndex, int8_t defaultCore);
+    static bool setWarmStartRecords(const WarmStartRecord* records, uint8_t count);
+    static uint8_t getWarmStartRecords(WarmStartRecord* records, uint8_t maxCount);
     static bool setRelayName(uint8_t relayId, const char* name);
     static String getRelayName(uint8_t relayId);
+    static uint32_t getNameGeneration();  // Advances whenever a sensor or relay name is saved
+    
+    // Sensor Signal Processing
+    static bool setFilterConfig(const FilterConfig& config);
+    static void getFilterConfig(FilterConfig& config);
+    static bool setSensorCalibration(const uint8_t* address, const SensorCalibration& calibration);
+    static void getSensorCalibration(const uint8_t* address, SensorCalibration& calibration);
+    static bool setAnomalyConfig(const AnomalyConfig& config);
+    static void getAnomalyConfig(AnomalyConfig& config);
+    
+    // Closed-loop Control
+    static bool setControlLoop(uint8_t loopId, const ControlLoopConfig& config);
+    static void getControlLoop(uint8_t loopId, ControlLoopConfig& config);
+    
+    // Automation Rules
+    static bool setRule(uint8_t ruleId, const RuleDefinition& definition);
+    static bool getRule(uint8_t ruleId, RuleDefinition& definition);
+    
+    // Virtual Sensors
+    static bool setVirtualSensor(uint8_t index, const VirtualSensorDefinition& definition);
+    static bool getVirtualSensor(uint8_t index, VirtualSensorDefinition& definition);
+    
+    // Modbus TCP server
+    static bool setModbusConfig(const ModbusConfig& config);
+    static void getModbusConfig(ModbusConfig& config);
+    
+    // BACnet/IP device
+    static bool setBacnetConfig(const BacnetConfig& config);
+    static void getBacnetConfig(BacnetConfig& config);
+    
+    // CoAP endpoint
+    static bool setCoapConfig(const CoapConfig& config);
+    static void getCoapConfig(CoapConfig& config);
+    static bool setBeaconConfig(const BeaconConfig& config);
+    static void getBeaconConfig(BeaconConfig& config);
+    
+    // MQTT payload format per topic class
+    static bool setMqttFormatConfig(const MqttFormatConfig& config);
+    static void getMqttFormatConfig(MqttFormatConfig& config);
+    
+    // MQTT client backend
+    static bool setMqttBackend(MqttBackend backend);
+    static MqttBackend getMqttBackend();
+    static bool setMqttProtocol(MqttProtocol protocol);
+    static MqttProtocol getMqttProtocol();
+    
+    // Sparkplug B mode
+    static bool setSparkplugConfig(const SparkplugConfig& config);
+    static void getSparkplugConfig(SparkplugConfig& config);
+    
+    // Slot assignment of a protocol server (see SensorSlots), stored under key
+    static bool setSensorSlots(const char* key, const uint8_t (*addresses)[8], uint8_t count);
+    static uint8_t getSensorSlots(const char* key, uint8_t (*addresses)[8], uint8_t maxCount);
     
     // Utility methods
     static String addressToString(const uint8_t* address);
@@ -49,6 +114,7 @@ public:
 private:
     static PreferenceStorage* prefs;
     static SemaphoreHandle_t prefsMutex;
+    static volatile uint32_t nameGeneration;
     
     // Mutex management
     static bool acquireMutex(const char* caller);
@@ -56,6 +122,7 @@ private:
     
     // Helper methods
     static String getSensorKey(const uint8_t* address);
+    static String getSensorKey(const char* prefix, const uint8_t* address);
     static bool isInitialized();
     
     // Prevent instantiation
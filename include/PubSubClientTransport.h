@@ -0,0 +1,46 @@
+// PubSubClientTransport.h
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <PubSubClient.h>
+#include "MqttTransport.h"
+#include "FixedString.h"
+#include "SharedDefinitions.h"
+
+// The polled PubSubClient backend, as the hub used before esp-mqtt. QoS is
+// ignored on publish: PubSubClient sends QoS 0 only. It speaks MQTT 3.1.1, so
+// publish properties are dropped and every session starts clean.
+class PubSubClientTransport : public MqttTransport {
+public:
+    PubSubClientTransport();
+
+    const char* name() const override { return "pubsubclient"; }
+    void begin(const char* caCert) override;
+    void setServer(const char* host, uint16_t port) override;
+    bool connect(const char* clientId, const char* username, const char* password, const Will& will) override;
+    bool connected() override;
+    void loop() override;
+    bool publish(const char* topic, const uint8_t* payload, size_t length, uint8_t qos, bool retain,
+                 const PublishProperties* properties) override;
+    bool subscribe(const char* topic, uint8_t qos) override;
+    void setMessageHandler(MessageHandler handler, void* context) override;
+    bool sessionPresent() override { return false; }
+    int state() override;
+    void getStats(Stats& stats) override;
+
+private:
+    WiFiClientSecure wifiClient;
+    PubSubClient mqtt;
+    FixedString<MAX_MQTT_SERVER_LENGTH> host;   // PubSubClient keeps the pointer
+    MessageHandler handler;
+    void* handlerContext;
+    uint32_t published;
+    uint32_t dropped;
+    uint32_t bytesSent;
+    uint32_t publishTimeAverage;
+
+    static constexpr uint16_t BUFFER_SIZE = 8192;    // Shared by both directions
+    static constexpr uint16_t SOCKET_TIMEOUT = 10;   // Seconds
+    static constexpr uint32_t SETTLE_DELAY = 50;     // ms after each publish
+};
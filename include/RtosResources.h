@@ -0,0 +1,146 @@
+// RtosResources.h
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include "Config.h"
+#include "SystemTypes.h"
+#include "AnomalyDetector.h"
+#include "OneWireTask.h"
+
+// Every task, queue and mutex in the firmware is declared in the tables
+// below and created with the FreeRTOS *Static APIs from storage reserved
+// here, so their worst-case RAM use is fixed at link time and does not
+// depend on heap fragmentation. Adding an object means adding an id and a
+// table row; the static_asserts keep the totals inside RTOS_STATIC_RAM_BUDGET.
+
+enum class TaskId : uint8_t {
+    ONEWIRE = 0,
+    CONTROL,
+    NETWORK,
+    NETWORK_BOOT,
+    MODBUS,
+    BACNET,
+    COAP,
+    BEACON,
+    COUNT
+};
+
+enum class QueueId : uint8_t {
+    ONEWIRE_COMMAND = 0,
+    CONTROL,
+    NETWORK_PUBLISH,
+    NETWORK_CONTROL,
+    NETWORK_EVENT,
+    COUNT
+};
+
+enum class MutexId : uint8_t {
+    PREFERENCES = 0,
+    SYSTEM_HEALTH,
+    AUTH_SESSIONS,
+    BOOT_PROFILER,
+    ONEWIRE_DATA,
+    ONEWIRE_SENSORS,
+    CONTROL_STATE,
+    MQTT_PUBLISH,
+    COUNT
+};
+
+struct TaskSpec {
+    const char* name;
+    uint32_t stackBytes;      // ESP-IDF stack depth is given in bytes
+    UBaseType_t priority;
+    int8_t core;              // Default affinity, TASK_CORE_ANY for none
+};
+
+struct QueueSpec {
+    const char* name;
+    uint16_t length;
+    uint16_t itemSize;
+};
+
+// Rows must follow the enum order
+constexpr TaskSpec TASK_TABLE[] = {
+    {"OneWireTask", ONEWIRE_TASK_STACK_SIZE,      ONEWIRE_TASK_PRIORITY, ONEWIRE_TASK_CORE},
+    {"ControlTask", CONTROL_TASK_STACK_SIZE,      CONTROL_TASK_PRIORITY, CONTROL_TASK_CORE},
+    {"NetworkTask", NETWORK_TASK_STACK_SIZE,      NETWORK_TASK_PRIORITY, NETWORK_TASK_CORE},
+    {"NetBoot",     NETWORK_BOOT_TASK_STACK_SIZE, NETWORK_TASK_PRIORITY, NETWORK_BOOT_TASK_CORE},
+    {"ModbusTask",  MODBUS_TASK_STACK_SIZE,       MODBUS_TASK_PRIORITY,  MODBUS_TASK_CORE},
+    {"BacnetTask",  BACNET_TASK_STACK_SIZE,       BACNET_TASK_PRIORITY,  BACNET_TASK_CORE},
+    {"CoapTask",    COAP_TASK_STACK_SIZE,         COAP_TASK_PRIORITY,    COAP_TASK_CORE},
+    {"BeaconTask",  BEACON_TASK_STACK_SIZE,       BEACON_TASK_PRIORITY,  BEACON_TASK_CORE},
+};
+
+constexpr QueueSpec QUEUE_TABLE[] = {
+    {"ow_cmd",     MAX_PENDING_COMMANDS, sizeof(OneWireTask::CommandHandle)},
+    {"control",    10, sizeof(TaskMessage)},
+    {"net_pub",    20, sizeof(TaskMessage)},
+    {"net_ctrl",   10, sizeof(TaskMessage)},
+    {"net_event",  16, sizeof(AnomalyEvent)},
+};
+
+constexpr const char* MUTEX_NAMES[] = {
+    "prefs", "health", "auth", "boot", "ow_data", "ow_sensors", "control", "mqtt_pub"
+};
+
+constexpr size_t TASK_COUNT = static_cast<size_t>(TaskId::COUNT);
+constexpr size_t QUEUE_COUNT = static_cast<size_t>(QueueId::COUNT);
+constexpr size_t MUTEX_COUNT = static_cast<size_t>(MutexId::COUNT);
+
+static_assert(sizeof(TASK_TABLE) / sizeof(TASK_TABLE[0]) == TASK_COUNT, "TASK_TABLE out of sync with TaskId");
+static_assert(sizeof(QUEUE_TABLE) / sizeof(QUEUE_TABLE[0]) == QUEUE_COUNT, "QUEUE_TABLE out of sync with QueueId");
+static_assert(sizeof(MUTEX_NAMES) / sizeof(MUTEX_NAMES[0]) == MUTEX_COUNT, "MUTEX_NAMES out of sync with MutexId");
+
+namespace RtosBudget {
+    constexpr size_t STACK_ALIGN = 16;
+
+    constexpr size_t stackOffset(size_t index) {
+        return index == 0 ? 0 : stackOffset(index - 1) + TASK_TABLE[index - 1].stackBytes;
+    }
+
+    constexpr size_t queueOffset(size_t index) {
+        return index == 0 ? 0 : queueOffset(index - 1) +
+               static_cast<size_t>(QUEUE_TABLE[index - 1].length) * QUEUE_TABLE[index - 1].itemSize;
+    }
+
+    constexpr bool stacksAligned(size_t index = 0) {
+        return index == TASK_COUNT ||
+               (TASK_TABLE[index].stackBytes % STACK_ALIGN == 0 && stacksAligned(index + 1));
+    }
+
+    constexpr size_t STACK_BYTES = stackOffset(TASK_COUNT);
+    constexpr size_t QUEUE_BYTES = queueOffset(QUEUE_COUNT);
+    constexpr size_t CONTROL_BLOCK_BYTES = TASK_COUNT * sizeof(StaticTask_t) +
+                                           QUEUE_COUNT * sizeof(StaticQueue_t) +
+                                           MUTEX_COUNT * sizeof(StaticSemaphore_t);
+    constexpr size_t TOTAL_BYTES = STACK_BYTES + QUEUE_BYTES + CONTROL_BLOCK_BYTES;
+}
+
+static_assert(RtosBudget::stacksAligned(), "Task stack sizes must be multiples of 16 bytes");
+static_assert(RtosBudget::TOTAL_BYTES <= RTOS_STATIC_RAM_BUDGET, "Static RTOS objects exceed RTOS_STATIC_RAM_BUDGET");
+
+class RtosResources {
+public:
+    // Each object can be created once; a second call returns the existing handle
+    static TaskHandle_t createTask(TaskId id, TaskFunction_t function, void* parameter = nullptr);
+    static QueueHandle_t createQueue(QueueId id);
+    static SemaphoreHandle_t createMutex(MutexId id);
+    
+    // Affinity: the configured core (preference override or table default) and
+    // the core the running task is actually pinned to
+    static int8_t getConfiguredCore(TaskId id);
+    static int8_t getPinnedCore(TaskId id);
+    static TaskId taskIdFromName(const char* name, bool& found);
+
+    // Logs the static budget, per-task stack headroom and the remaining heap
+    static void logBudget();
+
+private:
+    static TaskHandle_t taskHandles[TASK_COUNT];
+    static QueueHandle_t queueHandles[QUEUE_COUNT];
+    static SemaphoreHandle_t mutexHandles[MUTEX_COUNT];
+};
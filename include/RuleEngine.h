@@ -0,0 +1,131 @@
+// RuleEngine.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sensor-driven automation rules.
+//
+// A rule pairs a condition expression with a relay action, e.g.
+//   condition: T(28FF0000000000A1) - T(28FF0000000000B2) > 5
+//   relay 1 on after the condition held for 60 seconds
+//
+// Conditions are compiled once into a compact stack-machine bytecode and
+// re-evaluated only when one of the rule's input sensors changes. The
+// compiler bounds code size and stack depth, so evaluation cost per rule
+// is bounded. This module has no platform dependencies and builds on the
+// host as well as on the ESP32.
+//
+// Expression language:
+//   T(<16 hex ROM>)            sensor temperature in °C
+//   numbers                    12, -3.5, 0.25
+//   + - * /                    arithmetic
+//   > >= < <= == !=            comparisons (1 = true, 0 = false)
+//   && || !                    logic
+//   abs(x) min(a, b) max(a, b) functions
+//   ( )                        grouping
+
+constexpr size_t RULE_MAX_RULES = 8;
+constexpr size_t RULE_MAX_SOURCE = 128;
+constexpr size_t RULE_MAX_CODE = 64;
+constexpr size_t RULE_MAX_STACK = 8;
+constexpr size_t RULE_MAX_NESTING = 8;  // Parentheses, function calls and unary operators
+constexpr size_t RULE_MAX_INPUTS = 4;
+constexpr uint32_t RULE_MAX_HOLD_SECONDS = 7 * 24 * 3600;  // Keeps the hold time in ms within uint32_t
+
+enum class RuleOp : uint8_t {
+    END = 0,
+    CONST,      // followed by 4 byte float
+    INPUT,      // followed by 1 byte input index
+    ADD, SUB, MUL, DIV, NEG,
+    GT, GE, LT, LE, EQ, NE,
+    AND, OR, NOT,
+    ABS, MIN, MAX
+};
+
+struct CompiledRule {
+    uint8_t code[RULE_MAX_CODE];
+    uint8_t codeLength;
+    uint8_t maxStack;
+    uint8_t inputCount;
+    uint8_t inputs[RULE_MAX_INPUTS][8];
+};
+
+struct RuleDefinition {
+    bool enabled;
+    char condition[RULE_MAX_SOURCE];
+    uint8_t relay;            // Relay driven by the rule (0 or 1)
+    bool action;              // Relay state while the rule is active
+    uint32_t holdSeconds;     // Condition must hold this long before acting
+};
+
+struct RuleStats {
+    uint32_t evaluations;     // Number of bytecode evaluations
+    uint32_t triggers;        // Number of rule activations/deactivations
+    uint32_t lastEvalMicros;  // Duration of the last evaluation
+    uint32_t maxEvalMicros;   // Worst-case evaluation duration
+    bool condition;           // Last evaluated condition
+    bool active;              // Whether the rule currently applies its action
+};
+
+class RuleCompiler {
+public:
+    // Compile a condition; on failure a readable message is written to error
+    static bool compile(const char* source, CompiledRule& out, char* error, size_t errorSize);
+
+    // Execute compiled bytecode against the rule's input values
+    static bool evaluate(const CompiledRule& rule, const float* inputs, float& result);
+};
+
+class RuleEngine {
+public:
+    // Called when a rule changes the requested state of a relay
+    typedef void (*ActionHandler)(uint8_t relay, bool state, uint8_t ruleId, void* context);
+    // Microsecond clock used to measure evaluation cost (optional)
+    typedef uint32_t (*MicrosClock)();
+
+    RuleEngine();
+
+    void setClock(MicrosClock clock) { microsClock = clock; }
+    void clear();
+    // Replacing or disabling an active rule queues its reverse action for the
+    // next poll(); an unchanged rule keeps its state, inputs and statistics
+    bool setRule(uint8_t ruleId, const RuleDefinition& definition, char* error, size_t errorSize);
+    bool hasRules() const { return ruleCount > 0; }
+    bool hasPendingReleases() const { return releaseMask != 0; }
+
+    // Feed a sensor reading; only rules depending on a changed input are evaluated
+    void updateSensor(const uint8_t* address, float value, bool valid, uint32_t now);
+
+    // Apply hold timers and report rule transitions
+    void poll(uint32_t now, ActionHandler handler, void* context);
+
+    bool getStats(uint8_t ruleId, RuleStats& stats) const;
+
+private:
+    struct RuleSlot {
+        bool enabled;
+        CompiledRule program;
+        uint8_t relay;
+        bool action;
+        uint32_t holdMs;
+        float values[RULE_MAX_INPUTS];
+        uint8_t validMask;
+        bool condition;
+        uint32_t conditionSince;
+        RuleStats stats;
+    };
+
+    struct Release {
+        uint8_t relay;
+        bool state;
+    };
+
+    RuleSlot rules[RULE_MAX_RULES];
+    Release releases[RULE_MAX_RULES];
+    uint8_t releaseMask;
+    uint8_t ruleCount;
+    MicrosClock microsClock;
+
+    void evaluateRule(RuleSlot& slot, uint32_t now);
+};
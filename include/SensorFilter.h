@@ -0,0 +1,76 @@
+// SensorFilter.h
+#pragma once
+
+#include <stdint.h>
+
+// Per-sensor signal processing chain executed inside the OneWire task.
+// All values are fixed-point in DS18B20 raw units (1/128 °C), so the chain
+// runs without floating point and keeps O(1) state per stage.
+//
+// Stage order: calibration -> median-of-3 -> rate-of-change limit -> smoothing
+
+enum class SmoothingMode : uint8_t {
+    NONE = 0,
+    EMA = 1,
+    KALMAN = 2
+};
+
+// Global chain configuration shared by all sensors
+struct FilterConfig {
+    bool medianEnabled;       // Reject single-sample spikes with a median-of-3
+    SmoothingMode smoothing;  // Smoothing stage selection
+    uint16_t emaAlpha;        // EMA weight of the new sample, Q8 (1..256, 256 = no smoothing)
+    uint32_t kalmanQ;         // Process noise variance, raw units squared
+    uint32_t kalmanR;         // Measurement noise variance, raw units squared
+    uint32_t maxRatePerSec;   // Max change in raw units per second, 0 = unlimited
+};
+
+// Per-sensor calibration: calibrated = raw * gain + offset
+struct SensorCalibration {
+    int32_t offset;           // Offset in raw units (1/128 °C)
+    uint32_t gain;            // Gain in Q16 (65536 = 1.0)
+};
+
+// Running state of the chain for a single sensor
+struct FilterState {
+    int32_t window[3];        // Median-of-3 history (calibrated raw units)
+    uint8_t windowCount;      // Number of valid samples in the window
+    uint8_t windowPos;        // Next write position in the window
+    bool primed;              // Whether the smoothing stages have been seeded
+    int32_t limited;          // Last output of the rate limiter
+    uint32_t lastSampleTime;  // Timestamp of the last processed sample (ms)
+    int32_t smoothed;         // Smoothed value, Q8 raw units
+    uint32_t kalmanP;         // Kalman error covariance, raw units squared
+};
+
+class SensorFilter {
+public:
+    static constexpr int32_t RAW_PER_DEGREE = 128;
+    static constexpr int32_t POWER_ON_RESET_RAW = 85 * RAW_PER_DEGREE;
+    static constexpr uint32_t GAIN_ONE = 65536;
+
+    static FilterConfig defaultConfig();
+    static SensorCalibration defaultCalibration();
+    static void reset(FilterState& state);
+
+    // Run one raw sample through the chain and return the filtered value (raw units)
+    static int32_t process(const FilterConfig& config,
+                           const SensorCalibration& calibration,
+                           FilterState& state,
+                           int32_t raw,
+                           uint32_t now);
+
+    // Conversion helpers between raw units and degrees Celsius
+    static float toCelsius(int32_t raw) { return raw / static_cast<float>(RAW_PER_DEGREE); }
+    static int32_t fromCelsius(float celsius) {
+        float scaled = celsius * RAW_PER_DEGREE;
+        return static_cast<int32_t>(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+
+private:
+    static int32_t applyCalibration(const SensorCalibration& calibration, int32_t raw);
+    static int32_t applyMedian(FilterState& state, int32_t value);
+    static int32_t applyRateLimit(const FilterConfig& config, FilterState& state,
+                                  int32_t value, uint32_t now);
+    static int32_t applySmoothing(const FilterConfig& config, FilterState& state, int32_t value);
+};
@@ -0,0 +1,42 @@
+// SensorSlots.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorTable.h"
+
+// Stable ROM-to-slot assignment for the protocol servers, which expose each
+// sensor at a fixed address (a Modbus register block, a BACnet object
+// instance). A ROM keeps its slot when sensors are added, removed or
+// enumerated in a different order; the owner persists the assignment so it
+// also survives a restart. All-zero entries are free slots.
+//
+// Each refresh is one update pass:
+//   beginUpdate();
+//   markListed(rom) for every listed sensor;   // claims the slots already owned
+//   slotFor(rom) for every listed sensor;      // finds or assigns, -1 if full
+//   if (endUpdate()) persist();
+class SensorSlots {
+public:
+    static constexpr size_t CAPACITY = SENSOR_TABLE_CAPACITY;
+
+    SensorSlots();
+
+    void set(const uint8_t (*addresses)[8], size_t count);
+    size_t get(uint8_t (*addresses)[8], size_t capacity) const;
+
+    void beginUpdate();
+    void markListed(const uint8_t* address);
+    int slotFor(const uint8_t* address);
+    bool endUpdate() const { return assigned; }
+
+    int find(const uint8_t* address) const;
+    bool isListed(size_t slot) const { return slot < CAPACITY && listed[slot]; }
+    bool isFree(size_t slot) const;
+    const uint8_t* address(size_t slot) const { return slots[slot]; }
+
+private:
+    uint8_t slots[CAPACITY][8];
+    bool listed[CAPACITY];
+    bool assigned;
+};
@@ -0,0 +1,56 @@
+// SensorStatistics.h
+#pragma once
+
+#include <stdint.h>
+
+// Streaming per-sensor rollups over tumbling 1 minute / 1 hour / 24 hour
+// windows. Each window keeps a Welford mean/variance accumulator, min/max
+// with timestamps and a sample count, so memory per sensor is constant no
+// matter how many samples a window covers. Timestamps are millis() uptime.
+
+enum class StatsWindow : uint8_t {
+    MINUTE = 0,
+    HOUR = 1,
+    DAY = 2
+};
+
+constexpr uint8_t STATS_WINDOW_COUNT = 3;
+
+struct RollupWindow {
+    uint32_t startTime;       // Window start (ms)
+    uint32_t count;           // Number of samples in the window
+    float mean;               // Welford running mean
+    float m2;                 // Welford sum of squared deviations
+    float min;
+    float max;
+    uint32_t minTime;         // Timestamp of the minimum (ms)
+    uint32_t maxTime;         // Timestamp of the maximum (ms)
+};
+
+struct SensorStatistics {
+    RollupWindow current[STATS_WINDOW_COUNT];    // Windows being accumulated
+    RollupWindow completed[STATS_WINDOW_COUNT];  // Last closed window of each length
+    uint8_t pendingMask;      // Completed windows not yet handed to the publisher
+};
+
+// A completed window handed from the OneWire task to the publisher
+struct RollupReport {
+    uint8_t address[8];
+    StatsWindow window;
+    RollupWindow rollup;
+};
+
+class RollupStats {
+public:
+    static void reset(SensorStatistics& stats);
+
+    // Add a sample; closes any window whose period has elapsed first.
+    // Returns a bitmask of windows completed by this call.
+    static uint8_t addSample(SensorStatistics& stats, float value, uint32_t now);
+
+    static float variance(const RollupWindow& window);
+    static float stddev(const RollupWindow& window);
+
+    static uint32_t windowDuration(StatsWindow window);
+    static const char* windowName(StatsWindow window);  // "1m", "1h", "24h"
+};
@@ -0,0 +1,106 @@
+// SensorTable.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorFilter.h"
+#include "SensorStatistics.h"
+#include "AnomalyDetector.h"
+
+// Sensor storage of OneWireManager as two parallel fixed-size arrays. The hot
+// array holds what the read sweep touches for every sensor on every cycle: ROM,
+// current value, raw reading, timestamp and status flags, 20 bytes per sensor.
+// Calibration, filter, rollup and anomaly state and the probe schedule live in
+// the cold array, which is only touched for the sensor a reading is applied to.
+// Entries are updated in place; nothing is allocated after construction.
+//
+// Physical sensors come first, virtual sensors always follow them.
+
+// Bus health of a physical sensor. A failed reading makes it SUSPECT; after
+// SENSOR_QUARANTINE_AFTER failures in a row it is QUARANTINED: left out of the
+// read sweep, reported offline, and re-probed with an exponential backoff.
+enum class SensorHealth : uint8_t {
+    ACTIVE = 0,
+    SUSPECT,
+    QUARANTINED
+};
+
+// Room for MAX_ONEWIRE_SENSORS plus MAX_VIRTUAL_SENSORS (checked in OneWireManager.cpp)
+constexpr size_t SENSOR_TABLE_CAPACITY = 24;
+
+struct SensorHot {
+    uint8_t address[8];       // ROM
+    float temperature;        // Filtered value, last valid one while invalid (°C)
+    uint32_t readTime;        // millis() of the last good reading, 0 if none
+    int16_t raw;              // Unfiltered bus value (1/128 °C), NO_READING_RAW if none
+    uint8_t flags;            // Health in the low bits, see SensorTable::FLAG_*
+    uint8_t consecutiveErrors;
+};
+
+struct SensorCold {
+    float lastValidReading;   // °C
+    uint32_t nextProbeTime;   // When a quarantined sensor is probed next
+    uint32_t offlineSince;    // When the sensor was quarantined
+    uint8_t resolution;       // Conversion resolution in bits, 0 if unknown
+    uint8_t probeFailures;    // Failed re-probes while quarantined
+    SensorCalibration calibration;
+    FilterState filter;
+    AnomalyState anomaly;
+    SensorStatistics stats;
+};
+
+class SensorTable {
+public:
+    static constexpr uint8_t HEALTH_MASK = 0x03;
+    static constexpr uint8_t FLAG_VALID = 0x04;
+    static constexpr uint8_t FLAG_VIRTUAL = 0x08;
+
+    // Same values as DallasTemperature's DEVICE_DISCONNECTED_RAW / _C
+    static constexpr int16_t NO_READING_RAW = -7040;
+    static constexpr float NO_READING_C = -127.0f;
+
+    SensorTable();
+
+    size_t size() const { return count; }
+    size_t physicalCount() const { return physical; }
+    bool isFull() const { return count >= SENSOR_TABLE_CAPACITY; }
+
+    // Index of the entry with this ROM, -1 if there is none
+    int find(const uint8_t* address) const;
+
+    // Adds a reset entry and returns its index, -1 when the table is full.
+    // Physical entries are inserted ahead of the virtual ones.
+    int add(const uint8_t* address, bool isVirtual);
+
+    // Removes an entry, keeping the order of the others
+    void remove(size_t index);
+    void clear();
+
+    SensorHot& hot(size_t index) { return hotEntries[index]; }
+    const SensorHot& hot(size_t index) const { return hotEntries[index]; }
+    SensorCold& cold(size_t index) { return coldEntries[index]; }
+    const SensorCold& cold(size_t index) const { return coldEntries[index]; }
+
+    static SensorHealth health(const SensorHot& entry) {
+        return static_cast<SensorHealth>(entry.flags & HEALTH_MASK);
+    }
+    static void setHealth(SensorHot& entry, SensorHealth health) {
+        entry.flags = (entry.flags & ~HEALTH_MASK) | static_cast<uint8_t>(health);
+    }
+    static bool isValid(const SensorHot& entry) { return entry.flags & FLAG_VALID; }
+    static void setValid(SensorHot& entry, bool valid) {
+        entry.flags = valid ? (entry.flags | FLAG_VALID) : (entry.flags & ~FLAG_VALID);
+    }
+    static bool isVirtual(const SensorHot& entry) { return entry.flags & FLAG_VIRTUAL; }
+
+private:
+    void reset(size_t index, const uint8_t* address, bool isVirtual);
+    void moveEntry(size_t from, size_t to);
+
+    SensorHot hotEntries[SENSOR_TABLE_CAPACITY];
+    SensorCold coldEntries[SENSOR_TABLE_CAPACITY];
+    size_t count;
+    size_t physical;
+};
+
+static_assert(sizeof(SensorHot) == 20, "SensorHot should stay packed into 20 bytes");
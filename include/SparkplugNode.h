@@ -0,0 +1,115 @@
+// SparkplugNode.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "SensorTable.h"
+#include "FixedString.h"
+#include "SparkplugPayload.h"
+
+// Sparkplug B edge node of the hub, as MqttManager runs it in Sparkplug mode.
+// Topics are spBv1.0/<group>/<type>/<node>[/<device>]:
+//
+//   NBIRTH/NDATA/NDEATH   the hub: bdSeq, Node Control/Rebirth, Relay <n>
+//   DBIRTH/DDATA/DDEATH   one device per sensor, named by its ROM, with
+//                         Temperature, Raw Temperature and Status
+//
+// Births give every metric its name and an alias that is unique within the
+// node; NDATA and DDATA carry only the metrics that changed since the last
+// message, by alias. A temperature without a valid reading is sent as null.
+// seq runs from 0 in NBIRTH across every message of the node. NDEATH is the
+// connection's will and carries the bdSeq of the NBIRTH that follows the
+// connect. A sensor that appears gets a DBIRTH, one that disappears a DDEATH.
+// A Rebirth command or a failed publish births the node and all devices anew.
+//
+// bdSeq counts 1-255 and skips 0: PubSubClient sends the will as a C string,
+// and a zero bdSeq would encode as a NUL byte.
+//
+// Every payload is encoded into one member buffer; nothing is allocated and
+// nothing depends on the platform, so tools/sparkplug_host_node.cpp runs the
+// same code.
+
+constexpr size_t SPARKPLUG_MAX_PAYLOAD = 512;
+constexpr size_t SPARKPLUG_MAX_RELAYS = 8;
+constexpr size_t SPARKPLUG_ID_LENGTH = 32;
+
+// One sensor as handed to update()
+struct SparkplugSensorSample {
+    uint8_t address[8];
+    float temperature;        // Filtered value
+    float rawTemperature;
+    const char* status;       // "online", "offline" or "error", as on the status topic
+    bool valid;
+};
+
+class SparkplugNode {
+public:
+    using Publisher = bool (*)(const char* topic, const uint8_t* payload, size_t length, void* context);
+
+    static constexpr uint64_t REBIRTH_ALIAS = 1;
+
+    SparkplugNode();
+
+    void begin(const char* groupId, const char* nodeId, Publisher publisher, void* context);
+
+    // Will of the next CONNECT. Advances bdSeq; the NBIRTH of that session
+    // carries the same number. The payload is NUL-terminated for PubSubClient.
+    const char* deathTopic() const { return ndeathTopic.c_str(); }
+    size_t prepareDeath(const uint8_t*& payload);
+
+    // The NCMD topic to subscribe to, and its messages
+    const char* commandTopic() const { return ncmdTopic.c_str(); }
+    void handleCommand(const uint8_t* payload, size_t length);
+
+    // A new session needs NBIRTH before anything else
+    void sessionStarted();
+    bool birthPending() const { return rebirth; }
+
+    // Births first when pending, then DBIRTH/DDEATH for sensors that came or
+    // went and NDATA/DDATA with the metrics that changed. timestamp is UTC in
+    // milliseconds. False if a publish failed; everything is born anew then.
+    bool update(const SparkplugSensorSample* sensors, size_t count,
+                const bool* relays, uint8_t relayCount, uint64_t timestamp);
+
+    uint8_t getBdSeq() const { return bdSeq; }
+
+private:
+    // Last values sent for a sensor device
+    struct Device {
+        uint8_t address[8];
+        bool inUse;
+        bool born;
+        bool seen;
+        bool valid;
+        float temperature;
+        float rawTemperature;
+        const char* status;
+    };
+
+    Publisher publisher;
+    void* context;
+    FixedString<SPARKPLUG_ID_LENGTH> groupId;
+    FixedString<SPARKPLUG_ID_LENGTH> nodeId;
+    TopicString ndeathTopic;
+    TopicString ncmdTopic;
+
+    Device devices[SENSOR_TABLE_CAPACITY];
+    bool relayStates[SPARKPLUG_MAX_RELAYS];
+    uint8_t relayCount;
+    uint8_t bdSeq;
+    uint8_t seq;
+    bool rebirth;
+    uint8_t buffer[SPARKPLUG_MAX_PAYLOAD];
+
+    TopicString topic(const char* type, const uint8_t* address) const;
+    bool send(const char* type, const uint8_t* address, const SparkplugPayload& payload);
+    uint8_t nextSeq();
+
+    bool publishNodeBirth(const bool* relays, uint8_t count, uint64_t timestamp);
+    bool publishNodeData(const bool* relays, uint8_t count, uint64_t timestamp);
+    bool publishDeviceBirth(Device& device, const SparkplugSensorSample& sample, uint64_t timestamp);
+    bool publishDeviceData(Device& device, const SparkplugSensorSample& sample, uint64_t timestamp);
+    bool publishDeviceDeath(Device& device, uint64_t timestamp);
+    Device* findDevice(const uint8_t* address, bool allocate);
+    static uint64_t deviceAlias(size_t slot, uint8_t metric);
+};
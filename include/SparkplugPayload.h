@@ -0,0 +1,61 @@
+// SparkplugPayload.h
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Metric data types used by the hub (DataType in sparkplug_b.proto)
+enum class SparkplugType : uint8_t {
+    INT64 = 4,
+    FLOAT = 9,
+    BOOLEAN = 11,
+    STRING = 12
+};
+
+// One metric of a Sparkplug payload. Births give name and alias; data
+// messages give the alias alone.
+struct SparkplugMetric {
+    const char* name;         // nullptr to refer by alias only
+    uint64_t alias;           // 0 for none
+    SparkplugType type;
+    bool isNull;              // No value, e.g. a sensor without a valid reading
+    float floatValue;
+    bool boolValue;
+    int64_t longValue;
+    const char* stringValue;
+};
+
+// Hand-rolled protobuf encoding of the Sparkplug B Payload message into a
+// caller-provided buffer, with just the fields the hub sends: the payload
+// timestamp, the metrics (name, alias, datatype, is_null and one value) and
+// seq. Each metric is written in place with a one-byte length that is widened
+// afterwards if the metric turns out longer, so nothing is measured twice and
+// nothing is allocated. Writes that do not fit set overflowed() and are
+// dropped, as in CborWriter.
+class SparkplugPayload {
+public:
+    SparkplugPayload(uint8_t* buffer, size_t capacity);
+
+    void addTimestamp(uint64_t milliseconds);
+    void addMetric(const SparkplugMetric& metric);
+    void addSeq(uint64_t seq);
+
+    const uint8_t* data() const { return buffer; }
+    size_t size() const { return length; }
+    bool overflowed() const { return overflow; }
+
+    // True if an NCMD payload sets Node Control/Rebirth, by name or by
+    // rebirthAlias, to true. Unknown fields are skipped.
+    static bool requestsRebirth(const uint8_t* payload, size_t length, uint64_t rebirthAlias);
+
+private:
+    bool reserve(size_t count);
+    void writeVarint(uint64_t value);
+    void writeTag(uint8_t field, uint8_t wireType);
+    void writeString(uint8_t field, const char* text);
+
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+};
@@ -8,13 +8,21 @@
 #include <freertos/task.h>
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
+#include "SensorFilter.h"
+#include "SensorStatistics.h"
+#include "AnomalyDetector.h"
+#include "SensorTable.h"
+#include "PayloadEncoding.h"
 
 // Message types for inter-task communication
 enum class MessageType : uint8_t {
     RELAY_CHANGE_REQUEST,
     TEMPERATURE_UPDATE,
     SENSOR_SCAN_REQUEST,
-    MQTT_PUBLISH
+    MQTT_PUBLISH,
+    CONTROL_CONFIG_UPDATE,
+    DISPLAY_CONFIG_UPDATE,
+    RULES_UPDATE
 };
 
 // MQTT message structure
@@ -75,6 +83,80 @@ enum class DisplayMode : uint8_t {
     OFF = 3
 };
 
+// Display playlist entry: a sensor (physical or virtual), an optional short
+// label shown before the value, and how long the value stays on screen
+constexpr uint8_t MAX_PLAYLIST_ENTRIES = 8;
+constexpr uint8_t PLAYLIST_LABEL_LENGTH = 4;
+
+struct DisplayPlaylistEntry {
+    uint8_t address[8];
+    char label[PLAYLIST_LABEL_LENGTH + 1];
+    uint16_t dwellSeconds;
+};
+
+// Last known state of a physical sensor, kept across resets for warm start
+struct WarmStartRecord {
+    uint8_t address[8];
+    int16_t raw;              // Last raw reading (1/128 °C), before calibration
+    uint8_t resolution;       // Configured resolution in bits, 0 if unknown
+    uint8_t valid;            // Whether raw holds a good reading
+    uint32_t readTime;        // Uptime of the reading in the boot that took it (ms)
+};
+
+// Modbus TCP server settings; applied at the next restart
+struct ModbusConfig {
+    bool enabled;
+    uint16_t port;
+    bool allowWrites;         // Let clients switch relays through coils
+};
+
+// BACnet/IP device settings; applied at the next restart
+struct BacnetConfig {
+    bool enabled;
+    uint16_t port;
+    uint32_t deviceInstance;  // 0 derives one from the MAC address
+    float covIncrement;       // Analog Input COV_Increment in °C
+};
+
+// CoAP endpoint settings; applied at the next restart
+struct CoapConfig {
+    bool enabled;
+    uint16_t port;
+};
+
+// Multicast telemetry beacon settings; applied at the next restart
+struct BeaconConfig {
+    bool enabled;
+    uint32_t group;     // IPv4 multicast group, a.b.c.d as 0xaabbccdd
+    uint16_t port;
+    uint8_t ttl;
+};
+
+// Payload format of each MQTT topic class; applied at the next restart
+struct MqttFormatConfig {
+    PayloadFormat sensors;    // sensors/<id>/temperature, raw, status, last_update
+    PayloadFormat relays;     // relay/<n>/state, availability
+    PayloadFormat stats;      // <sensor>/stats/<window> rollups
+};
+
+// MQTT client backend (see MqttTransport); applied at the next restart
+enum class MqttBackend : uint8_t {
+    ESP_MQTT = 0,     // Event-driven esp-mqtt, QoS 1 with an in-flight window
+    PUBSUBCLIENT      // Polled PubSubClient, QoS 0
+};
+
+// MQTT protocol version; 5 needs the esp-mqtt backend. Applied at the next restart
+enum class MqttProtocol : uint8_t {
+    V3_1_1 = 0,
+    V5                // Topic aliases, message expiry, unit properties, session resumption
+};
+
+// Sparkplug B mode; applied at the next restart
+struct SparkplugConfig {
+    bool enabled;
+    char group[SPARKPLUG_GROUP_LENGTH + 1];   // Group id; the edge node id is DEVICE_ID
+};
+
 // Temperature scale enumeration
 enum class TemperatureScale : uint8_t {
     CELSIUS = 0,
@@ -82,16 +164,23 @@ enum class TemperatureScale : uint8_t {
     KELVIN = 2
 };
 
-// Temperature sensor data structure
+// Snapshot of one sensor as handed to consumers by OneWireManager::getSensorList().
+// The manager itself keeps sensors in a SensorTable.
 struct TemperatureSensor {
     uint8_t address[8];                              // Sensor's unique address
-    char friendlyName[MAX_FRIENDLY_NAME_LENGTH];     // Human-readable name
-    float temperature;                               // Current temperature reading
+    float temperature;                               // Current (filtered) temperature reading
+    float rawTemperature;                            // Unfiltered reading from the bus
     float lastValidReading;                         // Last known good reading
     uint32_t lastReadTime;                          // Timestamp of last reading
     uint8_t consecutiveErrors;                      // Error tracking
-    bool isActive;                                  // Whether sensor is currently responding
+    SensorHealth health;                            // Whether sensor is currently responding
+    uint8_t probeFailures;                          // Failed re-probes while quarantined
+    uint32_t nextProbeTime;                         // When a quarantined sensor is probed next
+    uint32_t offlineSince;                          // When the sensor was quarantined
     bool valid;                                     // Whether current reading is valid
+    uint8_t resolution;                             // Conversion resolution in bits
+    uint8_t anomalyMask;                            // Active AnomalyType bits
+    SensorCalibration calibration;                  // Per-sensor calibration
 };
 
 // Sensor data structure
@@ -100,7 +189,6 @@ struct SensorData {
     SensorType type;
     uint32_t timestamp;
     DeviceStatus status;
-    char friendlyName[MAX_FRIENDLY_NAME_LENGTH];
 };
 
 // System status structure
@@ -0,0 +1,53 @@
+// TelemetryBeacon.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorTable.h"
+
+// Binary telemetry datagram multicast by the beacon task after every read
+// cycle, for LAN displays and loggers that need neither a broker nor an HTTP
+// session. All integers are big-endian.
+//
+// Header, 16 bytes:
+//   0   'S' 'H'         magic
+//   2   version         TELEMETRY_BEACON_VERSION
+//   3   sensor count
+//   4   sequence        uint32, +1 per datagram, 0 after a restart
+//   8   collected at    uint32, device millis() when the read cycle completed
+//   12  send delay      uint16, ms from the end of the read cycle to the send
+//   14  relays          bit n set while relay n is on
+//   15  flags           BEACON_FLAG_*
+//
+// Then one 11-byte record per sensor, physical sensors first:
+//   0   ROM             8 bytes
+//   8   raw             int16, 1/128 °C as read from the bus (filtered value
+//                       for virtual sensors), -7040 when there is no reading
+//   10  status          SensorHot flags: health in bits 0-1, valid 0x04,
+//                       virtual 0x08
+//
+// A receiver counts gaps in the sequence as lost datagrams.
+// tools/beacon_receiver.py decodes the format.
+
+constexpr uint8_t TELEMETRY_BEACON_VERSION = 1;
+constexpr size_t BEACON_HEADER_SIZE = 16;
+constexpr size_t BEACON_SENSOR_RECORD_SIZE = 11;
+constexpr size_t BEACON_MAX_DATAGRAM = BEACON_HEADER_SIZE + SENSOR_TABLE_CAPACITY * BEACON_SENSOR_RECORD_SIZE;
+
+constexpr uint8_t BEACON_FLAG_RESTART = 0x01;   // First datagram since boot
+
+struct BeaconHeader {
+    uint32_t sequence;
+    uint32_t collectedAt;
+    uint16_t sendDelay;
+    uint8_t relayBits;
+    uint8_t flags;
+};
+
+class TelemetryBeacon {
+public:
+    // Writes the datagram for these sensors to out and returns its length, or
+    // 0 if it does not fit. Sensors beyond 255 are left out.
+    static size_t encode(const BeaconHeader& header, const SensorHot* sensors, size_t count,
+                         uint8_t* out, size_t capacity);
+};
@@ -0,0 +1,74 @@
+// ThermostatController.h
+#pragma once
+
+#include <stdint.h>
+
+// Closed-loop control of a single relay from a single sensor.
+// The controller is pure logic: ControlTask feeds it readings and relay
+// state and applies the returned demand to the hardware.
+
+enum class ControlMode : uint8_t {
+    OFF = 0,         // Relay is controlled manually (API/MQTT)
+    HYSTERESIS = 1,  // On/off thermostat with a dead band
+    PID = 2          // PID with time-proportioned relay output
+};
+
+struct ControlLoopConfig {
+    ControlMode mode;
+    uint8_t sensorAddress[8];  // ROM of the input sensor
+    float setpoint;            // Target temperature (°C)
+    float hysteresis;          // Dead band width for HYSTERESIS mode (°C)
+    bool cooling;              // Relay drives a cooler: on above setpoint
+    float kp;                  // PID gains, output is a 0..1 duty cycle
+    float ki;                  // per second
+    float kd;                  // seconds
+    uint32_t pidWindowMs;      // Time-proportioning window for PID mode
+    uint32_t minOnMs;          // Minimum time the relay stays on
+    uint32_t minOffMs;         // Minimum time the relay stays off
+};
+
+struct ControlLoopStats {
+    uint32_t evaluations;      // Number of evaluations on new readings
+    uint32_t actuations;       // Number of relay changes made by the loop
+    uint32_t lastEvalMicros;   // Duration of the last evaluation
+    uint32_t maxEvalMicros;    // Worst-case evaluation duration
+    uint32_t lastEvalTime;     // millis() of the last evaluation
+    float lastInput;           // Last sensor value used
+    float output;              // Current output (0/1 or PID duty cycle)
+    bool inputValid;           // Whether the last input was valid
+    bool demand;               // Relay state requested by the loop
+};
+
+class ThermostatController {
+public:
+    ThermostatController();
+
+    void configure(const ControlLoopConfig& config);
+    const ControlLoopConfig& getConfig() const { return config; }
+    // True when configure(candidate) would leave the configuration unchanged
+    bool hasConfig(const ControlLoopConfig& candidate) const;
+    bool isActive() const { return config.mode != ControlMode::OFF; }
+    float getOutput() const { return output; }
+
+    // Feed a new sensor reading; recomputes the loop output
+    void updateInput(float input, bool valid, uint32_t now);
+
+    // Decide the relay state for the current time, honouring minimum on/off times.
+    // Cheap enough to be called on every ControlTask tick.
+    bool computeDemand(bool relayOn, uint32_t relayChangedAt, uint32_t now);
+
+    static ControlLoopConfig defaultConfig();
+
+private:
+    ControlLoopConfig config;
+    bool hysteresisState;
+    float integral;
+    float previousInput;
+    uint32_t previousTime;
+    bool havePrevious;
+    float output;
+    bool inputValid;
+
+    void updateHysteresis(float input);
+    void updatePid(float input, uint32_t now);
+};
@@ -0,0 +1,76 @@
+// VirtualSensors.h
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Derived sensors computed from physical sensor readings (mean, min, max,
+// difference, weighted sum over a list of ROMs). Aggregates are updated
+// incrementally whenever one of their inputs changes, and each virtual
+// sensor is published under a synthetic ROM so consumers treat it like a
+// physical sensor.
+
+constexpr size_t MAX_VIRTUAL_SENSORS = 4;
+constexpr size_t MAX_VIRTUAL_INPUTS = 8;
+constexpr uint8_t VIRTUAL_SENSOR_FAMILY = 0xFE;  // Not assigned to any 1-Wire device family
+
+enum class VirtualSensorType : uint8_t {
+    MEAN = 0,
+    MIN = 1,
+    MAX = 2,
+    DIFFERENCE = 3,    // inputs[0] - inputs[1]
+    WEIGHTED_SUM = 4
+};
+
+struct VirtualSensorDefinition {
+    bool enabled;
+    VirtualSensorType type;
+    uint8_t inputCount;
+    uint8_t inputs[MAX_VIRTUAL_INPUTS][8];
+    float weights[MAX_VIRTUAL_INPUTS];
+};
+
+class VirtualSensorSet {
+public:
+    VirtualSensorSet();
+
+    void clear();
+    bool configure(uint8_t index, const VirtualSensorDefinition& definition);
+    bool isEnabled(uint8_t index) const;
+    const VirtualSensorDefinition& getDefinition(uint8_t index) const { return slots[index].definition; }
+
+    // Feed a physical reading; returns true if any virtual sensor changed
+    bool updateInput(const uint8_t* address, float value, bool valid);
+
+    // Current value of a virtual sensor
+    bool getValue(uint8_t index, float& value) const;
+
+    static void makeAddress(uint8_t index, uint8_t* address);
+    static bool isVirtualAddress(const uint8_t* address);
+
+    static const char* typeToString(VirtualSensorType type);
+    static bool typeFromString(const char* name, VirtualSensorType& type);
+
+private:
+    struct Slot {
+        VirtualSensorDefinition definition;
+        float values[MAX_VIRTUAL_INPUTS];
+        uint8_t validMask;
+        uint8_t validCount;
+        float weightedSum;       // Running sum for MEAN and WEIGHTED_SUM
+        float weightTotal;       // Sum of weights of valid inputs
+        uint8_t extremeIndex;    // Input holding the current MIN/MAX
+        uint16_t updatesSinceResync;
+        bool valid;
+        float value;
+    };
+
+    static constexpr uint16_t RESYNC_INTERVAL = 256;
+
+    Slot slots[MAX_VIRTUAL_SENSORS];
+
+    void applyInput(Slot& slot, uint8_t input, float value, bool valid);
+    void recomputeExtreme(Slot& slot);
+    void resync(Slot& slot);
+    void updateOutput(Slot& slot);
+};
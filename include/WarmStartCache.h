@@ -0,0 +1,46 @@
+// WarmStartCache.h
+#pragma once
+
+#include <Arduino.h>
+#include "SystemTypes.h"
+#include "Config.h"
+
+// Keeps the last known sensor list and readings across resets. Every
+// collection updates a copy in RTC slow memory, which survives software
+// resets, panics and watchdog resets. A copy in NVS survives power loss; it
+// is rewritten when the set of sensors changes and otherwise only every
+// WARM_START_NVS_INTERVAL to limit flash wear.
+class WarmStartCache {
+public:
+    enum class Source : uint8_t {
+        NONE = 0,
+        RTC = 1,
+        NVS = 2
+    };
+
+    // Load the freshest copy available; RTC memory is preferred over NVS
+    static uint8_t load(WarmStartRecord* records, uint8_t maxCount, Source& source);
+
+    // Store the current state; NVS is only written when due
+    static void save(const WarmStartRecord* records, uint8_t count, uint32_t now);
+
+    static const char* sourceToString(Source source);
+
+private:
+    static constexpr uint32_t RTC_MAGIC = 0x57534331;  // "WSC1"
+
+    struct RtcImage {
+        uint32_t magic;
+        uint8_t count;
+        WarmStartRecord records[MAX_ONEWIRE_SENSORS];
+        uint32_t crc;
+    };
+
+    static RtcImage rtcImage;
+    static uint32_t lastNvsSave;
+    static uint8_t nvsCount;
+    static uint8_t nvsAddresses[MAX_ONEWIRE_SENSORS][8];
+
+    static uint32_t imageCrc(const RtcImage& image);
+    static bool sameSensorSet(const WarmStartRecord* records, uint8_t count);
+};
@@ -14,9 +14,13 @@ class WebServer {
 public:
     WebServer(OneWireManager& owManager);
     void begin();
+    
+    // Push an event to connected /api/events (Server-Sent Events) clients
+    void pushEvent(const char* event, const char* data);
 
 private:
     AsyncWebServer server;
+    AsyncEventSource events;
     OneWireManager& oneWireManager;
     PreferencesApiHandler preferencesHandler;
 
@@ -32,15 +36,32 @@ private:
     void handleLogoutRequest(AsyncWebServerRequest* request);
     void handleRelayRequest(AsyncWebServerRequest* request);
     void handleRelayControlRequest(AsyncWebServerRequest* request, JsonVariant& json);
+    void handleControlStatusRequest(AsyncWebServerRequest* request);
+    void handleRulesRequest(AsyncWebServerRequest* request);
+    void handleRulesUpdateRequest(AsyncWebServerRequest* request, JsonVariant& json);
+    void handleStatsRequest(AsyncWebServerRequest* request);
+    void handleBootRequest(AsyncWebServerRequest* request);
+    void handleBenchmarkRequest(AsyncWebServerRequest* request);
+    void handleBenchmarkStartRequest(AsyncWebServerRequest* request, JsonVariant& json);
+    void handleScanRequest(AsyncWebServerRequest* request);
+    void handleReadRequest(AsyncWebServerRequest* request, JsonVariant& json);
+    void handleCommandRequest(AsyncWebServerRequest* request);
     
     // Authentication helpers
     bool isAuthenticatedRequest(AsyncWebServerRequest* request);
-    static String extractToken(AsyncWebServerRequest* request);
+    static AuthManager::SessionToken extractToken(AsyncWebServerRequest* request);
+    
+    // Binary responses, for clients whose Accept header asks for CBOR or MessagePack
+    static PayloadFormat acceptedFormat(AsyncWebServerRequest* request);
+    void sendEncodedSensors(AsyncWebServerRequest* request, const std::vector<TemperatureSensor>& sensors,
+                            PayloadFormat format);
+    void sendEncodedRelays(AsyncWebServerRequest* request, PayloadFormat format);
 
     // Helper methods
     JsonObject createSensorJson(JsonArray& array, const TemperatureSensor& sensor);
     void sendErrorResponse(AsyncWebServerRequest* request, int code, const String& message);
     void sendJsonResponse(AsyncWebServerRequest* request, const String& json);
-    static String addressToString(const uint8_t* address);
+    static void addRollupToJson(JsonObject& obj, const RollupWindow& rollup);
+    static void sendCommandAccepted(AsyncWebServerRequest* request, uint32_t handle);
     static void stringToAddress(const char* str, uint8_t* address);
 };
\ No newline at end of file
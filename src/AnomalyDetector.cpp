@@ -0,0 +1,98 @@
+// AnomalyDetector.cpp
+// Edge detection of rate-of-change, flatline and z-score anomalies.
+
+#include "AnomalyDetector.h"
+#include <math.h>
+#include <string.h>
+
+AnomalyConfig AnomalyDetector::defaultConfig() {
+    AnomalyConfig config;
+    config.maxRatePerMin = 0.0f;
+    config.flatlineCycles = 0;
+    config.zScoreThreshold = 0.0f;
+    config.zScoreWindow = 60;
+    return config;
+}
+
+void AnomalyDetector::reset(AnomalyState& state) {
+    memset(&state, 0, sizeof(state));
+}
+
+static void reportTransition(AnomalyState& state, AnomalyType type, bool active,
+                             float value, float metric, uint32_t now,
+                             AnomalyEvent* events, size_t& count) {
+    uint8_t bit = static_cast<uint8_t>(type);
+    bool wasActive = (state.activeMask & bit) != 0;
+    if (active == wasActive) return;
+
+    state.activeMask = active ? (state.activeMask | bit) : (state.activeMask & ~bit);
+
+    AnomalyEvent& event = events[count++];
+    memset(event.address, 0, sizeof(event.address));
+    event.type = type;
+    event.raised = active;
+    event.value = value;
+    event.metric = metric;
+    event.timestamp = now;
+}
+
+size_t AnomalyDetector::process(const AnomalyConfig& config, AnomalyState& state,
+                                float value, int32_t raw, uint32_t now,
+                                AnomalyEvent* events) {
+    size_t count = 0;
+
+    // Rate of change against the previous reading
+    if (config.maxRatePerMin > 0.0f && state.havePrevious && now != state.lastTime) {
+        float rate = (value - state.lastValue) * 60000.0f / (now - state.lastTime);
+        reportTransition(state, AnomalyType::RATE, fabsf(rate) > config.maxRatePerMin,
+                         value, rate, now, events, count);
+    }
+
+    // Flatline: a live sensor's raw value eventually moves by at least one LSB
+    if (state.havePrevious && raw == state.lastRaw) {
+        if (state.flatlineCount < UINT16_MAX) state.flatlineCount++;
+    } else {
+        state.flatlineCount = 0;
+    }
+    if (config.flatlineCycles > 0) {
+        reportTransition(state, AnomalyType::FLATLINE, state.flatlineCount >= config.flatlineCycles,
+                         value, state.flatlineCount, now, events, count);
+    }
+
+    // Z-score against the baseline before this sample is folded in
+    uint16_t window = config.zScoreWindow > 1 ? config.zScoreWindow : 2;
+    if (config.zScoreThreshold > 0.0f && state.samples >= window) {
+        float stddev = fmaxf(sqrtf(state.variance), MIN_STDDEV);
+        float z = (value - state.mean) / stddev;
+        reportTransition(state, AnomalyType::ZSCORE, fabsf(z) > config.zScoreThreshold,
+                         value, z, now, events, count);
+    }
+
+    // Exponentially weighted mean/variance update
+    if (state.samples == 0) {
+        state.mean = value;
+        state.variance = 0.0f;
+    } else {
+        float alpha = 1.0f / (state.samples < window ? state.samples + 1 : window);
+        float diff = value - state.mean;
+        float increment = alpha * diff;
+        state.mean += increment;
+        state.variance = (1.0f - alpha) * (state.variance + diff * increment);
+    }
+    if (state.samples < window) state.samples++;
+
+    state.havePrevious = true;
+    state.lastValue = value;
+    state.lastTime = now;
+    state.lastRaw = raw;
+    return count;
+}
+
+const char* AnomalyDetector::typeToString(AnomalyType type) {
+    switch (type) {
+        case AnomalyType::RATE:     return "rate";
+        case AnomalyType::FLATLINE: return "flatline";
+        case AnomalyType::ZSCORE:   return "zscore";
+        default:                    return "unknown";
+    }
+}
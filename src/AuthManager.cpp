@@ -1,5 +1,6 @@
 #include "AuthManager.h"
 #include <esp_random.h>
+#include "RtosResources.h"
 
 // Static member initialization
 std::vector<AuthManager::Session> AuthManager::activeSessions;
@@ -25,7 +26,7 @@ void AuthManager::init() {
     
     // Create mutex if it doesn't exist
     if (!sessionMutex) {
-        sessionMutex = xSemaphoreCreateMutex();
+        sessionMutex = RtosResources::createMutex(MutexId::AUTH_SESSIONS);
         if (!sessionMutex) {
             Logger::error("Failed to create session mutex");
             return;
@@ -146,8 +147,8 @@ String AuthManager::createSession(const String& username) {
     return token;
 }
 
-bool AuthManager::validateSession(const String& token) {
-    if (token.length() != SESSION_TOKEN_LENGTH) {
+bool AuthManager::validateSession(const char* token) {
+    if (!token || strlen(token) != SESSION_TOKEN_LENGTH) {
         return false;
     }
     
@@ -166,7 +167,8 @@ bool AuthManager::validateSession(const String& token) {
     return valid;
 }
 
-void AuthManager::revokeSession(const String& token) {
+void AuthManager::revokeSession(const char* token) {
+    if (!token) return;
     if (xSemaphoreTake(sessionMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
         auto it = std::remove_if(activeSessions.begin(), activeSessions.end(),
             [&token](const Session& session) {
@@ -0,0 +1,1321 @@
+// BacnetDevice.cpp
+// BACnet/IP (ASHRAE 135 Annex J) device of the hub. Frames are decoded and
+// answered in caller-provided and member buffers; nothing here allocates or
+// depends on the platform, so the same code runs in tools/bacnet_host_server.cpp.
+
+#include "BacnetDevice.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+    // BVLC
+    constexpr uint8_t BVLC_TYPE = 0x81;
+    constexpr uint8_t BVLC_FORWARDED_NPDU = 0x04;
+    constexpr uint8_t BVLC_UNICAST_NPDU = 0x0A;
+    constexpr uint8_t BVLC_BROADCAST_NPDU = 0x0B;
+
+    // NPDU control
+    constexpr uint8_t NPDU_VERSION = 0x01;
+    constexpr uint8_t NPDU_NETWORK_MESSAGE = 0x80;
+    constexpr uint8_t NPDU_DESTINATION = 0x20;
+    constexpr uint8_t NPDU_SOURCE = 0x08;
+    constexpr uint8_t NPDU_EXPECTING_REPLY = 0x04;
+    constexpr uint16_t GLOBAL_BROADCAST_NETWORK = 0xFFFF;
+
+    // APDU
+    constexpr uint8_t PDU_CONFIRMED_REQUEST = 0x00;
+    constexpr uint8_t PDU_UNCONFIRMED_REQUEST = 0x10;
+    constexpr uint8_t PDU_SIMPLE_ACK = 0x20;
+    constexpr uint8_t PDU_COMPLEX_ACK = 0x30;
+    constexpr uint8_t PDU_ERROR = 0x50;
+    constexpr uint8_t PDU_REJECT = 0x60;
+    constexpr uint8_t PDU_ABORT_FROM_SERVER = 0x71;
+    constexpr uint8_t PDU_SEGMENTED_MESSAGE = 0x08;
+    constexpr uint8_t MAX_APDU_1476 = 0x05;
+
+    constexpr uint8_t SERVICE_CONFIRMED_COV_NOTIFICATION = 1;
+    constexpr uint8_t SERVICE_SUBSCRIBE_COV = 5;
+    constexpr uint8_t SERVICE_READ_PROPERTY = 12;
+    constexpr uint8_t SERVICE_READ_PROPERTY_MULTIPLE = 14;
+    constexpr uint8_t SERVICE_I_AM = 0;
+    constexpr uint8_t SERVICE_UNCONFIRMED_COV_NOTIFICATION = 2;
+    constexpr uint8_t SERVICE_WHO_IS = 8;
+
+    constexpr uint8_t REJECT_INVALID_TAG = 4;
+    constexpr uint8_t REJECT_MISSING_REQUIRED_PARAMETER = 5;
+    constexpr uint8_t REJECT_TOO_MANY_ARGUMENTS = 7;
+    constexpr uint8_t REJECT_UNRECOGNIZED_SERVICE = 9;
+    constexpr uint8_t ABORT_SEGMENTATION_NOT_SUPPORTED = 4;
+
+    constexpr uint8_t ERROR_CLASS_OBJECT = 1;
+    constexpr uint8_t ERROR_CLASS_PROPERTY = 2;
+    constexpr uint8_t ERROR_CLASS_RESOURCES = 3;
+    constexpr uint8_t ERROR_CLASS_SERVICES = 5;
+    constexpr uint8_t ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT = 19;
+    constexpr uint8_t ERROR_CODE_UNKNOWN_OBJECT = 31;
+    constexpr uint8_t ERROR_CODE_UNKNOWN_PROPERTY = 32;
+    constexpr uint8_t ERROR_CODE_VALUE_OUT_OF_RANGE = 37;
+    constexpr uint8_t ERROR_CODE_INVALID_ARRAY_INDEX = 42;
+    constexpr uint8_t ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED = 45;
+    constexpr uint8_t ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY = 50;
+
+    constexpr uint16_t OBJECT_ANALOG_INPUT = 0;
+    constexpr uint16_t OBJECT_BINARY_OUTPUT = 4;
+    constexpr uint16_t OBJECT_DEVICE = 8;
+
+    enum Property : uint32_t {
+        PROP_ALL = 8,
+        PROP_APDU_TIMEOUT = 11,
+        PROP_APPLICATION_SOFTWARE_VERSION = 12,
+        PROP_COV_INCREMENT = 22,
+        PROP_DESCRIPTION = 28,
+        PROP_DEVICE_ADDRESS_BINDING = 30,
+        PROP_EVENT_STATE = 36,
+        PROP_FIRMWARE_REVISION = 44,
+        PROP_MAX_APDU_LENGTH_ACCEPTED = 62,
+        PROP_MODEL_NAME = 70,
+        PROP_NUMBER_OF_APDU_RETRIES = 73,
+        PROP_OBJECT_IDENTIFIER = 75,
+        PROP_OBJECT_LIST = 76,
+        PROP_OBJECT_NAME = 77,
+        PROP_OBJECT_TYPE = 79,
+        PROP_OPTIONAL = 80,
+        PROP_OUT_OF_SERVICE = 81,
+        PROP_POLARITY = 84,
+        PROP_PRESENT_VALUE = 85,
+        PROP_PRIORITY_ARRAY = 87,
+        PROP_PROTOCOL_OBJECT_TYPES_SUPPORTED = 96,
+        PROP_PROTOCOL_SERVICES_SUPPORTED = 97,
+        PROP_PROTOCOL_VERSION = 98,
+        PROP_RELIABILITY = 103,
+        PROP_RELINQUISH_DEFAULT = 104,
+        PROP_REQUIRED = 105,
+        PROP_SEGMENTATION_SUPPORTED = 107,
+        PROP_STATUS_FLAGS = 111,
+        PROP_SYSTEM_STATUS = 112,
+        PROP_UNITS = 117,
+        PROP_VENDOR_IDENTIFIER = 120,
+        PROP_VENDOR_NAME = 121,
+        PROP_PROTOCOL_REVISION = 139,
+        PROP_DATABASE_REVISION = 155,
+        PROP_PROPERTY_LIST = 371
+    };
+
+    constexpr uint8_t RELIABILITY_NO_FAULT_DETECTED = 0;
+    constexpr uint8_t RELIABILITY_NO_SENSOR = 1;
+    constexpr uint8_t RELIABILITY_UNRELIABLE_OTHER = 7;
+    constexpr uint8_t RELIABILITY_COMMUNICATION_FAILURE = 12;
+
+    constexpr uint8_t EVENT_STATE_NORMAL = 0;
+    constexpr uint8_t EVENT_STATE_OFFNORMAL = 2;
+
+    // BACnetStatusFlags as encoded: in-alarm, fault, overridden, out-of-service
+    constexpr uint8_t STATUS_IN_ALARM = 0x80;
+    constexpr uint8_t STATUS_FAULT = 0x40;
+
+    constexpr uint32_t PROTOCOL_REVISION = 14;
+    constexpr uint8_t SEGMENTATION_NONE = 3;
+    constexpr uint8_t SYSTEM_STATUS_OPERATIONAL = 0;
+    constexpr uint8_t UNITS_DEGREES_CELSIUS = 62;
+    constexpr uint32_t APDU_TIMEOUT_MS = 3000;
+    constexpr uint8_t PRIORITY_LEVELS = 16;
+
+    // Lifetimes are kept in millis(); longer ones would wrap
+    constexpr uint32_t MAX_COV_LIFETIME = 2000000;
+
+    // Services executed: subscribeCOV (5), readProperty (12),
+    // readPropertyMultiple (14), who-Is (34)
+    constexpr uint8_t SERVICES_SUPPORTED[] = {0x04, 0x0A, 0x00, 0x00, 0x20};
+    constexpr uint8_t SERVICES_SUPPORTED_BITS = 40;
+
+    // Object types: analog-input (0), binary-output (4), device (8)
+    constexpr uint8_t OBJECT_TYPES_SUPPORTED[] = {0x88, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00};
+    constexpr uint8_t OBJECT_TYPES_SUPPORTED_BITS = 56;
+
+    const uint32_t DEVICE_REQUIRED[] = {
+        PROP_OBJECT_IDENTIFIER, PROP_OBJECT_NAME, PROP_OBJECT_TYPE, PROP_SYSTEM_STATUS,
+        PROP_VENDOR_NAME, PROP_VENDOR_IDENTIFIER, PROP_MODEL_NAME, PROP_FIRMWARE_REVISION,
+        PROP_APPLICATION_SOFTWARE_VERSION, PROP_PROTOCOL_VERSION, PROP_PROTOCOL_REVISION,
+        PROP_PROTOCOL_SERVICES_SUPPORTED, PROP_PROTOCOL_OBJECT_TYPES_SUPPORTED, PROP_OBJECT_LIST,
+        PROP_MAX_APDU_LENGTH_ACCEPTED, PROP_SEGMENTATION_SUPPORTED, PROP_APDU_TIMEOUT,
+        PROP_NUMBER_OF_APDU_RETRIES, PROP_DEVICE_ADDRESS_BINDING, PROP_DATABASE_REVISION,
+        PROP_PROPERTY_LIST
+    };
+
+    const uint32_t ANALOG_INPUT_REQUIRED[] = {
+        PROP_OBJECT_IDENTIFIER, PROP_OBJECT_NAME, PROP_OBJECT_TYPE, PROP_PRESENT_VALUE,
+        PROP_STATUS_FLAGS, PROP_EVENT_STATE, PROP_OUT_OF_SERVICE, PROP_UNITS, PROP_PROPERTY_LIST
+    };
+    const uint32_t ANALOG_INPUT_OPTIONAL[] = {
+        PROP_DESCRIPTION, PROP_RELIABILITY, PROP_COV_INCREMENT
+    };
+
+    const uint32_t BINARY_OUTPUT_REQUIRED[] = {
+        PROP_OBJECT_IDENTIFIER, PROP_OBJECT_NAME, PROP_OBJECT_TYPE, PROP_PRESENT_VALUE,
+        PROP_STATUS_FLAGS, PROP_EVENT_STATE, PROP_OUT_OF_SERVICE, PROP_POLARITY,
+        PROP_PRIORITY_ARRAY, PROP_RELINQUISH_DEFAULT, PROP_PROPERTY_LIST
+    };
+
+    struct PropertySet {
+        const uint32_t* required;
+        size_t requiredCount;
+        const uint32_t* optional;
+        size_t optionalCount;
+    };
+
+    PropertySet propertySet(uint16_t type) {
+        switch (type) {
+            case OBJECT_DEVICE:
+                return {DEVICE_REQUIRED, sizeof(DEVICE_REQUIRED) / sizeof(uint32_t), nullptr, 0};
+            case OBJECT_ANALOG_INPUT:
+                return {ANALOG_INPUT_REQUIRED, sizeof(ANALOG_INPUT_REQUIRED) / sizeof(uint32_t),
+                        ANALOG_INPUT_OPTIONAL, sizeof(ANALOG_INPUT_OPTIONAL) / sizeof(uint32_t)};
+            default:
+                return {BINARY_OUTPUT_REQUIRED, sizeof(BINARY_OUTPUT_REQUIRED) / sizeof(uint32_t), nullptr, 0};
+        }
+    }
+
+    bool hasProperty(const PropertySet& set, uint32_t property) {
+        for (size_t i = 0; i < set.requiredCount; i++) {
+            if (set.required[i] == property) return true;
+        }
+        for (size_t i = 0; i < set.optionalCount; i++) {
+            if (set.optional[i] == property) return true;
+        }
+        return false;
+    }
+
+    // Property_List leaves out the properties every object has
+    bool inPropertyList(uint32_t property) {
+        return property != PROP_OBJECT_IDENTIFIER && property != PROP_OBJECT_NAME &&
+               property != PROP_OBJECT_TYPE && property != PROP_PROPERTY_LIST;
+    }
+
+    bool isArrayProperty(uint32_t property) {
+        return property == PROP_OBJECT_LIST || property == PROP_PRIORITY_ARRAY || property == PROP_PROPERTY_LIST;
+    }
+
+    size_t maxApduLength(uint8_t code) {
+        static const uint16_t LENGTHS[] = {50, 128, 206, 480, 1024, 1476};
+        return code < sizeof(LENGTHS) / sizeof(LENGTHS[0]) ? LENGTHS[code] : LENGTHS[0];
+    }
+
+    uint16_t readWord(const uint8_t* data) {
+        return static_cast<uint16_t>(data[0] << 8 | data[1]);
+    }
+
+    void writeWord(uint8_t* data, uint16_t value) {
+        data[0] = value >> 8;
+        data[1] = value & 0xFF;
+    }
+
+    bool sameAddress(const BacnetAddress& a, const BacnetAddress& b) {
+        return memcmp(a.ip, b.ip, 4) == 0 && a.port == b.port && a.network == b.network &&
+               a.macLength == b.macLength && memcmp(a.mac, b.mac, a.macLength) == 0;
+    }
+
+    void formatRom(const uint8_t* address, char* out) {
+        for (uint8_t i = 0; i < 8; i++) {
+            snprintf(out + 2 * i, 3, "%02X", address[i]);
+        }
+    }
+
+    uint32_t fnv1a(uint32_t hash, const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+}
+
+// Tag encoder over a fixed buffer. Writes past the capacity are dropped and
+// flagged, so a response that does not fit can be replaced by an abort.
+struct BacnetDevice::Writer {
+    uint8_t* data;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+
+    Writer(uint8_t* buffer, size_t size) : data(buffer), capacity(size), length(0), overflow(false) {}
+
+    void byte(uint8_t value) {
+        if (length < capacity) data[length++] = value;
+        else overflow = true;
+    }
+
+    void bytes(const void* source, size_t count) {
+        const uint8_t* p = static_cast<const uint8_t*>(source);
+        for (size_t i = 0; i < count; i++) byte(p[i]);
+    }
+
+    void rewind(size_t position) {
+        length = position;
+        overflow = false;
+    }
+
+    void tag(uint8_t number, bool context, uint32_t size) {
+        uint8_t first = context ? 0x08 : 0x00;
+        first |= number <= 14 ? number << 4 : 0xF0;
+        first |= size <= 4 ? size : 5;
+        byte(first);
+        if (number > 14) byte(number);
+        if (size <= 4) return;
+        if (size <= 253) {
+            byte(size);
+        } else if (size <= 0xFFFF) {
+            byte(254);
+            byte(size >> 8);
+            byte(size & 0xFF);
+        } else {
+            byte(255);
+            for (int shift = 24; shift >= 0; shift -= 8) byte(size >> shift);
+        }
+    }
+
+    void opening(uint8_t number) { byte(number <= 14 ? (number << 4) | 0x0E : 0xFE); if (number > 14) byte(number); }
+    void closing(uint8_t number) { byte(number <= 14 ? (number << 4) | 0x0F : 0xFF); if (number > 14) byte(number); }
+
+    static uint8_t unsignedSize(uint32_t value) {
+        return value < 0x100 ? 1 : value < 0x10000 ? 2 : value < 0x1000000 ? 3 : 4;
+    }
+
+    void unsignedContent(uint32_t value, uint8_t size) {
+        for (int i = size - 1; i >= 0; i--) byte(value >> (8 * i));
+    }
+
+    void appNull() { byte(0x00); }
+    void appBoolean(bool value) { byte(0x10 | (value ? 1 : 0)); }
+
+    void appUnsigned(uint32_t value) {
+        uint8_t size = unsignedSize(value);
+        tag(2, false, size);
+        unsignedContent(value, size);
+    }
+
+    void appEnumerated(uint32_t value) {
+        uint8_t size = unsignedSize(value);
+        tag(9, false, size);
+        unsignedContent(value, size);
+    }
+
+    void appReal(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        tag(4, false, 4);
+        unsignedContent(bits, 4);
+    }
+
+    void appCharString(const char* text) {
+        size_t size = strlen(text);
+        tag(7, false, size + 1);
+        byte(0);   // ISO 10646 (UTF-8)
+        bytes(text, size);
+    }
+
+    void appBitString(const uint8_t* bits, uint8_t bitCount) {
+        uint8_t size = (bitCount + 7) / 8;
+        tag(8, false, size + 1);
+        byte(size * 8 - bitCount);
+        bytes(bits, size);
+    }
+
+    void appStatusFlags(uint8_t flags) {
+        appBitString(&flags, 4);
+    }
+
+    void appObjectId(uint16_t type, uint32_t instance) {
+        tag(12, false, 4);
+        unsignedContent(static_cast<uint32_t>(type) << 22 | (instance & 0x3FFFFF), 4);
+    }
+
+    void contextUnsigned(uint8_t number, uint32_t value) {
+        uint8_t size = unsignedSize(value);
+        tag(number, true, size);
+        unsignedContent(value, size);
+    }
+
+    void contextObjectId(uint8_t number, uint16_t type, uint32_t instance) {
+        tag(number, true, 4);
+        unsignedContent(static_cast<uint32_t>(type) << 22 | (instance & 0x3FFFFF), 4);
+    }
+};
+
+// Tag decoder for the context-tagged service parameters of requests
+struct BacnetDevice::Reader {
+    struct Tag {
+        uint8_t number;
+        bool context;
+        bool opening;
+        bool closing;
+        uint32_t size;
+        size_t headerLength;
+    };
+
+    const uint8_t* data;
+    size_t length;
+    size_t position;
+
+    Reader(const uint8_t* buffer, size_t size) : data(buffer), length(size), position(0) {}
+
+    bool atEnd() const { return position >= length; }
+
+    uint8_t failureReason() const {
+        return atEnd() ? REJECT_MISSING_REQUIRED_PARAMETER : REJECT_INVALID_TAG;
+    }
+
+    bool peek(Tag& tag) const {
+        size_t p = position;
+        if (p >= length) return false;
+        uint8_t first = data[p++];
+        tag.number = first >> 4;
+        if (tag.number == 15) {
+            if (p >= length) return false;
+            tag.number = data[p++];
+        }
+        tag.context = first & 0x08;
+        uint8_t lengthValue = first & 0x07;
+        tag.opening = tag.context && lengthValue == 6;
+        tag.closing = tag.context && lengthValue == 7;
+        tag.size = 0;
+        if (tag.opening || tag.closing || (!tag.context && tag.number == 1)) {
+            // No content; an application boolean carries its value in the header
+        } else if (lengthValue < 5) {
+            tag.size = lengthValue;
+        } else {
+            if (p >= length) return false;
+            uint8_t extended = data[p++];
+            if (extended < 254) {
+                tag.size = extended;
+            } else if (extended == 254) {
+                if (length - p < 2) return false;
+                tag.size = readWord(data + p);
+                p += 2;
+            } else {
+                if (length - p < 4) return false;
+                tag.size = static_cast<uint32_t>(readWord(data + p)) << 16 | readWord(data + p + 2);
+                p += 4;
+            }
+        }
+        tag.headerLength = p - position;
+        return tag.size <= length - p;
+    }
+
+    bool nextIsContext(uint8_t number) const {
+        Tag tag;
+        return peek(tag) && tag.context && !tag.opening && !tag.closing && tag.number == number;
+    }
+
+    bool nextIsClosing(uint8_t number) const {
+        Tag tag;
+        return peek(tag) && tag.closing && tag.number == number;
+    }
+
+    bool skipBracket(uint8_t number, bool opening) {
+        Tag tag;
+        if (!peek(tag) || tag.number != number || (opening ? !tag.opening : !tag.closing)) return false;
+        position += tag.headerLength;
+        return true;
+    }
+
+    bool readOpening(uint8_t number) { return skipBracket(number, true); }
+    bool readClosing(uint8_t number) { return skipBracket(number, false); }
+
+    bool readUnsigned(uint8_t number, uint32_t& value) {
+        Tag tag;
+        if (!nextIsContext(number) || !peek(tag) || tag.size < 1 || tag.size > 4) return false;
+        const uint8_t* content = data + position + tag.headerLength;
+        value = 0;
+        for (uint32_t i = 0; i < tag.size; i++) value = value << 8 | content[i];
+        position += tag.headerLength + tag.size;
+        return true;
+    }
+
+    bool readObjectId(uint8_t number, uint16_t& type, uint32_t& instance) {
+        Tag tag;
+        if (!nextIsContext(number) || !peek(tag) || tag.size != 4) return false;
+        uint32_t value;
+        if (!readUnsigned(number, value)) return false;
+        type = value >> 22;
+        instance = value & 0x3FFFFF;
+        return true;
+    }
+
+    bool readBoolean(uint8_t number, bool& value) {
+        Tag tag;
+        if (!nextIsContext(number) || !peek(tag) || tag.size != 1) return false;
+        value = data[position + tag.headerLength] != 0;
+        position += tag.headerLength + 1;
+        return true;
+    }
+};
+
+BacnetDevice::BacnetDevice()
+    : outputCount(0)
+    , instance(WILDCARD_INSTANCE)
+    , vendorName("")
+    , vendorId(0)
+    , modelName("")
+    , firmware("")
+    , covIncrement(0.1f)
+    , databaseRevision(0)
+    , objectsChanged(true)
+    , nextInvokeId(0)
+    , sender(nullptr)
+    , senderContext(nullptr) {
+    memset(inputs, 0, sizeof(inputs));
+    memset(outputs, 0, sizeof(outputs));
+    memset(subscriptions, 0, sizeof(subscriptions));
+    memset(deviceName, 0, sizeof(deviceName));
+    for (auto& input : inputs) {
+        input.reliability = RELIABILITY_NO_SENSOR;
+        input.statusFlags = STATUS_FAULT;
+    }
+}
+
+void BacnetDevice::configure(const BacnetIdentity& identity, float increment) {
+    instance = identity.instance;
+    strncpy(deviceName, identity.name, BACNET_MAX_NAME);
+    vendorName = identity.vendorName;
+    vendorId = identity.vendorId;
+    modelName = identity.modelName;
+    firmware = identity.firmware;
+    covIncrement = increment;
+    objectsChanged = true;
+}
+
+void BacnetDevice::setSender(Sender callback, void* context) {
+    sender = callback;
+    senderContext = context;
+}
+
+void BacnetDevice::setSensorName(size_t slot, const char* name) {
+    if (slot >= BACNET_SENSOR_OBJECTS) return;
+    if (strncmp(inputs[slot].name, name, BACNET_MAX_NAME) == 0) return;
+    strncpy(inputs[slot].name, name, BACNET_MAX_NAME);
+    objectsChanged = true;
+}
+
+void BacnetDevice::setRelayName(uint8_t relay, const char* name) {
+    if (relay >= BACNET_MAX_BINARY_OUTPUTS) return;
+    if (strncmp(outputs[relay].name, name, BACNET_MAX_NAME) == 0) return;
+    strncpy(outputs[relay].name, name, BACNET_MAX_NAME);
+    objectsChanged = true;
+}
+
+uint8_t BacnetDevice::getSubscriptionCount() const {
+    uint8_t count = 0;
+    for (const auto& subscription : subscriptions) {
+        if (subscription.active) count++;
+    }
+    return count;
+}
+
+bool BacnetDevice::refresh(const BacnetSensorSample* samples, size_t count,
+                           const bool* relayStates, uint8_t relayCount, uint32_t now) {
+    slots.beginUpdate();
+    for (size_t i = 0; i < count; i++) {
+        slots.markListed(samples[i].address);
+    }
+    for (size_t i = 0; i < count; i++) {
+        int slot = slots.slotFor(samples[i].address);
+        if (slot < 0) continue;
+
+        const BacnetSensorSample& sample = samples[i];
+        AnalogInput& input = inputs[slot];
+        if (sample.temperature != SensorTable::NO_READING_C) {
+            input.presentValue = sample.temperature;
+        }
+        if (sample.health == SensorHealth::QUARANTINED) {
+            input.reliability = RELIABILITY_COMMUNICATION_FAILURE;
+        } else if (!sample.valid) {
+            input.reliability = sample.consecutiveErrors ? RELIABILITY_COMMUNICATION_FAILURE
+                                                         : RELIABILITY_UNRELIABLE_OTHER;
+        } else {
+            input.reliability = RELIABILITY_NO_FAULT_DETECTED;
+        }
+        input.statusFlags = 0;
+        if (input.reliability != RELIABILITY_NO_FAULT_DETECTED) input.statusFlags |= STATUS_FAULT;
+        if (sample.anomalyMask) input.statusFlags |= STATUS_IN_ALARM;
+    }
+
+    // A sensor that is gone keeps its object and last value
+    for (size_t slot = 0; slot < BACNET_SENSOR_OBJECTS; slot++) {
+        if (slots.isListed(slot) || slots.isFree(slot)) continue;
+        inputs[slot].reliability = RELIABILITY_NO_SENSOR;
+        inputs[slot].statusFlags = STATUS_FAULT;
+    }
+    bool assigned = slots.endUpdate();
+
+    uint8_t relays = relayCount < BACNET_MAX_BINARY_OUTPUTS ? relayCount : BACNET_MAX_BINARY_OUTPUTS;
+    if (relays != outputCount || assigned) objectsChanged = true;
+    outputCount = relays;
+    for (uint8_t i = 0; i < outputCount; i++) {
+        outputs[i].presentValue = relayStates[i];
+    }
+    if (objectsChanged) updateDatabaseRevision();
+
+    for (auto& subscription : subscriptions) {
+        if (!subscription.active) continue;
+        float value;
+        uint8_t flags;
+        if ((!subscription.indefinite && static_cast<int32_t>(now - subscription.expiry) >= 0) ||
+            !currentValue(subscription.objectType, subscription.objectInstance, value, flags)) {
+            subscription.active = false;
+            continue;
+        }
+
+        bool changed = flags != subscription.lastFlags;
+        if (subscription.objectType == OBJECT_ANALOG_INPUT) {
+            changed |= fabsf(value - subscription.lastValue) >= covIncrement;
+        } else {
+            changed |= value != subscription.lastValue;
+        }
+        if (changed) sendNotification(subscription, now);
+    }
+    return assigned;
+}
+
+// Hash of everything a client may cache, so the revision changes with the
+// object set or names but not across restarts
+void BacnetDevice::updateDatabaseRevision() {
+    uint32_t hash = 2166136261u;
+    hash = fnv1a(hash, &instance, sizeof(instance));
+    hash = fnv1a(hash, deviceName, strlen(deviceName));
+    for (size_t slot = 0; slot < BACNET_SENSOR_OBJECTS; slot++) {
+        hash = fnv1a(hash, slots.address(slot), 8);
+        hash = fnv1a(hash, inputs[slot].name, strlen(inputs[slot].name));
+    }
+    hash = fnv1a(hash, &outputCount, sizeof(outputCount));
+    for (uint8_t i = 0; i < outputCount; i++) {
+        hash = fnv1a(hash, outputs[i].name, strlen(outputs[i].name));
+    }
+    databaseRevision = hash;
+    objectsChanged = false;
+}
+
+void BacnetDevice::handleFrame(const uint8_t* frame, size_t length, const BacnetAddress& source, uint32_t now) {
+    if (length < 4 || frame[0] != BVLC_TYPE || readWord(frame + 2) != length) return;
+
+    BacnetAddress from = source;
+    from.network = 0;
+    from.macLength = 0;
+    size_t offset = 4;
+    switch (frame[1]) {
+        case BVLC_UNICAST_NPDU:
+        case BVLC_BROADCAST_NPDU:
+            break;
+        case BVLC_FORWARDED_NPDU:
+            // Relayed by a BBMD: answer the originating device, not the BBMD
+            if (length < 10) return;
+            memcpy(from.ip, frame + 4, 4);
+            from.port = readWord(frame + 8);
+            offset = 10;
+            break;
+        default:
+            return;
+    }
+
+    if (length < offset + 2 || frame[offset] != NPDU_VERSION) return;
+    uint8_t control = frame[offset + 1];
+    offset += 2;
+    if (control & NPDU_NETWORK_MESSAGE) return;
+    if (control & NPDU_DESTINATION) {
+        if (length < offset + 3) return;
+        // Not a router: of the routed destinations only a global broadcast is for us
+        if (readWord(frame + offset) != GLOBAL_BROADCAST_NETWORK) return;
+        offset += 3 + frame[offset + 2];
+    }
+    if (control & NPDU_SOURCE) {
+        if (length < offset + 3) return;
+        from.network = readWord(frame + offset);
+        from.macLength = frame[offset + 2];
+        if (from.network == 0 || from.network == GLOBAL_BROADCAST_NETWORK ||
+            from.macLength == 0 || from.macLength > sizeof(from.mac) ||
+            length < offset + 3 + from.macLength) {
+            return;
+        }
+        memcpy(from.mac, frame + offset + 3, from.macLength);
+        offset += 3 + from.macLength;
+    }
+    if (control & NPDU_DESTINATION) offset++;   // Hop count
+    if (offset >= length) return;
+
+    const uint8_t* apdu = frame + offset;
+    size_t apduLength = length - offset;
+    switch (apdu[0] & 0xF0) {
+        case PDU_CONFIRMED_REQUEST:
+            handleConfirmed(apdu, apduLength, from, now);
+            break;
+        case PDU_UNCONFIRMED_REQUEST:
+            if (apduLength >= 2 && apdu[1] == SERVICE_WHO_IS) {
+                handleWhoIs(apdu + 2, apduLength - 2, from);
+            }
+            break;
+        default:
+            // Acknowledgements of confirmed notifications need no action
+            break;
+    }
+}
+
+void BacnetDevice::handleConfirmed(const uint8_t* apdu, size_t length, const BacnetAddress& source, uint32_t now) {
+    if (length < 4) return;
+    uint8_t invokeId = apdu[2];
+    uint8_t service = apdu[3];
+
+    size_t header = beginFrame(source, false, false);
+    size_t capacity = maxApduLength(apdu[1] & 0x0F);
+    if (capacity > BACNET_MAX_PACKET - header) capacity = BACNET_MAX_PACKET - header;
+    Writer out(frameBuffer + header, capacity);
+
+    Result result;
+    PropertyError error = {0, 0};
+    uint8_t rejectReason = 0;
+    int subscription = -1;
+
+    if (apdu[0] & PDU_SEGMENTED_MESSAGE) {
+        out.byte(PDU_ABORT_FROM_SERVER);
+        out.byte(invokeId);
+        out.byte(ABORT_SEGMENTATION_NOT_SUPPORTED);
+        sendFrame(source, false, header + out.length);
+        return;
+    }
+
+    Reader in(apdu + 4, length - 4);
+    switch (service) {
+        case SERVICE_READ_PROPERTY:
+        case SERVICE_READ_PROPERTY_MULTIPLE:
+            out.byte(PDU_COMPLEX_ACK);
+            out.byte(invokeId);
+            out.byte(service);
+            result = service == SERVICE_READ_PROPERTY ? readProperty(in, out, error, rejectReason)
+                                                      : readPropertyMultiple(in, out, rejectReason);
+            break;
+        case SERVICE_SUBSCRIBE_COV:
+            result = subscribeCov(in, source, now, subscription, error, rejectReason);
+            if (result == Result::SEND_ACK) {
+                out.byte(PDU_SIMPLE_ACK);
+                out.byte(invokeId);
+                out.byte(service);
+            }
+            break;
+        default:
+            result = Result::SEND_REJECT;
+            rejectReason = REJECT_UNRECOGNIZED_SERVICE;
+            break;
+    }
+
+    if (result == Result::SEND_ERROR) {
+        out.rewind(0);
+        out.byte(PDU_ERROR);
+        out.byte(invokeId);
+        out.byte(service);
+        out.appEnumerated(error.errorClass);
+        out.appEnumerated(error.errorCode);
+    } else if (result == Result::SEND_REJECT) {
+        out.rewind(0);
+        out.byte(PDU_REJECT);
+        out.byte(invokeId);
+        out.byte(rejectReason);
+    } else if (out.overflow) {
+        out.rewind(0);
+        out.byte(PDU_ABORT_FROM_SERVER);
+        out.byte(invokeId);
+        out.byte(ABORT_SEGMENTATION_NOT_SUPPORTED);
+    }
+    sendFrame(source, false, header + out.length);
+
+    // A new or renewed subscription is answered with the current value
+    if (subscription >= 0) {
+        sendNotification(subscriptions[subscription], now);
+    }
+}
+
+void BacnetDevice::handleWhoIs(const uint8_t* data, size_t length, const BacnetAddress& source) {
+    Reader in(data, length);
+    if (!in.atEnd()) {
+        uint32_t low, high;
+        if (!in.readUnsigned(0, low) || !in.readUnsigned(1, high) || !in.atEnd()) return;
+        if (instance < low || instance > high) return;
+    }
+
+    // Broadcast on the requester's network: locally, or through its router
+    if (source.network) {
+        BacnetAddress destination = source;
+        destination.macLength = 0;
+        sendIAm(destination, false);
+    } else {
+        sendIAm(source, true);
+    }
+}
+
+void BacnetDevice::announce() {
+    BacnetAddress broadcast = {};
+    sendIAm(broadcast, true);
+}
+
+void BacnetDevice::sendIAm(const BacnetAddress& destination, bool broadcast) {
+    size_t header = beginFrame(destination, broadcast, false);
+    Writer out(frameBuffer + header, BACNET_MAX_PACKET - header);
+    out.byte(PDU_UNCONFIRMED_REQUEST);
+    out.byte(SERVICE_I_AM);
+    out.appObjectId(OBJECT_DEVICE, instance);
+    out.appUnsigned(BACNET_MAX_APDU);
+    out.appEnumerated(SEGMENTATION_NONE);
+    out.appUnsigned(vendorId);
+    sendFrame(destination, broadcast, header + out.length);
+}
+
+BacnetDevice::Result BacnetDevice::readProperty(Reader& in, Writer& out, PropertyError& error,
+                                                uint8_t& rejectReason) const {
+    uint16_t type;
+    uint32_t objectInstance, property, index = 0;
+    if (!in.readObjectId(0, type, objectInstance) || !in.readUnsigned(1, property)) {
+        rejectReason = in.failureReason();
+        return Result::SEND_REJECT;
+    }
+    bool hasIndex = in.nextIsContext(2);
+    if (hasIndex && !in.readUnsigned(2, index)) {
+        rejectReason = REJECT_INVALID_TAG;
+        return Result::SEND_REJECT;
+    }
+    if (!in.atEnd()) {
+        rejectReason = REJECT_TOO_MANY_ARGUMENTS;
+        return Result::SEND_REJECT;
+    }
+
+    out.contextObjectId(0, type, objectInstance);
+    out.contextUnsigned(1, property);
+    if (hasIndex) out.contextUnsigned(2, index);
+    out.opening(3);
+    if (!encodeProperty(type, objectInstance, property, hasIndex, index, out, error)) {
+        return Result::SEND_ERROR;
+    }
+    out.closing(3);
+    return Result::SEND_ACK;
+}
+
+BacnetDevice::Result BacnetDevice::readPropertyMultiple(Reader& in, Writer& out, uint8_t& rejectReason) const {
+    if (in.atEnd()) {
+        rejectReason = REJECT_MISSING_REQUIRED_PARAMETER;
+        return Result::SEND_REJECT;
+    }
+
+    while (!in.atEnd()) {
+        uint16_t type;
+        uint32_t objectInstance;
+        if (!in.readObjectId(0, type, objectInstance) || !in.readOpening(1) || in.nextIsClosing(1)) {
+            rejectReason = in.failureReason();
+            return Result::SEND_REJECT;
+        }
+        out.contextObjectId(0, type, objectInstance);
+        out.opening(1);
+
+        bool exists = objectExists(type, objectInstance);
+        while (!in.nextIsClosing(1)) {
+            uint32_t property, index = 0;
+            if (!in.readUnsigned(0, property)) {
+                rejectReason = in.failureReason();
+                return Result::SEND_REJECT;
+            }
+            bool hasIndex = in.nextIsContext(1);
+            if (hasIndex && !in.readUnsigned(1, index)) {
+                rejectReason = REJECT_INVALID_TAG;
+                return Result::SEND_REJECT;
+            }
+
+            bool special = property == PROP_ALL || property == PROP_REQUIRED || property == PROP_OPTIONAL;
+            if (!special || !exists) {
+                appendResult(type, objectInstance, property, hasIndex, index, out);
+                continue;
+            }
+            PropertySet set = propertySet(type);
+            if (property != PROP_OPTIONAL) {
+                for (size_t i = 0; i < set.requiredCount; i++) {
+                    appendResult(type, objectInstance, set.required[i], false, 0, out);
+                }
+            }
+            if (property != PROP_REQUIRED) {
+                for (size_t i = 0; i < set.optionalCount; i++) {
+                    appendResult(type, objectInstance, set.optional[i], false, 0, out);
+                }
+            }
+        }
+        in.readClosing(1);
+        out.closing(1);
+    }
+    return Result::SEND_ACK;
+}
+
+// One ReadAccessResult element: the value, or the error for this property alone
+void BacnetDevice::appendResult(uint16_t type, uint32_t objectInstance, uint32_t property,
+                                bool hasIndex, uint32_t index, Writer& out) const {
+    out.contextUnsigned(2, property);
+    if (hasIndex) out.contextUnsigned(3, index);
+
+    size_t mark = out.length;
+    bool overflow = out.overflow;
+    PropertyError error;
+    out.opening(4);
+    if (encodeProperty(type, objectInstance, property, hasIndex, index, out, error)) {
+        out.closing(4);
+        return;
+    }
+    out.rewind(mark);
+    out.overflow = overflow;
+    out.opening(5);
+    out.appEnumerated(error.errorClass);
+    out.appEnumerated(error.errorCode);
+    out.closing(5);
+}
+
+BacnetDevice::Result BacnetDevice::subscribeCov(Reader& in, const BacnetAddress& source, uint32_t now,
+                                                int& created, PropertyError& error, uint8_t& rejectReason) {
+    uint32_t processId, objectInstance, lifetime = 0;
+    uint16_t type;
+    bool confirmed = false;
+    if (!in.readUnsigned(0, processId) || !in.readObjectId(1, type, objectInstance)) {
+        rejectReason = in.failureReason();
+        return Result::SEND_REJECT;
+    }
+    bool hasConfirmed = in.nextIsContext(2);
+    if (hasConfirmed && !in.readBoolean(2, confirmed)) {
+        rejectReason = REJECT_INVALID_TAG;
+        return Result::SEND_REJECT;
+    }
+    bool hasLifetime = in.nextIsContext(3);
+    if (hasLifetime && !in.readUnsigned(3, lifetime)) {
+        rejectReason = REJECT_INVALID_TAG;
+        return Result::SEND_REJECT;
+    }
+    if (!in.atEnd()) {
+        rejectReason = REJECT_TOO_MANY_ARGUMENTS;
+        return Result::SEND_REJECT;
+    }
+    // Without either optional parameter the request cancels the subscription
+    bool cancel = !hasConfirmed && !hasLifetime;
+    if (!cancel && !hasConfirmed) {
+        rejectReason = REJECT_MISSING_REQUIRED_PARAMETER;
+        return Result::SEND_REJECT;
+    }
+
+    if (!objectExists(type, objectInstance)) {
+        error = {ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT};
+        return Result::SEND_ERROR;
+    }
+    if (type != OBJECT_ANALOG_INPUT && type != OBJECT_BINARY_OUTPUT) {
+        error = {ERROR_CLASS_OBJECT, ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED};
+        return Result::SEND_ERROR;
+    }
+    if (lifetime > MAX_COV_LIFETIME) {
+        error = {ERROR_CLASS_SERVICES, ERROR_CODE_VALUE_OUT_OF_RANGE};
+        return Result::SEND_ERROR;
+    }
+
+    int existing = -1;
+    int unused = -1;
+    for (size_t i = 0; i < BACNET_MAX_SUBSCRIPTIONS; i++) {
+        const Subscription& subscription = subscriptions[i];
+        if (!subscription.active) {
+            if (unused < 0) unused = static_cast<int>(i);
+        } else if (subscription.processId == processId && subscription.objectType == type &&
+                   subscription.objectInstance == objectInstance &&
+                   sameAddress(subscription.subscriber, source)) {
+            existing = static_cast<int>(i);
+        }
+    }
+    if (cancel) {
+        if (existing >= 0) subscriptions[existing].active = false;
+        return Result::SEND_ACK;
+    }
+
+    int index = existing >= 0 ? existing : unused;
+    if (index < 0) {
+        error = {ERROR_CLASS_RESOURCES, ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT};
+        return Result::SEND_ERROR;
+    }
+
+    Subscription& subscription = subscriptions[index];
+    subscription.active = true;
+    subscription.confirmed = confirmed;
+    subscription.indefinite = lifetime == 0;
+    subscription.subscriber = source;
+    subscription.processId = processId;
+    subscription.objectType = type;
+    subscription.objectInstance = objectInstance;
+    subscription.expiry = now + lifetime * 1000;
+    created = index;
+    return Result::SEND_ACK;
+}
+
+void BacnetDevice::sendNotification(Subscription& subscription, uint32_t now) {
+    float value;
+    uint8_t flags;
+    if (!currentValue(subscription.objectType, subscription.objectInstance, value, flags)) return;
+    subscription.lastValue = value;
+    subscription.lastFlags = flags;
+
+    size_t header = beginFrame(subscription.subscriber, false, subscription.confirmed);
+    Writer out(frameBuffer + header, BACNET_MAX_PACKET - header);
+    if (subscription.confirmed) {
+        out.byte(PDU_CONFIRMED_REQUEST);
+        out.byte(MAX_APDU_1476);
+        out.byte(nextInvokeId++);
+        out.byte(SERVICE_CONFIRMED_COV_NOTIFICATION);
+    } else {
+        out.byte(PDU_UNCONFIRMED_REQUEST);
+        out.byte(SERVICE_UNCONFIRMED_COV_NOTIFICATION);
+    }
+
+    uint32_t remaining = 0;
+    if (!subscription.indefinite && static_cast<int32_t>(subscription.expiry - now) > 0) {
+        remaining = (subscription.expiry - now + 999) / 1000;
+    }
+    out.contextUnsigned(0, subscription.processId);
+    out.contextObjectId(1, OBJECT_DEVICE, instance);
+    out.contextObjectId(2, subscription.objectType, subscription.objectInstance);
+    out.contextUnsigned(3, remaining);
+
+    out.opening(4);
+    out.contextUnsigned(0, PROP_PRESENT_VALUE);
+    out.opening(2);
+    if (subscription.objectType == OBJECT_ANALOG_INPUT) out.appReal(value);
+    else out.appEnumerated(value != 0.0f ? 1 : 0);
+    out.closing(2);
+    out.contextUnsigned(0, PROP_STATUS_FLAGS);
+    out.opening(2);
+    out.appStatusFlags(flags);
+    out.closing(2);
+    out.closing(4);
+
+    sendFrame(subscription.subscriber, false, header + out.length);
+}
+
+size_t BacnetDevice::beginFrame(const BacnetAddress& destination, bool broadcast, bool expectingReply) {
+    frameBuffer[0] = BVLC_TYPE;
+    frameBuffer[1] = broadcast ? BVLC_BROADCAST_NPDU : BVLC_UNICAST_NPDU;
+    size_t length = 4;
+
+    uint8_t control = expectingReply ? NPDU_EXPECTING_REPLY : 0;
+    if (destination.network) control |= NPDU_DESTINATION;
+    frameBuffer[length++] = NPDU_VERSION;
+    frameBuffer[length++] = control;
+    if (destination.network) {
+        writeWord(frameBuffer + length, destination.network);
+        frameBuffer[length + 2] = destination.macLength;
+        memcpy(frameBuffer + length + 3, destination.mac, destination.macLength);
+        length += 3 + destination.macLength;
+        frameBuffer[length++] = 255;   // Hop count
+    }
+    return length;
+}
+
+void BacnetDevice::sendFrame(const BacnetAddress& destination, bool broadcast, size_t length) {
+    writeWord(frameBuffer + 2, static_cast<uint16_t>(length));
+    if (sender) {
+        sender(destination, broadcast, frameBuffer, length, senderContext);
+    }
+}
+
+bool BacnetDevice::objectExists(uint16_t type, uint32_t objectInstance) const {
+    switch (type) {
+        case OBJECT_DEVICE:
+            return objectInstance == instance || objectInstance == WILDCARD_INSTANCE;
+        case OBJECT_ANALOG_INPUT:
+            return objectInstance < BACNET_SENSOR_OBJECTS && !slots.isFree(objectInstance);
+        case OBJECT_BINARY_OUTPUT:
+            return objectInstance < outputCount;
+        default:
+            return false;
+    }
+}
+
+// Device first, then the Analog Inputs by slot, then the Binary Outputs
+size_t BacnetDevice::objectCount() const {
+    size_t count = 1 + outputCount;
+    for (size_t slot = 0; slot < BACNET_SENSOR_OBJECTS; slot++) {
+        if (!slots.isFree(slot)) count++;
+    }
+    return count;
+}
+
+bool BacnetDevice::objectAt(size_t index, uint16_t& type, uint32_t& objectInstance) const {
+    if (index == 0) {
+        type = OBJECT_DEVICE;
+        objectInstance = instance;
+        return true;
+    }
+    index--;
+    for (size_t slot = 0; slot < BACNET_SENSOR_OBJECTS; slot++) {
+        if (slots.isFree(slot)) continue;
+        if (index == 0) {
+            type = OBJECT_ANALOG_INPUT;
+            objectInstance = slot;
+            return true;
+        }
+        index--;
+    }
+    if (index < outputCount) {
+        type = OBJECT_BINARY_OUTPUT;
+        objectInstance = index;
+        return true;
+    }
+    return false;
+}
+
+bool BacnetDevice::currentValue(uint16_t type, uint32_t objectInstance, float& value, uint8_t& flags) const {
+    if (!objectExists(type, objectInstance)) return false;
+    if (type == OBJECT_ANALOG_INPUT) {
+        value = inputs[objectInstance].presentValue;
+        flags = inputs[objectInstance].statusFlags;
+        return true;
+    }
+    if (type == OBJECT_BINARY_OUTPUT) {
+        value = outputs[objectInstance].presentValue ? 1.0f : 0.0f;
+        flags = 0;
+        return true;
+    }
+    return false;
+}
+
+bool BacnetDevice::encodeProperty(uint16_t type, uint32_t objectInstance, uint32_t property,
+                                  bool hasIndex, uint32_t index, Writer& out, PropertyError& error) const {
+    if (!objectExists(type, objectInstance)) {
+        error = {ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT};
+        return false;
+    }
+    PropertySet set = propertySet(type);
+    if (!hasProperty(set, property)) {
+        error = {ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY};
+        return false;
+    }
+    if (hasIndex && !isArrayProperty(property)) {
+        error = {ERROR_CLASS_PROPERTY, ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY};
+        return false;
+    }
+
+    switch (property) {
+        case PROP_OBJECT_IDENTIFIER:
+            out.appObjectId(type, type == OBJECT_DEVICE ? instance : objectInstance);
+            return true;
+        case PROP_OBJECT_TYPE:
+            out.appEnumerated(type);
+            return true;
+        case PROP_PROPERTY_LIST:
+            return encodePropertyList(type, hasIndex, index, out, error);
+        default:
+            break;
+    }
+
+    switch (type) {
+        case OBJECT_DEVICE:
+            return encodeDevice(property, hasIndex, index, out, error);
+        case OBJECT_ANALOG_INPUT:
+            encodeAnalogInput(objectInstance, property, out);
+            return true;
+        default:
+            return encodeBinaryOutput(objectInstance, property, hasIndex, index, out, error);
+    }
+}
+
+bool BacnetDevice::encodePropertyList(uint16_t type, bool hasIndex, uint32_t index,
+                                      Writer& out, PropertyError& error) const {
+    PropertySet set = propertySet(type);
+    uint32_t listed[32];
+    size_t count = 0;
+    for (size_t i = 0; i < set.requiredCount; i++) {
+        if (inPropertyList(set.required[i])) listed[count++] = set.required[i];
+    }
+    for (size_t i = 0; i < set.optionalCount; i++) {
+        if (inPropertyList(set.optional[i])) listed[count++] = set.optional[i];
+    }
+
+    if (!hasIndex) {
+        for (size_t i = 0; i < count; i++) out.appEnumerated(listed[i]);
+    } else if (index == 0) {
+        out.appUnsigned(count);
+    } else if (index <= count) {
+        out.appEnumerated(listed[index - 1]);
+    } else {
+        error = {ERROR_CLASS_PROPERTY, ERROR_CODE_INVALID_ARRAY_INDEX};
+        return false;
+    }
+    return true;
+}
+
+bool BacnetDevice::encodeDevice(uint32_t property, bool hasIndex, uint32_t index,
+                                Writer& out, PropertyError& error) const {
+    switch (property) {
+        case PROP_OBJECT_NAME:
+            out.appCharString(deviceName);
+            break;
+        case PROP_SYSTEM_STATUS:
+            out.appEnumerated(SYSTEM_STATUS_OPERATIONAL);
+            break;
+        case PROP_VENDOR_NAME:
+            out.appCharString(vendorName);
+            break;
+        case PROP_VENDOR_IDENTIFIER:
+            out.appUnsigned(vendorId);
+            break;
+        case PROP_MODEL_NAME:
+            out.appCharString(modelName);
+            break;
+        case PROP_FIRMWARE_REVISION:
+        case PROP_APPLICATION_SOFTWARE_VERSION:
+            out.appCharString(firmware);
+            break;
+        case PROP_PROTOCOL_VERSION:
+            out.appUnsigned(1);
+            break;
+        case PROP_PROTOCOL_REVISION:
+            out.appUnsigned(PROTOCOL_REVISION);
+            break;
+        case PROP_PROTOCOL_SERVICES_SUPPORTED:
+            out.appBitString(SERVICES_SUPPORTED, SERVICES_SUPPORTED_BITS);
+            break;
+        case PROP_PROTOCOL_OBJECT_TYPES_SUPPORTED:
+            out.appBitString(OBJECT_TYPES_SUPPORTED, OBJECT_TYPES_SUPPORTED_BITS);
+            break;
+        case PROP_OBJECT_LIST: {
+            size_t count = objectCount();
+            uint16_t type;
+            uint32_t objectInstance;
+            if (!hasIndex) {
+                for (size_t i = 0; i < count; i++) {
+                    objectAt(i, type, objectInstance);
+                    out.appObjectId(type, objectInstance);
+                }
+            } else if (index == 0) {
+                out.appUnsigned(count);
+            } else if (index <= count) {
+                objectAt(index - 1, type, objectInstance);
+                out.appObjectId(type, objectInstance);
+            } else {
+                error = {ERROR_CLASS_PROPERTY, ERROR_CODE_INVALID_ARRAY_INDEX};
+                return false;
+            }
+            break;
+        }
+        case PROP_MAX_APDU_LENGTH_ACCEPTED:
+            out.appUnsigned(BACNET_MAX_APDU);
+            break;
+        case PROP_SEGMENTATION_SUPPORTED:
+            out.appEnumerated(SEGMENTATION_NONE);
+            break;
+        case PROP_APDU_TIMEOUT:
+            out.appUnsigned(APDU_TIMEOUT_MS);
+            break;
+        case PROP_NUMBER_OF_APDU_RETRIES:
+            out.appUnsigned(0);
+            break;
+        case PROP_DEVICE_ADDRESS_BINDING:
+            break;   // Empty list: the device does not bind to other devices
+        case PROP_DATABASE_REVISION:
+            out.appUnsigned(databaseRevision);
+            break;
+        default:
+            error = {ERROR_CLASS_PROPERTY, ERROR_CODE_UNKNOWN_PROPERTY};
+            return false;
+    }
+    return true;
+}
+
+void BacnetDevice::encodeAnalogInput(uint32_t slot, uint32_t property, Writer& out) const {
+    const AnalogInput& input = inputs[slot];
+    switch (property) {
+        case PROP_OBJECT_NAME: {
+            char name[BACNET_MAX_NAME + 1];
+            formatSensorName(slot, name);
+            out.appCharString(name);
+            break;
+        }
+        case PROP_PRESENT_VALUE:
+            out.appReal(input.presentValue);
+            break;
+        case PROP_STATUS_FLAGS:
+            out.appStatusFlags(input.statusFlags);
+            break;
+        case PROP_EVENT_STATE:
+            out.appEnumerated(input.statusFlags & STATUS_IN_ALARM ? EVENT_STATE_OFFNORMAL : EVENT_STATE_NORMAL);
+            break;
+        case PROP_OUT_OF_SERVICE:
+            out.appBoolean(false);
+            break;
+        case PROP_UNITS:
+            out.appEnumerated(UNITS_DEGREES_CELSIUS);
+            break;
+        case PROP_DESCRIPTION: {
+            char rom[17];
+            formatRom(slots.address(slot), rom);
+            out.appCharString(rom);
+            break;
+        }
+        case PROP_RELIABILITY:
+            out.appEnumerated(input.reliability);
+            break;
+        case PROP_COV_INCREMENT:
+            out.appReal(covIncrement);
+            break;
+    }
+}
+
+bool BacnetDevice::encodeBinaryOutput(uint32_t relay, uint32_t property, bool hasIndex, uint32_t index,
+                                      Writer& out, PropertyError& error) const {
+    const BinaryOutput& output = outputs[relay];
+    switch (property) {
+        case PROP_OBJECT_NAME:
+            if (output.name[0]) {
+                out.appCharString(output.name);
+            } else {
+                char name[16];
+                snprintf(name, sizeof(name), "Relay %u", static_cast<unsigned>(relay));
+                out.appCharString(name);
+            }
+            break;
+        case PROP_PRESENT_VALUE:
+            out.appEnumerated(output.presentValue ? 1 : 0);
+            break;
+        case PROP_STATUS_FLAGS:
+            out.appStatusFlags(0);
+            break;
+        case PROP_EVENT_STATE:
+            out.appEnumerated(EVENT_STATE_NORMAL);
+            break;
+        case PROP_OUT_OF_SERVICE:
+            out.appBoolean(false);
+            break;
+        case PROP_POLARITY:
+            out.appEnumerated(0);   // Normal
+            break;
+        case PROP_PRIORITY_ARRAY:
+            // Relays are commanded by the hub's own control, never over BACnet
+            if (!hasIndex) {
+                for (uint8_t i = 0; i < PRIORITY_LEVELS; i++) out.appNull();
+            } else if (index == 0) {
+                out.appUnsigned(PRIORITY_LEVELS);
+            } else if (index <= PRIORITY_LEVELS) {
+                out.appNull();
+            } else {
+                error = {ERROR_CLASS_PROPERTY, ERROR_CODE_INVALID_ARRAY_INDEX};
+                return false;
+            }
+            break;
+        case PROP_RELINQUISH_DEFAULT:
+            out.appEnumerated(0);   // Inactive
+            break;
+    }
+    return true;
+}
+
+// The friendly name if one is set, otherwise the ROM
+void BacnetDevice::formatSensorName(size_t slot, char* out) const {
+    if (inputs[slot].name[0]) {
+        strncpy(out, inputs[slot].name, BACNET_MAX_NAME);
+        out[BACNET_MAX_NAME] = '\0';
+        return;
+    }
+    memcpy(out, "Sensor ", 7);
+    formatRom(slots.address(slot), out + 7);
+}
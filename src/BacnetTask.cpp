@@ -0,0 +1,216 @@
+// BacnetTask.cpp
+#include "BacnetTask.h"
+#include "OneWireTask.h"
+#include "ControlTask.h"
+#include "PreferencesManager.h"
+#include "RtosResources.h"
+#include "Logger.h"
+#include "FixedString.h"
+#include <ETH.h>
+#include <lwip/sockets.h>
+
+static const char* const SLOTS_KEY = "bn_slots";   // NVS key of the slot assignment
+
+// Static member initialization
+BacnetConfig BacnetTask::config = {false, BACNET_UDP_PORT, 0, BACNET_COV_INCREMENT};
+BacnetDevice BacnetTask::device;
+TemperatureSensor BacnetTask::snapshot[SENSOR_TABLE_CAPACITY] = {};
+BacnetSensorSample BacnetTask::samples[SENSOR_TABLE_CAPACITY] = {};
+uint8_t BacnetTask::packet[BACNET_MAX_PACKET] = {};
+int BacnetTask::udpSocket = -1;
+volatile bool BacnetTask::running = false;
+
+void BacnetTask::init() {
+    PreferencesManager::getBacnetConfig(config);
+    uint32_t instance = config.deviceInstance ? config.deviceInstance : defaultInstance();
+    
+    // Object_Name of the device must be unique on the internetwork
+    auto name = makeFixedString<BACNET_MAX_NAME>("%s_%lu", DEVICE_NAME, static_cast<unsigned long>(instance));
+    BacnetIdentity identity = {instance, name.c_str(), "Chaoticvolt", BACNET_VENDOR_ID,
+                               "SensorHUB", FIRMWARE_VERSION};
+    device.configure(identity, config.covIncrement);
+    device.setSender(sendFrame, nullptr);
+    
+    // Sensors keep the Analog Input instance they had before the restart
+    uint8_t addresses[BACNET_SENSOR_OBJECTS][8];
+    uint8_t count = PreferencesManager::getSensorSlots(SLOTS_KEY, addresses, BACNET_SENSOR_OBJECTS);
+    device.setSlots(addresses, count);
+    
+    Logger::info(makeFixedString<80>("BACnet/IP %s, port %u, device %lu, %u slots restored",
+                                     config.enabled ? "enabled" : "disabled", config.port,
+                                     static_cast<unsigned long>(instance), count).c_str());
+}
+
+void BacnetTask::start() {
+    if (!config.enabled) return;
+    RtosResources::createTask(TaskId::BACNET, taskFunction);
+}
+
+bool BacnetTask::isRunning() {
+    return running;
+}
+
+uint32_t BacnetTask::getDeviceInstance() {
+    return device.getInstance();
+}
+
+uint8_t BacnetTask::getSubscriptionCount() {
+    return device.getSubscriptionCount();
+}
+
+// 22 bits of the NIC-specific half of the MAC address, avoiding the wildcard
+uint32_t BacnetTask::defaultInstance() {
+    uint32_t instance = static_cast<uint32_t>(ESP.getEfuseMac() >> 24) & 0x3FFFFF;
+    if (instance == BacnetDevice::WILDCARD_INSTANCE) instance--;
+    return instance;
+}
+
+void BacnetTask::taskFunction(void* parameter) {
+    uint32_t lastRefresh = millis();
+    uint32_t lastNames = lastRefresh;
+    bool announced = false;
+    loadNames();
+    if (refreshObjects()) saveSlots();
+    
+    while (true) {
+        if (udpSocket < 0 && !openSocket()) {
+            vTaskDelay(pdMS_TO_TICKS(5000));
+            continue;
+        }
+        if (!announced) {
+            device.announce();
+            announced = true;
+        }
+        
+        uint32_t now = millis();
+        if (now - lastNames >= BACNET_NAME_REFRESH_INTERVAL) {
+            loadNames();
+            lastNames = now;
+        }
+        if (now - lastRefresh >= BACNET_REFRESH_INTERVAL) {
+            if (refreshObjects()) {
+                saveSlots();
+                loadNames();
+            }
+            lastRefresh = now;
+        }
+        
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(udpSocket, &readSet);
+        
+        // Short timeout so objects and COV keep their period without traffic
+        timeval timeout = {0, 250000};
+        int ready = select(udpSocket + 1, &readSet, nullptr, nullptr, &timeout);
+        if (ready < 0) {
+            Logger::error("BACnet select failed: " + String(errno), Logger::Category::NETWORK);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        if (ready > 0) receivePacket();
+    }
+}
+
+bool BacnetTask::openSocket() {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        Logger::error("BACnet socket creation failed", Logger::Category::NETWORK);
+        return false;
+    }
+    
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+    
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(config.port);
+    if (bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        Logger::error("BACnet bind to port " + String(config.port) + " failed: " + String(errno),
+                      Logger::Category::NETWORK);
+        close(sock);
+        return false;
+    }
+    
+    udpSocket = sock;
+    running = true;
+    Logger::info("BACnet/IP device " + String(device.getInstance()) + " on UDP port " + String(config.port),
+                 Logger::Category::NETWORK);
+    return true;
+}
+
+void BacnetTask::receivePacket() {
+    sockaddr_in peer = {};
+    socklen_t peerLength = sizeof(peer);
+    int received = recvfrom(udpSocket, packet, sizeof(packet), 0,
+                            reinterpret_cast<sockaddr*>(&peer), &peerLength);
+    if (received <= 0) return;
+    
+    BacnetAddress source = {};
+    memcpy(source.ip, &peer.sin_addr.s_addr, 4);
+    source.port = ntohs(peer.sin_port);
+    device.handleFrame(packet, received, source, millis());
+}
+
+bool BacnetTask::refreshObjects() {
+    size_t count = OneWireTask::manager.getSensors(snapshot, SENSOR_TABLE_CAPACITY);
+    
+    for (size_t i = 0; i < count; i++) {
+        const TemperatureSensor& sensor = snapshot[i];
+        BacnetSensorSample& sample = samples[i];
+        memcpy(sample.address, sensor.address, 8);
+        sample.temperature = sensor.temperature;
+        sample.health = sensor.health;
+        sample.consecutiveErrors = sensor.consecutiveErrors;
+        sample.anomalyMask = sensor.anomalyMask;
+        sample.valid = sensor.valid;
+    }
+    
+    bool relays[RELAY_COUNT];
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        relays[i] = ControlTask::getRelayState(i);
+    }
+    
+    return device.refresh(samples, count, relays, RELAY_COUNT, millis());
+}
+
+// Friendly names become Object_Name; an empty name falls back to the ROM
+void BacnetTask::loadNames() {
+    uint8_t addresses[BACNET_SENSOR_OBJECTS][8];
+    size_t count = device.getSlots(addresses, BACNET_SENSOR_OBJECTS);
+    for (size_t slot = 0; slot < count; slot++) {
+        device.setSensorName(slot, PreferencesManager::getSensorName(addresses[slot]).c_str());
+    }
+    for (uint8_t relay = 0; relay < RELAY_COUNT; relay++) {
+        device.setRelayName(relay, PreferencesManager::getRelayName(relay).c_str());
+    }
+}
+
+// Only called when a ROM gets a new slot, so flash is written rarely
+void BacnetTask::saveSlots() {
+    uint8_t addresses[BACNET_SENSOR_OBJECTS][8];
+    size_t count = device.getSlots(addresses, BACNET_SENSOR_OBJECTS);
+    if (!PreferencesManager::setSensorSlots(SLOTS_KEY, addresses, count)) {
+        Logger::error("Failed to save BACnet slot assignment");
+    }
+}
+
+// Broadcasts go to the directed broadcast address of the Ethernet subnet
+void BacnetTask::sendFrame(const BacnetAddress& destination, bool broadcast,
+                           const uint8_t* frame, size_t length, void* context) {
+    if (udpSocket < 0) return;
+    
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    if (broadcast) {
+        uint32_t ip = static_cast<uint32_t>(ETH.localIP());
+        uint32_t mask = static_cast<uint32_t>(ETH.subnetMask());
+        address.sin_addr.s_addr = ip | ~mask;
+        address.sin_port = htons(config.port);
+    } else {
+        memcpy(&address.sin_addr.s_addr, destination.ip, 4);
+        address.sin_port = htons(destination.port);
+    }
+    sendto(udpSocket, frame, length, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+}
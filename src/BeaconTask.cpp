@@ -0,0 +1,156 @@
+// BeaconTask.cpp
+#include "BeaconTask.h"
+#include "OneWireTask.h"
+#include "ControlTask.h"
+#include "PreferencesManager.h"
+#include "RtosResources.h"
+#include "Logger.h"
+#include "FixedString.h"
+#include <lwip/pbuf.h>
+#include <lwip/udp.h>
+#include <lwip/priv/tcpip_priv.h>
+
+// Both lwIP calls take their arguments from the static members
+static tcpip_api_call_data lwipCall;
+
+// Static member initialization
+BeaconConfig BeaconTask::config = {false, BEACON_MULTICAST_GROUP, BEACON_UDP_PORT, BEACON_MULTICAST_TTL};
+SensorHot BeaconTask::sensors[SENSOR_TABLE_CAPACITY] = {};
+pbuf* BeaconTask::buffer = nullptr;
+void* BeaconTask::payloadStart = nullptr;
+udp_pcb* BeaconTask::pcb = nullptr;
+TaskHandle_t BeaconTask::taskHandle = nullptr;
+volatile uint32_t BeaconTask::collectedAt = 0;
+uint32_t BeaconTask::sequence = 0;
+volatile uint32_t BeaconTask::sentCount = 0;
+volatile uint32_t BeaconTask::failedCount = 0;
+bool BeaconTask::lastSendFailed = false;
+volatile bool BeaconTask::running = false;
+
+void BeaconTask::init() {
+    PreferencesManager::getBeaconConfig(config);
+    
+    Logger::info(makeFixedString<80>("Telemetry beacon %s, group %u.%u.%u.%u:%u, TTL %u",
+                                     config.enabled ? "enabled" : "disabled",
+                                     static_cast<unsigned>(config.group >> 24),
+                                     static_cast<unsigned>((config.group >> 16) & 0xFF),
+                                     static_cast<unsigned>((config.group >> 8) & 0xFF),
+                                     static_cast<unsigned>(config.group & 0xFF),
+                                     config.port, config.ttl).c_str());
+}
+
+void BeaconTask::start() {
+    if (!config.enabled) return;
+    taskHandle = RtosResources::createTask(TaskId::BEACON, taskFunction);
+}
+
+void BeaconTask::notifyReadingsUpdated() {
+    if (!taskHandle) return;
+    collectedAt = millis();
+    xTaskNotifyGive(taskHandle);
+}
+
+bool BeaconTask::isRunning() {
+    return running;
+}
+
+uint32_t BeaconTask::getSentCount() {
+    return sentCount;
+}
+
+uint32_t BeaconTask::getFailedCount() {
+    return failedCount;
+}
+
+void BeaconTask::taskFunction(void* parameter) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        
+        // A failed setup is retried with the next read cycle
+        if (!pcb && !openPcb()) continue;
+        publish();
+    }
+}
+
+bool BeaconTask::openPcb() {
+    err_t result = tcpip_api_call(openInLwip, &lwipCall);
+    if (result != ERR_OK) {
+        Logger::error("Beacon UDP setup failed: " + String(result), Logger::Category::NETWORK);
+        return false;
+    }
+    
+    running = true;
+    Logger::info("Telemetry beacon on UDP port " + String(config.port), Logger::Category::NETWORK);
+    return true;
+}
+
+void BeaconTask::publish() {
+    // Sequence numbers advance for every cycle, sent or not, so receivers
+    // see datagrams that never left the device as lost
+    uint32_t number = sequence++;
+    
+    // Still referenced by the driver: rewriting it would corrupt that frame
+    if (buffer->ref != 1) {
+        failedCount++;
+        return;
+    }
+    
+    size_t count = OneWireTask::manager.getHotEntries(sensors, SENSOR_TABLE_CAPACITY);
+    uint32_t collected = collectedAt;
+    uint32_t delay = millis() - collected;
+    BeaconHeader header = {number, collected, static_cast<uint16_t>(delay > 0xFFFF ? 0xFFFF : delay),
+                           relayBits(), static_cast<uint8_t>(number == 0 ? BEACON_FLAG_RESTART : 0)};
+    
+    // Encoded in place. Sending moves payload onto the headers it prepends,
+    // so pointer and length are put back before every datagram.
+    buffer->payload = payloadStart;
+    size_t length = TelemetryBeacon::encode(header, sensors, count,
+                                            static_cast<uint8_t*>(payloadStart), BEACON_MAX_DATAGRAM);
+    buffer->len = static_cast<u16_t>(length);
+    buffer->tot_len = static_cast<u16_t>(length);
+    
+    err_t result = tcpip_api_call(sendInLwip, &lwipCall);
+    if (result == ERR_OK) {
+        sentCount++;
+        lastSendFailed = false;
+        return;
+    }
+    
+    failedCount++;
+    if (!lastSendFailed) {
+        Logger::warning("Beacon send failed: " + String(result), Logger::Category::NETWORK);
+    }
+    lastSendFailed = true;
+}
+
+uint8_t BeaconTask::relayBits() {
+    uint8_t bits = 0;
+    for (uint8_t i = 0; i < RELAY_COUNT && i < 8; i++) {
+        if (ControlTask::getRelayState(i)) bits |= 1 << i;
+    }
+    return bits;
+}
+
+err_t BeaconTask::openInLwip(tcpip_api_call_data* call) {
+    if (!buffer) {
+        // PBUF_TRANSPORT leaves room for the UDP, IP and Ethernet headers in
+        // front of the payload, so udp_sendto() never chains a header pbuf
+        buffer = pbuf_alloc(PBUF_TRANSPORT, BEACON_MAX_DATAGRAM, PBUF_RAM);
+        if (!buffer) return ERR_MEM;
+        payloadStart = buffer->payload;
+    }
+    
+    pcb = udp_new();
+    if (!pcb) return ERR_MEM;
+#if LWIP_MULTICAST_TX_OPTIONS
+    udp_set_multicast_ttl(pcb, config.ttl);
+#endif
+    return ERR_OK;
+}
+
+err_t BeaconTask::sendInLwip(tcpip_api_call_data* call) {
+    ip_addr_t group;
+    IP_ADDR4(&group, (config.group >> 24) & 0xFF, (config.group >> 16) & 0xFF,
+             (config.group >> 8) & 0xFF, config.group & 0xFF);
+    return udp_sendto(pcb, buffer, &group, config.port);
+}
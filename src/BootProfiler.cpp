@@ -0,0 +1,91 @@
+// BootProfiler.cpp
+#include "BootProfiler.h"
+#include "Logger.h"
+#include "RtosResources.h"
+
+BootProfiler::Phase BootProfiler::phases[BootProfiler::MAX_PHASES];
+uint8_t BootProfiler::phaseCount = 0;
+uint32_t BootProfiler::localReadyMs = 0;
+uint32_t BootProfiler::networkReadyMs = 0;
+SemaphoreHandle_t BootProfiler::mutex = nullptr;
+
+void BootProfiler::begin() {
+    if (!mutex) {
+        mutex = RtosResources::createMutex(MutexId::BOOT_PROFILER);
+    }
+    phaseCount = 0;
+    localReadyMs = 0;
+    networkReadyMs = 0;
+}
+
+uint8_t BootProfiler::startPhase(const char* name) {
+    uint8_t index = INVALID_PHASE;
+    if (mutex && xSemaphoreTake(mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (phaseCount < MAX_PHASES) {
+            index = phaseCount++;
+            phases[index] = {name, static_cast<uint32_t>(micros()), 0, PhaseState::RUNNING};
+        }
+        xSemaphoreGive(mutex);
+    }
+    return index;
+}
+
+void BootProfiler::endPhase(uint8_t phase, bool success) {
+    if (phase == INVALID_PHASE) return;
+    
+    uint32_t now = micros();
+    if (mutex && xSemaphoreTake(mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (phase < phaseCount) {
+            phases[phase].durationUs = now - phases[phase].startUs;
+            phases[phase].state = success ? PhaseState::OK : PhaseState::FAILED;
+        }
+        xSemaphoreGive(mutex);
+    }
+    
+    if (phase < phaseCount) {
+        Logger::info("Boot phase '" + String(phases[phase].name) + "' " + 
+                    (success ? "completed" : "FAILED") + " in " + 
+                    String((now - phases[phase].startUs) / 1000.0f, 1) + " ms");
+    }
+}
+
+void BootProfiler::markLocalReady() {
+    localReadyMs = millis();
+    Logger::info("Local subsystems running " + String(localReadyMs) + " ms after reset");
+}
+
+void BootProfiler::markNetworkReady() {
+    networkReadyMs = millis();
+    Logger::info("Network bring-up finished " + String(networkReadyMs) + " ms after reset");
+}
+
+uint8_t BootProfiler::getPhases(Phase* out, uint8_t maxCount) {
+    uint8_t count = 0;
+    if (mutex && xSemaphoreTake(mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        count = phaseCount < maxCount ? phaseCount : maxCount;
+        memcpy(out, phases, count * sizeof(Phase));
+        xSemaphoreGive(mutex);
+    }
+    return count;
+}
+
+void BootProfiler::logSummary() {
+    Phase snapshot[MAX_PHASES];
+    uint8_t count = getPhases(snapshot, MAX_PHASES);
+    
+    Logger::info("Boot timing summary:");
+    for (uint8_t i = 0; i < count; i++) {
+        Logger::info(" - " + String(snapshot[i].name) + ": " + 
+                    String(snapshot[i].durationUs / 1000.0f, 1) + " ms (" + 
+                    stateToString(snapshot[i].state) + ")");
+    }
+}
+
+const char* BootProfiler::stateToString(PhaseState state) {
+    switch (state) {
+        case PhaseState::RUNNING: return "running";
+        case PhaseState::OK:      return "ok";
+        case PhaseState::FAILED:  return "failed";
+        default:                  return "unknown";
+    }
+}
@@ -0,0 +1,128 @@
+// CborWriter.cpp
+#include "CborWriter.h"
+#include <string.h>
+
+namespace {
+    constexpr uint8_t MAJOR_UNSIGNED = 0;
+    constexpr uint8_t MAJOR_NEGATIVE = 1;
+    constexpr uint8_t MAJOR_BYTES = 2;
+    constexpr uint8_t MAJOR_TEXT = 3;
+    constexpr uint8_t MAJOR_ARRAY = 4;
+    constexpr uint8_t MAJOR_MAP = 5;
+
+    constexpr uint8_t SIMPLE_FALSE = 0xF4;
+    constexpr uint8_t SIMPLE_TRUE = 0xF5;
+    constexpr uint8_t SIMPLE_NULL = 0xF6;
+    constexpr uint8_t FLOAT_HALF = 0xF9;
+    constexpr uint8_t FLOAT_SINGLE = 0xFA;
+
+    // Half-precision bits of value if it converts without loss, else false.
+    // Covers zero and the normal half range, which holds every DS18B20 reading.
+    bool toHalf(float value, uint16_t& half) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint16_t sign = (bits >> 16) & 0x8000;
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127;
+        uint32_t mantissa = bits & 0x7FFFFF;
+
+        if ((bits & 0x7FFFFFFF) == 0) {
+            half = sign;
+            return true;
+        }
+        if (exponent < -14 || exponent > 15 || (mantissa & 0x1FFF) != 0) return false;
+        half = sign | static_cast<uint16_t>((exponent + 15) << 10) | static_cast<uint16_t>(mantissa >> 13);
+        return true;
+    }
+}
+
+CborWriter::CborWriter(uint8_t* buffer, size_t capacity)
+    : PayloadWriter(buffer, capacity) {
+}
+
+// Payload bytes are reserved along with the head, so a string never loses its body
+bool CborWriter::writeHead(uint8_t major, uint64_t value, size_t payload) {
+    uint8_t initial = major << 5;
+    if (value < 24) {
+        if (!reserve(1 + payload)) return false;
+        buffer[length++] = initial | static_cast<uint8_t>(value);
+        return true;
+    }
+
+    uint8_t bytes = value <= 0xFF ? 1 : value <= 0xFFFF ? 2 : value <= 0xFFFFFFFF ? 4 : 8;
+    if (!reserve(1 + bytes + payload)) return false;
+    buffer[length++] = initial | (bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27);
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        buffer[length++] = static_cast<uint8_t>(value >> shift);
+    }
+    return true;
+}
+
+void CborWriter::beginArray(size_t count) {
+    writeHead(MAJOR_ARRAY, count);
+}
+
+void CborWriter::beginMap(size_t pairs) {
+    writeHead(MAJOR_MAP, pairs);
+}
+
+void CborWriter::addUnsigned(uint64_t value) {
+    writeHead(MAJOR_UNSIGNED, value);
+}
+
+void CborWriter::addInt(int64_t value) {
+    if (value >= 0) {
+        writeHead(MAJOR_UNSIGNED, static_cast<uint64_t>(value));
+    } else {
+        writeHead(MAJOR_NEGATIVE, static_cast<uint64_t>(-(value + 1)));
+    }
+}
+
+void CborWriter::addBool(bool value) {
+    if (!reserve(1)) return;
+    buffer[length++] = value ? SIMPLE_TRUE : SIMPLE_FALSE;
+}
+
+void CborWriter::addNull() {
+    if (!reserve(1)) return;
+    buffer[length++] = SIMPLE_NULL;
+}
+
+void CborWriter::addFloat(float value) {
+    uint16_t half;
+    if (toHalf(value, half)) {
+        if (!reserve(3)) return;
+        buffer[length++] = FLOAT_HALF;
+        buffer[length++] = half >> 8;
+        buffer[length++] = half & 0xFF;
+        return;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (!reserve(5)) return;
+    buffer[length++] = FLOAT_SINGLE;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        buffer[length++] = static_cast<uint8_t>(bits >> shift);
+    }
+}
+
+void CborWriter::addText(const char* text, size_t count) {
+    if (!writeHead(MAJOR_TEXT, count, count)) return;
+    memcpy(buffer + length, text, count);
+    length += count;
+}
+
+void CborWriter::addBytes(const uint8_t* data, size_t count) {
+    if (!writeHead(MAJOR_BYTES, count, count)) return;
+    memcpy(buffer + length, data, count);
+    length += count;
+}
+
+void CborWriter::addHex(const uint8_t* data, size_t count) {
+    static const char DIGITS[] = "0123456789ABCDEF";
+    if (!writeHead(MAJOR_TEXT, count * 2, count * 2)) return;
+    for (size_t i = 0; i < count; i++) {
+        buffer[length++] = DIGITS[data[i] >> 4];
+        buffer[length++] = DIGITS[data[i] & 0x0F];
+    }
+}
@@ -0,0 +1,603 @@
+// CoapServer.cpp
+// CoAP endpoint of the hub with Observe and block-wise transfer. Messages are
+// parsed and answered in member buffers; nothing here allocates or depends on
+// the platform, so the same code runs in tools/coap_host_server.cpp.
+
+#include "CoapServer.h"
+#include "CborWriter.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+    constexpr uint8_t VERSION = 1;
+    constexpr uint8_t TYPE_CONFIRMABLE = 0;
+    constexpr uint8_t TYPE_NON_CONFIRMABLE = 1;
+    constexpr uint8_t TYPE_ACKNOWLEDGEMENT = 2;
+    constexpr uint8_t TYPE_RESET = 3;
+    constexpr uint8_t PAYLOAD_MARKER = 0xFF;
+
+    // Codes as class << 5 | detail
+    constexpr uint8_t CODE_EMPTY = 0x00;
+    constexpr uint8_t CODE_GET = 0x01;
+    constexpr uint8_t CODE_CONTENT = 0x45;                  // 2.05
+    constexpr uint8_t CODE_BAD_REQUEST = 0x80;              // 4.00
+    constexpr uint8_t CODE_BAD_OPTION = 0x82;               // 4.02
+    constexpr uint8_t CODE_NOT_FOUND = 0x84;                // 4.04
+    constexpr uint8_t CODE_METHOD_NOT_ALLOWED = 0x85;       // 4.05
+    constexpr uint8_t CODE_NOT_ACCEPTABLE = 0x86;           // 4.06
+    constexpr uint8_t CODE_INTERNAL_ERROR = 0xA0;           // 5.00
+    constexpr uint8_t CODE_PROXYING_NOT_SUPPORTED = 0xA5;   // 5.05
+
+    constexpr uint16_t OPTION_URI_HOST = 3;
+    constexpr uint16_t OPTION_ETAG = 4;
+    constexpr uint16_t OPTION_OBSERVE = 6;
+    constexpr uint16_t OPTION_URI_PORT = 7;
+    constexpr uint16_t OPTION_URI_PATH = 11;
+    constexpr uint16_t OPTION_CONTENT_FORMAT = 12;
+    constexpr uint16_t OPTION_URI_QUERY = 15;
+    constexpr uint16_t OPTION_ACCEPT = 17;
+    constexpr uint16_t OPTION_BLOCK2 = 23;
+    constexpr uint16_t OPTION_SIZE2 = 28;
+    constexpr uint16_t OPTION_PROXY_URI = 35;
+    constexpr uint16_t OPTION_PROXY_SCHEME = 39;
+
+    constexpr uint16_t FORMAT_LINK = 40;
+    constexpr uint16_t FORMAT_CBOR = 60;
+
+    constexpr uint8_t OBSERVE_REGISTER = 0;
+    constexpr uint8_t OBSERVE_DEREGISTER = 1;
+    constexpr uint32_t OBSERVE_MASK = 0xFFFFFF;    // Observe values are 24 bits
+
+    constexpr uint8_t MAX_BLOCK_SZX = 5;           // 16 << 5 = COAP_BLOCK_SIZE
+    constexpr uint8_t MAX_SEGMENTS = 4;
+
+    static_assert((16u << MAX_BLOCK_SZX) == COAP_BLOCK_SIZE, "COAP_BLOCK_SIZE must match MAX_BLOCK_SZX");
+
+    uint32_t fnv1a(const uint8_t* data, size_t length, uint32_t hash = 2166136261u) {
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    const char* healthName(SensorHealth health) {
+        switch (health) {
+            case SensorHealth::ACTIVE: return "active";
+            case SensorHealth::SUSPECT: return "suspect";
+            case SensorHealth::QUARANTINED: return "quarantined";
+        }
+        return "unknown";
+    }
+
+    bool segmentIs(const uint8_t* segment, uint8_t length, const char* text) {
+        return strlen(text) == length && memcmp(segment, text, length) == 0;
+    }
+
+    int hexDigit(uint8_t c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    uint32_t readUint(const uint8_t* data, uint16_t length) {
+        uint32_t value = 0;
+        for (uint16_t i = 0; i < length; i++) {
+            value = value << 8 | data[i];
+        }
+        return value;
+    }
+
+    // Appends one option in delta encoding; returns the new position or 0 if it does not fit
+    size_t writeOption(uint8_t* out, size_t position, size_t capacity, uint16_t& lastNumber,
+                       uint16_t number, const uint8_t* value, uint16_t length) {
+        uint16_t delta = number - lastNumber;
+        uint8_t extra[4];
+        size_t extraLength = 0;
+        auto nibble = [&](uint16_t field) -> uint8_t {
+            if (field < 13) return field;
+            if (field < 269) {
+                extra[extraLength++] = field - 13;
+                return 13;
+            }
+            extra[extraLength++] = (field - 269) >> 8;
+            extra[extraLength++] = (field - 269) & 0xFF;
+            return 14;
+        };
+        uint8_t first = nibble(delta) << 4;
+        first |= nibble(length);
+
+        if (position + 1 + extraLength + length > capacity) return 0;
+        out[position++] = first;
+        memcpy(out + position, extra, extraLength);
+        position += extraLength;
+        memcpy(out + position, value, length);
+        lastNumber = number;
+        return position + length;
+    }
+
+    // Unsigned option values use the fewest bytes, zero bytes for zero
+    uint16_t encodeUint(uint32_t value, uint8_t* out) {
+        uint16_t length = value > 0xFFFFFF ? 4 : value > 0xFFFF ? 3 : value > 0xFF ? 2 : value > 0 ? 1 : 0;
+        for (uint16_t i = 0; i < length; i++) {
+            out[i] = static_cast<uint8_t>(value >> (8 * (length - 1 - i)));
+        }
+        return length;
+    }
+}
+
+struct CoapServer::Request {
+    uint8_t type;
+    uint8_t code;
+    uint16_t messageId;
+    const uint8_t* token;
+    uint8_t tokenLength;
+    const uint8_t* segments[MAX_SEGMENTS];
+    uint8_t segmentLengths[MAX_SEGMENTS];
+    uint8_t segmentCount;
+    bool pathTooLong;
+    int32_t observe;          // -1 if absent
+    int32_t accept;           // -1 if absent
+    bool hasBlock2;
+    uint32_t block2Number;
+    uint8_t block2Szx;
+    uint8_t optionError;      // CODE_BAD_OPTION, CODE_BAD_REQUEST or CODE_PROXYING_NOT_SUPPORTED
+};
+
+CoapServer::CoapServer()
+    : sensorCount(0)
+    , relayCount(0)
+    , observeSequence(0)
+    , nextMessageId(0)
+    , sender(nullptr)
+    , senderContext(nullptr) {
+    memset(sensors, 0, sizeof(sensors));
+    memset(relays, 0, sizeof(relays));
+    memset(observers, 0, sizeof(observers));
+}
+
+void CoapServer::begin(Sender callback, void* context, uint16_t messageIdSeed) {
+    sender = callback;
+    senderContext = context;
+    nextMessageId = messageIdSeed;
+}
+
+uint8_t CoapServer::getObserverCount() const {
+    uint8_t count = 0;
+    for (const auto& observer : observers) {
+        if (observer.active) count++;
+    }
+    return count;
+}
+
+void CoapServer::refresh(const CoapSensorSample* samples, size_t count,
+                         const bool* relayStates, uint8_t states) {
+    sensorCount = count < SENSOR_TABLE_CAPACITY ? count : SENSOR_TABLE_CAPACITY;
+    memcpy(sensors, samples, sensorCount * sizeof(CoapSensorSample));
+    relayCount = states < COAP_MAX_RELAYS ? states : COAP_MAX_RELAYS;
+    memcpy(relays, relayStates, relayCount * sizeof(bool));
+
+    for (auto& observer : observers) {
+        if (observer.active) notify(observer);
+    }
+}
+
+// Sends a notification if the observed representation changed since the last one
+void CoapServer::notify(Observer& observer) {
+    size_t length = 0;
+    uint16_t contentFormat = FORMAT_CBOR;
+    uint8_t code = encode(observer.target, length, contentFormat);
+    uint32_t etag = fnv1a(representation, length, contentFormat);
+    if (code == CODE_CONTENT && etag == observer.etag) return;
+
+    uint8_t type = TYPE_NON_CONFIRMABLE;
+    if (++observer.sinceConfirmable >= COAP_CONFIRM_EVERY) {
+        // The previous confirmable notification was never acknowledged: the client is gone
+        if (observer.awaitingAck) {
+            observer.active = false;
+            return;
+        }
+        type = TYPE_CONFIRMABLE;
+        observer.sinceConfirmable = 0;
+    }
+
+    uint16_t messageId = nextMessageId++;
+    observer.lastMessageId = messageId;
+    if (type == TYPE_CONFIRMABLE) {
+        observer.awaitingAck = true;
+        observer.confirmableId = messageId;
+    }
+
+    // An error response ends the observation (RFC 7641 section 3.2)
+    int32_t sequence = static_cast<int32_t>(observeSequence = (observeSequence + 1) & OBSERVE_MASK);
+    size_t size = writeResponse(type, code, messageId, observer.token, observer.tokenLength,
+                                code == CODE_CONTENT ? &sequence : nullptr, contentFormat,
+                                observer.blockSzx, 0, length);
+    observer.etag = etag;
+    if (code != CODE_CONTENT) observer.active = false;
+    send(observer.endpoint, size);
+}
+
+void CoapServer::handleMessage(const uint8_t* data, size_t length, const CoapEndpoint& source) {
+    if (length < 4 || (data[0] >> 6) != VERSION) return;
+
+    Request request = {};
+    request.type = (data[0] >> 4) & 0x03;
+    request.tokenLength = data[0] & 0x0F;
+    request.code = data[1];
+    request.messageId = static_cast<uint16_t>(data[2] << 8 | data[3]);
+    request.observe = -1;
+    request.accept = -1;
+
+    // Format errors are answered with a reset if the message was confirmable
+    bool formatError = request.tokenLength > 8 || 4u + request.tokenLength > length;
+    if (formatError || request.code == CODE_EMPTY) {
+        if (!formatError && (request.type == TYPE_ACKNOWLEDGEMENT || request.type == TYPE_RESET)) {
+            handleReply(request.type, request.messageId, source);
+        } else if (request.type == TYPE_CONFIRMABLE) {
+            // Also the reply to a CoAP ping (empty confirmable message)
+            message[0] = VERSION << 6 | TYPE_RESET << 4;
+            message[1] = CODE_EMPTY;
+            message[2] = data[2];
+            message[3] = data[3];
+            send(source, 4);
+        }
+        return;
+    }
+    // Responses from the client (codes 2.xx and up) are not expected
+    if (request.code >= 0x20) return;
+    if (request.type == TYPE_ACKNOWLEDGEMENT || request.type == TYPE_RESET) return;
+
+    request.token = data + 4;
+    size_t position = 4 + request.tokenLength;
+    uint16_t number = 0;
+    while (position < length && data[position] != PAYLOAD_MARKER) {
+        uint16_t delta = data[position] >> 4;
+        uint16_t optionLength = data[position] & 0x0F;
+        position++;
+
+        bool bad = false;
+        auto extend = [&](uint16_t& field) {
+            if (field == 13) {
+                if (position >= length) { bad = true; return; }
+                field = 13 + data[position++];
+            } else if (field == 14) {
+                if (position + 1 >= length) { bad = true; return; }
+                field = 269 + (data[position] << 8 | data[position + 1]);
+                position += 2;
+            } else if (field == 15) {
+                bad = true;
+            }
+        };
+        extend(delta);
+        extend(optionLength);
+        if (bad || position + optionLength > length) {
+            request.optionError = CODE_BAD_REQUEST;
+            break;
+        }
+        number += delta;
+        const uint8_t* value = data + position;
+        position += optionLength;
+
+        switch (number) {
+            case OPTION_URI_PATH:
+                if (request.segmentCount < MAX_SEGMENTS) {
+                    request.segments[request.segmentCount] = value;
+                    request.segmentLengths[request.segmentCount] = static_cast<uint8_t>(optionLength);
+                    request.segmentCount++;
+                } else {
+                    request.pathTooLong = true;
+                }
+                break;
+            case OPTION_OBSERVE:
+                request.observe = static_cast<int32_t>(readUint(value, optionLength > 3 ? 3 : optionLength));
+                break;
+            case OPTION_ACCEPT:
+                request.accept = static_cast<int32_t>(readUint(value, optionLength > 2 ? 2 : optionLength));
+                break;
+            case OPTION_BLOCK2: {
+                uint32_t block = readUint(value, optionLength > 3 ? 3 : optionLength);
+                request.hasBlock2 = true;
+                request.block2Number = block >> 4;
+                request.block2Szx = block & 0x07;
+                if (request.block2Szx == 7) request.optionError = CODE_BAD_REQUEST;
+                break;
+            }
+            case OPTION_PROXY_URI:
+            case OPTION_PROXY_SCHEME:
+                request.optionError = CODE_PROXYING_NOT_SUPPORTED;
+                break;
+            case OPTION_URI_HOST:
+            case OPTION_URI_PORT:
+            case OPTION_URI_QUERY:
+                break;   // Served the same for any host, port or query
+            default:
+                // Unrecognized critical (odd) options must be rejected
+                if ((number & 1) && !request.optionError) request.optionError = CODE_BAD_OPTION;
+                break;
+        }
+        if (request.optionError == CODE_BAD_REQUEST) break;
+    }
+
+    handleRequest(request, source);
+}
+
+void CoapServer::handleReply(uint8_t type, uint16_t messageId, const CoapEndpoint& source) {
+    for (auto& observer : observers) {
+        if (!observer.active || observer.endpoint.port != source.port ||
+            memcmp(observer.endpoint.ip, source.ip, 4) != 0) {
+            continue;
+        }
+        if (type == TYPE_ACKNOWLEDGEMENT && observer.awaitingAck && observer.confirmableId == messageId) {
+            observer.awaitingAck = false;
+        } else if (type == TYPE_RESET &&
+                   (observer.lastMessageId == messageId ||
+                    (observer.awaitingAck && observer.confirmableId == messageId))) {
+            // A reset is how a client that lost interest cancels (RFC 7641 section 3.6)
+            observer.active = false;
+        }
+    }
+}
+
+void CoapServer::handleRequest(const Request& request, const CoapEndpoint& source) {
+    // Piggybacked on the acknowledgement, or a new non-confirmable message
+    uint8_t type = request.type == TYPE_CONFIRMABLE ? TYPE_ACKNOWLEDGEMENT : TYPE_NON_CONFIRMABLE;
+    uint16_t messageId = request.type == TYPE_CONFIRMABLE ? request.messageId : nextMessageId++;
+    auto reply = [&](uint8_t code) {
+        send(source, writeResponse(type, code, messageId, request.token, request.tokenLength,
+                                   nullptr, 0, 0, 0, 0));
+    };
+
+    if (request.optionError) return reply(request.optionError);
+    if (request.code != CODE_GET) return reply(CODE_METHOD_NOT_ALLOWED);
+
+    Target target;
+    if (!resolve(request, target)) return reply(CODE_NOT_FOUND);
+
+    size_t length = 0;
+    uint16_t contentFormat = FORMAT_CBOR;
+    uint8_t code = encode(target, length, contentFormat);
+    if (code != CODE_CONTENT) {
+        // A failed request also ends an existing observation with this token
+        Observer* existing = findObserver(source, request.token, request.tokenLength);
+        if (existing) existing->active = false;
+        return reply(code);
+    }
+    if (request.accept >= 0 && request.accept != contentFormat) return reply(CODE_NOT_ACCEPTABLE);
+
+    uint8_t szx = request.hasBlock2 && request.block2Szx < MAX_BLOCK_SZX ? request.block2Szx : MAX_BLOCK_SZX;
+    uint32_t block = request.hasBlock2 ? request.block2Number : 0;
+    if (block > 0 && block * (16u << szx) >= length) return reply(CODE_BAD_OPTION);
+
+    // Only a request for the first block can register (RFC 7959 section 2.6)
+    int32_t sequence = -1;
+    if (block == 0 && request.observe == OBSERVE_REGISTER) {
+        Observer* observer = registerObserver(request, source, target);
+        if (observer) {
+            observer->blockSzx = szx;
+            observer->etag = fnv1a(representation, length, contentFormat);
+            sequence = static_cast<int32_t>(observeSequence = (observeSequence + 1) & OBSERVE_MASK);
+        }
+    } else if (request.observe == OBSERVE_DEREGISTER) {
+        Observer* observer = findObserver(source, request.token, request.tokenLength);
+        if (observer) observer->active = false;
+    }
+
+    send(source, writeResponse(type, CODE_CONTENT, messageId, request.token, request.tokenLength,
+                               sequence >= 0 ? &sequence : nullptr, contentFormat, szx, block, length));
+}
+
+CoapServer::Observer* CoapServer::findObserver(const CoapEndpoint& endpoint, const uint8_t* token,
+                                               uint8_t tokenLength) {
+    for (auto& observer : observers) {
+        if (observer.active && observer.endpoint.port == endpoint.port &&
+            memcmp(observer.endpoint.ip, endpoint.ip, 4) == 0 &&
+            observer.tokenLength == tokenLength && memcmp(observer.token, token, tokenLength) == 0) {
+            return &observer;
+        }
+    }
+    return nullptr;
+}
+
+// Same endpoint and token replaces the registration; a full table declines it
+CoapServer::Observer* CoapServer::registerObserver(const Request& request, const CoapEndpoint& source,
+                                                   const Target& target) {
+    Observer* observer = findObserver(source, request.token, request.tokenLength);
+    if (!observer) {
+        for (auto& candidate : observers) {
+            if (!candidate.active) {
+                observer = &candidate;
+                break;
+            }
+        }
+    }
+    if (!observer) return nullptr;
+
+    memset(observer, 0, sizeof(*observer));
+    observer->active = true;
+    observer->endpoint = source;
+    memcpy(observer->token, request.token, request.tokenLength);
+    observer->tokenLength = request.tokenLength;
+    observer->target = target;
+    return observer;
+}
+
+bool CoapServer::resolve(const Request& request, Target& target) const {
+    memset(&target, 0, sizeof(target));
+    if (request.pathTooLong) return false;
+
+    const uint8_t* const* segments = request.segments;
+    const uint8_t* lengths = request.segmentLengths;
+    if (request.segmentCount == 2 && segmentIs(segments[0], lengths[0], ".well-known") &&
+        segmentIs(segments[1], lengths[1], "core")) {
+        target.resource = Resource::DISCOVERY;
+        return true;
+    }
+    if (request.segmentCount == 1 && segmentIs(segments[0], lengths[0], "sensors")) {
+        target.resource = Resource::SENSOR_LIST;
+        return true;
+    }
+    if (request.segmentCount == 2 && segmentIs(segments[0], lengths[0], "sensors") && lengths[1] == 16) {
+        for (uint8_t i = 0; i < 8; i++) {
+            int high = hexDigit(segments[1][2 * i]);
+            int low = hexDigit(segments[1][2 * i + 1]);
+            if (high < 0 || low < 0) return false;
+            target.address[i] = static_cast<uint8_t>(high << 4 | low);
+        }
+        target.resource = Resource::SENSOR;
+        return true;
+    }
+    if (request.segmentCount == 2 && segmentIs(segments[0], lengths[0], "relays") &&
+        lengths[1] == 1 && segments[1][0] >= '0' && segments[1][0] <= '9') {
+        target.resource = Resource::RELAY;
+        target.relay = segments[1][0] - '0';
+        return true;
+    }
+    return false;
+}
+
+int CoapServer::findSensor(const uint8_t* address) const {
+    for (size_t i = 0; i < sensorCount; i++) {
+        if (memcmp(sensors[i].address, address, 8) == 0) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+uint8_t CoapServer::encode(const Target& target, size_t& length, uint16_t& contentFormat) {
+    contentFormat = FORMAT_CBOR;
+    CborWriter out(representation, sizeof(representation));
+    auto writeSensor = [&](const CoapSensorSample& sensor) {
+        out.beginMap(5);
+        out.addText("rom");
+        out.addHex(sensor.address, 8);
+        out.addText("temp");
+        if (sensor.temperature == SensorTable::NO_READING_C) {
+            out.addNull();
+        } else {
+            out.addFloat(sensor.temperature);
+        }
+        out.addText("valid");
+        out.addBool(sensor.valid);
+        out.addText("health");
+        out.addText(healthName(sensor.health));
+        out.addText("anomalies");
+        out.addUnsigned(sensor.anomalyMask);
+    };
+
+    switch (target.resource) {
+        case Resource::DISCOVERY:
+            contentFormat = FORMAT_LINK;
+            length = encodeDiscovery();
+            return length ? CODE_CONTENT : CODE_INTERNAL_ERROR;
+        case Resource::SENSOR_LIST:
+            out.beginArray(sensorCount);
+            for (size_t i = 0; i < sensorCount; i++) {
+                writeSensor(sensors[i]);
+            }
+            break;
+        case Resource::SENSOR: {
+            int index = findSensor(target.address);
+            if (index < 0) return CODE_NOT_FOUND;
+            writeSensor(sensors[index]);
+            break;
+        }
+        case Resource::RELAY:
+            if (target.relay >= relayCount) return CODE_NOT_FOUND;
+            out.beginMap(2);
+            out.addText("id");
+            out.addUnsigned(target.relay);
+            out.addText("state");
+            out.addBool(relays[target.relay]);
+            break;
+        case Resource::NONE:
+            return CODE_NOT_FOUND;
+    }
+
+    length = out.size();
+    return out.overflowed() ? CODE_INTERNAL_ERROR : CODE_CONTENT;
+}
+
+// CoRE link format (RFC 6690) of every resource; 0 if it does not fit
+size_t CoapServer::encodeDiscovery() {
+    size_t length = 0;
+    auto append = [&](const char* text) {
+        size_t count = strlen(text);
+        if (length + count > sizeof(representation)) return false;
+        memcpy(representation + length, text, count);
+        length += count;
+        return true;
+    };
+
+    bool fits = append("</sensors>;ct=60;obs");
+    char link[48];
+    for (size_t i = 0; i < sensorCount && fits; i++) {
+        const uint8_t* a = sensors[i].address;
+        snprintf(link, sizeof(link), ",</sensors/%02X%02X%02X%02X%02X%02X%02X%02X>;ct=60;obs",
+                 a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+        fits = append(link);
+    }
+    for (uint8_t i = 0; i < relayCount && fits; i++) {
+        snprintf(link, sizeof(link), ",</relays/%u>;ct=60;obs", i);
+        fits = append(link);
+    }
+    return fits ? length : 0;
+}
+
+// Header, token and options in ascending order, then the requested block of
+// the representation. Observe, ETag and the block options only go with 2.05.
+size_t CoapServer::writeResponse(uint8_t type, uint8_t code, uint16_t messageId,
+                                 const uint8_t* token, uint8_t tokenLength,
+                                 const int32_t* observe, uint16_t contentFormat, uint8_t szx, uint32_t block,
+                                 size_t representationLength) {
+    message[0] = VERSION << 6 | type << 4 | tokenLength;
+    message[1] = code;
+    message[2] = messageId >> 8;
+    message[3] = messageId & 0xFF;
+    memcpy(message + 4, token, tokenLength);
+    size_t position = 4 + tokenLength;
+    if (code != CODE_CONTENT) return position;
+
+    size_t blockSize = 16u << szx;
+    size_t offset = block * blockSize;
+    bool blockwise = block > 0 || representationLength > blockSize;
+    size_t payload = representationLength - offset < blockSize ? representationLength - offset : blockSize;
+    bool more = offset + payload < representationLength;
+
+    uint8_t value[4];
+    uint16_t last = 0;
+    auto option = [&](uint16_t number, uint16_t valueLength) {
+        if (position > 0) {
+            position = writeOption(message, position, sizeof(message), last, number, value, valueLength);
+        }
+    };
+
+    uint32_t etag = fnv1a(representation, representationLength, contentFormat);
+    for (uint8_t i = 0; i < 4; i++) {
+        value[i] = static_cast<uint8_t>(etag >> (24 - 8 * i));
+    }
+    option(OPTION_ETAG, 4);
+    if (observe) option(OPTION_OBSERVE, encodeUint(static_cast<uint32_t>(*observe), value));
+    option(OPTION_CONTENT_FORMAT, encodeUint(contentFormat, value));
+    if (blockwise) {
+        option(OPTION_BLOCK2, encodeUint(block << 4 | (more ? 0x08 : 0) | szx, value));
+        if (block == 0) option(OPTION_SIZE2, encodeUint(static_cast<uint32_t>(representationLength), value));
+    }
+    if (position == 0 || position + 1 + payload > sizeof(message)) {
+        // Cannot happen with COAP_MAX_MESSAGE sized for the largest block
+        message[1] = CODE_INTERNAL_ERROR;
+        return 4 + tokenLength;
+    }
+
+    if (payload > 0) {
+        message[position++] = PAYLOAD_MARKER;
+        memcpy(message + position, representation + offset, payload);
+        position += payload;
+    }
+    return position;
+}
+
+void CoapServer::send(const CoapEndpoint& destination, size_t length) {
+    if (sender && length > 0) {
+        sender(destination, message, length, senderContext);
+    }
+}
@@ -0,0 +1,157 @@
+// CoapTask.cpp
+#include "CoapTask.h"
+#include "OneWireTask.h"
+#include "ControlTask.h"
+#include "PreferencesManager.h"
+#include "RtosResources.h"
+#include "Logger.h"
+#include "FixedString.h"
+#include <esp_random.h>
+#include <lwip/sockets.h>
+
+// Static member initialization
+CoapConfig CoapTask::config = {false, COAP_UDP_PORT};
+CoapServer CoapTask::server;
+TemperatureSensor CoapTask::snapshot[SENSOR_TABLE_CAPACITY] = {};
+CoapSensorSample CoapTask::samples[SENSOR_TABLE_CAPACITY] = {};
+size_t CoapTask::sampleCount = 0;
+bool CoapTask::relays[RELAY_COUNT] = {};
+uint8_t CoapTask::packet[COAP_MAX_MESSAGE] = {};
+TaskHandle_t CoapTask::taskHandle = nullptr;
+int CoapTask::udpSocket = -1;
+volatile bool CoapTask::running = false;
+
+void CoapTask::init() {
+    PreferencesManager::getCoapConfig(config);
+    server.begin(sendMessage, nullptr, static_cast<uint16_t>(esp_random()));
+    
+    Logger::info(makeFixedString<64>("CoAP %s, port %u",
+                                     config.enabled ? "enabled" : "disabled", config.port).c_str());
+}
+
+void CoapTask::start() {
+    if (!config.enabled) return;
+    taskHandle = RtosResources::createTask(TaskId::COAP, taskFunction);
+}
+
+void CoapTask::notifyReadingsUpdated() {
+    if (taskHandle) xTaskNotifyGive(taskHandle);
+}
+
+bool CoapTask::isRunning() {
+    return running;
+}
+
+uint8_t CoapTask::getObserverCount() {
+    return server.getObserverCount();
+}
+
+void CoapTask::taskFunction(void* parameter) {
+    takeSnapshot();
+    relaysChanged();
+    server.refresh(samples, sampleCount, relays, RELAY_COUNT);
+    
+    while (true) {
+        if (udpSocket < 0 && !openSocket()) {
+            vTaskDelay(pdMS_TO_TICKS(5000));
+            continue;
+        }
+        
+        // select() cannot wait on a task notification, so the timeout bounds
+        // how late observers hear about a new snapshot
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(udpSocket, &readSet);
+        timeval timeout = {0, static_cast<long>(COAP_POLL_INTERVAL * 1000)};
+        int ready = select(udpSocket + 1, &readSet, nullptr, nullptr, &timeout);
+        if (ready < 0) {
+            Logger::error("CoAP select failed: " + String(errno), Logger::Category::NETWORK);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        if (ready > 0) receivePacket();
+        
+        bool newSnapshot = ulTaskNotifyTake(pdTRUE, 0) > 0;
+        if (newSnapshot) takeSnapshot();
+        if (relaysChanged() || newSnapshot) {
+            server.refresh(samples, sampleCount, relays, RELAY_COUNT);
+        }
+    }
+}
+
+bool CoapTask::openSocket() {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        Logger::error("CoAP socket creation failed", Logger::Category::NETWORK);
+        return false;
+    }
+    
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(config.port);
+    if (bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        Logger::error("CoAP bind to port " + String(config.port) + " failed: " + String(errno),
+                      Logger::Category::NETWORK);
+        close(sock);
+        return false;
+    }
+    
+    udpSocket = sock;
+    running = true;
+    Logger::info("CoAP endpoint on UDP port " + String(config.port), Logger::Category::NETWORK);
+    return true;
+}
+
+void CoapTask::receivePacket() {
+    sockaddr_in peer = {};
+    socklen_t peerLength = sizeof(peer);
+    int received = recvfrom(udpSocket, packet, sizeof(packet), 0,
+                            reinterpret_cast<sockaddr*>(&peer), &peerLength);
+    if (received <= 0) return;
+    
+    CoapEndpoint source = {};
+    memcpy(source.ip, &peer.sin_addr.s_addr, 4);
+    source.port = ntohs(peer.sin_port);
+    server.handleMessage(packet, received, source);
+}
+
+void CoapTask::takeSnapshot() {
+    sampleCount = OneWireTask::manager.getSensors(snapshot, SENSOR_TABLE_CAPACITY);
+    
+    for (size_t i = 0; i < sampleCount; i++) {
+        const TemperatureSensor& sensor = snapshot[i];
+        CoapSensorSample& sample = samples[i];
+        memcpy(sample.address, sensor.address, 8);
+        sample.temperature = sensor.temperature;
+        sample.health = sensor.health;
+        sample.anomalyMask = sensor.anomalyMask;
+        sample.valid = sensor.valid;
+    }
+}
+
+bool CoapTask::relaysChanged() {
+    bool changed = false;
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        bool state = ControlTask::getRelayState(i);
+        if (state != relays[i]) {
+            relays[i] = state;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void CoapTask::sendMessage(const CoapEndpoint& destination, const uint8_t* message,
+                           size_t length, void* context) {
+    if (udpSocket < 0) return;
+    
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    memcpy(&address.sin_addr.s_addr, destination.ip, 4);
+    address.sin_port = htons(destination.port);
+    sendto(udpSocket, message, length, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+}
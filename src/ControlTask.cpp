@@ -2,6 +2,7 @@
 #include "PreferencesManager.h"
 #include "OneWireTask.h"
 #include "NetworkTask.h"
+#include "RtosResources.h"
 #include <cstring>
 #include <cstddef>
 #include <Arduino.h>
@@ -9,6 +10,9 @@
 // Static member initializations
 DisplayManager ControlTask::display(DISPLAY_CLK, DISPLAY_DIO);
 RelayState ControlTask::relayStates[2] = {{false, false, 0}, {false, false, 0}};
+ThermostatController ControlTask::controlLoops[2];
+ControlLoopStats ControlTask::loopStats[2] = {};
+RuleEngine ControlTask::rules;
 QueueHandle_t ControlTask::controlQueue = nullptr;
 SemaphoreHandle_t ControlTask::stateMutex = nullptr;
 
@@ -16,7 +20,7 @@ void ControlTask::init() {
     Logger::info("Starting ControlTask initialization");
     
     // Create control queue
-    controlQueue = xQueueCreate(10, sizeof(TaskMessage));
+    controlQueue = RtosResources::createQueue(QueueId::CONTROL);
     if (!controlQueue) {
         Logger::error("Failed to create control queue");
         return;
@@ -24,7 +28,7 @@ void ControlTask::init() {
     Logger::info("Control queue created");
     
     // Create mutex
-    stateMutex = xSemaphoreCreateMutex();
+    stateMutex = RtosResources::createMutex(MutexId::CONTROL_STATE);
     if (!stateMutex) {
         Logger::error("Failed to create state mutex");
         return;
@@ -43,26 +47,16 @@ void ControlTask::init() {
                  
     display.init();  // Initialize the display
     
+    loadControlConfig();
+    loadRules();
+    
     Logger::info("ControlTask initialization complete");
 }
 
 void ControlTask::start() {
     Logger::info("Starting ControlTask creation");
     
-    TaskHandle_t taskHandle;
-    BaseType_t result = xTaskCreate(
-        taskFunction,
-        "ControlTask",
-        CONTROL_TASK_STACK_SIZE,
-        nullptr,
-        CONTROL_TASK_PRIORITY,
-        &taskHandle
-    );
-    
-    if (result != pdPASS) {
-        Logger::error("Failed to create ControlTask - error code: " + String(result));
-        return;
-    }
+    TaskHandle_t taskHandle = RtosResources::createTask(TaskId::CONTROL, taskFunction);
     
     if (taskHandle == nullptr) {
         Logger::error("Task handle is null after creation");
@@ -85,41 +79,74 @@ void ControlTask::taskFunction(void* parameter) {
     const uint32_t PUBLISH_RETRY_INTERVAL = 5000; // 5 seconds between retries
     
     Logger::info("Control task starting");
+    loadDisplayConfig(displaySensorAddr);
     
     while (true) {
-        // Handle relay control messages
+        // Block until a message arrives or the next display tick is due, so
+        // control loops react to new readings without waiting for the tick
+        TickType_t elapsed = xTaskGetTickCount() - lastWakeTime;
+        TickType_t interval = pdMS_TO_TICKS(DISPLAY_UPDATE_INTERVAL);
+        TickType_t wait = elapsed < interval ? interval - elapsed : 0;
+        
+        // Wake up early when a temporary display message is due to expire
+        uint32_t displayWait = display.msUntilNextEvent(millis());
+        if (displayWait != UINT32_MAX && pdMS_TO_TICKS(displayWait) < wait) {
+            wait = pdMS_TO_TICKS(displayWait);
+        }
+        
+        bool newReadings = false;
         TaskMessage msg;
-        while (xQueueReceive(controlQueue, &msg, 0) == pdTRUE) {
+        while (xQueueReceive(controlQueue, &msg, wait) == pdTRUE) {
+            wait = 0;  // Drain remaining messages without blocking
+            
             if (msg.type == MessageType::RELAY_CHANGE_REQUEST) {
                 uint8_t relayId = msg.data.relayChange.relayId;
                 bool newState = msg.data.relayChange.state;
                 
+                if (controlLoops[relayId].isActive()) {
+                    Logger::warning("Relay " + String(relayId) + 
+                                  " is under closed-loop control - manual request ignored");
+                    continue;
+                }
+                
                 if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
                     relayStates[relayId].requested = newState;
                     xSemaphoreGive(stateMutex);
                 }
+            } else if (msg.type == MessageType::TEMPERATURE_UPDATE) {
+                newReadings = true;
+            } else if (msg.type == MessageType::CONTROL_CONFIG_UPDATE) {
+                loadControlConfig();
+                newReadings = true;  // Re-evaluate with the new configuration
+            } else if (msg.type == MessageType::RULES_UPDATE) {
+                loadRules();
+                newReadings = true;  // Feed current readings to new rules
+            } else if (msg.type == MessageType::DISPLAY_CONFIG_UPDATE) {
+                loadDisplayConfig(displaySensorAddr);
+                newReadings = true;  // Render the new playlist right away
             }
         }
         
-        // Update physical relay states if needed
-        if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            for (int i = 0; i < 2; i++) {
-                if (relayStates[i].requested != relayStates[i].actual) {
-                    digitalWrite(i == 0 ? RELAY_1_PIN : RELAY_2_PIN, 
-                               relayStates[i].requested ? HIGH : LOW);
-                    
-                    relayStates[i].actual = relayStates[i].requested;
-                    relayStates[i].lastChangeTime = millis();
-                    
-                    Logger::info("Relay " + String(i) + " state changed to " + 
-                               String(relayStates[i].actual ? "ON" : "OFF"));
-                }
-            }
-            xSemaphoreGive(stateMutex);
+        // Run control loops: full evaluation on new readings, otherwise only
+        // time-proportioning and minimum on/off checks
+        evaluateControlLoops(newReadings);
+        evaluateRules(newReadings);
+        applyRelayStates();
+        
+        // Playlist frames are rendered once per snapshot; rotation only swaps buffers
+        if (newReadings && display.isPlaylistActive()) {
+            display.updateSnapshot(OneWireTask::manager.getSensorList());
+        }
+        display.service(millis());
+        
+        if (xTaskGetTickCount() - lastWakeTime < interval) {
+            continue;  // Display tick not due yet
         }
+        lastWakeTime = xTaskGetTickCount();
         
-        // Get current preferences
-        PreferencesManager::getDisplaySensor(displaySensorAddr);
+        // With a playlist the display rotates on its own; the selected sensor
+        // is still tracked for the auxiliary MQTT topic
+        bool singleSensorDisplay = !display.isPlaylistActive();
         
         // Check if sensor selection changed
         if (memcmp(currentSensorAddr, displaySensorAddr, 8) != 0) {
@@ -135,8 +162,9 @@ void ControlTask::taskFunction(void* parameter) {
             memcpy(currentSensorAddr, displaySensorAddr, 8);
             
             // Show brief message indicating change
-            display.showMessage("CHG");
-            delay(500);
+            if (singleSensorDisplay) {
+                display.showTemporary("CHG", 500);
+            }
             
             // Reset last published temperature to force new publish
             lastPublishedTemp = -999.0f;
@@ -152,7 +180,9 @@ void ControlTask::taskFunction(void* parameter) {
                 sensorFound = true;
                 if (sensor.valid) {
                     float currentTemp = sensor.temperature;
-                    display.setTemperature(currentTemp);
+                    if (singleSensorDisplay) {
+                        display.setTemperature(currentTemp);
+                    }
                     Logger::debug("Temperature updated: " + String(currentTemp, 1));
                     
                     // Publish to MQTT if temperature changed by 0.1°C or more
@@ -172,7 +202,9 @@ void ControlTask::taskFunction(void* parameter) {
                         lastPublishAttempt = now;
                     }
                 } else {
-                    display.showMessage("ERR");
+                    if (singleSensorDisplay) {
+                        display.showMessage("ERR");
+                    }
                     Logger::warning("Selected sensor reading invalid");
                     
                     // Try to publish error state
@@ -198,18 +230,20 @@ void ControlTask::taskFunction(void* parameter) {
                 // Auto-select first sensor if none configured
                 PreferencesManager::setDisplaySensor(sensors[0].address);
                 memcpy(currentSensorAddr, sensors[0].address, 8);
-                display.showMessage("AUTO");
-                delay(500);
+                memcpy(displaySensorAddr, sensors[0].address, 8);
+                if (singleSensorDisplay) {
+                    display.showTemporary("AUTO", 500);
+                }
             } else {
-                display.showMessage("LOST");
+                if (singleSensorDisplay) {
+                    display.showMessage("LOST");
+                }
                 if (millis() - lastPublishAttempt >= PUBLISH_RETRY_INTERVAL) {
                     NetworkTask::publishToTopic(MQTT_AUX_DISPLAY_TOPIC, "lost");
                     lastPublishAttempt = millis();
                 }
             }
         }
-        
-        vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(DISPLAY_UPDATE_INTERVAL));
     }
 }
 
@@ -260,3 +294,272 @@ bool ControlTask::getRelayState(uint8_t relayId) {
     return state;
 }
 
+void ControlTask::applyRelayStates() {
+    // Update physical relay states if needed
+    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        for (int i = 0; i < 2; i++) {
+            if (relayStates[i].requested != relayStates[i].actual) {
+                digitalWrite(i == 0 ? RELAY_1_PIN : RELAY_2_PIN, 
+                           relayStates[i].requested ? HIGH : LOW);
+                
+                relayStates[i].actual = relayStates[i].requested;
+                relayStates[i].lastChangeTime = millis();
+                
+                if (controlLoops[i].isActive()) {
+                    loopStats[i].actuations++;
+                }
+                
+                Logger::info("Relay " + String(i) + " state changed to " + 
+                           String(relayStates[i].actual ? "ON" : "OFF"));
+            }
+        }
+        xSemaphoreGive(stateMutex);
+    }
+}
+
+void ControlTask::evaluateControlLoops(bool newReadings) {
+    if (!controlLoops[0].isActive() && !controlLoops[1].isActive()) {
+        return;
+    }
+    
+    static const std::vector<TemperatureSensor> noSensors;
+    const auto& sensors = newReadings ? OneWireTask::manager.getSensorList() : noSensors;
+    
+    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in evaluateControlLoops");
+        return;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        ThermostatController& loop = controlLoops[i];
+        if (!loop.isActive()) continue;
+        
+        uint32_t start = micros();
+        uint32_t now = millis();
+        
+        if (newReadings) {
+            // Look up the bound sensor and feed the new reading to the loop
+            bool found = false;
+            float input = 0.0f;
+            for (const auto& sensor : sensors) {
+                if (memcmp(sensor.address, loop.getConfig().sensorAddress, 8) == 0) {
+                    found = sensor.valid;
+                    input = sensor.temperature;
+                    break;
+                }
+            }
+            
+            loop.updateInput(input, found, now);
+            loopStats[i].evaluations++;
+            loopStats[i].lastEvalTime = now;
+            loopStats[i].lastInput = input;
+            loopStats[i].inputValid = found;
+            
+            if (!found) {
+                Logger::warning("Control loop " + String(i) + " input sensor unavailable");
+            }
+        }
+        
+        bool demand = loop.computeDemand(relayStates[i].actual, 
+                                         relayStates[i].lastChangeTime, now);
+        relayStates[i].requested = demand;
+        loopStats[i].demand = demand;
+        loopStats[i].output = loop.getOutput();
+        
+        if (newReadings) {
+            uint32_t duration = micros() - start;
+            loopStats[i].lastEvalMicros = duration;
+            if (duration > loopStats[i].maxEvalMicros) {
+                loopStats[i].maxEvalMicros = duration;
+            }
+        }
+    }
+    
+    xSemaphoreGive(stateMutex);
+}
+
+void ControlTask::loadControlConfig() {
+    // Only loops whose settings changed are reconfigured, so saving one
+    // setting does not reset the other loop or a manually switched relay
+    for (uint8_t i = 0; i < 2; i++) {
+        ControlLoopConfig config;
+        PreferencesManager::getControlLoop(i, config);
+        
+        bool changed = false;
+        if (stateMutex && xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            if (!controlLoops[i].hasConfig(config)) {
+                bool wasActive = controlLoops[i].isActive();
+                controlLoops[i].configure(config);
+                loopStats[i] = ControlLoopStats{};
+                if (wasActive && config.mode == ControlMode::OFF) {
+                    relayStates[i].requested = false;  // Release relays leaving closed-loop mode
+                }
+                changed = true;
+            }
+            xSemaphoreGive(stateMutex);
+        }
+        
+        if (changed) {
+            Logger::info("Control loop " + String(i) + " mode: " + 
+                        String(static_cast<int>(config.mode)));
+        }
+    }
+}
+
+void ControlTask::notifyReadingsUpdated() {
+    if (!controlQueue) return;
+    
+    TaskMessage msg;
+    msg.type = MessageType::TEMPERATURE_UPDATE;
+    msg.data.temperatureUpdate.sensorIndex = 0;
+    msg.data.temperatureUpdate.temperature = 0.0f;
+    
+    // Never block the OneWire task - a pending update already covers this one
+    xQueueSend(controlQueue, &msg, 0);
+}
+
+void ControlTask::reloadDisplayConfig() {
+    if (!controlQueue) return;
+    
+    TaskMessage msg;
+    msg.type = MessageType::DISPLAY_CONFIG_UPDATE;
+    if (xQueueSend(controlQueue, &msg, pdMS_TO_TICKS(100)) != pdPASS) {
+        Logger::error("Failed to queue display configuration reload");
+    }
+}
+
+// Read the display selection and playlist once, so display ticks never touch preferences
+void ControlTask::loadDisplayConfig(uint8_t* displaySensorAddr) {
+    PreferencesManager::getDisplaySensor(displaySensorAddr);
+    
+    DisplayPlaylistEntry playlist[MAX_PLAYLIST_ENTRIES];
+    uint8_t count = PreferencesManager::getDisplayPlaylist(playlist, MAX_PLAYLIST_ENTRIES);
+    display.setPlaylist(playlist, count);
+    
+    Logger::info("Display configuration loaded (" + 
+                (count > 0 ? String(count) + " playlist entries" : String("single sensor")) + ")");
+}
+
+void ControlTask::reloadControlConfig() {
+    if (!controlQueue) return;
+    
+    TaskMessage msg;
+    msg.type = MessageType::CONTROL_CONFIG_UPDATE;
+    if (xQueueSend(controlQueue, &msg, pdMS_TO_TICKS(100)) != pdPASS) {
+        Logger::error("Failed to queue control configuration reload");
+    }
+}
+
+bool ControlTask::getControlLoopStatus(uint8_t loopId, ControlLoopConfig& config, 
+                                       ControlLoopStats& stats) {
+    if (loopId >= 2 || !stateMutex) {
+        return false;
+    }
+    
+    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in getControlLoopStatus");
+        return false;
+    }
+    
+    config = controlLoops[loopId].getConfig();
+    stats = loopStats[loopId];
+    xSemaphoreGive(stateMutex);
+    return true;
+}
+
+void ControlTask::reloadRules() {
+    if (!controlQueue) return;
+    
+    TaskMessage msg;
+    msg.type = MessageType::RULES_UPDATE;
+    if (xQueueSend(controlQueue, &msg, pdMS_TO_TICKS(100)) != pdPASS) {
+        Logger::error("Failed to queue rules reload");
+    }
+}
+
+// Rules are updated slot by slot rather than cleared, so unchanged rules keep
+// their state and removed or disabled rules release the relay they held
+void ControlTask::loadRules() {
+    if (!stateMutex || xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in loadRules");
+        return;
+    }
+    
+    rules.setClock([]() -> uint32_t { return micros(); });
+    xSemaphoreGive(stateMutex);
+    
+    for (uint8_t i = 0; i < RULE_MAX_RULES; i++) {
+        RuleDefinition definition;
+        if (!PreferencesManager::getRule(i, definition)) {
+            definition.enabled = false;
+        }
+        
+        char error[64];
+        bool loaded = false;
+        if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            loaded = rules.setRule(i, definition, error, sizeof(error));
+            xSemaphoreGive(stateMutex);
+        }
+        
+        if (!definition.enabled) {
+            continue;
+        }
+        
+        if (loaded) {
+            Logger::info("Rule " + String(i) + " loaded: " + String(definition.condition));
+        } else {
+            Logger::error("Rule " + String(i) + " failed to compile: " + String(error));
+        }
+    }
+}
+
+void ControlTask::evaluateRules(bool newReadings) {
+    if (!rules.hasRules() && !rules.hasPendingReleases()) {
+        return;
+    }
+    
+    static const std::vector<TemperatureSensor> noSensors;
+    const auto& sensors = newReadings ? OneWireTask::manager.getSensorList() : noSensors;
+    
+    if (xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in evaluateRules");
+        return;
+    }
+    
+    uint32_t now = millis();
+    
+    // Only rules whose inputs changed are re-evaluated by the engine
+    for (const auto& sensor : sensors) {
+        rules.updateSensor(sensor.address, sensor.temperature, sensor.valid, now);
+    }
+    
+    // Hold timers are checked on every pass
+    rules.poll(now, applyRuleAction, nullptr);
+    
+    xSemaphoreGive(stateMutex);
+}
+
+// Called by the rule engine with stateMutex held
+void ControlTask::applyRuleAction(uint8_t relay, bool state, uint8_t ruleId, void* context) {
+    if (relay >= 2) return;
+    
+    if (controlLoops[relay].isActive()) {
+        Logger::warning("Rule " + String(ruleId) + " ignored - relay " + String(relay) + 
+                       " is under closed-loop control");
+        return;
+    }
+    
+    relayStates[relay].requested = state;
+    Logger::info("Rule " + String(ruleId) + " set relay " + String(relay) + 
+                " to " + String(state ? "ON" : "OFF"));
+}
+
+bool ControlTask::getRuleStatus(uint8_t ruleId, RuleStats& stats) {
+    if (!stateMutex || xSemaphoreTake(stateMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    
+    bool found = rules.getStats(ruleId, stats);
+    xSemaphoreGive(stateMutex);
+    return found;
+}
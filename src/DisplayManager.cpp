@@ -2,9 +2,32 @@
 #include "DisplayManager.h"
 #include "Logger.h"
 
+// Segment bits: a=0x01 b=0x02 c=0x04 d=0x08 e=0x10 f=0x20 g=0x40, point=0x80
+static const uint8_t SEGMENT_POINT = 0x80;
+static const uint8_t DIGIT_SEGMENTS[10] = {
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F
+};
+static const uint8_t LETTER_SEGMENTS[26] = {
+    0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71, 0x3D, 0x76, 0x06, 0x1E,  // A-J
+    0x75, 0x38, 0x37, 0x54, 0x3F, 0x73, 0x67, 0x50, 0x6D, 0x78,  // K-T
+    0x3E, 0x3E, 0x2A, 0x76, 0x6E, 0x5B                           // U-Z
+};
+
 DisplayManager::DisplayManager(uint8_t clkPin, uint8_t dioPin)
     : display(clkPin, dioPin)
-    , currentTemp(0.0f) {
+    , currentTemp(0.0f)
+    , haveTemp(false)
+    , temporaryActive(false)
+    , temporaryUntil(0)
+    , shownValid(false)
+    , transmitCount(0)
+    , playlistCount(0)
+    , playlistIndex(0)
+    , showingLabel(false)
+    , nextRotation(0) {
+    memset(baseSegments, 0, sizeof(baseSegments));
+    memset(temporarySegments, 0, sizeof(temporarySegments));
+    memset(shownSegments, 0, sizeof(shownSegments));
 }
 
 void DisplayManager::init() {
@@ -12,44 +35,36 @@ void DisplayManager::init() {
     display.begin();
     display.setBrightnessPercent(90);
     
-    showMessage("TEST");
-    delay(2000);
-    
+    // Self-test pattern; the regular content takes over when it expires
+    showTemporary("TEST", 2000);
     showMessage("----");
     Logger::info("Display initialization complete");
 }
 
 void DisplayManager::update() {
-    char tempStr[5];  // Buffer for temperature string
-    
-    if (currentTemp < -9.9 || currentTemp > 99.9) {
-        showMessage("ERR");
-        return;
-    }
-    
-    // Format temperature with one decimal place
-    int temp = abs(round(currentTemp * 10));
-    int whole = temp / 10;
-    int decimal = temp % 10;
-    
-    if (currentTemp < 0) {
-        snprintf(tempStr, sizeof(tempStr), "-%d.%d", whole, decimal);
-    } else {
-        snprintf(tempStr, sizeof(tempStr), "%d.%d", whole, decimal);
-    }
-    
-    showMessage(tempStr);
-    Logger::info("Display update: " + String(tempStr));
+    uint8_t segments[DIGIT_COUNT];
+    renderTemperature(currentTemp, segments);
+    setBase(segments);
 }
 
 void DisplayManager::showMessage(const char* text) {
-    display.display(text, false, false, 0);
-    Logger::info("Display message: " + String(text));
+    haveTemp = false;  // The next temperature must replace the message
+    uint8_t segments[DIGIT_COUNT];
+    renderText(text, segments);
+    setBase(segments);
+}
+
+void DisplayManager::showTemporary(const char* text, uint32_t durationMs) {
+    renderText(text, temporarySegments);
+    temporaryActive = true;
+    temporaryUntil = millis() + durationMs;
+    flush();
 }
 
 void DisplayManager::setTemperature(float temp) {
-    if (temp != currentTemp) {
+    if (!haveTemp || temp != currentTemp) {
         currentTemp = temp;
+        haveTemp = true;
         update();
     }
 }
@@ -59,5 +74,189 @@ void DisplayManager::setBrightness(uint8_t percent) {
 }
 
 void DisplayManager::clear() {
+    haveTemp = false;
     showMessage("    ");  // Four spaces
-}
\ No newline at end of file
+}
+
+void DisplayManager::service(uint32_t now) {
+    if (temporaryActive && static_cast<int32_t>(now - temporaryUntil) >= 0) {
+        temporaryActive = false;
+        flush();
+    }
+    
+    if (playlistCount > 0 && static_cast<int32_t>(now - nextRotation) >= 0) {
+        // Advance label -> value -> next entry's label
+        if (showingLabel) {
+            showingLabel = false;
+        } else {
+            playlistIndex = (playlistIndex + 1) % playlistCount;
+            showingLabel = playlist[playlistIndex].label[0] != '\0';
+        }
+        showPlaylistStep(now);
+    }
+}
+
+uint32_t DisplayManager::msUntilNextEvent(uint32_t now) const {
+    uint32_t next = UINT32_MAX;
+    
+    if (temporaryActive) {
+        int32_t remaining = static_cast<int32_t>(temporaryUntil - now);
+        next = remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+    }
+    if (playlistCount > 0) {
+        int32_t remaining = static_cast<int32_t>(nextRotation - now);
+        uint32_t rotation = remaining > 0 ? static_cast<uint32_t>(remaining) : 0;
+        if (rotation < next) next = rotation;
+    }
+    return next;
+}
+
+void DisplayManager::setPlaylist(const DisplayPlaylistEntry* entries, uint8_t count) {
+    playlistCount = count < MAX_PLAYLIST_ENTRIES ? count : MAX_PLAYLIST_ENTRIES;
+    
+    for (uint8_t i = 0; i < playlistCount; i++) {
+        playlist[i] = entries[i];
+        if (playlist[i].dwellSeconds == 0) playlist[i].dwellSeconds = 1;
+        renderText(playlist[i].label, labelFrames[i]);
+        renderText("----", valueFrames[i]);  // Until the first snapshot arrives
+    }
+    
+    playlistIndex = 0;
+    if (playlistCount > 0) {
+        showingLabel = playlist[0].label[0] != '\0';
+        showPlaylistStep(millis());
+    } else {
+        // Back to single-sensor mode; force the next reading to be rendered
+        haveTemp = false;
+    }
+}
+
+// Render value frames for all playlist entries from a new sensor snapshot
+void DisplayManager::updateSnapshot(const std::vector<TemperatureSensor>& sensors) {
+    for (uint8_t i = 0; i < playlistCount; i++) {
+        const char* fallback = "LOST";
+        for (const auto& sensor : sensors) {
+            if (memcmp(sensor.address, playlist[i].address, 8) == 0) {
+                if (sensor.valid) {
+                    renderTemperature(sensor.temperature, valueFrames[i]);
+                    fallback = nullptr;
+                } else {
+                    fallback = "ERR";
+                }
+                break;
+            }
+        }
+        if (fallback) {
+            renderText(fallback, valueFrames[i]);
+        }
+    }
+    
+    // A value currently on screen is refreshed right away
+    if (playlistCount > 0 && !showingLabel) {
+        setBase(valueFrames[playlistIndex]);
+    }
+}
+
+void DisplayManager::showPlaylistStep(uint32_t now) {
+    if (showingLabel) {
+        setBase(labelFrames[playlistIndex]);
+        nextRotation = now + LABEL_DURATION_MS;
+    } else {
+        setBase(valueFrames[playlistIndex]);
+        nextRotation = now + playlist[playlistIndex].dwellSeconds * 1000UL;
+    }
+}
+
+void DisplayManager::setBase(const uint8_t* segments) {
+    // A new value that renders identically (e.g. 21.04 -> 21.01) is not a change
+    if (memcmp(baseSegments, segments, DIGIT_COUNT) == 0 && shownValid) {
+        return;
+    }
+    memcpy(baseSegments, segments, DIGIT_COUNT);
+    flush();
+}
+
+// Transmit the visible layer only if it differs from what the display shows
+void DisplayManager::flush() {
+    const uint8_t* visible = temporaryActive ? temporarySegments : baseSegments;
+    if (shownValid && memcmp(shownSegments, visible, DIGIT_COUNT) == 0) {
+        return;
+    }
+    
+    display.displayRawBytes(visible, DIGIT_COUNT);
+    memcpy(shownSegments, visible, DIGIT_COUNT);
+    shownValid = true;
+    transmitCount++;
+    
+    Logger::debug("Display segments updated: " + String(visible[0], HEX) + " " + 
+                 String(visible[1], HEX) + " " + String(visible[2], HEX) + " " + 
+                 String(visible[3], HEX));
+}
+
+void DisplayManager::renderTemperature(float temp, uint8_t* segments) {
+    char tempStr[6];  // Buffer for temperature string
+    
+    if (temp < -9.9 || temp > 99.9) {
+        renderText("ERR", segments);
+        return;
+    }
+    
+    // Format temperature with one decimal place
+    int value = abs(round(temp * 10));
+    int whole = value / 10;
+    int decimal = value % 10;
+    
+    if (temp < 0) {
+        snprintf(tempStr, sizeof(tempStr), "-%d.%d", whole, decimal);
+    } else {
+        snprintf(tempStr, sizeof(tempStr), "%d.%d", whole, decimal);
+    }
+    
+    renderText(tempStr, segments);
+}
+
+void DisplayManager::renderText(const char* text, uint8_t* segments) {
+    memset(segments, 0, DIGIT_COUNT);
+    uint8_t pos = 0;
+    
+    for (const char* p = text; p && *p; p++) {
+        if (*p == '.') {
+            // Attach the point to the previous digit, or show it on a blank one
+            if (pos > 0 && !(segments[pos - 1] & SEGMENT_POINT)) {
+                segments[pos - 1] |= SEGMENT_POINT;
+                continue;
+            }
+            if (pos >= DIGIT_COUNT) break;
+            segments[pos++] = SEGMENT_POINT;
+            continue;
+        }
+        if (pos >= DIGIT_COUNT) break;
+        segments[pos++] = encodeChar(*p);
+    }
+}
+
+uint8_t DisplayManager::encodeChar(char c) {
+    if (c >= '0' && c <= '9') return DIGIT_SEGMENTS[c - '0'];
+    
+    switch (c) {
+        // Lowercase forms that read better than their uppercase counterparts
+        case 'b': return 0x7C;
+        case 'c': return 0x58;
+        case 'd': return 0x5E;
+        case 'h': return 0x74;
+        case 'n': return 0x54;
+        case 'o': return 0x5C;
+        case 'r': return 0x50;
+        case 't': return 0x78;
+        case 'u': return 0x1C;
+        case '-': return 0x40;
+        case '_': return 0x08;
+        case '=': return 0x48;
+        case '*': return 0x63;  // Degree sign
+        default: break;
+    }
+    
+    if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+    if (c >= 'A' && c <= 'Z') return LETTER_SEGMENTS[c - 'A'];
+    return 0x00;  // Blank for anything else
+}
@@ -0,0 +1,506 @@
+// EspMqttTransport.cpp
+#include "EspMqttTransport.h"
+#include "MqttWire.h"
+#include "RtosResources.h"
+#include <esp_idf_version.h>
+#include <string.h>
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+namespace {
+    // 0 marks an unbound alias, so a topic never hashes to it
+    uint32_t topicHash(const char* topic) {
+        uint32_t hash = 2166136261u;
+        for (const char* p = topic; *p; p++) {
+            hash = (hash ^ static_cast<uint8_t>(*p)) * 16777619u;
+        }
+        return hash ? hash : 1;
+    }
+}
+#endif
+
+EspMqttTransport::EspMqttTransport()
+    : client(nullptr)
+    , caCert(nullptr)
+    , host()
+    , port(0)
+    , started(false)
+    , session(Session::IDLE)
+    , lastError(0)
+    , resumed(false)
+    , lock(portMUX_INITIALIZER_UNLOCKED)
+    , publishMutex(nullptr)
+    , protocol(MqttProtocol::V3_1_1)
+    , sessionExpiry(0)
+    , inFlight()
+    , inFlightCount(0)
+    , reservedCount(0)
+    , earlyAcks()
+    , earlyAckCount(0)
+    , inbound()
+    , inboundHead(0)
+    , inboundCount(0)
+    , stats()
+    , handler(nullptr)
+    , handlerContext(nullptr)
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    , aliasTopics()
+    , aliasLimit(0)
+    , units()
+    , unitCount(0)
+#endif
+{
+}
+
+EspMqttTransport::~EspMqttTransport() {
+    if (client) {
+        esp_mqtt_client_destroy(client);
+    }
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    for (size_t i = 0; i < unitCount; i++) {
+        esp_mqtt5_client_delete_user_property(units[i].list);
+    }
+#endif
+}
+
+bool EspMqttTransport::setProtocol(MqttProtocol protocol, uint32_t sessionExpiry) {
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    this->protocol = protocol;
+    this->sessionExpiry = protocol == MqttProtocol::V5 ? sessionExpiry : 0;
+    return true;
+#else
+    (void)sessionExpiry;
+    return protocol == MqttProtocol::V3_1_1;
+#endif
+}
+
+void EspMqttTransport::begin(const char* caCert) {
+    this->caCert = caCert;
+    publishMutex = RtosResources::createMutex(MutexId::MQTT_PUBLISH);
+}
+
+void EspMqttTransport::setServer(const char* host, uint16_t port) {
+    this->host.assign(host);
+    this->port = port;
+}
+
+void EspMqttTransport::fillConfig(esp_mqtt_client_config_t& config, const char* clientId, const char* username,
+                                  const char* password, const Will& will) const {
+    memset(&config, 0, sizeof(config));
+#if ESP_IDF_VERSION_MAJOR >= 5
+    config.broker.address.hostname = host.c_str();
+    config.broker.address.port = port;
+    config.broker.address.transport = MQTT_TRANSPORT_OVER_SSL;
+    config.broker.verification.certificate = caCert;
+    config.credentials.client_id = clientId;
+    config.credentials.username = username;
+    config.credentials.authentication.password = password;
+    config.session.last_will.topic = will.topic;
+    config.session.last_will.msg = reinterpret_cast<const char*>(will.payload);
+    config.session.last_will.msg_len = static_cast<int>(will.length);
+    config.session.last_will.qos = will.qos;
+    config.session.last_will.retain = will.retain;
+    config.session.keepalive = MQTT_KEEPALIVE;
+    config.network.disable_auto_reconnect = true;
+    config.network.timeout_ms = MQTT_CONNECT_TIMEOUT;
+    config.buffer.size = MQTT_IN_BUFFER_SIZE;
+    config.buffer.out_size = MQTT_OUT_BUFFER_SIZE;
+    config.task.priority = MQTT_CLIENT_TASK_PRIORITY;
+    config.task.stack_size = MQTT_CLIENT_TASK_STACK_SIZE;
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (protocol == MqttProtocol::V5) {
+        config.session.protocol_ver = MQTT_PROTOCOL_V_5;
+        // Clean Start off: the broker resumes the session within its expiry
+        config.session.disable_clean_session = sessionExpiry > 0;
+    }
+#endif
+#else
+    config.host = host.c_str();
+    config.port = port;
+    config.transport = MQTT_TRANSPORT_OVER_SSL;
+    config.cert_pem = caCert;
+    config.client_id = clientId;
+    config.username = username;
+    config.password = password;
+    config.lwt_topic = will.topic;
+    config.lwt_msg = reinterpret_cast<const char*>(will.payload);
+    config.lwt_msg_len = static_cast<int>(will.length);
+    config.lwt_qos = will.qos;
+    config.lwt_retain = will.retain;
+    config.keepalive = MQTT_KEEPALIVE;
+    config.disable_auto_reconnect = true;
+    config.network_timeout_ms = MQTT_CONNECT_TIMEOUT;
+    config.buffer_size = MQTT_IN_BUFFER_SIZE;
+    config.out_buffer_size = MQTT_OUT_BUFFER_SIZE;
+    config.task_prio = MQTT_CLIENT_TASK_PRIORITY;
+    config.task_stack = MQTT_CLIENT_TASK_STACK_SIZE;
+#endif
+}
+
+bool EspMqttTransport::connect(const char* clientId, const char* username, const char* password,
+                               const Will& will) {
+    // The client copies every string of the configuration
+    esp_mqtt_client_config_t config;
+    fillConfig(config, clientId, username, password, will);
+    
+    if (!publishMutex || xSemaphoreTake(publishMutex, pdMS_TO_TICKS(MQTT_CONNECT_TIMEOUT)) != pdTRUE) {
+        lastError = ESP_ERR_TIMEOUT;
+        return false;
+    }
+    
+    if (started) {
+        esp_mqtt_client_stop(client);
+        started = false;
+        endSession();
+    }
+    
+    // A new client for every connection. The outbox of the old one may still
+    // hold publishes that name their topic by an alias of the old connection,
+    // and those must not be sent again on this one.
+    if (client) {
+        esp_mqtt_client_destroy(client);
+        client = nullptr;
+    }
+    client = esp_mqtt_client_init(&config);
+    if (!client) {
+        xSemaphoreGive(publishMutex);
+        lastError = ESP_ERR_NO_MEM;
+        return false;
+    }
+    esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, onEvent, this);
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (protocol == MqttProtocol::V5) {
+        esp_mqtt5_connection_property_config_t property = {};
+        property.session_expiry_interval = sessionExpiry;
+        if (esp_mqtt5_client_set_connect_property(client, &property) != ESP_OK) {
+            xSemaphoreGive(publishMutex);
+            lastError = ESP_ERR_INVALID_ARG;
+            return false;
+        }
+        
+        // Aliases last for the network connection, even when the session resumes
+        memset(aliasTopics, 0, sizeof(aliasTopics));
+        aliasLimit = MQTT_TOPIC_ALIAS_MAX;
+    }
+#endif
+    xSemaphoreGive(publishMutex);
+    
+    resumed = false;
+    session = Session::CONNECTING;
+    esp_err_t result = esp_mqtt_client_start(client);
+    if (result != ESP_OK) {
+        session = Session::IDLE;
+        lastError = result;
+        return false;
+    }
+    started = true;
+    
+    // The client task connects; CONNECTED or DISCONNECTED ends the wait
+    uint32_t start = millis();
+    while (session == Session::CONNECTING && millis() - start < MQTT_CONNECT_TIMEOUT) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (session == Session::CONNECTED) {
+        return true;
+    }
+    
+    esp_mqtt_client_stop(client);
+    started = false;
+    session = Session::IDLE;
+    endSession();
+    return false;
+}
+
+bool EspMqttTransport::connected() {
+    return session == Session::CONNECTED;
+}
+
+// Hands received messages to the handler on the calling task
+void EspMqttTransport::loop() {
+    Inbound message;
+    while (true) {
+        portENTER_CRITICAL(&lock);
+        bool available = inboundCount > 0;
+        if (available) {
+            message = inbound[inboundHead];
+            inboundHead = (inboundHead + 1) % MQTT_INBOUND_SLOTS;
+            inboundCount--;
+        }
+        portEXIT_CRITICAL(&lock);
+        
+        if (!available) break;
+        if (handler) {
+            handler(message.topic, message.payload, message.length, handlerContext);
+        }
+    }
+}
+
+bool EspMqttTransport::publish(const char* topic, const uint8_t* payload, size_t length,
+                               uint8_t qos, bool retain, const PublishProperties* properties) {
+    if (!connected()) {
+        return false;
+    }
+    
+    // Backpressure: wait for an acknowledgement to free a slot, and reserve
+    // it in the same critical section so a concurrent publish cannot take it
+    if (qos > 0) {
+        uint32_t start = millis();
+        while (true) {
+            portENTER_CRITICAL(&lock);
+            bool full = inFlightCount + reservedCount >= MQTT_INFLIGHT_WINDOW;
+            if (!full) {
+                reservedCount++;
+            }
+            portEXIT_CRITICAL(&lock);
+            if (!full) break;
+            if (!connected() || millis() - start >= MQTT_WINDOW_WAIT) {
+                portENTER_CRITICAL(&lock);
+                stats.dropped++;
+                portEXIT_CRITICAL(&lock);
+                return false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(2));
+        }
+    }
+    
+    // Properties, enqueue and alias binding must not interleave with another
+    // task's publish, or the PUBLISH could go out with an empty topic and no alias
+    const char* wireTopic = topic;
+    size_t propertiesLength = 0;
+    int msgId = -1;
+    uint32_t elapsed = 0;
+    if (publishMutex && xSemaphoreTake(publishMutex, pdMS_TO_TICKS(MQTT_WINDOW_WAIT)) == pdTRUE) {
+        uint32_t start = micros();
+#ifdef CONFIG_MQTT_PROTOCOL_5
+        uint16_t binding = 0;
+        if (protocol == MqttProtocol::V5) {
+            propertiesLength = setPublishProperties(topic, properties, wireTopic, binding);
+        }
+#else
+        (void)properties;
+#endif
+        
+        // Copied into the outbox and sent by the client task
+        msgId = esp_mqtt_client_enqueue(client, wireTopic, reinterpret_cast<const char*>(payload),
+                                        static_cast<int>(length), qos, retain, true);
+        elapsed = micros() - start;
+        
+#ifdef CONFIG_MQTT_PROTOCOL_5
+        if (binding && msgId >= 0) {
+            aliasTopics[binding] = topicHash(topic);
+        }
+#endif
+        xSemaphoreGive(publishMutex);
+    }
+    
+    portENTER_CRITICAL(&lock);
+    if (qos > 0) {
+        reservedCount--;  // Becomes the in-flight entry below, or is released
+    }
+    if (msgId < 0) {
+        stats.dropped++;
+    } else {
+        stats.publishTimeAverage = stats.published == 0 ? elapsed :
+            stats.publishTimeAverage + (static_cast<int32_t>(elapsed - stats.publishTimeAverage) / 8);
+        stats.published++;
+        stats.bytesSent += MqttWire::publishLength(strlen(wireTopic), length, qos, propertiesLength);
+        if (qos > 0) {
+            bool acknowledged = false;
+            for (size_t i = 0; i < earlyAckCount; i++) {
+                if (earlyAcks[i] == msgId) {
+                    earlyAcks[i] = earlyAcks[--earlyAckCount];
+                    acknowledged = true;
+                    break;
+                }
+            }
+            if (acknowledged) {
+                stats.acknowledged++;
+            } else {
+                inFlight[inFlightCount++] = InFlight{msgId, millis()};
+            }
+        }
+    }
+    stats.inFlight = inFlightCount;
+    portEXIT_CRITICAL(&lock);
+    return msgId >= 0;
+}
+
+bool EspMqttTransport::subscribe(const char* topic, uint8_t qos) {
+    return connected() && esp_mqtt_client_subscribe(client, topic, qos) >= 0;
+}
+
+void EspMqttTransport::setMessageHandler(MessageHandler handler, void* context) {
+    this->handler = handler;
+    handlerContext = context;
+}
+
+bool EspMqttTransport::sessionPresent() {
+    return resumed;
+}
+
+int EspMqttTransport::state() {
+    return lastError;
+}
+
+void EspMqttTransport::getStats(Stats& stats) {
+    portENTER_CRITICAL(&lock);
+    stats = this->stats;
+    portEXIT_CRITICAL(&lock);
+}
+
+void EspMqttTransport::onEvent(void* arg, esp_event_base_t base, int32_t eventId, void* eventData) {
+    (void)base;
+    (void)eventId;
+    static_cast<EspMqttTransport*>(arg)->handleEvent(static_cast<esp_mqtt_event_handle_t>(eventData));
+}
+
+// Runs on the esp-mqtt task
+void EspMqttTransport::handleEvent(esp_mqtt_event_handle_t event) {
+    switch (event->event_id) {
+        case MQTT_EVENT_CONNECTED:
+            resumed = event->session_present;
+            session = Session::CONNECTED;
+            break;
+        
+        case MQTT_EVENT_DISCONNECTED:
+            session = Session::DISCONNECTED;
+            endSession();
+            break;
+        
+        case MQTT_EVENT_PUBLISHED:
+            acknowledge(event->msg_id);
+            break;
+        
+        case MQTT_EVENT_DATA: {
+            // Only whole messages that fit a slot; larger ones arrive in pieces
+            bool whole = event->current_data_offset == 0 && event->data_len == event->total_data_len;
+            bool fits = event->data_len <= static_cast<int>(MQTT_INBOUND_PAYLOAD) &&
+                        event->topic_len <= static_cast<int>(TopicString::capacity());
+            portENTER_CRITICAL(&lock);
+            if (!whole || !fits || inboundCount >= MQTT_INBOUND_SLOTS) {
+                stats.inboundDropped++;
+            } else {
+                Inbound& slot = inbound[(inboundHead + inboundCount) % MQTT_INBOUND_SLOTS];
+                memcpy(slot.topic, event->topic, event->topic_len);
+                slot.topic[event->topic_len] = '\0';
+                memcpy(slot.payload, event->data, event->data_len);
+                slot.length = static_cast<uint16_t>(event->data_len);
+                inboundCount++;
+            }
+            portEXIT_CRITICAL(&lock);
+            break;
+        }
+        
+        case MQTT_EVENT_ERROR:
+            if (event->error_handle->error_type == MQTT_ERROR_TYPE_CONNECTION_REFUSED) {
+                lastError = event->error_handle->connect_return_code;
+            } else if (event->error_handle->esp_tls_last_esp_err != 0) {
+                lastError = event->error_handle->esp_tls_last_esp_err;
+            }
+            break;
+        
+        default:
+            break;
+    }
+}
+
+void EspMqttTransport::acknowledge(int msgId) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&lock);
+    bool found = false;
+    for (size_t i = 0; i < inFlightCount; i++) {
+        if (inFlight[i].msgId != msgId) continue;
+        uint32_t elapsed = now - inFlight[i].sentAt;
+        stats.ackTimeAverage = stats.acknowledged == 0 ? elapsed :
+            stats.ackTimeAverage + (static_cast<int32_t>(elapsed - stats.ackTimeAverage) / 8);
+        if (elapsed > stats.ackTimeMax) stats.ackTimeMax = elapsed;
+        stats.acknowledged++;
+        inFlight[i] = inFlight[--inFlightCount];
+        found = true;
+        break;
+    }
+    if (!found) {
+        // publish() has not recorded it yet; the oldest early ack gives way
+        if (earlyAckCount == MQTT_INFLIGHT_WINDOW) {
+            memmove(earlyAcks, earlyAcks + 1, (MQTT_INFLIGHT_WINDOW - 1) * sizeof(earlyAcks[0]));
+            earlyAckCount--;
+        }
+        earlyAcks[earlyAckCount++] = msgId;
+    }
+    stats.inFlight = inFlightCount;
+    portEXIT_CRITICAL(&lock);
+}
+
+// Publishes still unacknowledged count as lost; the next session starts clean
+void EspMqttTransport::endSession() {
+    portENTER_CRITICAL(&lock);
+    stats.dropped += inFlightCount;
+    inFlightCount = 0;
+    earlyAckCount = 0;
+    stats.inFlight = 0;
+    portEXIT_CRITICAL(&lock);
+}
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+// esp-mqtt attaches the properties set here to the next publish only. They
+// are set before every MQTT 5 publish, empty if there are none, so nothing
+// carries over from the one before. Returns the size of the property block.
+size_t EspMqttTransport::setPublishProperties(const char* topic, const PublishProperties* properties,
+                                              const char*& wireTopic, uint16_t& binding) {
+    esp_mqtt5_publish_property_config_t config = {};
+    PublishProperties sent = {0, 0, nullptr};
+    if (properties) {
+        sent.messageExpiry = properties->messageExpiry;
+        config.message_expiry_interval = properties->messageExpiry;
+        if (properties->unit) {
+            config.user_property = unitProperty(properties->unit);
+            sent.unit = config.user_property ? properties->unit : nullptr;
+        }
+        
+        // An alias bound to another topic leaves this one in full
+        uint16_t alias = properties->topicAlias;
+        if (alias > 0 && alias <= aliasLimit) {
+            uint32_t hash = topicHash(topic);
+            if (aliasTopics[alias] == hash) {
+                wireTopic = "";
+                sent.topicAlias = alias;
+            } else if (aliasTopics[alias] == 0) {
+                binding = alias;
+                sent.topicAlias = alias;
+            }
+        }
+        config.topic_alias = sent.topicAlias;
+    }
+    
+    if (esp_mqtt5_client_set_publish_property(client, &config) != ESP_OK && config.topic_alias) {
+        // Above the broker's Topic Alias Maximum
+        aliasLimit = config.topic_alias - 1;
+        config.topic_alias = 0;
+        sent.topicAlias = 0;
+        wireTopic = topic;
+        binding = 0;
+        esp_mqtt5_client_set_publish_property(client, &config);
+    }
+    return MqttWire::publishPropertiesLength(&sent);
+}
+
+// The list for a unit is built on first use and kept; units are string literals
+mqtt5_user_property_handle_t EspMqttTransport::unitProperty(const char* unit) {
+    for (size_t i = 0; i < unitCount; i++) {
+        if (strcmp(units[i].unit, unit) == 0) {
+            return units[i].list;
+        }
+    }
+    if (unitCount == sizeof(units) / sizeof(units[0])) {
+        return nullptr;
+    }
+    
+    esp_mqtt5_user_property_item_t item = {MqttWire::UNIT_PROPERTY, unit};
+    mqtt5_user_property_handle_t list = nullptr;
+    if (esp_mqtt5_client_set_user_property(&list, &item, 1) != ESP_OK) {
+        return nullptr;
+    }
+    units[unitCount++] = UnitProperty{unit, list};
+    return list;
+}
+#endif
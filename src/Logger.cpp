@@ -19,25 +19,50 @@ void Logger::disableCategory(Category category) {
 }
 
 void Logger::error(const String& message, Category category) {
-    logMessage(Level::ERROR, category, message);
+    logMessage(Level::ERROR, category, message.c_str());
 }
 
 void Logger::warning(const String& message, Category category) {
-    logMessage(Level::WARNING, category, message);
+    logMessage(Level::WARNING, category, message.c_str());
 }
 
 void Logger::info(const String& message, Category category) {
-    logMessage(Level::INFO, category, message);
+    logMessage(Level::INFO, category, message.c_str());
 }
 
 void Logger::debug(const String& message, Category category) {
-    logMessage(Level::DEBUG, category, message);
+    logMessage(Level::DEBUG, category, message.c_str());
 }
 
 void Logger::trace(const String& message, Category category) {
+    logMessage(Level::TRACE, category, message.c_str());
+}
+
+void Logger::error(const char* message, Category category) {
+    logMessage(Level::ERROR, category, message);
+}
+
+void Logger::warning(const char* message, Category category) {
+    logMessage(Level::WARNING, category, message);
+}
+
+void Logger::info(const char* message, Category category) {
+    logMessage(Level::INFO, category, message);
+}
+
+void Logger::debug(const char* message, Category category) {
+    logMessage(Level::DEBUG, category, message);
+}
+
+void Logger::trace(const char* message, Category category) {
     logMessage(Level::TRACE, category, message);
 }
 
+bool Logger::isEnabled(Level level, Category category) {
+    return static_cast<int>(level) <= static_cast<int>(currentLevel) && 
+           isCategoryEnabled(category);
+}
+
 const char* Logger::getLevelString(Level level) {
     switch (level) {
         case Level::ERROR:   return "ERROR";
@@ -64,10 +89,9 @@ bool Logger::isCategoryEnabled(Category category) {
     return (enabledCategories & (1 << static_cast<uint8_t>(category))) != 0;
 }
 
-void Logger::logMessage(Level level, Category category, const String& message) {
+void Logger::logMessage(Level level, Category category, const char* message) {
     // Check if this message should be logged based on level and category
-    if (static_cast<int>(level) > static_cast<int>(currentLevel) || 
-        !isCategoryEnabled(category)) {
+    if (!isEnabled(level, category)) {
         return;
     }
     
@@ -91,5 +115,5 @@ void Logger::logMessage(Level level, Category category, const String& message) {
                  timeStr,
                  getLevelString(level),
                  getCategoryString(category),
-                 message.c_str());
+                 message);
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+// ModbusRegisterMap.cpp
+// Register image and request handling of the Modbus TCP server. Frames are
+// parsed and answered in caller-provided buffers; nothing here allocates or
+// depends on the platform, so the same code runs in tools/modbus_host_server.cpp.
+
+#include "ModbusRegisterMap.h"
+#include <string.h>
+
+namespace {
+    constexpr size_t MBAP_LENGTH = 7;       // Transaction, protocol, length, unit
+    constexpr uint16_t MAX_READ_REGISTERS = 125;
+    constexpr uint16_t MAX_READ_COILS = 2000;
+    constexpr uint16_t MAX_WRITE_COILS = 1968;
+
+    uint16_t readWord(const uint8_t* data) {
+        return static_cast<uint16_t>(data[0] << 8 | data[1]);
+    }
+
+    void writeWord(uint8_t* data, uint16_t value) {
+        data[0] = value >> 8;
+        data[1] = value & 0xFF;
+    }
+
+    int16_t toHundredths(float celsius) {
+        float scaled = celsius * 100.0f;
+        if (scaled > 32767.0f) return 32767;
+        if (scaled < -32768.0f) return -32768;
+        return static_cast<int16_t>(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+}
+
+ModbusRegisterMap::ModbusRegisterMap()
+    : coilCount(0)
+    , sequence(0) {
+    memset(registers, 0, sizeof(registers));
+    memset(coils, 0, sizeof(coils));
+}
+
+bool ModbusRegisterMap::refresh(const ModbusSensorSample* samples, size_t count,
+                                const bool* relayStates, uint8_t relayCount,
+                                uint32_t uptimeSeconds) {
+    uint16_t present = 0;
+
+    slots.beginUpdate();
+    for (size_t i = 0; i < count; i++) {
+        slots.markListed(samples[i].address);
+    }
+    for (size_t i = 0; i < count; i++) {
+        int slot = slots.slotFor(samples[i].address);
+        if (slot < 0) continue;
+        writeSensor(slot, samples[i]);
+        present++;
+    }
+    for (size_t slot = 0; slot < MODBUS_SENSOR_SLOTS; slot++) {
+        if (!slots.isListed(slot)) clearSensor(slot);
+    }
+
+    coilCount = relayCount < MODBUS_MAX_COILS ? relayCount : MODBUS_MAX_COILS;
+    for (uint8_t i = 0; i < coilCount; i++) {
+        coils[i] = relayStates[i];
+    }
+
+    registers[0] = LAYOUT_VERSION;
+    registers[1] = MODBUS_SENSOR_SLOTS;
+    registers[2] = present;
+    registers[3] = coilCount;
+    registers[4] = uptimeSeconds >> 16;
+    registers[5] = uptimeSeconds & 0xFFFF;
+    registers[6] = ++sequence;
+    registers[7] = 0;
+    return slots.endUpdate();
+}
+
+void ModbusRegisterMap::writeSensor(size_t slot, const ModbusSensorSample& sample) {
+    uint16_t* block = registers + HEADER_REGISTERS + slot * REGISTERS_PER_SENSOR;
+
+    uint16_t status = STATUS_PRESENT;
+    if (sample.valid) status |= STATUS_VALID;
+    if (sample.isVirtual) status |= STATUS_VIRTUAL;
+    status |= (static_cast<uint16_t>(sample.health) & 0x03) << STATUS_HEALTH_SHIFT;
+    status |= static_cast<uint16_t>(sample.anomalyMask & 0x07) << STATUS_ANOMALY_SHIFT;
+
+    block[0] = status;
+    block[1] = static_cast<uint16_t>(sample.raw);
+    block[2] = static_cast<uint16_t>(toHundredths(sample.temperature));
+    block[3] = sample.ageSeconds > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(sample.ageSeconds);
+    for (uint8_t i = 0; i < 4; i++) {
+        block[4 + i] = static_cast<uint16_t>(sample.address[2 * i] << 8 | sample.address[2 * i + 1]);
+    }
+}
+
+// A slot whose sensor is not listed keeps its ROM but reports it absent
+void ModbusRegisterMap::clearSensor(size_t slot) {
+    uint16_t* block = registers + HEADER_REGISTERS + slot * REGISTERS_PER_SENSOR;
+    block[0] = 0;
+    block[1] = static_cast<uint16_t>(SensorTable::NO_READING_RAW);
+    block[2] = static_cast<uint16_t>(toHundredths(SensorTable::NO_READING_C));
+    block[3] = 0xFFFF;
+    const uint8_t* address = slots.address(slot);
+    for (uint8_t i = 0; i < 4; i++) {
+        block[4 + i] = static_cast<uint16_t>(address[2 * i] << 8 | address[2 * i + 1]);
+    }
+}
+
+size_t ModbusRegisterMap::frameLength(const uint8_t* buffer, size_t length) {
+    if (length < 6) return 0;
+    uint16_t protocol = readWord(buffer + 2);
+    uint16_t remaining = readWord(buffer + 4);   // Unit id and PDU
+    if (protocol != 0 || remaining < 2 || remaining > MODBUS_MAX_ADU - 6) {
+        return INVALID_FRAME;
+    }
+    size_t total = 6 + remaining;
+    return length >= total ? total : 0;
+}
+
+size_t ModbusRegisterMap::handleRequest(const uint8_t* request, size_t length, uint8_t* response,
+                                        bool allowWrites, CoilWriter writer, void* context) {
+    size_t frame = frameLength(request, length);
+    if (frame == 0 || frame == INVALID_FRAME) return 0;
+
+    const uint8_t* pdu = request + MBAP_LENGTH;
+    size_t pduLength = frame - MBAP_LENGTH;
+    uint8_t* out = response + MBAP_LENGTH;
+
+    size_t outLength;
+    switch (pdu[0]) {
+        case 0x01:
+            outLength = readCoils(pdu, pduLength, out);
+            break;
+        case 0x03:
+        case 0x04:
+            outLength = readRegisters(pdu, pduLength, out);
+            break;
+        case 0x05:
+            outLength = writeCoil(pdu, pduLength, out, allowWrites, writer, context);
+            break;
+        case 0x0F:
+            outLength = writeCoils(pdu, pduLength, out, allowWrites, writer, context);
+            break;
+        default:
+            outLength = exception(pdu[0], ILLEGAL_FUNCTION, out);
+            break;
+    }
+
+    // Same transaction, protocol and unit id as the request
+    memcpy(response, request, MBAP_LENGTH);
+    writeWord(response + 4, static_cast<uint16_t>(outLength + 1));
+    return MBAP_LENGTH + outLength;
+}
+
+size_t ModbusRegisterMap::readCoils(const uint8_t* pdu, size_t length, uint8_t* out) {
+    if (length != 5) return exception(pdu[0], ILLEGAL_VALUE, out);
+    uint16_t start = readWord(pdu + 1);
+    uint16_t quantity = readWord(pdu + 3);
+    if (quantity == 0 || quantity > MAX_READ_COILS) return exception(pdu[0], ILLEGAL_VALUE, out);
+    if (static_cast<uint32_t>(start) + quantity > coilCount) return exception(pdu[0], ILLEGAL_ADDRESS, out);
+
+    uint8_t bytes = (quantity + 7) / 8;
+    out[0] = pdu[0];
+    out[1] = bytes;
+    memset(out + 2, 0, bytes);
+    for (uint16_t i = 0; i < quantity; i++) {
+        if (coils[start + i]) out[2 + i / 8] |= 1 << (i % 8);
+    }
+    return 2 + bytes;
+}
+
+size_t ModbusRegisterMap::readRegisters(const uint8_t* pdu, size_t length, uint8_t* out) {
+    if (length != 5) return exception(pdu[0], ILLEGAL_VALUE, out);
+    uint16_t start = readWord(pdu + 1);
+    uint16_t quantity = readWord(pdu + 3);
+    if (quantity == 0 || quantity > MAX_READ_REGISTERS) return exception(pdu[0], ILLEGAL_VALUE, out);
+    if (static_cast<uint32_t>(start) + quantity > REGISTER_COUNT) return exception(pdu[0], ILLEGAL_ADDRESS, out);
+
+    out[0] = pdu[0];
+    out[1] = quantity * 2;
+    for (uint16_t i = 0; i < quantity; i++) {
+        writeWord(out + 2 + 2 * i, registers[start + i]);
+    }
+    return 2 + quantity * 2;
+}
+
+size_t ModbusRegisterMap::writeCoil(const uint8_t* pdu, size_t length, uint8_t* out,
+                                    bool allowWrites, CoilWriter writer, void* context) {
+    if (!allowWrites) return exception(pdu[0], ILLEGAL_FUNCTION, out);
+    if (length != 5) return exception(pdu[0], ILLEGAL_VALUE, out);
+    uint16_t address = readWord(pdu + 1);
+    uint16_t value = readWord(pdu + 3);
+    if (value != 0xFF00 && value != 0x0000) return exception(pdu[0], ILLEGAL_VALUE, out);
+    if (address >= coilCount) return exception(pdu[0], ILLEGAL_ADDRESS, out);
+
+    bool state = value == 0xFF00;
+    if (!writer || !writer(address, state, context)) return exception(pdu[0], DEVICE_FAILURE, out);
+    coils[address] = state;
+
+    // The response echoes the request
+    memcpy(out, pdu, 5);
+    return 5;
+}
+
+size_t ModbusRegisterMap::writeCoils(const uint8_t* pdu, size_t length, uint8_t* out,
+                                     bool allowWrites, CoilWriter writer, void* context) {
+    if (!allowWrites) return exception(pdu[0], ILLEGAL_FUNCTION, out);
+    if (length < 6) return exception(pdu[0], ILLEGAL_VALUE, out);
+    uint16_t start = readWord(pdu + 1);
+    uint16_t quantity = readWord(pdu + 3);
+    uint8_t bytes = pdu[5];
+    if (quantity == 0 || quantity > MAX_WRITE_COILS || bytes != (quantity + 7) / 8 || length != 6u + bytes) {
+        return exception(pdu[0], ILLEGAL_VALUE, out);
+    }
+    if (static_cast<uint32_t>(start) + quantity > coilCount) return exception(pdu[0], ILLEGAL_ADDRESS, out);
+
+    for (uint16_t i = 0; i < quantity; i++) {
+        bool state = pdu[6 + i / 8] & (1 << (i % 8));
+        if (!writer || !writer(start + i, state, context)) return exception(pdu[0], DEVICE_FAILURE, out);
+        coils[start + i] = state;
+    }
+
+    out[0] = pdu[0];
+    writeWord(out + 1, start);
+    writeWord(out + 3, quantity);
+    return 5;
+}
+
+size_t ModbusRegisterMap::exception(uint8_t function, Exception code, uint8_t* out) {
+    out[0] = function | 0x80;
+    out[1] = code;
+    return 2;
+}
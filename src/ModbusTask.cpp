@@ -0,0 +1,252 @@
+// ModbusTask.cpp
+#include "ModbusTask.h"
+#include "OneWireTask.h"
+#include "ControlTask.h"
+#include "PreferencesManager.h"
+#include "RtosResources.h"
+#include "Logger.h"
+#include "FixedString.h"
+#include <lwip/sockets.h>
+#include <algorithm>
+
+static const char* const SLOTS_KEY = "mb_slots";   // NVS key of the slot assignment
+
+// Static member initialization
+ModbusConfig ModbusTask::config = {false, MODBUS_TCP_PORT, false};
+ModbusRegisterMap ModbusTask::registerMap;
+ModbusTask::Client ModbusTask::clients[MODBUS_MAX_CLIENTS] = {};
+TemperatureSensor ModbusTask::snapshot[SENSOR_TABLE_CAPACITY] = {};
+ModbusSensorSample ModbusTask::samples[SENSOR_TABLE_CAPACITY] = {};
+uint8_t ModbusTask::response[MODBUS_MAX_ADU] = {};
+int ModbusTask::listenSocket = -1;
+volatile uint8_t ModbusTask::clientCount = 0;
+volatile bool ModbusTask::running = false;
+
+void ModbusTask::init() {
+    PreferencesManager::getModbusConfig(config);
+    for (auto& client : clients) {
+        client.socket = -1;
+    }
+    
+    // Sensors keep the register block they had before the restart
+    uint8_t addresses[MODBUS_SENSOR_SLOTS][8];
+    uint8_t count = PreferencesManager::getSensorSlots(SLOTS_KEY, addresses, MODBUS_SENSOR_SLOTS);
+    registerMap.setSlots(addresses, count);
+    
+    Logger::info(makeFixedString<80>("Modbus TCP %s, port %u, coil writes %s, %u slots restored",
+                                     config.enabled ? "enabled" : "disabled", config.port,
+                                     config.allowWrites ? "allowed" : "rejected", count).c_str());
+}
+
+void ModbusTask::start() {
+    if (!config.enabled) return;
+    RtosResources::createTask(TaskId::MODBUS, taskFunction);
+}
+
+bool ModbusTask::isRunning() {
+    return running;
+}
+
+uint8_t ModbusTask::getClientCount() {
+    return clientCount;
+}
+
+void ModbusTask::taskFunction(void* parameter) {
+    uint32_t lastRefresh = millis();
+    refreshImage();
+    
+    while (true) {
+        if (listenSocket < 0 && !openListener()) {
+            vTaskDelay(pdMS_TO_TICKS(5000));
+            continue;
+        }
+        
+        uint32_t now = millis();
+        if (now - lastRefresh >= MODBUS_REFRESH_INTERVAL) {
+            refreshImage();
+            lastRefresh = now;
+        }
+        
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(listenSocket, &readSet);
+        int maxSocket = listenSocket;
+        for (auto& client : clients) {
+            if (client.socket < 0) continue;
+            if (now - client.lastActivity >= MODBUS_IDLE_TIMEOUT) {
+                Logger::info("Modbus client idle - closing connection", Logger::Category::NETWORK);
+                closeClient(client);
+                continue;
+            }
+            FD_SET(client.socket, &readSet);
+            maxSocket = std::max(maxSocket, client.socket);
+        }
+        
+        // Short timeout so the image refresh keeps its period without clients
+        timeval timeout = {0, 250000};
+        int ready = select(maxSocket + 1, &readSet, nullptr, nullptr, &timeout);
+        if (ready < 0) {
+            Logger::error("Modbus select failed: " + String(errno), Logger::Category::NETWORK);
+            vTaskDelay(pdMS_TO_TICKS(100));
+            continue;
+        }
+        if (ready == 0) continue;
+        
+        if (FD_ISSET(listenSocket, &readSet)) {
+            acceptClient();
+        }
+        for (auto& client : clients) {
+            if (client.socket >= 0 && FD_ISSET(client.socket, &readSet)) {
+                serviceClient(client);
+            }
+        }
+    }
+}
+
+bool ModbusTask::openListener() {
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0) {
+        Logger::error("Modbus socket creation failed", Logger::Category::NETWORK);
+        return false;
+    }
+    
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(config.port);
+    if (bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(sock, MODBUS_MAX_CLIENTS) != 0) {
+        Logger::error("Modbus listen on port " + String(config.port) + " failed: " + String(errno),
+                      Logger::Category::NETWORK);
+        close(sock);
+        return false;
+    }
+    
+    listenSocket = sock;
+    running = true;
+    Logger::info("Modbus TCP server listening on port " + String(config.port), Logger::Category::NETWORK);
+    return true;
+}
+
+void ModbusTask::acceptClient() {
+    sockaddr_in peer = {};
+    socklen_t peerLength = sizeof(peer);
+    int sock = accept(listenSocket, reinterpret_cast<sockaddr*>(&peer), &peerLength);
+    if (sock < 0) return;
+    
+    Client* slot = nullptr;
+    for (auto& client : clients) {
+        if (client.socket < 0) {
+            slot = &client;
+            break;
+        }
+    }
+    if (!slot) {
+        Logger::warning("Modbus client limit reached - refusing connection", Logger::Category::NETWORK);
+        close(sock);
+        return;
+    }
+    
+    // Replies are single small segments; don't hold them back for coalescing,
+    // and never let a stalled client block the task for long
+    int noDelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    timeval sendTimeout = {1, 0};
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+    
+    slot->socket = sock;
+    slot->length = 0;
+    slot->lastActivity = millis();
+    clientCount++;
+    Logger::info("Modbus client connected from " + String(inet_ntoa(peer.sin_addr)),
+                 Logger::Category::NETWORK);
+}
+
+void ModbusTask::serviceClient(Client& client) {
+    int received = recv(client.socket, client.buffer + client.length,
+                        sizeof(client.buffer) - client.length, 0);
+    if (received <= 0) {
+        closeClient(client);
+        return;
+    }
+    client.length += received;
+    client.lastActivity = millis();
+    
+    // A client may send several requests back to back
+    while (true) {
+        size_t frame = ModbusRegisterMap::frameLength(client.buffer, client.length);
+        if (frame == ModbusRegisterMap::INVALID_FRAME) {
+            Logger::warning("Malformed Modbus frame - closing connection", Logger::Category::NETWORK);
+            closeClient(client);
+            return;
+        }
+        if (frame == 0) break;
+        
+        size_t length = registerMap.handleRequest(client.buffer, frame, response,
+                                                  config.allowWrites, writeCoil, nullptr);
+        if (length > 0 && send(client.socket, response, length, 0) != static_cast<int>(length)) {
+            closeClient(client);
+            return;
+        }
+        memmove(client.buffer, client.buffer + frame, client.length - frame);
+        client.length -= frame;
+    }
+}
+
+void ModbusTask::closeClient(Client& client) {
+    if (client.socket < 0) return;
+    close(client.socket);
+    client.socket = -1;
+    client.length = 0;
+    if (clientCount > 0) clientCount--;
+}
+
+void ModbusTask::refreshImage() {
+    size_t count = OneWireTask::manager.getSensors(snapshot, SENSOR_TABLE_CAPACITY);
+    uint32_t now = millis();
+    
+    for (size_t i = 0; i < count; i++) {
+        const TemperatureSensor& sensor = snapshot[i];
+        ModbusSensorSample& sample = samples[i];
+        memcpy(sample.address, sensor.address, 8);
+        if (sensor.rawTemperature == DEVICE_DISCONNECTED_C) {
+            sample.raw = SensorTable::NO_READING_RAW;
+        } else {
+            int32_t raw = SensorFilter::fromCelsius(sensor.rawTemperature);
+            sample.raw = static_cast<int16_t>(std::max<int32_t>(INT16_MIN, std::min<int32_t>(INT16_MAX, raw)));
+        }
+        sample.temperature = sensor.temperature;
+        sample.ageSeconds = sensor.lastReadTime ? (now - sensor.lastReadTime) / 1000 : UINT32_MAX;
+        sample.health = sensor.health;
+        sample.anomalyMask = sensor.anomalyMask;
+        sample.valid = sensor.valid;
+        sample.isVirtual = VirtualSensorSet::isVirtualAddress(sensor.address);
+    }
+    
+    bool relays[RELAY_COUNT];
+    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+        relays[i] = ControlTask::getRelayState(i);
+    }
+    
+    if (registerMap.refresh(samples, count, relays, RELAY_COUNT, now / 1000)) {
+        saveSlots();
+    }
+}
+
+// Only called when a ROM gets a new slot, so flash is written rarely
+void ModbusTask::saveSlots() {
+    uint8_t addresses[MODBUS_SENSOR_SLOTS][8];
+    size_t count = registerMap.getSlots(addresses, MODBUS_SENSOR_SLOTS);
+    if (!PreferencesManager::setSensorSlots(SLOTS_KEY, addresses, count)) {
+        Logger::error("Failed to save Modbus slot assignment");
+    }
+}
+
+bool ModbusTask::writeCoil(uint16_t coil, bool state, void* context) {
+    if (coil >= RELAY_COUNT) return false;
+    ControlTask::updateRelayRequest(coil, state);
+    return true;
+}
@@ -3,28 +3,155 @@
 #include "MqttManager.h"
 #include <cstring>
 #include "PreferencesManager.h"
+#include "FixedString.h"
+#include <sys/time.h>
+
+namespace {
+    enum class TopicScope : uint8_t {
+        SENSOR,   // SYSTEM/DEVICE/sensors/<ROM>/<leaf>
+        RELAY,    // SYSTEM/DEVICE/relay/<n>/<leaf>
+        HUB       // <leaf> as is; the connection's last will
+    };
+    
+    struct TopicSpec {
+        TopicScope scope;
+        const char* leaf;
+        const char* unit;        // MQTT 5 "unit" user property, nullptr for none
+        const char* component;   // Home Assistant component, nullptr if not announced
+        const char* label;       // Entity name after the sensor or hub name
+        const char* fields;      // Further discovery members
+    };
+    
+    // Rows follow MqttManager::Topic. Telemetry topics are built from this
+    // table, and discovery announces every row that names a component.
+    // Relays are announced read-only: nothing handles their set topics yet.
+    const TopicSpec TOPIC_TABLE[] = {
+        {TopicScope::SENSOR, "temperature", "°C", "sensor", "temperature",
+         "\"dev_cla\":\"temperature\",\"unit_of_meas\":\"°C\",\"stat_cla\":\"measurement\""},
+        {TopicScope::SENSOR, "raw", "°C", "sensor", "raw temperature",
+         "\"dev_cla\":\"temperature\",\"unit_of_meas\":\"°C\",\"stat_cla\":\"measurement\","
+         "\"ent_cat\":\"diagnostic\",\"en\":false"},
+        {TopicScope::SENSOR, "status", nullptr, "sensor", "status",
+         "\"dev_cla\":\"enum\",\"ops\":[\"online\",\"offline\",\"error\"],\"ent_cat\":\"diagnostic\""},
+        {TopicScope::SENSOR, "last_update", nullptr, nullptr, nullptr, nullptr},
+        {TopicScope::RELAY, "state", nullptr, "binary_sensor", nullptr, "\"dev_cla\":\"power\""},
+        {TopicScope::RELAY, "availability", nullptr, nullptr, nullptr, nullptr},
+        {TopicScope::HUB, "status", nullptr, "binary_sensor", "connection",
+         "\"dev_cla\":\"connectivity\",\"pl_on\":\"online\",\"pl_off\":\"offline\",\"ent_cat\":\"diagnostic\""},
+    };
+    
+    const uint8_t NO_ADDRESS[8] = {};
+    
+    uint32_t fnv1a(uint32_t hash, const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+    
+    // 0 stands for "no config", so a real one never hashes to it
+    template <size_t N>
+    uint32_t configHash(const FixedString<N>& config) {
+        uint32_t hash = fnv1a(2166136261u, config.c_str(), config.length());
+        return hash ? hash : 1;
+    }
+    
+    // Unique within the device: <ROM>_<leaf>, relay<n> or <leaf>
+    template <size_t N>
+    void appendObjectId(FixedString<N>& out, const TopicSpec& spec, const uint8_t* address, uint8_t relay) {
+        switch (spec.scope) {
+            case TopicScope::SENSOR:
+                out.appendHex(address, 8).append('_').append(spec.leaf);
+                break;
+            case TopicScope::RELAY:
+                out.appendf("relay%u", relay + 1);
+                break;
+            case TopicScope::HUB:
+                out.append(spec.leaf);
+                break;
+        }
+    }
+    
+    template <size_t N>
+    void appendJsonString(FixedString<N>& out, const char* text) {
+        out.append('"');
+        for (const char* p = text; *p; p++) {
+            if (*p == '"' || *p == '\\') {
+                out.append('\\').append(*p);
+            } else if (static_cast<uint8_t>(*p) < 0x20) {
+                out.appendf("\\u%04x", static_cast<unsigned>(*p));
+            } else {
+                out.append(*p);
+            }
+        }
+        out.append('"');
+    }
+}
 
 MqttManager::MqttManager() 
-    : wifiClient()
-    , mqtt(wifiClient)  // Initialize mqtt with wifiClient
+    : espMqttTransport()
+    , pubSubClientTransport()
+    , transport(&espMqttTransport)
+    , protocol(MqttProtocol::V3_1_1)
     , mqttBroker("")
     , mqttPort(0)
     , mqttUsername("")
     , mqttPassword("")
     , lastReconnectAttempt(0)
     , lastPublishAttempt(0)
-    , currentReconnectDelay(0) {
+    , currentReconnectDelay(0)
+    , formats{PayloadFormat::TEXT, PayloadFormat::TEXT, PayloadFormat::TEXT}
+    , discovery()
+    , discoverySensorHash(0)
+    , discoveryNameGeneration(0)
+    , discoveryUpdated(false)
+    , discoveryNewSession(false)
+    , aliasSensors()
+    , aliasSensorCount(0)
+    , sparkplugEnabled(false)
+    , sparkplug()
+    , sparkplugSamples()
+    , sparkplugSampleCount(0)
+    , sparkplugRelays()
+    , sparkplugRelayCount(0)
+    , sparkplugHasData(false)
+    , sparkplugClockWarned(false) {
     
-    setupSecureClient();
+    static_assert(sizeof(TOPIC_TABLE) / sizeof(TOPIC_TABLE[0]) == static_cast<size_t>(Topic::COUNT),
+                  "TOPIC_TABLE out of sync with MqttManager::Topic");
+    static_assert(SENSOR_TABLE_CAPACITY * ALIASES_PER_SENSOR <= MQTT_TOPIC_ALIAS_MAX,
+                  "MQTT_TOPIC_ALIAS_MAX too small for the sensor alias blocks");
 }
 
 void MqttManager::begin() {
     Logger::info("Initializing MQTT Manager", Logger::Category::NETWORK);
+    
+    // The backend is fixed for the uptime; the other one stays unconfigured
+    if (PreferencesManager::getMqttBackend() == MqttBackend::PUBSUBCLIENT) {
+        transport = &pubSubClientTransport;
+    }
+    transport->begin(getLetsEncryptRootCA());
+    transport->setMessageHandler(onMessage, this);
+    
     loadConfiguration();
+    
+    // MQTT 5 needs esp-mqtt. Sparkplug B sessions must start clean, so they are never resumed
+    if (PreferencesManager::getMqttProtocol() == MqttProtocol::V5) {
+        if (transport != &espMqttTransport) {
+            Logger::warning("MQTT 5 needs the esp-mqtt backend - using 3.1.1", Logger::Category::NETWORK);
+        } else if (!espMqttTransport.setProtocol(MqttProtocol::V5, sparkplugEnabled ? 0 : MQTT_SESSION_EXPIRY)) {
+            Logger::warning("esp-mqtt built without MQTT 5 - using 3.1.1", Logger::Category::NETWORK);
+        } else {
+            protocol = MqttProtocol::V5;
+        }
+    }
+    Logger::info(String("MQTT transport: ") + transport->name() +
+                 (protocol == MqttProtocol::V5 ? ", MQTT 5" : ", MQTT 3.1.1"), Logger::Category::NETWORK);
 }
 
 bool MqttManager::connected() {
-    return mqtt.connected();
+    return transport->connected();
 }
 
 // Main connection maintenance function
@@ -39,7 +166,7 @@ bool MqttManager::maintainConnection() {
         return false;
     }
     
-    mqtt.loop();
+    transport->loop();
     return true;
 }
 void MqttManager::loadConfiguration() {
@@ -58,9 +185,32 @@ void MqttManager::loadConfiguration() {
     mqttUsername = String(username);
     mqttPassword = String(password);
     
+    PreferencesManager::getMqttFormatConfig(formats);
+    if (formats.sensors != PayloadFormat::TEXT || formats.relays != PayloadFormat::TEXT ||
+        formats.stats != PayloadFormat::TEXT) {
+        Logger::info(makeFixedString<80>("MQTT payloads: sensors %s, relays %s, stats %s",
+                                         PayloadEncoding::formatName(formats.sensors),
+                                         PayloadEncoding::formatName(formats.relays),
+                                         PayloadEncoding::formatName(formats.stats)).c_str(),
+                     Logger::Category::NETWORK);
+    }
+    
+    SparkplugConfig sparkplugConfig;
+    PreferencesManager::getSparkplugConfig(sparkplugConfig);
+    sparkplugEnabled = sparkplugConfig.enabled;
+    if (sparkplugEnabled) {
+        sparkplug.begin(sparkplugConfig.group, DEVICE_ID, publishSparkplugMessage, this);
+        
+        // Sparkplug timestamps are UTC
+        configTime(0, 0, SNTP_SERVER);
+        Logger::info(makeFixedString<96>("Sparkplug B mode: group %s, node %s",
+                                         sparkplugConfig.group, DEVICE_ID).c_str(),
+                     Logger::Category::NETWORK);
+    }
+    
     // Update MQTT client configuration if we have valid settings
     if (mqttBroker.length() > 0 && mqttPort > 0) {
-        mqtt.setServer(mqttBroker.c_str(), mqttPort);
+        transport->setServer(mqttBroker.c_str(), mqttPort);
         Logger::info("MQTT configured with broker: " + mqttBroker + ":" + String(mqttPort), 
                     Logger::Category::NETWORK);
     } else {
@@ -68,30 +218,25 @@ void MqttManager::loadConfiguration() {
     }
 }
 
-void MqttManager::setupSecureClient() {
-    // Configure secure WiFi client with the root CA certificate
-    //wifiClient.setCACert(letsencrypt_root_ca);
-    wifiClient.setCACert(getLetsEncryptRootCA());
-    
-    // Configure MQTT client
-    mqtt.setBufferSize(8192);  // Set a reasonably large buffer for sensor data
-    mqtt.setSocketTimeout(10);  // 10 seconds socket timeout
-    
-    // Load and apply MQTT configuration
-    char broker[MAX_MQTT_SERVER_LENGTH];
-    char username[MAX_MQTT_CRED_LENGTH];
-    char password[MAX_MQTT_CRED_LENGTH];
-    unsigned short port;
-    
-    PreferencesManager::getMqttConfig(broker, port, username, password);
-    
-    if (strlen(broker) > 0 && port > 0) {
-        mqtt.setServer(broker, port);
-        Logger::debug("MQTT client configured with broker: " + String(broker));
+// Received messages, on the network task from maintainConnection()
+void MqttManager::onMessage(const char* topic, const uint8_t* payload, size_t length, void* context) {
+    MqttManager* self = static_cast<MqttManager*>(context);
+    if (self->sparkplugEnabled && strcmp(topic, self->sparkplug.commandTopic()) == 0) {
+        bool pending = self->sparkplug.birthPending();
+        self->sparkplug.handleCommand(payload, length);
+        if (!pending && self->sparkplug.birthPending()) {
+            Logger::info("Sparkplug rebirth requested", Logger::Category::NETWORK);
+        }
     }
 }
 
-bool MqttManager::publish(const char* topic, const char* payload, bool retained) {
+bool MqttManager::publish(const char* topic, const char* payload, bool retained,
+                          const MqttTransport::PublishProperties* properties) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), strlen(payload), retained, properties);
+}
+
+bool MqttManager::publish(const char* topic, const uint8_t* payload, size_t length, bool retained,
+                          const MqttTransport::PublishProperties* properties) {
     if (!connected()) {
         Logger::warning("Not publishing - MQTT disconnected");
         return false;
@@ -105,13 +250,12 @@ bool MqttManager::publish(const char* topic, const char* payload, bool retained)
             delay((1 << retry) * 200);  // 200ms, 400ms, 600ms
         }
 
-        if (mqtt.publish(topic, payload, retained)) {
-            // Give some time for the message to be processed
-            delay(50);
+        if (transport->publish(topic, payload, length, MQTT_QOS, retained, properties)) {
             return true;
         }
         
-        Logger::warning("Publish attempt " + String(retry + 1) + " failed for topic: " + String(topic));
+        Logger::warning(makeFixedString<160>("Publish attempt %d failed for topic: %s", 
+                                             retry + 1, topic).c_str());
     }
     
     return false;
@@ -123,23 +267,23 @@ void MqttManager::publishRelayState(uint8_t relayId, bool state) {
         return;
     }
 
-    char topicBuffer[128];
     const char* stateStr = state ? "ON" : "OFF";
     
     // Publish state topic
-    snprintf(topicBuffer, sizeof(topicBuffer), 
-             "%s/%s/relay/%d/state",
-             SYSTEM_NAME, DEVICE_ID, relayId + 1);
-    
-    Logger::debug("Publishing relay " + String(relayId + 1) + " state: " + stateStr);
-    publish(topicBuffer, stateStr, true);
+    if (Logger::isEnabled(Logger::Level::DEBUG)) {
+        Logger::debug(makeFixedString<48>("Publishing relay %d state: %s", relayId + 1, stateStr).c_str());
+    }
+    TopicString topic = stateTopic(Topic::RELAY_STATE, nullptr, relayId);
+    if (formats.relays == PayloadFormat::TEXT) {
+        publish(topic.c_str(), stateStr, true);
+    } else {
+        uint8_t payload[4];
+        size_t length = PayloadEncoding::encodeBool(formats.relays, state, payload, sizeof(payload));
+        publish(topic.c_str(), payload, length, true);
+    }
     
     // Publish availability topic
-    snprintf(topicBuffer, sizeof(topicBuffer), 
-             "%s/%s/relay/%d/availability",
-             SYSTEM_NAME, DEVICE_ID, relayId + 1);
-    
-    publish(topicBuffer, "online", true);
+    publishText(stateTopic(Topic::RELAY_AVAILABILITY, nullptr, relayId).c_str(), formats.relays, "online");
 }
 
 void MqttManager::publishSensorData(const TemperatureSensor& sensor) {
@@ -148,43 +292,437 @@ void MqttManager::publishSensorData(const TemperatureSensor& sensor) {
         return;
     }
 
-    char topicBuffer[128];
-    char payloadBuffer[64];
-    String sensorId = PreferencesManager::addressToString(sensor.address);  // Use PreferencesManager's method
-
+    PayloadFormat format = formats.sensors;
+    MqttTransport::PublishProperties properties;
+    uint16_t firstAlias = sensorAlias(sensor.address);
 
     // Publish temperature
-    snprintf(topicBuffer, sizeof(topicBuffer), 
-             "%s/%s/%s/%s/temperature",
-             SYSTEM_NAME, DEVICE_ID, MQTT_TOPIC_BASE, sensorId.c_str());
-    
-    snprintf(payloadBuffer, sizeof(payloadBuffer), "%.2f", sensor.temperature);
-    publish(topicBuffer, payloadBuffer, true);
+    publishFloat(stateTopic(Topic::SENSOR_TEMPERATURE, sensor.address, 0).c_str(), format,
+                 sensor.temperature, sensorProperties(Topic::SENSOR_TEMPERATURE, firstAlias, properties));
+
+    // Publish unfiltered reading alongside the processed value
+    publishFloat(stateTopic(Topic::SENSOR_RAW, sensor.address, 0).c_str(), format, sensor.rawTemperature,
+                 sensorProperties(Topic::SENSOR_RAW, firstAlias, properties));
 
     // Publish status
-    snprintf(topicBuffer, sizeof(topicBuffer), 
-             "%s/%s/%s/%s/status",
-             SYSTEM_NAME, DEVICE_ID, MQTT_TOPIC_BASE, sensorId.c_str());
-    
-    publish(topicBuffer, sensor.valid ? "online" : "error", true);
+    publishText(stateTopic(Topic::SENSOR_STATUS, sensor.address, 0).c_str(), format,
+                sensor.health == SensorHealth::QUARANTINED ? "offline" :
+                sensor.valid ? "online" : "error",
+                sensorProperties(Topic::SENSOR_STATUS, firstAlias, properties));
 
     // Publish last update time
+    publishUnsigned(stateTopic(Topic::SENSOR_LAST_UPDATE, sensor.address, 0).c_str(), format,
+                    sensor.lastReadTime, sensorProperties(Topic::SENSOR_LAST_UPDATE, firstAlias, properties));
+}
+
+// First alias of the sensor's block, handed out on its first publish of the
+// connection. 0 without MQTT 5 or once every block is taken.
+uint16_t MqttManager::sensorAlias(const uint8_t* address) {
+    if (protocol != MqttProtocol::V5) {
+        return 0;
+    }
+    for (size_t i = 0; i < aliasSensorCount; i++) {
+        if (memcmp(aliasSensors[i], address, 8) == 0) {
+            return static_cast<uint16_t>(i * ALIASES_PER_SENSOR + 1);
+        }
+    }
+    if (aliasSensorCount == SENSOR_TABLE_CAPACITY) {
+        return 0;
+    }
+    memcpy(aliasSensors[aliasSensorCount], address, 8);
+    return static_cast<uint16_t>(aliasSensorCount++ * ALIASES_PER_SENSOR + 1);
+}
+
+// Alias, telemetry expiry and unit of a sensor topic; nullptr without MQTT 5
+const MqttTransport::PublishProperties* MqttManager::sensorProperties(
+    Topic topic, uint16_t firstAlias, MqttTransport::PublishProperties& properties) const {
+    if (protocol != MqttProtocol::V5) {
+        return nullptr;
+    }
+    properties.topicAlias = firstAlias ? static_cast<uint16_t>(firstAlias + static_cast<uint16_t>(topic)) : 0;
+    properties.messageExpiry = MQTT_TELEMETRY_EXPIRY;
+    properties.unit = TOPIC_TABLE[static_cast<size_t>(topic)].unit;
+    return &properties;
+}
+
+// One reading in the topic class's format: "%.2f" text or a single binary item
+bool MqttManager::publishFloat(const char* topic, PayloadFormat format, float value,
+                               const MqttTransport::PublishProperties* properties) {
+    if (format == PayloadFormat::TEXT) {
+        char text[24];
+        snprintf(text, sizeof(text), "%.2f", value);
+        return publish(topic, text, true, properties);
+    }
+    uint8_t payload[8];
+    size_t length = PayloadEncoding::encodeFloat(format, value, payload, sizeof(payload));
+    return publish(topic, payload, length, true, properties);
+}
+
+bool MqttManager::publishUnsigned(const char* topic, PayloadFormat format, uint32_t value,
+                                  const MqttTransport::PublishProperties* properties) {
+    if (format == PayloadFormat::TEXT) {
+        char text[12];
+        snprintf(text, sizeof(text), "%lu", static_cast<unsigned long>(value));
+        return publish(topic, text, true, properties);
+    }
+    uint8_t payload[8];
+    size_t length = PayloadEncoding::encodeUnsigned(format, value, payload, sizeof(payload));
+    return publish(topic, payload, length, true, properties);
+}
+
+bool MqttManager::publishText(const char* topic, PayloadFormat format, const char* text,
+                              const MqttTransport::PublishProperties* properties) {
+    if (format == PayloadFormat::TEXT) {
+        return publish(topic, text, true, properties);
+    }
+    uint8_t payload[16];
+    size_t length = PayloadEncoding::encodeText(format, text, payload, sizeof(payload));
+    return publish(topic, payload, length, true, properties);
+}
+
+// Publish a completed statistics window to <sensor>/stats/<1m|1h|24h>
+bool MqttManager::publishRollup(const RollupReport& report) {
+    if (!connected()) {
+        return false;
+    }
+
+    char topicBuffer[128];
+    char payloadBuffer[256];
+    AddressString sensorId = formatAddress(report.address);
+    const RollupWindow& rollup = report.rollup;
+
     snprintf(topicBuffer, sizeof(topicBuffer), 
-             "%s/%s/%s/%s/last_update",
-             SYSTEM_NAME, DEVICE_ID, MQTT_TOPIC_BASE, sensorId.c_str());
-    
-    snprintf(payloadBuffer, sizeof(payloadBuffer), "%lu", sensor.lastReadTime);
-    publish(topicBuffer, payloadBuffer, true);
+             "%s/%s/%s/%s/stats/%s",
+             SYSTEM_NAME, DEVICE_ID, MQTT_TOPIC_BASE, sensorId.c_str(),
+             RollupStats::windowName(report.window));
+
+    if (formats.stats != PayloadFormat::TEXT) {
+        uint8_t payload[PayloadEncoding::MAX_ROLLUP_ITEM];
+        size_t length = PayloadEncoding::encodeRollup(formats.stats, rollup, payload, sizeof(payload));
+        return publish(topicBuffer, payload, length, true);
+    }
+
+    snprintf(payloadBuffer, sizeof(payloadBuffer),
+             "{\"start\":%lu,\"count\":%lu,\"mean\":%.3f,\"stddev\":%.3f,"
+             "\"min\":%.2f,\"minTime\":%lu,\"max\":%.2f,\"maxTime\":%lu}",
+             static_cast<unsigned long>(rollup.startTime),
+             static_cast<unsigned long>(rollup.count),
+             rollup.mean, RollupStats::stddev(rollup),
+             rollup.min, static_cast<unsigned long>(rollup.minTime),
+             rollup.max, static_cast<unsigned long>(rollup.maxTime));
+
+    return publish(topicBuffer, payloadBuffer, true);
 }
 
 void MqttManager::publishAuxDisplayData(const TemperatureSensor& sensor) {
-    String topic = String(SYSTEM_NAME) + "/" + 
-                  String(DEVICE_ID) + "/" + 
-                  String(MQTT_AUX_DISPLAY_TOPIC);
+    TopicString topic = makeFixedString<TopicString::capacity()>(
+        "%s/%s/%s", SYSTEM_NAME, DEVICE_ID, MQTT_AUX_DISPLAY_TOPIC);
     
-    String payload = String(sensor.temperature);
-    mqtt.publish(topic.c_str(), payload.c_str(), true);
-    Logger::debug("Published aux display temperature: " + payload + " to topic: " + topic);
+    char payload[16];
+    snprintf(payload, sizeof(payload), "%.2f", sensor.temperature);
+    transport->publish(topic.c_str(), reinterpret_cast<const uint8_t*>(payload), strlen(payload), MQTT_QOS, true,
+                       nullptr);
+}
+
+// Samples the readings and relays of a publication cycle and sends what
+// changed. The samples are kept for births requested before the next cycle.
+void MqttManager::publishSparkplug(const std::vector<TemperatureSensor>& sensors,
+                                   const bool* relays, uint8_t relayCount) {
+    sparkplugSampleCount = 0;
+    for (const auto& sensor : sensors) {
+        if (sparkplugSampleCount >= SENSOR_TABLE_CAPACITY) break;
+        SparkplugSensorSample& sample = sparkplugSamples[sparkplugSampleCount++];
+        memcpy(sample.address, sensor.address, sizeof(sample.address));
+        sample.temperature = sensor.temperature;
+        sample.rawTemperature = sensor.rawTemperature;
+        sample.status = sensor.health == SensorHealth::QUARANTINED ? "offline" :
+                        sensor.valid ? "online" : "error";
+        sample.valid = sensor.valid && sensor.health != SensorHealth::QUARANTINED;
+    }
+    
+    sparkplugRelayCount = std::min<uint8_t>(relayCount, SPARKPLUG_MAX_RELAYS);
+    memcpy(sparkplugRelays, relays, sparkplugRelayCount);
+    sparkplugHasData = true;
+    sendSparkplug();
+}
+
+void MqttManager::serviceSparkplug() {
+    if (sparkplugEnabled && sparkplugHasData && sparkplug.birthPending() && connected()) {
+        sendSparkplug();
+    }
+}
+
+void MqttManager::logTransportStats() {
+    if (!Logger::isEnabled(Logger::Level::DEBUG)) {
+        return;
+    }
+    MqttTransport::Stats stats;
+    transport->getStats(stats);
+    Logger::debug(makeFixedString<224>("MQTT %s: %lu published, %lu acked (avg %lu ms, max %lu ms), "
+                                       "%lu in flight, %lu dropped, %lu inbound dropped, "
+                                       "%lu bytes sent, %lu us per publish",
+                                       transport->name(),
+                                       static_cast<unsigned long>(stats.published),
+                                       static_cast<unsigned long>(stats.acknowledged),
+                                       static_cast<unsigned long>(stats.ackTimeAverage),
+                                       static_cast<unsigned long>(stats.ackTimeMax),
+                                       static_cast<unsigned long>(stats.inFlight),
+                                       static_cast<unsigned long>(stats.dropped),
+                                       static_cast<unsigned long>(stats.inboundDropped),
+                                       static_cast<unsigned long>(stats.bytesSent),
+                                       static_cast<unsigned long>(stats.publishTimeAverage)).c_str(),
+                  Logger::Category::NETWORK);
+}
+
+bool MqttManager::sendSparkplug() {
+    if (!connected()) {
+        return false;
+    }
+    
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    if (now.tv_sec < 1600000000) {
+        if (!sparkplugClockWarned) {
+            Logger::warning("Sparkplug waiting for SNTP time", Logger::Category::NETWORK);
+            sparkplugClockWarned = true;
+        }
+        return false;
+    }
+    uint64_t timestamp = static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_usec / 1000;
+    
+    bool births = sparkplug.birthPending();
+    if (!sparkplug.update(sparkplugSamples, sparkplugSampleCount, sparkplugRelays, sparkplugRelayCount,
+                          timestamp)) {
+        Logger::warning("Sparkplug publish failed - rebirth on the next pass", Logger::Category::NETWORK);
+        return false;
+    }
+    if (births) {
+        Logger::info(makeFixedString<64>("Sparkplug NBIRTH sent, bdSeq %u, %u devices",
+                                         static_cast<unsigned>(sparkplug.getBdSeq()),
+                                         static_cast<unsigned>(sparkplugSampleCount)).c_str(),
+                     Logger::Category::NETWORK);
+    }
+    return true;
+}
+
+bool MqttManager::publishSparkplugMessage(const char* topic, const uint8_t* payload, size_t length, void* context) {
+    // Sparkplug messages are never retained; state is rebuilt from births
+    return static_cast<MqttManager*>(context)->publish(topic, payload, length, false);
+}
+
+// Marks the configs that differ from what the broker holds. Runs in full
+// only when the sensor set, a name or the session changed since last time.
+void MqttManager::updateDiscovery(const std::vector<TemperatureSensor>& sensors) {
+    uint32_t sensorHash = 2166136261u;
+    for (const auto& sensor : sensors) {
+        sensorHash = fnv1a(sensorHash, sensor.address, 8);
+    }
+    uint32_t generation = PreferencesManager::getNameGeneration();
+    if (discoveryUpdated && !discoveryNewSession && sensorHash == discoverySensorHash &&
+        generation == discoveryNameGeneration) {
+        return;
+    }
+    
+    // Retained configs survive a reconnect, but a new session may be a broker
+    // that lost them, so every current entity is announced again
+    for (auto& entry : discovery) {
+        if (discoveryNewSession && entry.wanted != 0) entry.published = 0;
+        entry.wanted = 0;
+    }
+    
+    for (size_t row = 0; row < static_cast<size_t>(Topic::COUNT); row++) {
+        const TopicSpec& spec = TOPIC_TABLE[row];
+        if (!spec.component) continue;
+        
+        // Home Assistant reads text state topics only. Entities of a class
+        // switched to a binary format are removed instead, once per boot, in
+        // case the broker still holds their configs from before.
+        PayloadFormat format = spec.scope == TopicScope::SENSOR ? formats.sensors :
+                               spec.scope == TopicScope::RELAY ? formats.relays : PayloadFormat::TEXT;
+        bool announce = format == PayloadFormat::TEXT;
+        if (!announce && discoveryUpdated) continue;
+        
+        Topic topic = static_cast<Topic>(row);
+        switch (spec.scope) {
+            case TopicScope::SENSOR:
+                for (const auto& sensor : sensors) {
+                    wantDiscovery(topic, sensor.address, 0, announce);
+                }
+                break;
+            case TopicScope::RELAY:
+                for (uint8_t relay = 0; relay < RELAY_COUNT; relay++) {
+                    wantDiscovery(topic, nullptr, relay, announce);
+                }
+                break;
+            case TopicScope::HUB:
+                wantDiscovery(topic, nullptr, 0, announce);
+                break;
+        }
+    }
+    
+    // Entities no longer wanted and never announced need nothing
+    size_t pending = 0;
+    for (auto& entry : discovery) {
+        if (!entry.inUse) continue;
+        if (entry.wanted == 0 && entry.published == 0) {
+            entry.inUse = false;
+        } else if (entry.wanted != entry.published) {
+            pending++;
+        }
+    }
+    
+    discoverySensorHash = sensorHash;
+    discoveryNameGeneration = generation;
+    discoveryUpdated = true;
+    discoveryNewSession = false;
+    if (pending > 0) {
+        Logger::info(makeFixedString<64>("Home Assistant discovery: %u configs to publish",
+                                         static_cast<unsigned>(pending)).c_str(),
+                     Logger::Category::NETWORK);
+    }
+}
+
+size_t MqttManager::publishDiscovery(size_t maxMessages) {
+    size_t sent = 0;
+    for (auto& entry : discovery) {
+        if (sent >= maxMessages || !connected()) break;
+        if (!entry.inUse || entry.published == entry.wanted) continue;
+        
+        TopicString topic = discoveryTopic(entry);
+        if (entry.wanted == 0) {
+            // An empty retained config removes the entity
+            if (!publish(topic.c_str(), "", true)) break;
+            entry.inUse = false;
+            sent++;
+            continue;
+        }
+        
+        // Rebuilt rather than cached; a name saved since the update is picked up
+        DiscoveryConfig config;
+        buildDiscoveryConfig(entry, config);
+        uint32_t hash = configHash(config);
+        if (config.truncated()) {
+            Logger::error("Discovery config too long for " + topic, Logger::Category::NETWORK);
+            entry.published = entry.wanted = hash;
+            continue;
+        }
+        if (!publish(topic.c_str(), config.c_str(), true)) break;
+        entry.published = entry.wanted = hash;
+        sent++;
+    }
+    return sent;
+}
+
+void MqttManager::wantDiscovery(Topic topic, const uint8_t* address, uint8_t relay, bool announce) {
+    if (!address) address = NO_ADDRESS;
+    
+    DiscoveryEntry* entry = nullptr;
+    DiscoveryEntry* unused = nullptr;
+    for (auto& candidate : discovery) {
+        if (!candidate.inUse) {
+            if (!unused) unused = &candidate;
+        } else if (candidate.topic == topic && candidate.relay == relay &&
+                   memcmp(candidate.address, address, 8) == 0) {
+            entry = &candidate;
+            break;
+        }
+    }
+    
+    if (!entry) {
+        if (!unused) {
+            Logger::warning("Discovery table full - entity not announced", Logger::Category::NETWORK);
+            return;
+        }
+        entry = unused;
+        *entry = DiscoveryEntry();
+        memcpy(entry->address, address, 8);
+        entry->topic = topic;
+        entry->relay = relay;
+        entry->inUse = true;
+    }
+    
+    if (!announce) {
+        // Removal of a config the broker may hold from an earlier boot
+        if (entry->published == 0) entry->published = 1;
+        return;
+    }
+    
+    DiscoveryConfig config;
+    buildDiscoveryConfig(*entry, config);
+    entry->wanted = configHash(config);
+}
+
+TopicString MqttManager::stateTopic(Topic topic, const uint8_t* address, uint8_t relay) const {
+    const TopicSpec& spec = TOPIC_TABLE[static_cast<size_t>(topic)];
+    switch (spec.scope) {
+        case TopicScope::SENSOR:
+            return makeFixedString<TopicString::capacity()>(
+                "%s/%s/%s/%s/%s", SYSTEM_NAME, DEVICE_ID, MQTT_TOPIC_BASE,
+                formatAddress(address).c_str(), spec.leaf);
+        case TopicScope::RELAY:
+            return makeFixedString<TopicString::capacity()>(
+                "%s/%s/relay/%d/%s", SYSTEM_NAME, DEVICE_ID, relay + 1, spec.leaf);
+        case TopicScope::HUB:
+        default:
+            return TopicString(spec.leaf);
+    }
+}
+
+// <prefix>/<component>/<device>/<object id>/config
+TopicString MqttManager::discoveryTopic(const DiscoveryEntry& entry) const {
+    const TopicSpec& spec = TOPIC_TABLE[static_cast<size_t>(entry.topic)];
+    TopicString topic = makeFixedString<TopicString::capacity()>(
+        "%s/%s/%s/", MQTT_DISCOVERY_PREFIX, spec.component, DEVICE_ID);
+    appendObjectId(topic, spec, entry.address, entry.relay);
+    topic.append("/config");
+    return topic;
+}
+
+void MqttManager::buildDiscoveryConfig(const DiscoveryEntry& entry, DiscoveryConfig& config) const {
+    const TopicSpec& spec = TOPIC_TABLE[static_cast<size_t>(entry.topic)];
+    
+    // Sensors and relays go by their configured names, falling back to ROM and number
+    String name;
+    if (spec.scope == TopicScope::SENSOR) {
+        name = PreferencesManager::getSensorName(entry.address);
+        if (name.isEmpty()) name = formatAddress(entry.address).c_str();
+    } else if (spec.scope == TopicScope::RELAY) {
+        name = PreferencesManager::getRelayName(entry.relay);
+        if (name.isEmpty()) name = "Relay " + String(entry.relay + 1);
+    } else {
+        name = "SensorHUB";
+    }
+    if (spec.label) {
+        name += " ";
+        name += spec.label;
+    }
+    
+    config.clear();
+    config.append("{\"name\":");
+    appendJsonString(config, name.c_str());
+    config.appendf(",\"uniq_id\":\"%s_", DEVICE_ID);
+    appendObjectId(config, spec, entry.address, entry.relay);
+    config.appendf("\",\"stat_t\":\"%s\"", stateTopic(entry.topic, entry.address, entry.relay).c_str());
+    
+    // Available while the hub is connected and, where there is one, the
+    // sensor or relay reports itself online
+    TopicString hubStatus = stateTopic(Topic::HUB_STATUS, nullptr, 0);
+    if (entry.topic == Topic::SENSOR_TEMPERATURE || entry.topic == Topic::SENSOR_RAW) {
+        config.appendf(",\"avty\":[{\"t\":\"%s\"},{\"t\":\"%s\"}],\"avty_mode\":\"all\"", hubStatus.c_str(),
+                       stateTopic(Topic::SENSOR_STATUS, entry.address, 0).c_str());
+    } else if (spec.scope == TopicScope::RELAY) {
+        config.appendf(",\"avty\":[{\"t\":\"%s\"},{\"t\":\"%s\"}],\"avty_mode\":\"all\"", hubStatus.c_str(),
+                       stateTopic(Topic::RELAY_AVAILABILITY, nullptr, entry.relay).c_str());
+    } else if (spec.scope != TopicScope::HUB) {
+        config.appendf(",\"avty_t\":\"%s\"", hubStatus.c_str());
+    }
+    
+    if (spec.fields) {
+        config.append(',').append(spec.fields);
+    }
+    config.appendf(",\"dev\":{\"ids\":[\"%s_%s\"],\"name\":\"%s\",\"mf\":\"Chaoticvolt\","
+                   "\"mdl\":\"SensorHUB\",\"sw\":\"%s\"}}",
+                   SYSTEM_NAME, DEVICE_ID, DEVICE_NAME, FIRMWARE_VERSION);
 }
 
 // Private helper methods
@@ -206,32 +744,56 @@ bool MqttManager::reconnect() {
     
     String clientId = "ESP32-";
     clientId += ETH.macAddress();
+    TopicString statusTopic = stateTopic(Topic::HUB_STATUS, nullptr, 0);
+    static const char OFFLINE[] = "offline";
+    MqttTransport::Will will = {statusTopic.c_str(), reinterpret_cast<const uint8_t*>(OFFLINE),
+                                sizeof(OFFLINE) - 1, MQTT_QOS, true};
+    if (sparkplugEnabled) {
+        // NDEATH with the bdSeq of this session replaces the status will
+        will.length = sparkplug.prepareDeath(will.payload);
+        will.topic = sparkplug.deathTopic();
+        will.retain = false;
+    }
     
-    if (mqtt.connect(clientId.c_str(), 
-                    mqttUsername.c_str(), 
-                    mqttPassword.c_str(),
-                    "status", 
-                    MQTT_QOS, 
-                    true, 
-                    "offline")) {
+    if (transport->connect(clientId.c_str(), 
+                           mqttUsername.c_str(), 
+                           mqttPassword.c_str(),
+                           will)) {
         Logger::info("MQTT Connected successfully", Logger::Category::NETWORK);
         currentReconnectDelay = 0;  // Reset delay on success
-        char topicBuffer[128];
+        aliasSensorCount = 0;       // Aliases are bound per connection
+        
+        if (sparkplugEnabled) {
+            // NBIRTH goes out from serviceSparkplug() once the clock is set
+            transport->subscribe(sparkplug.commandTopic(), 1);
+            sparkplug.sessionStarted();
+            return true;
+        }
+        
+        // An MQTT 5 session the broker resumed still has its subscriptions,
+        // and the broker still holds the retained discovery configs
+        bool resumed = transport->sessionPresent();
+        discoveryNewSession = !resumed;
+        if (resumed) {
+            Logger::info("MQTT session resumed - subscriptions kept", Logger::Category::NETWORK);
+        } else {
+            char topicBuffer[128];
         
-        for (int i = 0; i < 2; i++) {
-            snprintf(topicBuffer, sizeof(topicBuffer), 
-                     "%s/%s/%s/relay%d/set",
-                     SYSTEM_NAME, DEVICE_ID, MQTT_SWITCH_BASE, i + 1);
-            mqtt.subscribe(topicBuffer);
+            for (int i = 0; i < 2; i++) {
+                snprintf(topicBuffer, sizeof(topicBuffer), 
+                         "%s/%s/%s/relay%d/set",
+                         SYSTEM_NAME, DEVICE_ID, MQTT_SWITCH_BASE, i + 1);
+                transport->subscribe(topicBuffer, 0);
+            }
         }
 
-        mqtt.publish("status", "online", true);
+        publish(statusTopic.c_str(), "online", true);
         return true;
     }
     
     // Create a properly formatted error message
     char message[64];
-    snprintf(message, sizeof(message), "MQTT connection failed, rc=%d", mqtt.state());
+    snprintf(message, sizeof(message), "MQTT connection failed, rc=%d", transport->state());
     Logger::error(message, Logger::Category::NETWORK);
     return false;
 }
@@ -243,6 +805,6 @@ unsigned int MqttManager::getReconnectDelay() {
 }
 
 void MqttManager::setServer(const IPAddress& ip) {
-    mqtt.setServer(ip.toString().c_str(), mqttPort);  // Using the internal PubSubClient instance
+    transport->setServer(ip.toString().c_str(), mqttPort);
     Logger::debug("MQTT server IP updated to: " + ip.toString());
 }
\ No newline at end of file
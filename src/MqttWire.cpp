@@ -0,0 +1,36 @@
+// MqttWire.cpp
+#include "MqttWire.h"
+#include <string.h>
+
+constexpr const char* MqttWire::UNIT_PROPERTY;
+
+size_t MqttWire::varIntLength(size_t value) {
+    size_t length = 1;
+    while (value >= 128) {
+        value >>= 7;
+        length++;
+    }
+    return length;
+}
+
+size_t MqttWire::publishPropertiesLength(const MqttTransport::PublishProperties* properties) {
+    size_t length = 0;
+    if (properties) {
+        if (properties->messageExpiry) {
+            length += 1 + 4;
+        }
+        if (properties->topicAlias) {
+            length += 1 + 2;
+        }
+        if (properties->unit) {
+            // Identifier, then key and value as length-prefixed strings
+            length += 1 + 2 + strlen(UNIT_PROPERTY) + 2 + strlen(properties->unit);
+        }
+    }
+    return varIntLength(length) + length;
+}
+
+size_t MqttWire::publishLength(size_t topicLength, size_t payloadLength, uint8_t qos, size_t propertiesLength) {
+    size_t remaining = 2 + topicLength + (qos > 0 ? 2 : 0) + propertiesLength + payloadLength;
+    return 1 + varIntLength(remaining) + remaining;
+}
@@ -0,0 +1,121 @@
+// MsgPackWriter.cpp
+#include "MsgPackWriter.h"
+#include <string.h>
+
+namespace {
+    constexpr uint8_t TYPE_NIL = 0xC0;
+    constexpr uint8_t TYPE_FALSE = 0xC2;
+    constexpr uint8_t TYPE_TRUE = 0xC3;
+    constexpr uint8_t TYPE_BIN8 = 0xC4;
+    constexpr uint8_t TYPE_FLOAT32 = 0xCA;
+    constexpr uint8_t TYPE_UINT8 = 0xCC;
+    constexpr uint8_t TYPE_INT8 = 0xD0;
+    constexpr uint8_t TYPE_STR8 = 0xD9;
+    constexpr uint8_t TYPE_ARRAY16 = 0xDC;
+    constexpr uint8_t TYPE_MAP16 = 0xDE;
+
+    constexpr uint8_t FIX_MAP = 0x80;
+    constexpr uint8_t FIX_ARRAY = 0x90;
+    constexpr uint8_t FIX_STR = 0xA0;
+
+    // Index 0-3 of the 8-, 16-, 32- and 64-bit forms of a type family
+    uint8_t widthIndex(uint64_t magnitude) {
+        return magnitude <= 0xFF ? 0 : magnitude <= 0xFFFF ? 1 : magnitude <= 0xFFFFFFFF ? 2 : 3;
+    }
+}
+
+MsgPackWriter::MsgPackWriter(uint8_t* buffer, size_t capacity)
+    : PayloadWriter(buffer, capacity) {
+}
+
+bool MsgPackWriter::writeTyped(uint8_t type, uint64_t value, uint8_t bytes, size_t payload) {
+    if (!reserve(1 + bytes + payload)) return false;
+    buffer[length++] = type;
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        buffer[length++] = static_cast<uint8_t>(value >> shift);
+    }
+    return true;
+}
+
+// Arrays and maps have no 8-bit form; their 16-bit type comes first
+bool MsgPackWriter::writeLength(uint8_t fixType, size_t fixLimit, uint8_t typeBase, bool hasLength8,
+                                size_t value, size_t payload) {
+    if (value < fixLimit) {
+        if (!reserve(1 + payload)) return false;
+        buffer[length++] = fixType | static_cast<uint8_t>(value);
+        return true;
+    }
+    uint8_t index = widthIndex(value);
+    if (!hasLength8 && index == 0) index = 1;
+    return writeTyped(typeBase + index - (hasLength8 ? 0 : 1), value, 1 << index, payload);
+}
+
+void MsgPackWriter::beginArray(size_t count) {
+    writeLength(FIX_ARRAY, 16, TYPE_ARRAY16, false, count, 0);
+}
+
+void MsgPackWriter::beginMap(size_t pairs) {
+    writeLength(FIX_MAP, 16, TYPE_MAP16, false, pairs, 0);
+}
+
+void MsgPackWriter::addUnsigned(uint64_t value) {
+    if (value < 0x80) {
+        if (!reserve(1)) return;
+        buffer[length++] = static_cast<uint8_t>(value);
+        return;
+    }
+    uint8_t index = widthIndex(value);
+    writeTyped(TYPE_UINT8 + index, value, 1 << index);
+}
+
+void MsgPackWriter::addInt(int64_t value) {
+    if (value >= 0) {
+        addUnsigned(static_cast<uint64_t>(value));
+        return;
+    }
+    if (value >= -32) {
+        if (!reserve(1)) return;
+        buffer[length++] = static_cast<uint8_t>(value);
+        return;
+    }
+    uint8_t index = value >= INT8_MIN ? 0 : value >= INT16_MIN ? 1 : value >= INT32_MIN ? 2 : 3;
+    writeTyped(TYPE_INT8 + index, static_cast<uint64_t>(value), 1 << index);
+}
+
+void MsgPackWriter::addBool(bool value) {
+    if (!reserve(1)) return;
+    buffer[length++] = value ? TYPE_TRUE : TYPE_FALSE;
+}
+
+void MsgPackWriter::addNull() {
+    if (!reserve(1)) return;
+    buffer[length++] = TYPE_NIL;
+}
+
+void MsgPackWriter::addFloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    writeTyped(TYPE_FLOAT32, bits, 4);
+}
+
+void MsgPackWriter::addText(const char* text, size_t count) {
+    if (!writeLength(FIX_STR, 32, TYPE_STR8, true, count, count)) return;
+    memcpy(buffer + length, text, count);
+    length += count;
+}
+
+void MsgPackWriter::addBytes(const uint8_t* data, size_t count) {
+    uint8_t index = widthIndex(count);
+    if (!writeTyped(TYPE_BIN8 + index, count, 1 << index, count)) return;
+    memcpy(buffer + length, data, count);
+    length += count;
+}
+
+void MsgPackWriter::addHex(const uint8_t* data, size_t count) {
+    static const char DIGITS[] = "0123456789ABCDEF";
+    if (!writeLength(FIX_STR, 32, TYPE_STR8, true, count * 2, count * 2)) return;
+    for (size_t i = 0; i < count; i++) {
+        buffer[length++] = DIGITS[data[i] >> 4];
+        buffer[length++] = DIGITS[data[i] & 0x0F];
+    }
+}
@@ -8,8 +8,9 @@
 #include <ESPmDNS.h>
 #include "Config.h"
 #include "ControlTask.h"
+#include "FixedString.h"
+#include "RtosResources.h"
 
-#define NETWORK_TASK_STACK_SIZE 16192
 #define SENSOR_BATCH_SIZE 4        // Process sensors in small batches
 #define BATCH_DELAY_MS 500         // Time between batches to let memory stabilize
 #define SENSOR_DELAY_MS 100        // Time between individual sensors
@@ -20,15 +21,17 @@ OneWireManager& NetworkTask::owManager = OneWireTask::manager;
 WebServer NetworkTask::webServer(NetworkTask::owManager);
 QueueHandle_t NetworkTask::publishQueue = nullptr;
 QueueHandle_t NetworkTask::controlQueue = nullptr;
+QueueHandle_t NetworkTask::eventQueue = nullptr;
 unsigned long NetworkTask::lastPublishTime = 0;
 
 void NetworkTask::init() {
     Logger::info("Starting Network task initialization");
     
-    publishQueue = xQueueCreate(20, sizeof(TaskMessage));
-    controlQueue = xQueueCreate(10, sizeof(TaskMessage));
+    publishQueue = RtosResources::createQueue(QueueId::NETWORK_PUBLISH);
+    controlQueue = RtosResources::createQueue(QueueId::NETWORK_CONTROL);
+    eventQueue = RtosResources::createQueue(QueueId::NETWORK_EVENT);
     
-    if (!publishQueue || !controlQueue) {
+    if (!publishQueue || !controlQueue || !eventQueue) {
         Logger::error("Failed to create queues");
         return;
     }
@@ -44,26 +47,7 @@ void NetworkTask::init() {
 }
 
 void NetworkTask::start() {
-    xTaskCreate(
-        taskFunction,
-        "NetworkTask",
-        NETWORK_TASK_STACK_SIZE,
-        nullptr,
-        NETWORK_TASK_PRIORITY,
-        nullptr
-    );
-}
-
-String NetworkTask::addressToString(const uint8_t* address) {
-    if (!address) {
-        return String("Invalid");
-    }
-    
-    char buffer[17];
-    snprintf(buffer, sizeof(buffer), "%02X%02X%02X%02X%02X%02X%02X%02X",
-             address[0], address[1], address[2], address[3],
-             address[4], address[5], address[6], address[7]);
-    return String(buffer);
+    RtosResources::createTask(TaskId::NETWORK, taskFunction);
 }
 
 void NetworkTask::publishSensorBatch(const std::vector<TemperatureSensor>& sensors, 
@@ -80,10 +64,46 @@ void NetworkTask::publishSensorBatch(const std::vector<TemperatureSensor>& senso
         
         mqttManager.publishSensorData(sensors[i]);
         vTaskDelay(pdMS_TO_TICKS(SENSOR_DELAY_MS));
+        drainPriorityEvents();
     }
     
     // Allow system to stabilize between batches
     vTaskDelay(pdMS_TO_TICKS(BATCH_DELAY_MS));
+    drainPriorityEvents();
+}
+
+bool NetworkTask::queueAnomalyEvent(const AnomalyEvent& event) {
+    if (!eventQueue) {
+        return false;
+    }
+    return xQueueSend(eventQueue, &event, 0) == pdTRUE;
+}
+
+// Publish queued anomaly events to MQTT and the push channel ahead of regular traffic
+void NetworkTask::drainPriorityEvents() {
+    AnomalyEvent event;
+    while (eventQueue && xQueueReceive(eventQueue, &event, 0) == pdTRUE) {
+        char payload[192];
+        snprintf(payload, sizeof(payload),
+                 "{\"sensor\":\"%s\",\"type\":\"%s\",\"state\":\"%s\","
+                 "\"value\":%.2f,\"metric\":%.3f,\"time\":%lu}",
+                 formatAddress(event.address).c_str(),
+                 AnomalyDetector::typeToString(event.type),
+                 event.raised ? "raised" : "cleared",
+                 event.value, event.metric,
+                 static_cast<unsigned long>(event.timestamp));
+        
+        webServer.pushEvent("anomaly", payload);
+        
+        if (mqttManager.connected()) {
+            TopicString topic = makeFixedString<TopicString::capacity()>(
+                "%s/%s/%s", SYSTEM_NAME, DEVICE_ID, MQTT_EVENT_TOPIC);
+            if (!mqttManager.publish(topic.c_str(), payload, false)) {
+                Logger::warning("Failed to publish anomaly event");
+            }
+        }
+        Logger::info(makeFixedString<200>("Anomaly %s", payload).c_str(), Logger::Category::SENSORS);
+    }
 }
 
 void NetworkTask::taskFunction(void* parameter) {
@@ -97,7 +117,13 @@ void NetworkTask::taskFunction(void* parameter) {
         Logger::error("Error setting up mDNS responder!");
     }
     
+    std::vector<RollupReport> rollups;
+    rollups.reserve((MAX_ONEWIRE_SENSORS + MAX_VIRTUAL_SENSORS) * STATS_WINDOW_COUNT);
+    
     while (true) {
+        // Priority events go out before anything else in the cycle
+        drainPriorityEvents();
+        
         unsigned long currentTime = millis();
         bool mqttIsConnected = mqttManager.maintainConnection();
         
@@ -116,8 +142,10 @@ void NetworkTask::taskFunction(void* parameter) {
                     if (memcmp(sensor.address, displaySensorAddr, sizeof(displaySensorAddr)) == 0) {
                         char tempStr[10];
                         snprintf(tempStr, sizeof(tempStr), "%.1f", sensor.temperature);
-                        if (NetworkTask::publishToTopic(MQTT_AUX_DISPLAY_TOPIC, tempStr)) {
-                            Logger::debug("Published display sensor temperature: " + String(tempStr));
+                        if (NetworkTask::publishToTopic(MQTT_AUX_DISPLAY_TOPIC, tempStr) &&
+                            Logger::isEnabled(Logger::Level::DEBUG)) {
+                            Logger::debug(makeFixedString<64>("Published display sensor temperature: %s", 
+                                                              tempStr).c_str());
                         }
                         displaySensorHandled = true;
                         break;
@@ -128,36 +156,65 @@ void NetworkTask::taskFunction(void* parameter) {
                     Logger::warning("Display sensor not found in sensor list");
                 }
                 
-                // Then handle all other sensors in batches
-                size_t totalSensors = sensors.size();
-                
-                Logger::info("Starting publication cycle for " + String(totalSensors) + 
-                           " sensors in batches of " + String(SENSOR_BATCH_SIZE));
-                
-                // Calculate number of complete batches
-                size_t numBatches = (totalSensors + SENSOR_BATCH_SIZE - 1) / SENSOR_BATCH_SIZE;
-                
-                // Process all batches including the last partial one
-                for (size_t batchIdx = 0; batchIdx < numBatches; batchIdx++) {
-                    size_t startIdx = batchIdx * SENSOR_BATCH_SIZE;
-                    size_t batchSize = std::min<size_t>(SENSOR_BATCH_SIZE, totalSensors - startIdx);
-                    publishSensorBatch(sensors, startIdx, batchSize);
+                if (mqttManager.isSparkplug()) {
+                    // Sparkplug B: the changed metrics of all sensors and relays at once
+                    bool relays[RELAY_COUNT];
+                    for (uint8_t i = 0; i < RELAY_COUNT; i++) {
+                        relays[i] = ControlTask::getRelayState(i);
+                    }
+                    mqttManager.publishSparkplug(sensors, relays, RELAY_COUNT);
+                } else {
+                    // Then handle all other sensors in batches
+                    size_t totalSensors = sensors.size();
+                    
+                    Logger::info(makeFixedString<80>("Starting publication cycle for %u sensors in batches of %d",
+                                                     static_cast<unsigned>(totalSensors), SENSOR_BATCH_SIZE).c_str());
                     
-                    // Also publish relay states after the first batch
-                    if (batchIdx == 0) {
-                        mqttManager.publishRelayState(0, ControlTask::getRelayState(0));
-                        mqttManager.publishRelayState(1, ControlTask::getRelayState(1));
+                    // Calculate number of complete batches
+                    size_t numBatches = (totalSensors + SENSOR_BATCH_SIZE - 1) / SENSOR_BATCH_SIZE;
+                    
+                    // Process all batches including the last partial one
+                    for (size_t batchIdx = 0; batchIdx < numBatches; batchIdx++) {
+                        size_t startIdx = batchIdx * SENSOR_BATCH_SIZE;
+                        size_t batchSize = std::min<size_t>(SENSOR_BATCH_SIZE, totalSensors - startIdx);
+                        publishSensorBatch(sensors, startIdx, batchSize);
+                    
+                        // Also publish relay states after the first batch
+                        if (batchIdx == 0) {
+                            mqttManager.publishRelayState(0, ControlTask::getRelayState(0));
+                            mqttManager.publishRelayState(1, ControlTask::getRelayState(1));
+                        }
                     }
+                    
+                    // Discovery configs that changed go out in the passes that follow
+                    mqttManager.updateDiscovery(sensors);
                 }
                 
                 lastPublishTime = millis();
                 Logger::info("Completed publication cycle");
+                mqttManager.logTransportStats();
             } else {
                 Logger::warning("Skipping publication cycle - MQTT not connected");
                 lastPublishTime = currentTime;
             }
         }
         
+        // Publish statistics windows as they complete; they stay pending while disconnected
+        if (mqttIsConnected && mqttManager.connected() && 
+            owManager.takeCompletedRollups(rollups) > 0) {
+            for (const auto& report : rollups) {
+                if (!mqttManager.publishRollup(report)) {
+                    Logger::warning(makeFixedString<64>("Failed to publish %s rollup for %s",
+                                                        RollupStats::windowName(report.window),
+                                                        formatAddress(report.address).c_str()).c_str());
+                }
+            }
+            if (Logger::isEnabled(Logger::Level::DEBUG)) {
+                Logger::debug(makeFixedString<48>("Published %u statistics rollups", 
+                                                  static_cast<unsigned>(rollups.size())).c_str());
+            }
+        }
+        
         // Process queued messages
         TaskMessage msg;
         while (xQueueReceive(publishQueue, &msg, 0) == pdTRUE) {
@@ -175,36 +232,46 @@ void NetworkTask::taskFunction(void* parameter) {
             }
         }
         
+        // Home Assistant discovery trickles out behind telemetry, a few configs per pass
+        if (mqttManager.connected()) {
+            mqttManager.publishDiscovery(MQTT_DISCOVERY_PER_PASS);
+        }
+        
+        // Sparkplug births requested by a new session or a Rebirth command
+        mqttManager.serviceSparkplug();
+        
         vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(100));
     }
 }
 
 bool NetworkTask::publishSensorData(const TemperatureSensor& sensor) {
     bool success = true;
+    AddressString sensorId = formatAddress(sensor.address);
+    TopicString topic;
     
     if (sensor.valid) {
         char tempStr[10];
         snprintf(tempStr, sizeof(tempStr), "%.2f", sensor.temperature);
-        success &= mqttManager.publish((String(SYSTEM_NAME) + "/" + MQTT_TOPIC_BASE + "/" + 
-                                     addressToString(sensor.address) + "/temperature").c_str(), 
-                                     tempStr, true);
+        topic.clear();
+        topic.appendf("%s/%s/%s/temperature", SYSTEM_NAME, MQTT_TOPIC_BASE, sensorId.c_str());
+        success &= mqttManager.publish(topic.c_str(), tempStr, true);
         
         if (!success) {
-            Logger::error("Failed to publish temperature for sensor " + 
-                         addressToString(sensor.address));
+            Logger::error("Failed to publish temperature for sensor " + sensorId);
         }
     }
     
     char timeStr[20];
     snprintf(timeStr, sizeof(timeStr), "%lu", sensor.lastReadTime);
-    success &= mqttManager.publish((String(SYSTEM_NAME) + "/" + MQTT_TOPIC_BASE + "/" + 
-                                 addressToString(sensor.address) + "/last_update").c_str(), 
-                                 timeStr, true);
+    topic.clear();
+    topic.appendf("%s/%s/%s/last_update", SYSTEM_NAME, MQTT_TOPIC_BASE, sensorId.c_str());
+    success &= mqttManager.publish(topic.c_str(), timeStr, true);
     
-    const char* status = sensor.valid ? "online" : "error";
-    success &= mqttManager.publish((String(SYSTEM_NAME) + "/" + MQTT_TOPIC_BASE + "/" + 
-                                 addressToString(sensor.address) + "/status").c_str(), 
-                                 status, true);
+    const char* status = sensor.health == SensorHealth::QUARANTINED ? "offline" :
+                         sensor.valid ? "online" : "error";
+    topic.clear();
+    topic.appendf("%s/%s/%s/status", SYSTEM_NAME, MQTT_TOPIC_BASE, sensorId.c_str());
+    success &= mqttManager.publish(topic.c_str(), status, true);
     
     return success;
 }
@@ -216,11 +283,10 @@ bool NetworkTask::publishToTopic(const char* topic, const char* payload) {
     }
     
     // Build the full topic path: system_name/device_id/topic
-    String fullTopic = String(SYSTEM_NAME) + "/" + DEVICE_ID + "/" + topic;
-    Logger::debug("Publishing to topic: " + fullTopic);
+    TopicString fullTopic = makeFixedString<TopicString::capacity()>(
+        "%s/%s/%s", SYSTEM_NAME, DEVICE_ID, topic);
     
     if (mqttManager.publish(fullTopic.c_str(), payload, true)) {
-        Logger::debug("Successfully published: " + String(payload));
         return true;
     } else {
         Logger::error("Failed to publish to topic: " + fullTopic);
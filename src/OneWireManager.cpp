@@ -5,8 +5,18 @@
 #include "Config.h"
 #include "OneWireManager.h"
 #include "Logger.h"
+#include "PreferencesManager.h"
+#include "WarmStartCache.h"
+#include "FixedString.h"
+#include "RtosResources.h"
+#include <esp_task_wdt.h>
 #include <algorithm>
 
+static_assert(SENSOR_TABLE_CAPACITY >= MAX_ONEWIRE_SENSORS + MAX_VIRTUAL_SENSORS,
+              "SensorTable too small for all physical and virtual sensors");
+static_assert(SensorTable::NO_READING_RAW == DEVICE_DISCONNECTED_RAW,
+              "SensorTable must use the DallasTemperature disconnected marker");
+
 // Constructor takes the OneWire bus pin and initializes the system
 OneWireManager::OneWireManager(uint8_t pin) 
     : oneWire(pin)
@@ -16,10 +26,15 @@ OneWireManager::OneWireManager(uint8_t pin)
     , lastScanTime(0)
     , lastReadTime(0)
     , conversionStartTime(0)
-    , conversionInProgress(false) {
+    , conversionInProgress(false)
+    , filterConfig(SensorFilter::defaultConfig())
+    , anomalyConfig(AnomalyDetector::defaultConfig())
+    , timingReport{} {
+    
+    pendingAnomalies.reserve(MAX_PENDING_ANOMALIES);
     
     // Create mutex for thread-safe access
-    sensorMutex = xSemaphoreCreateMutex();
+    sensorMutex = RtosResources::createMutex(MutexId::ONEWIRE_SENSORS);
     if (!sensorMutex) {
         Logger::error("Failed to create sensor mutex in constructor");
         return;
@@ -65,33 +80,223 @@ bool OneWireManager::checkAndCollectTemperatures() {
     }
     
     bool success = true;
-    std::vector<TemperatureSensor> updatedList;
-    updatedList.reserve(sensorList.size());
+    uint32_t now = millis();
+    bool virtualChanged = false;
+    // Entries are updated in place; the sweep itself only reads the hot array
+    for (size_t i = 0; i < table.physicalCount(); i++) {
+        SensorHot& sensor = table.hot(i);
+        // Quarantined sensors are only touched by probeQuarantinedSensors()
+        if (SensorTable::health(sensor) == SensorHealth::QUARANTINED) continue;
+        
+        int32_t raw = sensors.getTemp(sensor.address);
+        success &= applyReading(i, raw, now);
+        virtualChanged |= virtualSensors.updateInput(sensor.address, sensor.temperature,
+                                                     SensorTable::isValid(sensor));
+    }
+    
+    if (virtualChanged) {
+        refreshVirtualSensors(now);
+    }
+    for (size_t i = table.physicalCount(); i < table.size(); i++) {
+        if (SensorTable::isValid(table.hot(i))) {
+            RollupStats::addSample(table.cold(i).stats, table.hot(i).temperature, now);
+        }
+    }
     
-    for (const auto& sensor : sensorList) {
-        TemperatureSensor updated = sensor;
-        float temp = sensors.getTempC(sensor.address);
+    conversionInProgress = false;
+    
+    xSemaphoreGive(sensorMutex);
+    return success;
+}
+
+// Runs one raw reading through calibration, filtering, rollups and anomaly
+// detection. Caller holds sensorMutex. Returns false for a failed reading.
+bool OneWireManager::applyReading(size_t index, int32_t raw, uint32_t now) {
+    SensorHot& sensor = table.hot(index);
+    SensorCold& meta = table.cold(index);
+    
+    if (raw == DEVICE_DISCONNECTED_RAW || raw == SensorFilter::POWER_ON_RESET_RAW) {
+        if (sensor.consecutiveErrors < UINT8_MAX) sensor.consecutiveErrors++;
+        if (sensor.consecutiveErrors > MAX_RETRIES) {
+            SensorTable::setValid(sensor, false);
+        }
+        // Keep last valid reading but mark as invalid
+        sensor.temperature = meta.lastValidReading;
         
-        if (temp != DEVICE_DISCONNECTED_C && temp != 85.0) {
-            updated.temperature = temp;
-            updated.lastValidReading = temp;
-            updated.lastReadTime = millis();
-            updated.valid = true;
-            updated.consecutiveErrors = 0;
+        if (sensor.consecutiveErrors >= SENSOR_QUARANTINE_AFTER) {
+            quarantine(index, now);
         } else {
-            updated.consecutiveErrors++;
-            if (updated.consecutiveErrors > MAX_RETRIES) {
-                updated.valid = false;
+            SensorTable::setHealth(sensor, SensorHealth::SUSPECT);
+        }
+        return false;
+    }
+    
+    int32_t filtered = SensorFilter::process(filterConfig, meta.calibration,
+                                             meta.filter, raw, now);
+    sensor.raw = static_cast<int16_t>(raw);
+    sensor.temperature = SensorFilter::toCelsius(filtered);
+    sensor.readTime = now;
+    sensor.consecutiveErrors = 0;
+    SensorTable::setValid(sensor, true);
+    SensorTable::setHealth(sensor, SensorHealth::ACTIVE);
+    meta.lastValidReading = sensor.temperature;
+    RollupStats::addSample(meta.stats, sensor.temperature, now);
+    
+    AnomalyEvent events[ANOMALY_TYPE_COUNT];
+    size_t eventCount = AnomalyDetector::process(anomalyConfig, meta.anomaly,
+                                                 sensor.temperature, raw, now, events);
+    for (size_t i = 0; i < eventCount; i++) {
+        if (pendingAnomalies.size() >= MAX_PENDING_ANOMALIES) {
+            Logger::warning("Anomaly event queue full - dropping event", Logger::Category::SENSORS);
+            break;
+        }
+        memcpy(events[i].address, sensor.address, 8);
+        pendingAnomalies.push_back(events[i]);
+    }
+    return true;
+}
+
+// Takes a sensor out of the read sweep and schedules its first re-probe
+void OneWireManager::quarantine(size_t index, uint32_t now) {
+    SensorHot& sensor = table.hot(index);
+    SensorCold& meta = table.cold(index);
+    if (SensorTable::health(sensor) != SensorHealth::QUARANTINED) {
+        Logger::warning("Sensor " + formatAddress(sensor.address) + " quarantined after " +
+                       String(sensor.consecutiveErrors) + " failed readings", Logger::Category::SENSORS);
+        meta.offlineSince = now;
+    }
+    SensorTable::setHealth(sensor, SensorHealth::QUARANTINED);
+    SensorTable::setValid(sensor, false);
+    meta.probeFailures = 0;
+    meta.nextProbeTime = now + SENSOR_PROBE_BACKOFF_MIN;
+}
+
+// Re-probes quarantined sensors whose backoff has run out. A probe is a reset
+// with presence pulse, Match ROM and a scratchpad read checked by CRC, so only
+// the addressed device can pass. A sensor that answers goes back on probation
+// as SUSPECT: one more failed reading quarantines it again.
+uint8_t OneWireManager::probeQuarantinedSensors() {
+    if (!verifyMutex() || conversionInProgress) return 0;
+    
+    uint32_t now = millis();
+    uint8_t due[MAX_ONEWIRE_SENSORS][8];
+    uint8_t dueCount = 0;
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) return 0;
+    for (size_t i = 0; i < table.physicalCount() && dueCount < MAX_ONEWIRE_SENSORS; i++) {
+        if (SensorTable::health(table.hot(i)) == SensorHealth::QUARANTINED &&
+            static_cast<int32_t>(now - table.cold(i).nextProbeTime) >= 0) {
+            memcpy(due[dueCount++], table.hot(i).address, 8);
+        }
+    }
+    xSemaphoreGive(sensorMutex);
+    if (dueCount == 0 || isBusBusy()) return 0;
+    
+    bool answered[MAX_ONEWIRE_SENSORS];
+    uint8_t resolution[MAX_ONEWIRE_SENSORS];
+    setBusBusy(true);
+    for (uint8_t i = 0; i < dueCount; i++) {
+        uint8_t data[9];
+        answered[i] = false;
+        resolution[i] = 0;
+        if (!oneWire.reset()) continue;  // No presence pulse from any device
+        oneWire.select(due[i]);
+        oneWire.write(0xBE);  // Read scratchpad
+        oneWire.read_bytes(data, sizeof(data));
+        bool allOnes = true;
+        for (uint8_t b : data) allOnes &= b == 0xFF;
+        answered[i] = !allOnes && OneWire::crc8(data, 8) == data[8];
+        resolution[i] = ((data[4] >> 5) & 0x03) + 9;
+    }
+    setBusBusy(false);
+    
+    uint8_t recovered = 0;
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) return 0;
+    now = millis();
+    for (uint8_t i = 0; i < dueCount; i++) {
+        int index = table.find(due[i]);
+        if (index < 0) continue;
+        SensorHot& sensor = table.hot(index);
+        SensorCold& meta = table.cold(index);
+        if (SensorTable::health(sensor) != SensorHealth::QUARANTINED) continue;
+        
+        if (answered[i]) {
+            // A power cycle reverts the device to its EEPROM resolution
+            if (meta.resolution != 0 && resolution[i] != meta.resolution) {
+                sensors.setResolution(sensor.address, meta.resolution);
+            }
+            SensorTable::setHealth(sensor, SensorHealth::SUSPECT);
+            sensor.consecutiveErrors = SENSOR_QUARANTINE_AFTER - 1;
+            meta.probeFailures = 0;
+            recovered++;
+            Logger::info("Sensor " + formatAddress(sensor.address) + " answered probe after " +
+                        String((now - meta.offlineSince) / 1000) + " s offline", Logger::Category::SENSORS);
+        } else {
+            if (meta.probeFailures < UINT8_MAX) meta.probeFailures++;
+            uint32_t backoff = SENSOR_PROBE_BACKOFF_MIN;
+            for (uint8_t n = 0; n < meta.probeFailures && backoff < SENSOR_PROBE_BACKOFF_MAX; n++) {
+                backoff *= 2;
             }
-            // Keep last valid reading but mark as invalid
-            updated.temperature = updated.lastValidReading;
-            success = false;
+            meta.nextProbeTime = now + std::min(backoff, SENSOR_PROBE_BACKOFF_MAX);
         }
-        updatedList.push_back(std::move(updated));
+    }
+    xSemaphoreGive(sensorMutex);
+    return recovered;
+}
+
+const char* OneWireManager::healthToString(SensorHealth health) {
+    switch (health) {
+        case SensorHealth::ACTIVE:      return "active";
+        case SensorHealth::SUSPECT:     return "suspect";
+        case SensorHealth::QUARANTINED: return "offline";
+        default:                        return "unknown";
+    }
+}
+
+// On-demand conversion of a single device. Blocks the calling task for the
+// conversion time, so only the OneWire task should call it.
+bool OneWireManager::readTemperature(const uint8_t* address, float& temperature) {
+    if (!verifyMutex() || VirtualSensorSet::isVirtualAddress(address)) return false;
+    if (conversionInProgress || isBusBusy()) {
+        Logger::warning("Cannot read sensor - bus busy");
+        return false;
     }
     
-    sensorList = std::move(updatedList);
-    conversionInProgress = false;
+    uint8_t resolution = 0;
+    bool known = false;
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        int index = table.find(address);
+        if (index >= 0) {
+            resolution = table.cold(index).resolution;
+            known = true;
+        }
+        xSemaphoreGive(sensorMutex);
+    }
+    if (!known) return false;
+    
+    setBusBusy(true);
+    int32_t raw = DEVICE_DISCONNECTED_RAW;
+    if (sensors.requestTemperaturesByAddress(address)) {
+        vTaskDelay(pdMS_TO_TICKS(sensors.millisToWaitForConversion(resolution ? resolution : 12)));
+        raw = sensors.getTemp(address);
+    }
+    setBusBusy(false);
+    
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in readTemperature");
+        return false;
+    }
+    
+    bool success = false;
+    uint32_t now = millis();
+    int index = table.find(address);
+    if (index >= 0) {
+        success = applyReading(index, raw, now);
+        const SensorHot& sensor = table.hot(index);
+        temperature = sensor.temperature;
+        if (virtualSensors.updateInput(sensor.address, sensor.temperature, SensorTable::isValid(sensor))) {
+            refreshVirtualSensors(now);
+        }
+    }
     
     xSemaphoreGive(sensorMutex);
     return success;
@@ -152,20 +357,23 @@ bool OneWireManager::processFoundDevices(uint8_t deviceCount,
         DeviceAddress tempAddr;
         if (sensors.getAddress(tempAddr, i)) {
             TemperatureSensor sensor = {};
-            sensor.isActive = true;
+            sensor.health = SensorHealth::ACTIVE;
             memcpy(sensor.address, tempAddr, sizeof(DeviceAddress));
             
             // Initialize sensor state
             sensor.valid = false;
             sensor.consecutiveErrors = 0;
             sensor.temperature = DEVICE_DISCONNECTED_C;
+            sensor.rawTemperature = DEVICE_DISCONNECTED_C;
             sensor.lastValidReading = DEVICE_DISCONNECTED_C;
             sensor.lastReadTime = 0;
+            sensor.resolution = sensors.getResolution();
+            PreferencesManager::getSensorCalibration(sensor.address, sensor.calibration);
             
             if (sensors.validAddress(sensor.address)) {
                 tempList.push_back(std::move(sensor));
                 anyDeviceProcessed = true;
-                Logger::debug("Added sensor: " + addressToString(tempAddr));
+                Logger::debug("Added sensor: " + formatAddress(tempAddr));
             }
         }
     }
@@ -173,75 +381,170 @@ bool OneWireManager::processFoundDevices(uint8_t deviceCount,
     return anyDeviceProcessed;
 }
 
-// Update sensor list with thread safety and data preservation
+// Merge a scan result (or the warm start list) into the table. Entries of
+// sensors found again keep their filter, rollup and anomaly state.
 void OneWireManager::updateSensorList(const std::vector<TemperatureSensor>& newList) {
     if (!verifyMutex()) return;
     
     if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        try {
-            std::vector<TemperatureSensor> updatedList;
-            updatedList.reserve(newList.size());
+        bool listed[SENSOR_TABLE_CAPACITY] = {};
+        
+        // Preserve existing sensor data while updating the list
+        for (const auto& newSensor : newList) {
+            if (VirtualSensorSet::isVirtualAddress(newSensor.address)) continue;
+            int index = table.find(newSensor.address);
+            if (index < 0) continue;
             
-            // Preserve existing sensor data while updating the list
-            for (const auto& newSensor : newList) {
-                bool found = false;
-                
-                // Look for matching sensor in existing list
-                for (const auto& existingSensor : sensorList) {
-                    if (memcmp(existingSensor.address, newSensor.address, 8) == 0) {
-                        // Preserve historical data for existing sensors
-                        TemperatureSensor updated = newSensor;
-                        if (existingSensor.valid) {
-                            updated.temperature = existingSensor.temperature;
-                            updated.lastValidReading = existingSensor.lastValidReading;
-                            updated.lastReadTime = existingSensor.lastReadTime;
-                            updated.valid = existingSensor.valid;
-                            updated.consecutiveErrors = existingSensor.consecutiveErrors;
-                        }
-                        updatedList.push_back(updated);
-                        found = true;
-                        break;
-                    }
-                }
-                
-                // Add new sensors with initialized state
-                if (!found) {
-                    updatedList.push_back(newSensor);
-                }
-            }
+            listed[index] = true;
+            loadSensor(index, newSensor, !SensorTable::isValid(table.hot(index)));
+        }
+        
+        // Known sensors the search did not find stay listed as offline and
+        // keep being probed, until they have been gone for SENSOR_FORGET_AFTER.
+        // Walk backwards so removals do not shift entries still to be visited.
+        uint32_t now = millis();
+        for (size_t i = table.physicalCount(); i-- > 0;) {
+            if (listed[i]) continue;
             
-            // Update the main sensor list
-            sensorList = std::move(updatedList);
-            Logger::info("Updated sensor list with " + String(sensorList.size()) + 
-                        " sensors");
+            if (SensorTable::health(table.hot(i)) != SensorHealth::QUARANTINED) {
+                quarantine(i, now);
+            } else if (now - table.cold(i).offlineSince >= SENSOR_FORGET_AFTER) {
+                Logger::info("Forgetting sensor " + formatAddress(table.hot(i).address) + 
+                            " after 24 hours offline", Logger::Category::SENSORS);
+                table.remove(i);
+            }
+        }
+        
+        // Add new sensors with initialized state; a sensor the search found
+        // takes the place of one that is missing when the table is full
+        for (const auto& newSensor : newList) {
+            if (VirtualSensorSet::isVirtualAddress(newSensor.address)) continue;
+            if (table.find(newSensor.address) >= 0) continue;
             
-        } catch (const std::exception& e) {
-            Logger::error("Exception during sensor list update: " + String(e.what()));
+            if (table.physicalCount() >= MAX_ONEWIRE_SENSORS) {
+                size_t evict = 0;
+                while (evict < table.physicalCount() &&
+                       SensorTable::health(table.hot(evict)) != SensorHealth::QUARANTINED) {
+                    evict++;
+                }
+                if (evict == table.physicalCount()) break;
+                table.remove(evict);
+            }
+            int index = table.add(newSensor.address, false);
+            if (index < 0) break;
+            loadSensor(index, newSensor, true);
         }
         
+        // Virtual sensors always follow the physical ones
+        syncVirtualSensors();
+        
+        Logger::info("Updated sensor list with " + String(table.size()) + 
+                    " sensors");
+        
         xSemaphoreGive(sensorMutex);
     } else {
         Logger::error("Failed to acquire mutex in updateSensorList");
     }
 }
 
-// Thread-safe access to the sensor list
-const std::vector<TemperatureSensor>& OneWireManager::getSensorList() const {
-    static const std::vector<TemperatureSensor> emptyList;
+// Copy a scanned or restored sensor into a table entry. Caller must hold the sensor mutex.
+void OneWireManager::loadSensor(size_t index, const TemperatureSensor& sensor, bool withReading) {
+    SensorHot& entry = table.hot(index);
+    SensorCold& meta = table.cold(index);
+    SensorTable::setHealth(entry, sensor.health);
+    meta.resolution = sensor.resolution;
+    meta.calibration = sensor.calibration;
+    meta.probeFailures = sensor.probeFailures;
+    meta.nextProbeTime = sensor.nextProbeTime;
+    meta.offlineSince = sensor.offlineSince;
+    if (!withReading) return;
     
+    entry.temperature = sensor.temperature;
+    entry.raw = sensor.rawTemperature == DEVICE_DISCONNECTED_C ?
+                SensorTable::NO_READING_RAW :
+                static_cast<int16_t>(SensorFilter::fromCelsius(sensor.rawTemperature));
+    entry.readTime = sensor.lastReadTime;
+    entry.consecutiveErrors = sensor.consecutiveErrors;
+    SensorTable::setValid(entry, sensor.valid);
+    meta.lastValidReading = sensor.lastValidReading;
+}
+
+// Fill a consumer snapshot from a table entry. Caller must hold the sensor mutex.
+void OneWireManager::copySensor(size_t index, TemperatureSensor& sensor) const {
+    const SensorHot& entry = table.hot(index);
+    const SensorCold& meta = table.cold(index);
+    memcpy(sensor.address, entry.address, 8);
+    sensor.temperature = entry.temperature;
+    if (SensorTable::isVirtual(entry)) {
+        sensor.rawTemperature = entry.temperature;
+    } else {
+        sensor.rawTemperature = entry.raw == SensorTable::NO_READING_RAW ?
+                                DEVICE_DISCONNECTED_C : SensorFilter::toCelsius(entry.raw);
+    }
+    sensor.lastValidReading = meta.lastValidReading;
+    sensor.lastReadTime = entry.readTime;
+    sensor.consecutiveErrors = entry.consecutiveErrors;
+    sensor.health = SensorTable::health(entry);
+    sensor.probeFailures = meta.probeFailures;
+    sensor.nextProbeTime = meta.nextProbeTime;
+    sensor.offlineSince = meta.offlineSince;
+    sensor.valid = SensorTable::isValid(entry);
+    sensor.resolution = meta.resolution;
+    sensor.anomalyMask = meta.anomaly.activeMask;
+    sensor.calibration = meta.calibration;
+}
+
+// Thread-safe copy of the sensor list
+std::vector<TemperatureSensor> OneWireManager::getSensorList() const {
+    // Sized up front so nothing is allocated while the mutex is held
+    std::vector<TemperatureSensor> list(SENSOR_TABLE_CAPACITY);
+    list.resize(getSensors(list.data(), list.size()));
+    return list;
+}
+
+size_t OneWireManager::getSensors(TemperatureSensor* out, size_t capacity) const {
     if (!verifyMutex() || !sensorMutex) {
-        Logger::error("Invalid mutex in getSensorList");
-        return emptyList;
+        Logger::error("Invalid mutex in getSensors");
+        return 0;
     }
     
     if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
-        Logger::error("Failed to acquire mutex in getSensorList");
-        return emptyList;
+        Logger::error("Failed to acquire mutex in getSensors");
+        return 0;
     }
     
-    const auto& list = sensorList;  
+    size_t count = std::min(table.size(), capacity);
+    for (size_t i = 0; i < count; i++) {
+        copySensor(i, out[i]);
+    }
     xSemaphoreGive(sensorMutex);
-    return list;
+    return count;
+}
+
+// Copy of the hot array alone, for consumers that only need the readings
+size_t OneWireManager::getHotEntries(SensorHot* out, size_t capacity) const {
+    if (!verifyMutex() || xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return 0;
+    }
+    
+    size_t count = std::min(table.size(), capacity);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = table.hot(i);
+    }
+    xSemaphoreGive(sensorMutex);
+    return count;
+}
+
+bool OneWireManager::getSensorStatistics(const uint8_t* address, SensorStatistics& stats) const {
+    if (!verifyMutex() || xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return false;
+    }
+    int index = table.find(address);
+    if (index >= 0) {
+        stats = table.cold(index).stats;
+    }
+    xSemaphoreGive(sensorMutex);
+    return index >= 0;
 }
 
 // Check if enough time has passed for a new scan
@@ -290,7 +593,7 @@ void OneWireManager::setBusBusy(bool busy) {
 // Verify mutex exists and is valid
 bool OneWireManager::verifyMutex() const {
     if (!sensorMutex) {
-        sensorMutex = xSemaphoreCreateMutex();
+        sensorMutex = RtosResources::createMutex(MutexId::ONEWIRE_SENSORS);
         if (!sensorMutex) {
             Logger::error("Failed to create mutex in verifyMutex");
             return false;
@@ -300,18 +603,6 @@ bool OneWireManager::verifyMutex() const {
     return true;
 }
 
-String OneWireManager::addressToString(const uint8_t* address) const {
-    if (!address) {
-        return "Invalid Address";
-    }
-    
-    char buffer[17];  // 8 bytes in hex (2 chars each) + null terminator
-    snprintf(buffer, sizeof(buffer), "%02X%02X%02X%02X%02X%02X%02X%02X",
-             address[0], address[1], address[2], address[3],
-             address[4], address[5], address[6], address[7]);
-    return String(buffer);
-}
-
 float OneWireManager::getCachedTemperature(const uint8_t* address) {
     if (!verifyMutex() || !sensorMutex) {
         Logger::error("Invalid mutex in getCachedTemperature");
@@ -320,29 +611,30 @@ float OneWireManager::getCachedTemperature(const uint8_t* address) {
     
     float temp = DEVICE_DISCONNECTED_C;
     if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        // Log the address we're looking for
-        String searchAddr = addressToString(address);
-        Logger::debug("Searching for babel temperature for sensor: " + searchAddr);
-        
-        // Log all available sensors for debugging
-        Logger::debug("Current sensor list:");
-        for (const auto& sensor : sensorList) {
-            String sensorAddr = addressToString(sensor.address);
-            Logger::debug(" - " + sensorAddr + ": " + String(sensor.temperature, 2) + 
-                         " (valid: " + String(sensor.valid) + ")");
+        bool debug = Logger::isEnabled(Logger::Level::DEBUG);
+        if (debug) {
+            // Log the address we're looking for and all available sensors
+            Logger::debug(makeFixedString<80>("Searching for babel temperature for sensor: %s",
+                                              formatAddress(address).c_str()).c_str());
+            Logger::debug("Current sensor list:");
+            for (size_t i = 0; i < table.size(); i++) {
+                const SensorHot& sensor = table.hot(i);
+                Logger::debug(makeFixedString<64>(" - %s: %.2f (valid: %d)",
+                                                  formatAddress(sensor.address).c_str(),
+                                                  sensor.temperature, SensorTable::isValid(sensor)).c_str());
+            }
         }
         
-        for (const auto& sensor : sensorList) {
-            if (memcmp(sensor.address, address, 8) == 0) {
-                // Return last valid reading if recent, otherwise return current temp
-                if (!sensor.valid && (millis() - sensor.lastReadTime) < 60000) {
-                    temp = sensor.lastValidReading;
-                    Logger::debug("Found sensor, using last valid reading: " + String(temp, 2));
-                } else {
-                    temp = sensor.temperature;
-                    Logger::debug("Found sensor, using current temperature: " + String(temp, 2));
-                }
-                break;
+        int index = table.find(address);
+        if (index >= 0) {
+            const SensorHot& sensor = table.hot(index);
+            // Return last valid reading if recent, otherwise return current temp
+            bool useLastValid = !SensorTable::isValid(sensor) && (millis() - sensor.readTime) < 60000;
+            temp = useLastValid ? table.cold(index).lastValidReading : sensor.temperature;
+            if (debug) {
+                Logger::debug(makeFixedString<64>("Found sensor, using %s: %.2f",
+                                                  useLastValid ? "last valid reading" : "current temperature",
+                                                  temp).c_str());
             }
         }
         
@@ -357,3 +649,380 @@ float OneWireManager::getCachedTemperature(const uint8_t* address) {
     
     return temp;
 }
+
+
+// Reload the processing chain configuration and per-sensor calibration
+void OneWireManager::reloadFilterConfig() {
+    FilterConfig newConfig;
+    PreferencesManager::getFilterConfig(newConfig);
+    
+    // Collect addresses first so preferences are never read while holding the sensor mutex
+    uint8_t addresses[SENSOR_TABLE_CAPACITY][8];
+    SensorCalibration calibrations[SENSOR_TABLE_CAPACITY];
+    size_t count = 0;
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in reloadFilterConfig");
+        return;
+    }
+    for (; count < table.size(); count++) {
+        memcpy(addresses[count], table.hot(count).address, 8);
+    }
+    xSemaphoreGive(sensorMutex);
+    
+    for (size_t i = 0; i < count; i++) {
+        PreferencesManager::getSensorCalibration(addresses[i], calibrations[i]);
+    }
+    
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in reloadFilterConfig");
+        return;
+    }
+    filterConfig = newConfig;
+    for (size_t i = 0; i < count; i++) {
+        int index = table.find(addresses[i]);
+        if (index >= 0) {
+            table.cold(index).calibration = calibrations[i];
+        }
+    }
+    for (size_t i = 0; i < table.size(); i++) {
+        // Restart the chain so stale state from the old configuration is discarded
+        SensorFilter::reset(table.cold(i).filter);
+    }
+    xSemaphoreGive(sensorMutex);
+    
+    Logger::info("Sensor filter configuration reloaded", Logger::Category::SENSORS);
+}
+
+FilterConfig OneWireManager::getFilterConfig() const {
+    FilterConfig config = SensorFilter::defaultConfig();
+    if (verifyMutex() && xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        config = filterConfig;
+        xSemaphoreGive(sensorMutex);
+    }
+    return config;
+}
+
+// Reload virtual sensor definitions and rebuild their entries in the sensor list
+void OneWireManager::reloadVirtualSensors() {
+    VirtualSensorDefinition definitions[MAX_VIRTUAL_SENSORS];
+    for (uint8_t i = 0; i < MAX_VIRTUAL_SENSORS; i++) {
+        PreferencesManager::getVirtualSensor(i, definitions[i]);
+    }
+    
+    if (!verifyMutex() || xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in reloadVirtualSensors");
+        return;
+    }
+    
+    virtualSensors.clear();
+    for (uint8_t i = 0; i < MAX_VIRTUAL_SENSORS; i++) {
+        if (definitions[i].enabled && !virtualSensors.configure(i, definitions[i])) {
+            Logger::warning("Ignoring invalid virtual sensor definition " + String(i));
+        }
+    }
+    
+    // Seed the aggregates with the current physical readings
+    for (size_t i = 0; i < table.physicalCount(); i++) {
+        const SensorHot& sensor = table.hot(i);
+        if (sensor.readTime != 0) {
+            virtualSensors.updateInput(sensor.address, sensor.temperature, SensorTable::isValid(sensor));
+        }
+    }
+    syncVirtualSensors();
+    
+    xSemaphoreGive(sensorMutex);
+    Logger::info("Virtual sensor configuration reloaded", Logger::Category::SENSORS);
+}
+
+// Match the virtual entries to the enabled virtual sensors, keeping the state
+// of existing ones. Caller must hold the sensor mutex.
+void OneWireManager::syncVirtualSensors() {
+    for (size_t i = table.size(); i-- > table.physicalCount();) {
+        if (!virtualSensors.isEnabled(table.hot(i).address[7])) {
+            table.remove(i);
+        }
+    }
+    for (uint8_t i = 0; i < MAX_VIRTUAL_SENSORS; i++) {
+        if (!virtualSensors.isEnabled(i)) continue;
+        
+        uint8_t address[8];
+        VirtualSensorSet::makeAddress(i, address);
+        if (table.find(address) < 0) {
+            table.add(address, true);
+        }
+    }
+    refreshVirtualSensors(millis());
+}
+
+// Copy the current virtual sensor values into their table entries
+void OneWireManager::refreshVirtualSensors(uint32_t now) {
+    for (size_t i = table.physicalCount(); i < table.size(); i++) {
+        SensorHot& sensor = table.hot(i);
+        SensorCold& meta = table.cold(i);
+        
+        float value;
+        if (virtualSensors.getValue(sensor.address[7], value)) {
+            if (!SensorTable::isValid(sensor) || value != sensor.temperature) {
+                sensor.readTime = now;
+            }
+            sensor.temperature = value;
+            meta.lastValidReading = value;
+            sensor.consecutiveErrors = 0;
+            SensorTable::setValid(sensor, true);
+        } else {
+            sensor.temperature = meta.lastValidReading;
+            SensorTable::setValid(sensor, false);
+        }
+    }
+}
+
+size_t OneWireManager::takeCompletedRollups(std::vector<RollupReport>& reports) {
+    reports.clear();
+    if (!verifyMutex() || xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return 0;
+    }
+    
+    for (size_t index = 0; index < table.size(); index++) {
+        SensorStatistics& stats = table.cold(index).stats;
+        if (!stats.pendingMask) continue;
+        
+        for (uint8_t i = 0; i < STATS_WINDOW_COUNT; i++) {
+            if (!(stats.pendingMask & (1 << i))) continue;
+            RollupReport report;
+            memcpy(report.address, table.hot(index).address, 8);
+            report.window = static_cast<StatsWindow>(i);
+            report.rollup = stats.completed[i];
+            reports.push_back(report);
+        }
+        stats.pendingMask = 0;
+    }
+    
+    xSemaphoreGive(sensorMutex);
+    return reports.size();
+}
+
+void OneWireManager::reloadAnomalyConfig() {
+    AnomalyConfig newConfig;
+    PreferencesManager::getAnomalyConfig(newConfig);
+    
+    if (!verifyMutex() || xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in reloadAnomalyConfig");
+        return;
+    }
+    anomalyConfig = newConfig;
+    for (size_t i = 0; i < table.size(); i++) {
+        AnomalyDetector::reset(table.cold(i).anomaly);
+    }
+    xSemaphoreGive(sensorMutex);
+    
+    Logger::info("Anomaly detection configuration reloaded", Logger::Category::SENSORS);
+}
+
+size_t OneWireManager::takeAnomalyEvents(std::vector<AnomalyEvent>& events) {
+    events.clear();
+    if (!verifyMutex() || xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return 0;
+    }
+    events.assign(pendingAnomalies.begin(), pendingAnomalies.end());
+    pendingAnomalies.clear();
+    xSemaphoreGive(sensorMutex);
+    return events.size();
+}
+
+// Rebuild the sensor list from the last saved state so consumers see the known
+// devices and their last readings before the first bus scan has run
+uint8_t OneWireManager::restoreWarmStart() {
+    WarmStartRecord records[MAX_ONEWIRE_SENSORS];
+    WarmStartCache::Source source;
+    uint8_t count = WarmStartCache::load(records, MAX_ONEWIRE_SENSORS, source);
+    if (count == 0) {
+        Logger::info("No warm start data - full discovery required");
+        return 0;
+    }
+    
+    std::vector<TemperatureSensor> restored;
+    restored.reserve(count);
+    for (uint8_t i = 0; i < count; i++) {
+        TemperatureSensor sensor = {};
+        memcpy(sensor.address, records[i].address, 8);
+        sensor.resolution = records[i].resolution;
+        
+        // The reading is from the previous boot: shown as last known value, not as valid
+        float last = records[i].valid ? SensorFilter::toCelsius(records[i].raw) : DEVICE_DISCONNECTED_C;
+        sensor.temperature = last;
+        sensor.rawTemperature = last;
+        sensor.lastValidReading = last;
+        sensor.lastReadTime = 0;
+        sensor.valid = false;
+        sensor.health = SensorHealth::SUSPECT;  // Until verifyKnownDevices() has addressed it
+        PreferencesManager::getSensorCalibration(sensor.address, sensor.calibration);
+        restored.push_back(std::move(sensor));
+    }
+    
+    updateSensorList(restored);
+    Logger::info("Warm start: restored " + String(count) + " sensors from " + 
+                WarmStartCache::sourceToString(source));
+    return count;
+}
+
+// Address each restored device directly instead of searching the bus. Reading
+// the resolution from the scratchpad doubles as the presence check.
+uint8_t OneWireManager::verifyKnownDevices() {
+    if (!verifyMutex() || isBusBusy()) return 0;
+    
+    setBusBusy(true);
+    uint8_t verified = 0;
+    
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        for (size_t i = 0; i < table.physicalCount(); i++) {
+            SensorHot& sensor = table.hot(i);
+            SensorCold& meta = table.cold(i);
+            
+            uint8_t resolution = sensors.getResolution(sensor.address);
+            if (resolution == 0) {
+                Logger::warning("Known sensor " + formatAddress(sensor.address) + " not responding");
+                quarantine(i, millis());
+                continue;
+            }
+            SensorTable::setHealth(sensor, SensorHealth::ACTIVE);
+            
+            // A power cycle reverts the device to its EEPROM setting
+            if (meta.resolution != 0 && resolution != meta.resolution) {
+                sensors.setResolution(sensor.address, meta.resolution);
+            }
+            meta.resolution = meta.resolution != 0 ? meta.resolution : resolution;
+            verified++;
+        }
+        xSemaphoreGive(sensorMutex);
+    } else {
+        Logger::error("Failed to acquire mutex in verifyKnownDevices");
+    }
+    
+    setBusBusy(false);
+    Logger::info("Warm start: " + String(verified) + " known sensors verified");
+    return verified;
+}
+
+// RTC memory is refreshed on every call; WarmStartCache decides when NVS is due
+void OneWireManager::saveWarmStart() {
+    if (!verifyMutex()) return;
+    
+    WarmStartRecord records[MAX_ONEWIRE_SENSORS];
+    uint8_t count = 0;
+    
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    for (size_t i = 0; i < table.physicalCount() && count < MAX_ONEWIRE_SENSORS; i++) {
+        const SensorHot& sensor = table.hot(i);
+        
+        WarmStartRecord& record = records[count++];
+        memcpy(record.address, sensor.address, 8);
+        record.raw = sensor.raw;
+        record.resolution = table.cold(i).resolution;
+        record.valid = sensor.raw != SensorTable::NO_READING_RAW ? 1 : 0;
+        record.readTime = sensor.readTime;
+    }
+    xSemaphoreGive(sensorMutex);
+    
+    WarmStartCache::save(records, count, millis());
+}
+
+// Time complete addressed transactions against each physical sensor. The fastest
+// transaction seen in a warm-up round is the reference; anything slower by more
+// than a slot was stretched by preemption or interrupts between bit slots.
+void OneWireManager::runTimingBenchmark(uint16_t rounds) {
+    if (!verifyMutex() || isBusBusy()) {
+        Logger::warning("Cannot run bus benchmark - bus busy");
+        return;
+    }
+    
+    std::vector<TemperatureSensor> list = getSensorList();
+    std::vector<const uint8_t*> targets;
+    targets.reserve(list.size());
+    for (const auto& sensor : list) {
+        if (!VirtualSensorSet::isVirtualAddress(sensor.address) && sensor.health != SensorHealth::QUARANTINED) {
+            targets.push_back(sensor.address);
+        }
+    }
+    if (targets.empty()) {
+        Logger::warning("Bus benchmark skipped - no sensors");
+        return;
+    }
+    
+    rounds = std::min<uint16_t>(std::max<uint16_t>(rounds, 1), BUS_BENCHMARK_MAX_ROUNDS);
+    setBusBusy(true);
+    BusTimingReport report = {};
+    report.startTime = millis();
+    report.rounds = rounds;
+    report.sensors = targets.size();
+    report.core = xPortGetCoreID();
+    report.running = true;
+    report.minUs = UINT32_MAX;
+    storeTimingReport(report);
+    
+    uint32_t reference = UINT32_MAX;
+    float mean = 0.0f;
+    float m2 = 0.0f;
+    
+    // Round 0 only establishes the reference duration
+    for (uint16_t round = 0; round <= rounds; round++) {
+        for (const uint8_t* address : targets) {
+            uint8_t data[9];
+            uint32_t start = micros();
+            bool present = oneWire.reset();
+            oneWire.select(address);
+            oneWire.write(0xBE);  // Read scratchpad
+            oneWire.read_bytes(data, sizeof(data));
+            uint32_t duration = micros() - start;
+            
+            if (round == 0) {
+                reference = std::min(reference, duration);
+                continue;
+            }
+            
+            report.transactions++;
+            if (!present) report.presenceErrors++;
+            if (OneWire::crc8(data, 8) != data[8]) report.crcErrors++;
+            if (duration > reference + SLOT_TIME_US) report.lateTransactions++;
+            report.minUs = std::min(report.minUs, duration);
+            report.maxUs = std::max(report.maxUs, duration);
+            
+            float delta = duration - mean;
+            mean += delta / report.transactions;
+            m2 += delta * (duration - mean);
+        }
+        // Keep the watchdog and lower-priority tasks serviced between rounds
+        esp_task_wdt_reset();
+        vTaskDelay(1);
+    }
+    
+    report.meanUs = mean;
+    report.stddevUs = report.transactions > 1 ? sqrtf(m2 / (report.transactions - 1)) : 0.0f;
+    report.running = false;
+    storeTimingReport(report);
+    setBusBusy(false);
+    
+    Logger::info(makeFixedString<128>("Bus benchmark on core %d: %lu transactions, %lu late, %lu CRC errors, "
+                                      "%.0f us mean", report.core,
+                                      static_cast<unsigned long>(report.transactions),
+                                      static_cast<unsigned long>(report.lateTransactions),
+                                      static_cast<unsigned long>(report.crcErrors),
+                                      report.meanUs).c_str());
+}
+
+BusTimingReport OneWireManager::getTimingReport() const {
+    BusTimingReport report = {};
+    if (verifyMutex() && xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        report = timingReport;
+        xSemaphoreGive(sensorMutex);
+    }
+    return report;
+}
+
+void OneWireManager::storeTimingReport(const BusTimingReport& report) {
+    if (xSemaphoreTake(sensorMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        timingReport = report;
+        xSemaphoreGive(sensorMutex);
+    }
+}
@@ -3,11 +3,24 @@
 #include "Config.h"
 #include "Logger.h"
 #include "esp_task_wdt.h"
+#include "ControlTask.h"
+#include "NetworkTask.h"
+#include "CoapTask.h"
+#include "BeaconTask.h"
+#include "RtosResources.h"
+#include "FixedString.h"
+#include <algorithm>
 
 // Static member initialization
 OneWireManager OneWireTask::manager(ONE_WIRE_BUS);
 QueueHandle_t OneWireTask::commandQueue = nullptr;
 SemaphoreHandle_t OneWireTask::dataMutex = nullptr;
+OneWireTask::CommandSlot OneWireTask::slots[MAX_PENDING_COMMANDS] = {};
+OneWireTask::CommandHandle OneWireTask::nextHandle = 1;
+bool OneWireTask::conversionStarted = false;
+uint32_t OneWireTask::conversionStartTime = 0;
+uint32_t OneWireTask::lastScanTime = 0;
+uint32_t OneWireTask::lastReadTime = 0;
 
 void OneWireTask::init() {
     Logger::info("Initializing OneWire task");
@@ -17,111 +30,520 @@ void OneWireTask::init() {
     ESP_ERROR_CHECK(esp_task_wdt_add(NULL));
     
     // Create command queue and mutex
-    commandQueue = xQueueCreate(10, sizeof(TaskMessage));
-    dataMutex = xSemaphoreCreateMutex();
+    commandQueue = RtosResources::createQueue(QueueId::ONEWIRE_COMMAND);
+    dataMutex = RtosResources::createMutex(MutexId::ONEWIRE_DATA);
     
     if (!commandQueue || !dataMutex) {
         Logger::error("Failed to create OneWire task queues or mutex");
         return;
     }
     
+    // Load calibration, filter, virtual sensor and anomaly settings before the first reading
+    manager.reloadFilterConfig();
+    manager.reloadVirtualSensors();
+    manager.reloadAnomalyConfig();
+    
+    // Known sensors are listed right away; readings follow after verification
+    manager.restoreWarmStart();
+    
     Logger::info("OneWire task initialized successfully");
 }
 
 void OneWireTask::start() {
     Logger::info("Starting OneWire task");
     
-    xTaskCreate(
-        taskFunction,
-        "OneWireTask",
-        ONEWIRE_TASK_STACK_SIZE,
-        nullptr,
-        ONEWIRE_TASK_PRIORITY,
-        nullptr
-    );
+    RtosResources::createTask(TaskId::ONEWIRE, taskFunction);
+}
+
+OneWireTask::CommandHandle OneWireTask::submit(const CommandRequest& request) {
+    if (!commandQueue || !dataMutex) return INVALID_COMMAND;
+    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        Logger::warning("OneWire command rejected - mutex timeout");
+        return INVALID_COMMAND;
+    }
+    
+    uint32_t now = millis();
+    uint32_t deadline = request.deadlineMs ? std::max<uint32_t>(now + request.deadlineMs, 1) : 0;
+    
+    // Merge with an equal command that has not started yet. A running READ_ALL
+    // can also be joined, since its collection has not happened yet.
+    CommandSlot* slot = nullptr;
+    for (auto& candidate : slots) {
+        const CommandResult& existing = candidate.result;
+        bool joinable = existing.state == CommandState::PENDING ||
+                        (existing.state == CommandState::RUNNING && existing.type == CommandType::READ_ALL);
+        if (!joinable || existing.type != request.type) continue;
+        if (request.type == CommandType::READ_ONE && memcmp(existing.address, request.address, 8) != 0) continue;
+        slot = &candidate;
+        break;
+    }
+    
+    CommandHandle handle = INVALID_COMMAND;
+    if (slot) {
+        if (!request.callback || slot->waiterCount < MAX_COMMAND_WAITERS) {
+            slot->priority = std::max(slot->priority, request.priority);
+            if (deadline && (!slot->deadline || static_cast<int32_t>(deadline - slot->deadline) < 0)) {
+                slot->deadline = deadline;
+            }
+            slot->rounds = std::max(slot->rounds, request.rounds);
+            if (slot->result.requests < UINT8_MAX) slot->result.requests++;
+            handle = slot->result.handle;
+        }
+    } else if ((slot = allocateSlot()) != nullptr) {
+        memset(slot, 0, sizeof(*slot));
+        handle = nextHandle++;
+        if (nextHandle == INVALID_COMMAND) nextHandle = 1;
+        
+        slot->result.handle = handle;
+        slot->result.type = request.type;
+        slot->result.state = CommandState::PENDING;
+        slot->result.temperature = NAN;
+        slot->result.requests = 1;
+        slot->result.submitTime = now;
+        if (request.type == CommandType::READ_ONE) {
+            memcpy(slot->result.address, request.address, 8);
+        }
+        slot->priority = request.priority;
+        slot->deadline = deadline;
+        slot->rounds = request.rounds;
+    }
+    
+    if (handle != INVALID_COMMAND && request.callback) {
+        slot->waiters[slot->waiterCount++] = {request.callback, request.context};
+    }
+    xSemaphoreGive(dataMutex);
+    
+    if (handle == INVALID_COMMAND) {
+        Logger::warning("OneWire command rejected - command table full");
+        return INVALID_COMMAND;
+    }
+    
+    // Wake the task; a full queue already guarantees a wake-up
+    xQueueSend(commandQueue, &handle, 0);
+    return handle;
+}
+
+OneWireTask::CommandHandle OneWireTask::requestScan(CommandPriority priority, uint32_t deadlineMs) {
+    CommandRequest request = {};
+    request.type = CommandType::SCAN;
+    request.priority = priority;
+    request.deadlineMs = deadlineMs;
+    return submit(request);
+}
+
+OneWireTask::CommandHandle OneWireTask::requestRead(CommandPriority priority, uint32_t deadlineMs) {
+    CommandRequest request = {};
+    request.type = CommandType::READ_ALL;
+    request.priority = priority;
+    request.deadlineMs = deadlineMs;
+    return submit(request);
+}
+
+OneWireTask::CommandHandle OneWireTask::requestReadSensor(const uint8_t* address,
+                                                          CommandPriority priority, uint32_t deadlineMs) {
+    if (!address) return INVALID_COMMAND;
+    CommandRequest request = {};
+    request.type = CommandType::READ_ONE;
+    request.priority = priority;
+    request.deadlineMs = deadlineMs;
+    memcpy(request.address, address, 8);
+    return submit(request);
+}
+
+OneWireTask::CommandHandle OneWireTask::requestBenchmark(uint16_t rounds) {
+    CommandRequest request = {};
+    request.type = CommandType::BENCHMARK;
+    request.priority = CommandPriority::BACKGROUND;
+    request.rounds = rounds;
+    return submit(request);
+}
+
+bool OneWireTask::getResult(CommandHandle handle, CommandResult& result) {
+    if (!dataMutex || xSemaphoreTake(dataMutex, pdMS_TO_TICKS(100)) != pdTRUE) return false;
+    CommandSlot* slot = findSlot(handle);
+    if (slot) {
+        result = slot->result;
+    }
+    xSemaphoreGive(dataMutex);
+    return slot != nullptr;
+}
+
+bool OneWireTask::waitFor(CommandHandle handle, CommandResult& result, TickType_t timeout) {
+    StaticSemaphore_t buffer;
+    SemaphoreHandle_t done = xSemaphoreCreateBinaryStatic(&buffer);
+    
+    if (addWaiter(handle, signalWaiter, done)) {
+        if (xSemaphoreTake(done, timeout) != pdTRUE && !removeWaiter(handle, signalWaiter, done)) {
+            // Completion already took the waiter; its signal is on the way and
+            // must land before this stack frame goes away
+            xSemaphoreTake(done, portMAX_DELAY);
+        }
+    }
+    vSemaphoreDelete(done);
+    
+    return getResult(handle, result) && isFinal(result.state);
+}
+
+bool OneWireTask::isFinal(CommandState state) {
+    return state == CommandState::DONE || state == CommandState::FAILED || state == CommandState::EXPIRED;
+}
+
+const char* OneWireTask::typeToString(CommandType type) {
+    switch (type) {
+        case CommandType::SCAN:      return "scan";
+        case CommandType::READ_ALL:  return "read";
+        case CommandType::READ_ONE:  return "read_sensor";
+        case CommandType::BENCHMARK: return "benchmark";
+        default:                     return "unknown";
+    }
+}
+
+const char* OneWireTask::stateToString(CommandState state) {
+    switch (state) {
+        case CommandState::PENDING: return "pending";
+        case CommandState::RUNNING: return "running";
+        case CommandState::DONE:    return "done";
+        case CommandState::FAILED:  return "failed";
+        case CommandState::EXPIRED: return "expired";
+        default:                    return "unknown";
+    }
 }
 
 void OneWireTask::taskFunction(void* parameter) {
     Logger::info("OneWire task started");
     TickType_t lastWakeTime = xTaskGetTickCount();
-    uint32_t lastScanTime = 0;
-    uint32_t lastReadTime = 0;
-    bool conversionStarted = false;
+    const TickType_t interval = pdMS_TO_TICKS(TASK_INTERVAL);
+    std::vector<AnomalyEvent> anomalies;
     
-    // Initial scan
-    Logger::info("Performing initial OneWire bus scan");
-    if (manager.scanDevices()) {
-        lastScanTime = millis();
-        Logger::info("Initial scan completed successfully");
+    // Warm start: read the known devices first and run full discovery after the
+    // first collection. Without warm start data the initial scan runs as before.
+    bool discoveryPending = false;
+    if (manager.verifyKnownDevices() > 0) {
+        startConversion();
+        discoveryPending = true;
+    } else {
+        Logger::info("Performing initial OneWire bus scan");
+        if (manager.scanDevices()) {
+            lastScanTime = millis();
+            Logger::info("Initial scan completed successfully");
+        }
     }
     
     // Main task loop
     while (true) {
         esp_task_wdt_reset();
         
-        // Process commands with higher priority
-        TaskMessage msg;
-        while (xQueueReceive(commandQueue, &msg, 0) == pdTRUE) {
-            processCommand(msg);
-        }
+        // Queued handles only wake the task; the slots hold the commands
+        CommandHandle wake;
+        while (xQueueReceive(commandQueue, &wake, 0) == pdTRUE) {}
+        
+        // Commands run before periodic work
+        processCommands();
         
         // Current time for interval checks
         uint32_t currentTime = millis();
         
-        // Periodic scan check
-        if (currentTime - lastScanTime >= SCAN_INTERVAL) {
+        // Periodic scan check; deferred warm start discovery runs as soon as the bus is free
+        if (discoveryPending || currentTime - lastScanTime >= SCAN_INTERVAL) {
             if (!manager.isBusBusy() && !conversionStarted) {
                 Logger::info("Starting periodic scan");
                 if (manager.scanDevices()) {
                     lastScanTime = currentTime;
                 }
+                discoveryPending = false;
             }
         }
         
+        // Re-probe quarantined sensors that are due while the bus is idle
+        if (!conversionStarted) {
+            manager.probeQuarantinedSensors();
+        }
+        
         // Temperature reading state machine
         if (!conversionStarted) {
             if (currentTime - lastReadTime >= READ_INTERVAL) {
                 if (!manager.isBusBusy()) {
-                    manager.startTemperatureConversion();
-                    conversionStarted = true;
-                    Logger::debug("Started temperature conversion");
+                    startConversion();
                 }
             }
-        } else {
-            if (manager.checkAndCollectTemperatures()) {
-                lastReadTime = currentTime;
-                conversionStarted = false;
-                Logger::debug("Temperature collection complete");
+        } else if (currentTime - conversionStartTime >= CONVERSION_TIME_MS) {
+            bool collected = manager.checkAndCollectTemperatures();
+            
+            // Let closed-loop control, CoAP observers and the beacon react to the new readings right away
+            ControlTask::notifyReadingsUpdated();
+            CoapTask::notifyReadingsUpdated();
+            BeaconTask::notifyReadingsUpdated();
+            
+            // Hand anomaly events to the network task's priority queue
+            if (manager.takeAnomalyEvents(anomalies) > 0) {
+                for (const auto& event : anomalies) {
+                    if (!NetworkTask::queueAnomalyEvent(event)) {
+                        Logger::warning("Priority event queue full - anomaly event dropped");
+                    }
+                }
             }
+            
+            // RTC copy on every collection, NVS copy when due
+            manager.saveWarmStart();
+            
+            onCollectionComplete();
+            
+            // Sensors that failed keep their error count and are retried with the
+            // next conversion, so a missing device cannot hold up queued commands
+            lastReadTime = currentTime;
+            conversionStarted = false;
+            Logger::debug(collected ? "Temperature collection complete"
+                                    : "Temperature collection complete with failed sensors");
+        }
+        
+        // Sleep until the next interval, or until a running conversion is due;
+        // a submitted command wakes the task early
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = now - lastWakeTime >= interval ? 0 : interval - (now - lastWakeTime);
+        if (conversionStarted) {
+            uint32_t elapsed = millis() - conversionStartTime;
+            TickType_t conversionLeft = elapsed >= CONVERSION_TIME_MS ? 0 : pdMS_TO_TICKS(CONVERSION_TIME_MS - elapsed);
+            wait = std::min(wait, conversionLeft);
         }
+        xQueuePeek(commandQueue, &wake, wait);
         
-        // Fixed task interval
-        vTaskDelayUntil(&lastWakeTime, pdMS_TO_TICKS(TASK_INTERVAL));
+        now = xTaskGetTickCount();
+        if (now - lastWakeTime >= interval) {
+            // Keep the fixed cadence, but do not try to catch up after an overrun
+            lastWakeTime = now - lastWakeTime >= 2 * interval ? now : lastWakeTime + interval;
+        }
     }
 }
 
-void OneWireTask::processCommand(const TaskMessage& msg) {
-    switch (msg.type) {
-        case MessageType::SENSOR_SCAN_REQUEST:
-            Logger::info("Processing scan request");
-            if (!manager.isBusBusy()) {
-                manager.scanDevices();
-            } else {
-                Logger::warning("Scan request ignored - bus busy");
+// Runs every ready command, highest priority first, then earliest deadline,
+// then submission order. Everything except READ_ALL waits for a running
+// conversion to be collected before it may use the bus.
+void OneWireTask::processCommands() {
+    while (true) {
+        Waiter waiters[MAX_COMMAND_WAITERS];
+        uint8_t waiterCount = 0;
+        CommandResult expired;
+        bool haveExpired = false;
+        CommandSlot selected;
+        bool haveSelected = false;
+        
+        if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            Logger::error("Failed to acquire mutex in processCommands");
+            return;
+        }
+        
+        uint32_t now = millis();
+        CommandSlot* next = nullptr;
+        for (auto& slot : slots) {
+            if (slot.result.state != CommandState::PENDING) continue;
+            
+            if (slot.deadline && static_cast<int32_t>(now - slot.deadline) > 0) {
+                finish(slot, CommandState::EXPIRED, waiters, waiterCount);
+                expired = slot.result;
+                haveExpired = true;
+                break;
             }
-            break;
+            if (conversionStarted && slot.result.type != CommandType::READ_ALL) continue;
             
-        case MessageType::TEMPERATURE_READ_REQUEST:
-            Logger::info("Processing temperature read request");
-            if (!manager.isBusBusy() && !manager.isConversionInProgress()) {
-                manager.startTemperatureConversion();
-            } else {
-                Logger::warning("Read request ignored - operation in progress");
+            if (!next) {
+                next = &slot;
+            } else if (slot.priority != next->priority) {
+                if (slot.priority > next->priority) next = &slot;
+            } else if (slot.deadline != next->deadline) {
+                if (!next->deadline || (slot.deadline && static_cast<int32_t>(slot.deadline - next->deadline) < 0)) {
+                    next = &slot;
+                }
+            } else if (static_cast<int32_t>(slot.result.handle - next->result.handle) < 0) {
+                next = &slot;
             }
+        }
+        
+        if (!haveExpired && next) {
+            next->result.state = CommandState::RUNNING;
+            selected = *next;
+            haveSelected = true;
+        }
+        xSemaphoreGive(dataMutex);
+        
+        if (haveExpired) {
+            Logger::warning(makeFixedString<64>("OneWire %s command %lu expired",
+                                                typeToString(expired.type),
+                                                static_cast<unsigned long>(expired.handle)).c_str());
+            notifyWaiters(expired, waiters, waiterCount);
+            continue;
+        }
+        if (!haveSelected) {
+            return;
+        }
+        execute(selected);
+        esp_task_wdt_reset();
+    }
+}
+
+void OneWireTask::execute(const CommandSlot& slot) {
+    const CommandResult& command = slot.result;
+    if (Logger::isEnabled(Logger::Level::DEBUG)) {
+        Logger::debug(makeFixedString<64>("Running OneWire %s command %lu",
+                                          typeToString(command.type),
+                                          static_cast<unsigned long>(command.handle)).c_str());
+    }
+    
+    switch (command.type) {
+        case CommandType::SCAN: {
+            bool success = manager.scanDevices();
+            if (success) {
+                lastScanTime = millis();
+            }
+            complete(command.handle, success ? CommandState::DONE : CommandState::FAILED,
+                     NAN, manager.getSensorList().size());
             break;
-            
+        }
+        
+        case CommandType::READ_ALL:
+            // Completes from onCollectionComplete(); joins a conversion already under way
+            if (!conversionStarted) {
+                startConversion();
+            }
+            break;
+        
+        case CommandType::READ_ONE: {
+            float temperature = NAN;
+            bool success = manager.readTemperature(command.address, temperature);
+            complete(command.handle, success ? CommandState::DONE : CommandState::FAILED, temperature, success ? 1 : 0);
+            break;
+        }
+        
+        case CommandType::BENCHMARK: {
+            manager.runTimingBenchmark(slot.rounds);
+            BusTimingReport report = manager.getTimingReport();
+            complete(command.handle, report.transactions > 0 ? CommandState::DONE : CommandState::FAILED,
+                     NAN, report.transactions);
+            break;
+        }
+        
         default:
-            Logger::warning("Unknown command received");
+            complete(command.handle, CommandState::FAILED, NAN, 0);
+            break;
+    }
+}
+
+void OneWireTask::startConversion() {
+    manager.startTemperatureConversion();
+    conversionStarted = true;
+    conversionStartTime = millis();
+    Logger::debug("Started temperature conversion");
+}
+
+void OneWireTask::onCollectionComplete() {
+    uint32_t validCount = 0;
+    for (const auto& sensor : manager.getSensorList()) {
+        if (sensor.valid && !VirtualSensorSet::isVirtualAddress(sensor.address)) validCount++;
+    }
+    
+    // At most one READ_ALL runs at a time since new requests join it
+    CommandHandle running = INVALID_COMMAND;
+    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        for (const auto& slot : slots) {
+            if (slot.result.state == CommandState::RUNNING && slot.result.type == CommandType::READ_ALL) {
+                running = slot.result.handle;
+                break;
+            }
+        }
+        xSemaphoreGive(dataMutex);
+    }
+    if (running != INVALID_COMMAND) {
+        complete(running, CommandState::DONE, NAN, validCount);
+    }
+}
+
+void OneWireTask::complete(CommandHandle handle, CommandState state, float temperature, uint32_t count) {
+    Waiter waiters[MAX_COMMAND_WAITERS];
+    uint8_t waiterCount = 0;
+    CommandResult result;
+    
+    if (xSemaphoreTake(dataMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        Logger::error("Failed to acquire mutex in complete");
+        return;
+    }
+    CommandSlot* slot = findSlot(handle);
+    bool finished = slot && slot->result.state == CommandState::RUNNING;
+    if (finished) {
+        slot->result.temperature = temperature;
+        slot->result.count = count;
+        finish(*slot, state, waiters, waiterCount);
+        result = slot->result;
+    }
+    xSemaphoreGive(dataMutex);
+    
+    if (finished) {
+        notifyWaiters(result, waiters, waiterCount);
+    }
+}
+
+// Caller holds dataMutex; waiters are handed out so they run without it
+void OneWireTask::finish(CommandSlot& slot, CommandState state, Waiter* waiters, uint8_t& waiterCount) {
+    slot.result.state = state;
+    slot.result.completeTime = millis();
+    waiterCount = slot.waiterCount;
+    memcpy(waiters, slot.waiters, waiterCount * sizeof(Waiter));
+    slot.waiterCount = 0;
+}
+
+void OneWireTask::notifyWaiters(const CommandResult& result, const Waiter* waiters, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        waiters[i].callback(result, waiters[i].context);
+    }
+}
+
+bool OneWireTask::addWaiter(CommandHandle handle, CommandCallback callback, void* context) {
+    if (!dataMutex || xSemaphoreTake(dataMutex, pdMS_TO_TICKS(100)) != pdTRUE) return false;
+    CommandSlot* slot = findSlot(handle);
+    bool added = slot && !isFinal(slot->result.state) && slot->waiterCount < MAX_COMMAND_WAITERS;
+    if (added) {
+        slot->waiters[slot->waiterCount++] = {callback, context};
+    }
+    xSemaphoreGive(dataMutex);
+    return added;
+}
+
+bool OneWireTask::removeWaiter(CommandHandle handle, CommandCallback callback, void* context) {
+    if (xSemaphoreTake(dataMutex, portMAX_DELAY) != pdTRUE) return false;
+    bool removed = false;
+    CommandSlot* slot = findSlot(handle);
+    for (uint8_t i = 0; slot && i < slot->waiterCount; i++) {
+        if (slot->waiters[i].callback == callback && slot->waiters[i].context == context) {
+            slot->waiters[i] = slot->waiters[--slot->waiterCount];
+            removed = true;
             break;
+        }
+    }
+    xSemaphoreGive(dataMutex);
+    return removed;
+}
+
+// Caller holds dataMutex
+OneWireTask::CommandSlot* OneWireTask::findSlot(CommandHandle handle) {
+    if (handle == INVALID_COMMAND) return nullptr;
+    for (auto& slot : slots) {
+        if (slot.result.handle == handle && slot.result.state != CommandState::UNKNOWN) return &slot;
+    }
+    return nullptr;
+}
+
+// Caller holds dataMutex. Finished results are kept for polling until their
+// slot is needed; the oldest one is reused first.
+OneWireTask::CommandSlot* OneWireTask::allocateSlot() {
+    CommandSlot* oldest = nullptr;
+    for (auto& slot : slots) {
+        if (slot.result.state == CommandState::UNKNOWN) return &slot;
+        if (isFinal(slot.result.state) &&
+            (!oldest || static_cast<int32_t>(slot.result.completeTime - oldest->result.completeTime) < 0)) {
+            oldest = &slot;
+        }
     }
-}
\ No newline at end of file
+    return oldest;
+}
+
+void OneWireTask::signalWaiter(const CommandResult& result, void* context) {
+    xSemaphoreGive(static_cast<SemaphoreHandle_t>(context));
+}
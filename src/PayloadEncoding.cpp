@@ -0,0 +1,251 @@
+// PayloadEncoding.cpp
+#include "PayloadEncoding.h"
+#include "CborWriter.h"
+#include "MsgPackWriter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+namespace {
+    // What the JSON API reports for a sensor without a valid reading (DEVICE_DISCONNECTED_C)
+    constexpr float DISCONNECTED_C = -127.0f;
+
+    const PayloadFormat FORMATS[] = {PayloadFormat::TEXT, PayloadFormat::CBOR, PayloadFormat::MSGPACK};
+
+    struct MediaType {
+        const char* name;
+        PayloadFormat format;
+    };
+
+    const MediaType MEDIA_TYPES[] = {
+        {"application/cbor", PayloadFormat::CBOR},
+        {"application/msgpack", PayloadFormat::MSGPACK},
+        {"application/x-msgpack", PayloadFormat::MSGPACK},
+        {"application/vnd.msgpack", PayloadFormat::MSGPACK},
+        {"application/json", PayloadFormat::TEXT},
+        {"application/*", PayloadFormat::TEXT},
+        {"*/*", PayloadFormat::TEXT},
+    };
+
+    // As OneWireManager::healthToString()
+    const char* healthName(SensorHealth health) {
+        switch (health) {
+            case SensorHealth::ACTIVE:      return "active";
+            case SensorHealth::SUSPECT:     return "suspect";
+            case SensorHealth::QUARANTINED: return "offline";
+        }
+        return "unknown";
+    }
+
+    // Runs write on a writer of the format over out; the item's length, or 0
+    template <typename Write>
+    size_t encodeWith(PayloadFormat format, uint8_t* out, size_t capacity, Write write) {
+        switch (format) {
+            case PayloadFormat::CBOR: {
+                CborWriter writer(out, capacity);
+                write(writer);
+                return writer.overflowed() ? 0 : writer.size();
+            }
+            case PayloadFormat::MSGPACK: {
+                MsgPackWriter writer(out, capacity);
+                write(writer);
+                return writer.overflowed() ? 0 : writer.size();
+            }
+            case PayloadFormat::TEXT:
+                break;
+        }
+        return 0;
+    }
+}
+
+const char* PayloadEncoding::contentType(PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::CBOR:    return "application/cbor";
+        case PayloadFormat::MSGPACK: return "application/msgpack";
+        case PayloadFormat::TEXT:    break;
+    }
+    return "application/json";
+}
+
+const char* PayloadEncoding::formatName(PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::CBOR:    return "cbor";
+        case PayloadFormat::MSGPACK: return "msgpack";
+        case PayloadFormat::TEXT:    break;
+    }
+    return "text";
+}
+
+bool PayloadEncoding::parseFormat(const char* name, PayloadFormat& format) {
+    if (!name) return false;
+    for (PayloadFormat candidate : FORMATS) {
+        if (strcasecmp(name, formatName(candidate)) == 0) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+PayloadFormat PayloadEncoding::fromAccept(const char* accept) {
+    PayloadFormat best = PayloadFormat::TEXT;
+    double bestQuality = 0.0;
+    const char* p = accept ? accept : "";
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        const char* type = p;
+        while (*p && *p != ';' && *p != ',' && *p != ' ') p++;
+        size_t typeLength = p - type;
+
+        // Parameters up to the next range; only q matters
+        double quality = 1.0;
+        while (*p && *p != ',') {
+            if (*p++ != ';') continue;
+            while (*p == ' ') p++;
+            if ((*p == 'q' || *p == 'Q') && p[1] == '=') {
+                quality = strtod(p + 2, nullptr);
+            }
+        }
+        if (quality <= 0.0 || typeLength == 0) continue;
+
+        // Highest q wins; JSON wins ties, otherwise the earlier range does
+        for (const MediaType& media : MEDIA_TYPES) {
+            if (strlen(media.name) == typeLength && strncasecmp(type, media.name, typeLength) == 0) {
+                if (quality > bestQuality ||
+                    (quality == bestQuality && media.format == PayloadFormat::TEXT)) {
+                    best = media.format;
+                    bestQuality = quality;
+                }
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+size_t PayloadEncoding::encodeArrayHead(PayloadFormat format, size_t count, uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        writer.beginArray(count);
+    });
+}
+
+// Members and their order follow WebServer::createSensorJson()
+size_t PayloadEncoding::encodeSensor(PayloadFormat format, const SensorRecord& sensor,
+                                     uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        const uint8_t lastAnomaly = static_cast<uint8_t>(AnomalyType::ZSCORE);
+        size_t anomalies = 0;
+        for (uint8_t bit = 1; bit <= lastAnomaly; bit <<= 1) {
+            if (sensor.anomalyMask & bit) anomalies++;
+        }
+        bool named = sensor.name && sensor.name[0];
+        bool offline = !sensor.isVirtual && sensor.health == SensorHealth::QUARANTINED;
+
+        writer.beginMap(6 + named + offline + (anomalies > 0) + (sensor.displaySensor ? 2 : 0));
+        writer.addText("address");
+        writer.addHex(sensor.address, 8);
+        if (named) {
+            writer.addText("name");
+            writer.addText(sensor.name);
+        }
+        writer.addText("temperature");
+        writer.addFloat(sensor.valid ? sensor.temperature : DISCONNECTED_C);
+        writer.addText("rawTemperature");
+        writer.addFloat(sensor.valid ? sensor.rawTemperature : DISCONNECTED_C);
+        writer.addText("valid");
+        writer.addBool(sensor.valid);
+        writer.addText("lastReadTime");
+        writer.addUnsigned(sensor.lastReadTime);
+        if (sensor.isVirtual) {
+            writer.addText("virtual");
+            writer.addBool(true);
+        } else {
+            writer.addText("health");
+            writer.addText(healthName(sensor.health));
+            if (offline) {
+                writer.addText("offlineSince");
+                writer.addUnsigned(sensor.offlineSince);
+            }
+        }
+        if (anomalies > 0) {
+            writer.addText("anomalies");
+            writer.beginArray(anomalies);
+            for (uint8_t bit = 1; bit <= lastAnomaly; bit <<= 1) {
+                if (sensor.anomalyMask & bit) {
+                    writer.addText(AnomalyDetector::typeToString(static_cast<AnomalyType>(bit)));
+                }
+            }
+        }
+        if (sensor.displaySensor) {
+            writer.addText("isBabelSensor");
+            writer.addBool(true);
+            writer.addText("babelTemperature");
+            writer.addFloat(sensor.temperature);
+        }
+    });
+}
+
+// Members follow WebServer::handleRelayRequest()
+size_t PayloadEncoding::encodeRelay(PayloadFormat format, uint8_t relayId, bool state, const char* name,
+                                    uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        bool named = name && name[0];
+        writer.beginMap(2 + named);
+        writer.addText("relay_id");
+        writer.addUnsigned(relayId);
+        writer.addText("state");
+        writer.addBool(state);
+        if (named) {
+            writer.addText("name");
+            writer.addText(name);
+        }
+    });
+}
+
+// Members follow MqttManager::publishRollup()
+size_t PayloadEncoding::encodeRollup(PayloadFormat format, const RollupWindow& rollup,
+                                     uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        writer.beginMap(8);
+        writer.addText("start");
+        writer.addUnsigned(rollup.startTime);
+        writer.addText("count");
+        writer.addUnsigned(rollup.count);
+        writer.addText("mean");
+        writer.addFloat(rollup.mean);
+        writer.addText("stddev");
+        writer.addFloat(RollupStats::stddev(rollup));
+        writer.addText("min");
+        writer.addFloat(rollup.min);
+        writer.addText("minTime");
+        writer.addUnsigned(rollup.minTime);
+        writer.addText("max");
+        writer.addFloat(rollup.max);
+        writer.addText("maxTime");
+        writer.addUnsigned(rollup.maxTime);
+    });
+}
+
+size_t PayloadEncoding::encodeFloat(PayloadFormat format, float value, uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        writer.addFloat(value);
+    });
+}
+
+size_t PayloadEncoding::encodeUnsigned(PayloadFormat format, uint32_t value, uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        writer.addUnsigned(value);
+    });
+}
+
+size_t PayloadEncoding::encodeBool(PayloadFormat format, bool value, uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        writer.addBool(value);
+    });
+}
+
+size_t PayloadEncoding::encodeText(PayloadFormat format, const char* text, uint8_t* out, size_t capacity) {
+    return encodeWith(format, out, capacity, [&](PayloadWriter& writer) {
+        writer.addText(text);
+    });
+}
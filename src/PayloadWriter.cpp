@@ -0,0 +1,27 @@
+// PayloadWriter.cpp
+#include "PayloadWriter.h"
+#include <string.h>
+
+PayloadWriter::PayloadWriter(uint8_t* buffer, size_t capacity)
+    : buffer(buffer)
+    , capacity(capacity)
+    , length(0)
+    , overflow(false) {
+}
+
+void PayloadWriter::addText(const char* text) {
+    addText(text, strlen(text));
+}
+
+void PayloadWriter::reset() {
+    length = 0;
+    overflow = false;
+}
+
+bool PayloadWriter::reserve(size_t count) {
+    if (overflow || capacity - length < count) {
+        overflow = true;
+        return false;
+    }
+    return true;
+}
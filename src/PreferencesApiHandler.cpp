@@ -1,11 +1,17 @@
 // PreferencesApiHandler.cpp
 #include "PreferencesApiHandler.h"
 #include <Arduino.h>
+#include "ControlTask.h"
+#include "RtosResources.h"
+#include "ModbusTask.h"
+#include "BacnetTask.h"
+#include "CoapTask.h"
+#include "BeaconTask.h"
 
 String PreferencesApiHandler::handleGet() {
     Logger::debug("Building preferences JSON response");
     
-    DynamicJsonDocument doc(1024);
+    DynamicJsonDocument doc(4096);
     JsonObject root = doc.to<JsonObject>();
     
     // Add MQTT settings
@@ -42,6 +48,42 @@ String PreferencesApiHandler::handleGet() {
         }
     }
     
+    // Add signal processing configuration
+    addFilterConfigToJson(root);
+    
+    // Add closed-loop control configuration
+    addControlConfigToJson(root);
+    
+    // Add virtual sensor definitions
+    addVirtualSensorsToJson(root);
+    
+    // Add anomaly detection thresholds
+    addAnomalyConfigToJson(root);
+    
+    // Add task core placement
+    addTaskAffinityToJson(root);
+    
+    // Add Modbus TCP server settings
+    addModbusConfigToJson(root);
+    
+    // Add BACnet/IP device settings
+    addBacnetConfigToJson(root);
+    
+    // Add CoAP endpoint settings
+    addCoapConfigToJson(root);
+    
+    // Add multicast beacon settings
+    addBeaconConfigToJson(root);
+    
+    // Add MQTT payload formats
+    addMqttFormatConfigToJson(root);
+    
+    // Add Sparkplug B mode
+    addSparkplugConfigToJson(root);
+    
+    // Add MQTT client backend
+    addMqttTransportConfigToJson(root);
+    
     String output;
     serializeJson(doc, output);
     Logger::debug("Generated preferences JSON: " + output);
@@ -95,6 +137,17 @@ void PreferencesApiHandler::addDisplayConfigToJson(JsonObject& root) {
     // Add display settings
     display["brightnessLevel"] = 7;  // Default brightness
     display["displayTimeout"] = 30;   // Default timeout in seconds
+    
+    // Add rotation playlist
+    DisplayPlaylistEntry entries[MAX_PLAYLIST_ENTRIES];
+    uint8_t count = PreferencesManager::getDisplayPlaylist(entries, MAX_PLAYLIST_ENTRIES);
+    JsonArray playlist = display.createNestedArray("playlist");
+    for (uint8_t i = 0; i < count; i++) {
+        JsonObject entry = playlist.createNestedObject();
+        entry["sensor"] = PreferencesManager::addressToString(entries[i].address);
+        entry["label"] = entries[i].label;
+        entry["dwell"] = entries[i].dwellSeconds;
+    }
 }
 
 void PreferencesApiHandler::addSensorNamesToJson(JsonObject& root) {
@@ -167,6 +220,7 @@ bool PreferencesApiHandler::handlePost(const String& jsonData) {
         JsonObject display = doc["display"];
         if (validateDisplayConfig(display)) {
             success &= updateDisplayConfig(display);
+            ControlTask::reloadDisplayConfig();
         } else {
             success = false;
         }
@@ -177,6 +231,134 @@ bool PreferencesApiHandler::handlePost(const String& jsonData) {
         success &= updateSensorNames(sensors);
     }
     
+    bool filterChanged = false;
+    if (doc.containsKey("filter")) {
+        JsonObject filter = doc["filter"];
+        if (validateFilterConfig(filter)) {
+            success &= updateFilterConfig(filter);
+            filterChanged = true;
+        } else {
+            success = false;
+        }
+    }
+    
+    if (doc.containsKey("calibration")) {
+        success &= updateSensorCalibration(doc["calibration"]);
+        filterChanged = true;
+    }
+    
+    // Apply new processing settings to the running OneWire task
+    if (filterChanged) {
+        oneWireManager.reloadFilterConfig();
+    }
+    
+    if (doc.containsKey("control")) {
+        if (validateControlConfig(doc["control"])) {
+            success &= updateControlConfig(doc["control"]);
+            ControlTask::reloadControlConfig();
+        } else {
+            success = false;
+        }
+    }
+    
+    if (doc.containsKey("virtualSensors")) {
+        if (validateVirtualSensors(doc["virtualSensors"])) {
+            success &= updateVirtualSensors(doc["virtualSensors"]);
+            oneWireManager.reloadVirtualSensors();
+        } else {
+            success = false;
+        }
+    }
+    
+    if (doc.containsKey("anomaly")) {
+        JsonObject anomaly = doc["anomaly"];
+        if (validateAnomalyConfig(anomaly)) {
+            success &= updateAnomalyConfig(anomaly);
+            oneWireManager.reloadAnomalyConfig();
+        } else {
+            success = false;
+        }
+    }
+    
+    // Core placement is applied when the tasks are next created, i.e. after a restart
+    if (doc.containsKey("tasks")) {
+        if (validateTaskAffinity(doc["tasks"])) {
+            success &= updateTaskAffinity(doc["tasks"]);
+        } else {
+            success = false;
+        }
+    }
+    
+    // The Modbus server reads its settings once at boot
+    if (doc.containsKey("modbus")) {
+        JsonObject modbus = doc["modbus"];
+        if (validateModbusConfig(modbus)) {
+            success &= updateModbusConfig(modbus);
+        } else {
+            success = false;
+        }
+    }
+    
+    // So does the BACnet device
+    if (doc.containsKey("bacnet")) {
+        JsonObject bacnet = doc["bacnet"];
+        if (validateBacnetConfig(bacnet)) {
+            success &= updateBacnetConfig(bacnet);
+        } else {
+            success = false;
+        }
+    }
+    
+    // And the CoAP endpoint
+    if (doc.containsKey("coap")) {
+        JsonObject coap = doc["coap"];
+        if (validateCoapConfig(coap)) {
+            success &= updateCoapConfig(coap);
+        } else {
+            success = false;
+        }
+    }
+    
+    // And the telemetry beacon
+    if (doc.containsKey("beacon")) {
+        JsonObject beacon = doc["beacon"];
+        if (validateBeaconConfig(beacon)) {
+            success &= updateBeaconConfig(beacon);
+        } else {
+            success = false;
+        }
+    }
+    
+    // And the MQTT payload formats
+    if (doc.containsKey("mqttFormat")) {
+        JsonObject formats = doc["mqttFormat"];
+        if (validateMqttFormatConfig(formats)) {
+            success &= updateMqttFormatConfig(formats);
+        } else {
+            success = false;
+        }
+    }
+    
+    // And Sparkplug B mode
+    if (doc.containsKey("sparkplug")) {
+        JsonObject sparkplug = doc["sparkplug"];
+        if (validateSparkplugConfig(sparkplug)) {
+            success &= updateSparkplugConfig(sparkplug);
+        } else {
+            success = false;
+        }
+    }
+    
+    // And the MQTT client backend
+    if (doc.containsKey("mqttTransport")) {
+        JsonObject transport = doc["mqttTransport"];
+        if (validateMqttTransportConfig(transport)) {
+            success &= updateMqttTransportConfig(transport);
+        } else {
+            success = false;
+        }
+    }
+    
     return success;
 }
 
@@ -257,6 +439,26 @@ bool PreferencesApiHandler::validateDisplayConfig(JsonObject& display) {
         }
     }
     
+    if (display.containsKey("playlist")) {
+        JsonArray playlist = display["playlist"].as<JsonArray>();
+        if (playlist.isNull() || playlist.size() > MAX_PLAYLIST_ENTRIES) {
+            Logger::error("Invalid display playlist (array of up to " + 
+                         String(MAX_PLAYLIST_ENTRIES) + " entries)");
+            return false;
+        }
+        for (JsonObject entry : playlist) {
+            const char* sensor = entry["sensor"] | "";
+            const char* label = entry["label"] | "";
+            int dwell = entry["dwell"] | 5;
+            if (strlen(sensor) != 16 || strlen(label) > PLAYLIST_LABEL_LENGTH || 
+                strchr(label, ':') || strchr(label, ';') || dwell < 1 || dwell > 3600) {
+                Logger::error("Invalid playlist entry (16 character sensor, label up to " + 
+                             String(PLAYLIST_LABEL_LENGTH) + " characters, dwell 1-3600 s)");
+                isValid = false;
+            }
+        }
+    }
+    
     return isValid;
 }
 
@@ -268,7 +470,7 @@ bool PreferencesApiHandler::updateSensorNames(JsonVariant sensors) {
         Logger::error("Invalid sensors data - expected array");
         return false;
     }
-
+    
     // Get the array and process it
     JsonArray sensorArray = sensors.as<JsonArray>();
     Logger::info("Processing " + String(sensorArray.size()) + " sensor names");
@@ -349,30 +551,893 @@ bool PreferencesApiHandler::updateDisplayConfig(JsonObject& display) {
         Logger::debug("Display sensor update " + String(success ? "succeeded" : "failed"));
     }
     
+    if (display.containsKey("playlist")) {
+        DisplayPlaylistEntry entries[MAX_PLAYLIST_ENTRIES] = {};
+        uint8_t count = 0;
+        for (JsonObject entry : display["playlist"].as<JsonArray>()) {
+            PreferencesManager::stringToAddress(entry["sensor"].as<String>(), entries[count].address);
+            strlcpy(entries[count].label, entry["label"] | "", sizeof(entries[count].label));
+            entries[count].dwellSeconds = entry["dwell"] | 5;
+            count++;
+        }
+        success &= PreferencesManager::setDisplayPlaylist(entries, count);
+    }
+    
+    return success;
+}
+
+void PreferencesApiHandler::addFilterConfigToJson(JsonObject& root) {
+    FilterConfig config;
+    PreferencesManager::getFilterConfig(config);
+    
+    JsonObject filter = root.createNestedObject("filter");
+    filter["median"] = config.medianEnabled;
+    switch (config.smoothing) {
+        case SmoothingMode::EMA:    filter["smoothing"] = "ema"; break;
+        case SmoothingMode::KALMAN: filter["smoothing"] = "kalman"; break;
+        default:                    filter["smoothing"] = "none"; break;
+    }
+    filter["emaAlpha"] = config.emaAlpha / 256.0f;
+    
+    // Variances are stored in raw units squared, report them in °C²
+    const float rawSquared = SensorFilter::RAW_PER_DEGREE * SensorFilter::RAW_PER_DEGREE;
+    filter["kalmanQ"] = config.kalmanQ / rawSquared;
+    filter["kalmanR"] = config.kalmanR / rawSquared;
+    filter["maxRate"] = SensorFilter::toCelsius(config.maxRatePerSec);
+    
+    JsonArray calibration = root.createNestedArray("calibration");
+    const auto& sensorList = oneWireManager.getSensorList();
+    for (const auto& sensor : sensorList) {
+        if (sensor.calibration.offset == 0 && 
+            sensor.calibration.gain == SensorFilter::GAIN_ONE) {
+            continue;  // Only report sensors with a non-default calibration
+        }
+        JsonObject entry = calibration.createNestedObject();
+        entry["address"] = PreferencesManager::addressToString(sensor.address);
+        entry["offset"] = SensorFilter::toCelsius(sensor.calibration.offset);
+        entry["gain"] = sensor.calibration.gain / static_cast<float>(SensorFilter::GAIN_ONE);
+    }
+}
+
+bool PreferencesApiHandler::validateFilterConfig(JsonObject& filter) {
+    bool isValid = true;
+    
+    if (filter.containsKey("smoothing")) {
+        const char* mode = filter["smoothing"] | "";
+        if (strcmp(mode, "none") != 0 && strcmp(mode, "ema") != 0 && 
+            strcmp(mode, "kalman") != 0) {
+            Logger::error("Invalid smoothing mode (must be none, ema or kalman)");
+            isValid = false;
+        }
+    }
+    
+    if (filter.containsKey("emaAlpha")) {
+        float alpha = filter["emaAlpha"] | -1.0f;
+        if (alpha <= 0.0f || alpha > 1.0f) {
+            Logger::error("Invalid EMA alpha (must be > 0 and <= 1)");
+            isValid = false;
+        }
+    }
+    
+    if (filter.containsKey("kalmanQ") || filter.containsKey("kalmanR")) {
+        float q = filter["kalmanQ"] | 0.0f;
+        float r = filter["kalmanR"] | 0.0f;
+        if (q < 0.0f || r < 0.0f || q > 100.0f || r > 100.0f) {
+            Logger::error("Invalid Kalman variances (must be 0-100)");
+            isValid = false;
+        }
+    }
+    
+    if (filter.containsKey("maxRate")) {
+        float rate = filter["maxRate"] | -1.0f;
+        if (rate < 0.0f || rate > 100.0f) {
+            Logger::error("Invalid max rate (must be 0-100 °C/s)");
+            isValid = false;
+        }
+    }
+    
+    return isValid;
+}
+
+bool PreferencesApiHandler::updateFilterConfig(JsonObject& filter) {
+    FilterConfig config;
+    PreferencesManager::getFilterConfig(config);
+    
+    if (filter.containsKey("median")) {
+        config.medianEnabled = filter["median"];
+    }
+    
+    if (filter.containsKey("smoothing")) {
+        const char* mode = filter["smoothing"];
+        if (strcmp(mode, "ema") == 0) {
+            config.smoothing = SmoothingMode::EMA;
+        } else if (strcmp(mode, "kalman") == 0) {
+            config.smoothing = SmoothingMode::KALMAN;
+        } else {
+            config.smoothing = SmoothingMode::NONE;
+        }
+    }
+    
+    if (filter.containsKey("emaAlpha")) {
+        float alpha = filter["emaAlpha"];
+        config.emaAlpha = constrain(static_cast<int>(alpha * 256.0f + 0.5f), 1, 256);
+    }
+    
+    const float rawSquared = SensorFilter::RAW_PER_DEGREE * SensorFilter::RAW_PER_DEGREE;
+    if (filter.containsKey("kalmanQ")) {
+        config.kalmanQ = static_cast<uint32_t>(filter["kalmanQ"].as<float>() * rawSquared + 0.5f);
+    }
+    if (filter.containsKey("kalmanR")) {
+        config.kalmanR = static_cast<uint32_t>(filter["kalmanR"].as<float>() * rawSquared + 0.5f);
+    }
+    
+    if (filter.containsKey("maxRate")) {
+        config.maxRatePerSec = SensorFilter::fromCelsius(filter["maxRate"].as<float>());
+    }
+    
+    return PreferencesManager::setFilterConfig(config);
+}
+
+bool PreferencesApiHandler::updateSensorCalibration(JsonVariant calibration) {
+    if (!calibration.is<JsonArray>()) {
+        Logger::error("Invalid calibration data - expected array");
+        return false;
+    }
+    
+    bool success = true;
+    for (JsonObject entry : calibration.as<JsonArray>()) {
+        const char* address = entry["address"] | "";
+        if (strlen(address) != 16) {
+            Logger::error("Invalid calibration address: " + String(address));
+            success = false;
+            continue;
+        }
+        
+        float offset = entry["offset"] | 0.0f;
+        float gain = entry["gain"] | 1.0f;
+        if (offset < -10.0f || offset > 10.0f || gain < 0.5f || gain > 2.0f) {
+            Logger::error("Calibration out of range for sensor: " + String(address));
+            success = false;
+            continue;
+        }
+        
+        uint8_t addr[8];
+        PreferencesManager::stringToAddress(address, addr);
+        
+        SensorCalibration cal;
+        cal.offset = SensorFilter::fromCelsius(offset);
+        cal.gain = static_cast<uint32_t>(gain * SensorFilter::GAIN_ONE + 0.5f);
+        
+        if (!PreferencesManager::setSensorCalibration(addr, cal)) {
+            Logger::error("Failed to save calibration for sensor: " + String(address));
+            success = false;
+        }
+    }
+    
+    return success;
+}
+
+void PreferencesApiHandler::addControlLoopToJson(JsonObject& obj, const ControlLoopConfig& config) {
+    switch (config.mode) {
+        case ControlMode::HYSTERESIS: obj["mode"] = "hysteresis"; break;
+        case ControlMode::PID:        obj["mode"] = "pid"; break;
+        default:                      obj["mode"] = "off"; break;
+    }
+    obj["sensor"] = PreferencesManager::addressToString(config.sensorAddress);
+    obj["setpoint"] = config.setpoint;
+    obj["hysteresis"] = config.hysteresis;
+    obj["cooling"] = config.cooling;
+    obj["kp"] = config.kp;
+    obj["ki"] = config.ki;
+    obj["kd"] = config.kd;
+    obj["pidWindow"] = config.pidWindowMs / 1000;
+    obj["minOn"] = config.minOnMs / 1000;
+    obj["minOff"] = config.minOffMs / 1000;
+}
+
+void PreferencesApiHandler::addControlConfigToJson(JsonObject& root) {
+    JsonArray control = root.createNestedArray("control");
+    
+    for (uint8_t i = 0; i < 2; i++) {
+        ControlLoopConfig config;
+        PreferencesManager::getControlLoop(i, config);
+        
+        JsonObject loop = control.createNestedObject();
+        loop["loop"] = i;
+        addControlLoopToJson(loop, config);
+    }
+}
+
+bool PreferencesApiHandler::validateControlConfig(JsonVariant control) {
+    if (!control.is<JsonArray>()) {
+        Logger::error("Invalid control data - expected array");
+        return false;
+    }
+    
+    for (JsonObject loop : control.as<JsonArray>()) {
+        int loopId = loop["loop"] | -1;
+        if (loopId < 0 || loopId > 1) {
+            Logger::error("Invalid control loop id (must be 0 or 1)");
+            return false;
+        }
+        
+        const char* mode = loop["mode"] | "off";
+        if (strcmp(mode, "off") != 0 && strcmp(mode, "hysteresis") != 0 && 
+            strcmp(mode, "pid") != 0) {
+            Logger::error("Invalid control mode (must be off, hysteresis or pid)");
+            return false;
+        }
+        
+        if (strcmp(mode, "off") != 0) {
+            const char* sensor = loop["sensor"] | "";
+            if (strlen(sensor) != 16) {
+                Logger::error("Control loop requires a 16 character sensor address");
+                return false;
+            }
+        }
+        
+        float setpoint = loop["setpoint"] | 20.0f;
+        float hysteresis = loop["hysteresis"] | 0.5f;
+        if (setpoint < -55.0f || setpoint > 125.0f || hysteresis < 0.0f || hysteresis > 20.0f) {
+            Logger::error("Control loop setpoint or hysteresis out of range");
+            return false;
+        }
+        
+        int window = loop["pidWindow"] | 60;
+        int minOn = loop["minOn"] | 0;
+        int minOff = loop["minOff"] | 0;
+        if (window < 1 || window > 3600 || minOn < 0 || minOn > 3600 || 
+            minOff < 0 || minOff > 3600) {
+            Logger::error("Control loop timing out of range (0-3600 seconds)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateControlConfig(JsonVariant control) {
+    bool success = true;
+    
+    for (JsonObject loop : control.as<JsonArray>()) {
+        uint8_t loopId = loop["loop"];
+        
+        // Start from the stored loop so partial updates keep other fields
+        ControlLoopConfig config;
+        PreferencesManager::getControlLoop(loopId, config);
+        
+        if (loop.containsKey("mode")) {
+            const char* mode = loop["mode"];
+            if (strcmp(mode, "hysteresis") == 0) {
+                config.mode = ControlMode::HYSTERESIS;
+            } else if (strcmp(mode, "pid") == 0) {
+                config.mode = ControlMode::PID;
+            } else {
+                config.mode = ControlMode::OFF;
+            }
+        }
+        if (loop.containsKey("sensor")) {
+            PreferencesManager::stringToAddress(loop["sensor"].as<String>(), config.sensorAddress);
+        }
+        if (loop.containsKey("setpoint")) config.setpoint = loop["setpoint"];
+        if (loop.containsKey("hysteresis")) config.hysteresis = loop["hysteresis"];
+        if (loop.containsKey("cooling")) config.cooling = loop["cooling"];
+        if (loop.containsKey("kp")) config.kp = loop["kp"];
+        if (loop.containsKey("ki")) config.ki = loop["ki"];
+        if (loop.containsKey("kd")) config.kd = loop["kd"];
+        if (loop.containsKey("pidWindow")) config.pidWindowMs = loop["pidWindow"].as<uint32_t>() * 1000;
+        if (loop.containsKey("minOn")) config.minOnMs = loop["minOn"].as<uint32_t>() * 1000;
+        if (loop.containsKey("minOff")) config.minOffMs = loop["minOff"].as<uint32_t>() * 1000;
+        
+        success &= PreferencesManager::setControlLoop(loopId, config);
+    }
+    
+    return success;
+}
+
+void PreferencesApiHandler::addVirtualSensorsToJson(JsonObject& root) {
+    JsonArray list = root.createNestedArray("virtualSensors");
+    
+    for (uint8_t i = 0; i < MAX_VIRTUAL_SENSORS; i++) {
+        VirtualSensorDefinition definition;
+        if (!PreferencesManager::getVirtualSensor(i, definition)) continue;
+        
+        uint8_t address[8];
+        VirtualSensorSet::makeAddress(i, address);
+        
+        JsonObject entry = list.createNestedObject();
+        entry["index"] = i;
+        entry["address"] = PreferencesManager::addressToString(address);
+        entry["enabled"] = definition.enabled;
+        entry["type"] = VirtualSensorSet::typeToString(definition.type);
+        
+        JsonArray inputs = entry.createNestedArray("inputs");
+        for (uint8_t j = 0; j < definition.inputCount; j++) {
+            JsonObject input = inputs.createNestedObject();
+            input["address"] = PreferencesManager::addressToString(definition.inputs[j]);
+            input["weight"] = definition.weights[j];
+        }
+    }
+}
+
+bool PreferencesApiHandler::validateVirtualSensors(JsonVariant virtualSensors) {
+    if (!virtualSensors.is<JsonArray>()) {
+        Logger::error("Invalid virtual sensor data - expected array");
+        return false;
+    }
+    
+    for (JsonObject entry : virtualSensors.as<JsonArray>()) {
+        int index = entry["index"] | -1;
+        if (index < 0 || index >= static_cast<int>(MAX_VIRTUAL_SENSORS)) {
+            Logger::error("Invalid virtual sensor index (must be 0-" + 
+                         String(MAX_VIRTUAL_SENSORS - 1) + ")");
+            return false;
+        }
+        
+        VirtualSensorType type;
+        if (!VirtualSensorSet::typeFromString(entry["type"] | "", type)) {
+            Logger::error("Invalid virtual sensor type (must be mean, min, max, difference or weightedSum)");
+            return false;
+        }
+        
+        JsonArray inputs = entry["inputs"].as<JsonArray>();
+        if (inputs.isNull() || inputs.size() == 0 || inputs.size() > MAX_VIRTUAL_INPUTS) {
+            Logger::error("Virtual sensor requires 1-" + String(MAX_VIRTUAL_INPUTS) + " inputs");
+            return false;
+        }
+        if (type == VirtualSensorType::DIFFERENCE && inputs.size() != 2) {
+            Logger::error("Difference virtual sensor requires exactly 2 inputs");
+            return false;
+        }
+        
+        for (JsonVariant input : inputs) {
+            const char* address = input.is<const char*>() ? input.as<const char*>() : (input["address"] | "");
+            if (strlen(address) != 16) {
+                Logger::error("Virtual sensor input requires a 16 character sensor address");
+                return false;
+            }
+            uint8_t rom[8];
+            PreferencesManager::stringToAddress(String(address), rom);
+            if (VirtualSensorSet::isVirtualAddress(rom)) {
+                Logger::error("Virtual sensors cannot use other virtual sensors as input");
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateVirtualSensors(JsonVariant virtualSensors) {
+    bool success = true;
+    
+    for (JsonObject entry : virtualSensors.as<JsonArray>()) {
+        VirtualSensorDefinition definition = {};
+        definition.enabled = entry["enabled"] | true;
+        VirtualSensorSet::typeFromString(entry["type"].as<const char*>(), definition.type);
+        
+        // Inputs are either plain addresses or {"address": ..., "weight": ...}
+        for (JsonVariant input : entry["inputs"].as<JsonArray>()) {
+            const char* address = input.is<const char*>() ? input.as<const char*>() : input["address"].as<const char*>();
+            PreferencesManager::stringToAddress(String(address), definition.inputs[definition.inputCount]);
+            definition.weights[definition.inputCount] = input.is<JsonObject>() ? (input["weight"] | 1.0f) : 1.0f;
+            definition.inputCount++;
+        }
+        
+        success &= PreferencesManager::setVirtualSensor(entry["index"], definition);
+    }
+    
+    return success;
+}
+
+void PreferencesApiHandler::addAnomalyConfigToJson(JsonObject& root) {
+    AnomalyConfig config;
+    PreferencesManager::getAnomalyConfig(config);
+    
+    JsonObject anomaly = root.createNestedObject("anomaly");
+    anomaly["maxRate"] = config.maxRatePerMin;
+    anomaly["flatlineCycles"] = config.flatlineCycles;
+    anomaly["zScore"] = config.zScoreThreshold;
+    anomaly["zScoreWindow"] = config.zScoreWindow;
+}
+
+bool PreferencesApiHandler::validateAnomalyConfig(JsonObject& anomaly) {
+    float rate = anomaly["maxRate"] | 0.0f;
+    if (rate < 0.0f || rate > 100.0f) {
+        Logger::error("Invalid anomaly rate threshold (0-100 °C/min)");
+        return false;
+    }
+    
+    int cycles = anomaly["flatlineCycles"] | 0;
+    if (cycles < 0 || cycles > 10000) {
+        Logger::error("Invalid flatline cycle count (0-10000)");
+        return false;
+    }
+    
+    float z = anomaly["zScore"] | 0.0f;
+    int window = anomaly["zScoreWindow"] | 60;
+    if (z < 0.0f || z > 50.0f || window < 2 || window > 10000) {
+        Logger::error("Invalid z-score settings (threshold 0-50, window 2-10000)");
+        return false;
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateAnomalyConfig(JsonObject& anomaly) {
+    AnomalyConfig config;
+    PreferencesManager::getAnomalyConfig(config);
+    
+    if (anomaly.containsKey("maxRate")) config.maxRatePerMin = anomaly["maxRate"];
+    if (anomaly.containsKey("flatlineCycles")) config.flatlineCycles = anomaly["flatlineCycles"];
+    if (anomaly.containsKey("zScore")) config.zScoreThreshold = anomaly["zScore"];
+    if (anomaly.containsKey("zScoreWindow")) config.zScoreWindow = anomaly["zScoreWindow"];
+    
+    return PreferencesManager::setAnomalyConfig(config);
+}
+
+void PreferencesApiHandler::addTaskAffinityToJson(JsonObject& root) {
+    JsonArray tasks = root.createNestedArray("tasks");
+    for (size_t i = 0; i < TASK_COUNT; i++) {
+        TaskId id = static_cast<TaskId>(i);
+        int8_t core = RtosResources::getConfiguredCore(id);
+        int8_t pinned = RtosResources::getPinnedCore(id);
+        
+        JsonObject task = tasks.createNestedObject();
+        task["name"] = TASK_TABLE[i].name;
+        if (core == TASK_CORE_ANY) task["core"] = "any";
+        else task["core"] = core;
+        if (pinned == TASK_CORE_ANY) task["pinned"] = "any";
+        else task["pinned"] = pinned;
+    }
+}
+
+bool PreferencesApiHandler::validateTaskAffinity(JsonVariant tasks) {
+    if (!tasks.is<JsonArray>()) {
+        Logger::error("Task affinity must be an array");
+        return false;
+    }
+    
+    for (JsonObject task : tasks.as<JsonArray>()) {
+        bool found = false;
+        RtosResources::taskIdFromName(task["name"] | "", found);
+        if (!found) {
+            Logger::error("Unknown task in affinity map");
+            return false;
+        }
+        
+        JsonVariant core = task["core"];
+        if (core.is<int>()) {
+            int value = core.as<int>();
+            if (value < 0 || value >= portNUM_PROCESSORS) {
+                Logger::error("Invalid task core (0-" + String(portNUM_PROCESSORS - 1) + ")");
+                return false;
+            }
+        } else if (!core.is<const char*>() ||
+                   (strcmp(core.as<const char*>(), "any") != 0 && strcmp(core.as<const char*>(), "default") != 0)) {
+            Logger::error("Task core must be a core number, \"any\" or \"default\"");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateTaskAffinity(JsonVariant tasks) {
+    bool success = true;
+    
+    for (JsonObject task : tasks.as<JsonArray>()) {
+        bool found = false;
+        TaskId id = RtosResources::taskIdFromName(task["name"] | "", found);
+        uint8_t index = static_cast<uint8_t>(id);
+        
+        JsonVariant core = task["core"];
+        if (core.is<int>()) {
+            success &= PreferencesManager::setTaskCore(index, core.as<int>());
+        } else if (strcmp(core.as<const char*>(), "any") == 0) {
+            success &= PreferencesManager::setTaskCore(index, TASK_CORE_ANY);
+        } else {
+            success &= PreferencesManager::clearTaskCore(index);
+        }
+    }
+    
+    if (success) {
+        Logger::info("Task affinity updated; takes effect after restart");
+    }
     return success;
 }
 
+void PreferencesApiHandler::addModbusConfigToJson(JsonObject& root) {
+    ModbusConfig config;
+    PreferencesManager::getModbusConfig(config);
+    
+    JsonObject modbus = root.createNestedObject("modbus");
+    modbus["enabled"] = config.enabled;
+    modbus["port"] = config.port;
+    modbus["allowWrites"] = config.allowWrites;
+    modbus["running"] = ModbusTask::isRunning();
+    modbus["clients"] = ModbusTask::getClientCount();
+}
+
+bool PreferencesApiHandler::validateModbusConfig(JsonObject& modbus) {
+    if (modbus.isNull()) {
+        Logger::error("Modbus settings must be an object");
+        return false;
+    }
+    
+    if (modbus.containsKey("port")) {
+        long port = modbus["port"] | 0L;
+        if (port < 1 || port > 65535) {
+            Logger::error("Invalid Modbus port (1-65535)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateModbusConfig(JsonObject& modbus) {
+    ModbusConfig config;
+    PreferencesManager::getModbusConfig(config);
+    
+    if (modbus.containsKey("enabled")) config.enabled = modbus["enabled"];
+    if (modbus.containsKey("port")) config.port = modbus["port"];
+    if (modbus.containsKey("allowWrites")) config.allowWrites = modbus["allowWrites"];
+    
+    if (!PreferencesManager::setModbusConfig(config)) {
+        return false;
+    }
+    Logger::info("Modbus settings updated; takes effect after restart");
+    return true;
+}
+
+void PreferencesApiHandler::addBacnetConfigToJson(JsonObject& root) {
+    BacnetConfig config;
+    PreferencesManager::getBacnetConfig(config);
+    
+    JsonObject bacnet = root.createNestedObject("bacnet");
+    bacnet["enabled"] = config.enabled;
+    bacnet["port"] = config.port;
+    bacnet["deviceInstance"] = config.deviceInstance;
+    bacnet["covIncrement"] = config.covIncrement;
+    bacnet["running"] = BacnetTask::isRunning();
+    bacnet["activeInstance"] = BacnetTask::getDeviceInstance();
+    bacnet["subscriptions"] = BacnetTask::getSubscriptionCount();
+}
+
+bool PreferencesApiHandler::validateBacnetConfig(JsonObject& bacnet) {
+    if (bacnet.isNull()) {
+        Logger::error("BACnet settings must be an object");
+        return false;
+    }
+    
+    if (bacnet.containsKey("port")) {
+        long port = bacnet["port"] | 0L;
+        if (port < 1 || port > 65535) {
+            Logger::error("Invalid BACnet port (1-65535)");
+            return false;
+        }
+    }
+    
+    // 0 derives the instance from the MAC address; 4194303 is the wildcard
+    if (bacnet.containsKey("deviceInstance")) {
+        long instance = bacnet["deviceInstance"] | -1L;
+        if (instance < 0 || instance >= static_cast<long>(BacnetDevice::WILDCARD_INSTANCE)) {
+            Logger::error("Invalid BACnet device instance (0-4194302)");
+            return false;
+        }
+    }
+    
+    if (bacnet.containsKey("covIncrement")) {
+        float increment = bacnet["covIncrement"] | -1.0f;
+        if (increment <= 0.0f || increment > 10.0f) {
+            Logger::error("Invalid BACnet COV increment (above 0, at most 10 °C)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateBacnetConfig(JsonObject& bacnet) {
+    BacnetConfig config;
+    PreferencesManager::getBacnetConfig(config);
+    
+    if (bacnet.containsKey("enabled")) config.enabled = bacnet["enabled"];
+    if (bacnet.containsKey("port")) config.port = bacnet["port"];
+    if (bacnet.containsKey("deviceInstance")) config.deviceInstance = bacnet["deviceInstance"];
+    if (bacnet.containsKey("covIncrement")) config.covIncrement = bacnet["covIncrement"];
+    
+    if (!PreferencesManager::setBacnetConfig(config)) {
+        return false;
+    }
+    Logger::info("BACnet settings updated; takes effect after restart");
+    return true;
+}
+
+void PreferencesApiHandler::addCoapConfigToJson(JsonObject& root) {
+    CoapConfig config;
+    PreferencesManager::getCoapConfig(config);
+    
+    JsonObject coap = root.createNestedObject("coap");
+    coap["enabled"] = config.enabled;
+    coap["port"] = config.port;
+    coap["running"] = CoapTask::isRunning();
+    coap["observers"] = CoapTask::getObserverCount();
+}
+
+bool PreferencesApiHandler::validateCoapConfig(JsonObject& coap) {
+    if (coap.isNull()) {
+        Logger::error("CoAP settings must be an object");
+        return false;
+    }
+    
+    if (coap.containsKey("port")) {
+        long port = coap["port"] | 0L;
+        if (port < 1 || port > 65535) {
+            Logger::error("Invalid CoAP port (1-65535)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateCoapConfig(JsonObject& coap) {
+    CoapConfig config;
+    PreferencesManager::getCoapConfig(config);
+    
+    if (coap.containsKey("enabled")) config.enabled = coap["enabled"];
+    if (coap.containsKey("port")) config.port = coap["port"];
+    
+    if (!PreferencesManager::setCoapConfig(config)) {
+        return false;
+    }
+    Logger::info("CoAP settings updated; takes effect after restart");
+    return true;
+}
+
+void PreferencesApiHandler::addBeaconConfigToJson(JsonObject& root) {
+    BeaconConfig config;
+    PreferencesManager::getBeaconConfig(config);
+    
+    JsonObject beacon = root.createNestedObject("beacon");
+    beacon["enabled"] = config.enabled;
+    beacon["group"] = IPAddress(config.group >> 24, (config.group >> 16) & 0xFF,
+                                (config.group >> 8) & 0xFF, config.group & 0xFF).toString();
+    beacon["port"] = config.port;
+    beacon["ttl"] = config.ttl;
+    beacon["running"] = BeaconTask::isRunning();
+    beacon["sent"] = BeaconTask::getSentCount();
+    beacon["failed"] = BeaconTask::getFailedCount();
+}
+
+bool PreferencesApiHandler::validateBeaconConfig(JsonObject& beacon) {
+    if (beacon.isNull()) {
+        Logger::error("Beacon settings must be an object");
+        return false;
+    }
+    
+    if (beacon.containsKey("group")) {
+        IPAddress group;
+        const char* text = beacon["group"] | "";
+        if (!group.fromString(text) || group[0] < 224 || group[0] > 239) {
+            Logger::error("Invalid beacon group (IPv4 multicast address, 224.0.0.0-239.255.255.255)");
+            return false;
+        }
+    }
+    
+    if (beacon.containsKey("port")) {
+        long port = beacon["port"] | 0L;
+        if (port < 1 || port > 65535) {
+            Logger::error("Invalid beacon port (1-65535)");
+            return false;
+        }
+    }
+    
+    if (beacon.containsKey("ttl")) {
+        long ttl = beacon["ttl"] | 0L;
+        if (ttl < 1 || ttl > 255) {
+            Logger::error("Invalid beacon TTL (1-255)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateBeaconConfig(JsonObject& beacon) {
+    BeaconConfig config;
+    PreferencesManager::getBeaconConfig(config);
+    
+    if (beacon.containsKey("enabled")) config.enabled = beacon["enabled"];
+    if (beacon.containsKey("group")) {
+        IPAddress group;
+        group.fromString(beacon["group"].as<const char*>());
+        config.group = (static_cast<uint32_t>(group[0]) << 24) | (static_cast<uint32_t>(group[1]) << 16) |
+                       (static_cast<uint32_t>(group[2]) << 8) | group[3];
+    }
+    if (beacon.containsKey("port")) config.port = beacon["port"];
+    if (beacon.containsKey("ttl")) config.ttl = beacon["ttl"];
+    
+    if (!PreferencesManager::setBeaconConfig(config)) {
+        return false;
+    }
+    Logger::info("Beacon settings updated; takes effect after restart");
+    return true;
+}
+
+void PreferencesApiHandler::addMqttFormatConfigToJson(JsonObject& root) {
+    MqttFormatConfig config;
+    PreferencesManager::getMqttFormatConfig(config);
+    
+    JsonObject formats = root.createNestedObject("mqttFormat");
+    formats["sensors"] = PayloadEncoding::formatName(config.sensors);
+    formats["relays"] = PayloadEncoding::formatName(config.relays);
+    formats["stats"] = PayloadEncoding::formatName(config.stats);
+}
+
+bool PreferencesApiHandler::validateMqttFormatConfig(JsonObject& formats) {
+    if (formats.isNull()) {
+        Logger::error("MQTT format settings must be an object");
+        return false;
+    }
+    
+    static const char* const TOPIC_CLASSES[] = {"sensors", "relays", "stats"};
+    for (const char* topicClass : TOPIC_CLASSES) {
+        if (!formats.containsKey(topicClass)) continue;
+        PayloadFormat format;
+        if (!PayloadEncoding::parseFormat(formats[topicClass] | "", format)) {
+            Logger::error(String("Invalid MQTT format for ") + topicClass + " (text, cbor or msgpack)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateMqttFormatConfig(JsonObject& formats) {
+    MqttFormatConfig config;
+    PreferencesManager::getMqttFormatConfig(config);
+    
+    if (formats.containsKey("sensors")) {
+        PayloadEncoding::parseFormat(formats["sensors"].as<const char*>(), config.sensors);
+    }
+    if (formats.containsKey("relays")) {
+        PayloadEncoding::parseFormat(formats["relays"].as<const char*>(), config.relays);
+    }
+    if (formats.containsKey("stats")) {
+        PayloadEncoding::parseFormat(formats["stats"].as<const char*>(), config.stats);
+    }
+    
+    if (!PreferencesManager::setMqttFormatConfig(config)) {
+        return false;
+    }
+    Logger::info("MQTT payload formats updated; takes effect after restart");
+    return true;
+}
+
+void PreferencesApiHandler::addSparkplugConfigToJson(JsonObject& root) {
+    SparkplugConfig config;
+    PreferencesManager::getSparkplugConfig(config);
+    
+    JsonObject sparkplug = root.createNestedObject("sparkplug");
+    sparkplug["enabled"] = config.enabled;
+    sparkplug["group"] = String(config.group);
+    sparkplug["node"] = DEVICE_ID;
+}
+
+bool PreferencesApiHandler::validateSparkplugConfig(JsonObject& sparkplug) {
+    if (sparkplug.isNull()) {
+        Logger::error("Sparkplug settings must be an object");
+        return false;
+    }
+    
+    if (sparkplug.containsKey("group")) {
+        // A topic level: no separators or wildcards
+        const char* group = sparkplug["group"] | "";
+        size_t length = strlen(group);
+        if (length == 0 || length > SPARKPLUG_GROUP_LENGTH || strpbrk(group, "/+#")) {
+            Logger::error("Invalid Sparkplug group (1-32 characters, no / + #)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateSparkplugConfig(JsonObject& sparkplug) {
+    SparkplugConfig config;
+    PreferencesManager::getSparkplugConfig(config);
+    
+    if (sparkplug.containsKey("enabled")) config.enabled = sparkplug["enabled"];
+    if (sparkplug.containsKey("group")) {
+        strncpy(config.group, sparkplug["group"] | "", SPARKPLUG_GROUP_LENGTH);
+        config.group[SPARKPLUG_GROUP_LENGTH] = '\0';
+    }
+    
+    if (!PreferencesManager::setSparkplugConfig(config)) {
+        return false;
+    }
+    Logger::info("Sparkplug settings updated; takes effect after restart");
+    return true;
+}
+
+void PreferencesApiHandler::addMqttTransportConfigToJson(JsonObject& root) {
+    JsonObject transport = root.createNestedObject("mqttTransport");
+    transport["backend"] = PreferencesManager::getMqttBackend() == MqttBackend::PUBSUBCLIENT ?
+                           "pubsubclient" : "esp-mqtt";
+    transport["protocol"] = PreferencesManager::getMqttProtocol() == MqttProtocol::V5 ? "5" : "3.1.1";
+    transport["window"] = MQTT_INFLIGHT_WINDOW;
+}
+
+bool PreferencesApiHandler::validateMqttTransportConfig(JsonObject& transport) {
+    if (transport.isNull()) {
+        Logger::error("MQTT transport settings must be an object");
+        return false;
+    }
+    
+    if (transport.containsKey("backend")) {
+        const char* backend = transport["backend"] | "";
+        if (strcmp(backend, "esp-mqtt") != 0 && strcmp(backend, "pubsubclient") != 0) {
+            Logger::error("Invalid MQTT backend (esp-mqtt or pubsubclient)");
+            return false;
+        }
+    }
+    
+    if (transport.containsKey("protocol")) {
+        const char* protocol = transport["protocol"] | "";
+        if (strcmp(protocol, "3.1.1") != 0 && strcmp(protocol, "5") != 0) {
+            Logger::error("Invalid MQTT protocol (3.1.1 or 5)");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool PreferencesApiHandler::updateMqttTransportConfig(JsonObject& transport) {
+    if (transport.containsKey("backend")) {
+        MqttBackend backend = strcmp(transport["backend"] | "", "pubsubclient") == 0 ?
+                              MqttBackend::PUBSUBCLIENT : MqttBackend::ESP_MQTT;
+        if (!PreferencesManager::setMqttBackend(backend)) {
+            return false;
+        }
+        Logger::info("MQTT backend updated; takes effect after restart");
+    }
+    
+    if (transport.containsKey("protocol")) {
+        MqttProtocol protocol = strcmp(transport["protocol"] | "", "5") == 0 ?
+                                MqttProtocol::V5 : MqttProtocol::V3_1_1;
+        if (!PreferencesManager::setMqttProtocol(protocol)) {
+            return false;
+        }
+        Logger::info("MQTT protocol updated; takes effect after restart");
+    }
+    return true;
+}
+
 bool PreferencesApiHandler::validateHostname(const char* hostname) {
     if (!hostname || strlen(hostname) == 0) {
         return false;
     }
-
+    
     for (size_t i = 0; hostname[i]; i++) {
         char c = hostname[i];
         if (!isalnum(c) && c != '.' && c != '-' && c != ':') {
             return false;
         }
     }
-
+    
     if (strstr(hostname, "..") || strstr(hostname, "--")) {
         return false;
     }
-
+    
     size_t len = strlen(hostname);
     if (hostname[0] == '.' || hostname[len-1] == '.' ||
         hostname[0] == '-' || hostname[len-1] == '-') {
         return false;
     }
-
+    
     return true;
 }
@@ -1,23 +1,27 @@
 #include "PreferencesManager.h"
 #include "ESP32PreferenceStorage.h"
+#include "FixedString.h"
+#include "RtosResources.h"
+#include <algorithm>
 
 // Static member initialization
 PreferenceStorage* PreferencesManager::prefs = nullptr;
 SemaphoreHandle_t PreferencesManager::prefsMutex = nullptr;
+volatile uint32_t PreferencesManager::nameGeneration = 0;
 
 void PreferencesManager::init() {
     Logger::info("Initializing PreferencesManager");
-
+    
     // Create mutex if it doesn't exist
     if (!prefsMutex) {
-        prefsMutex = xSemaphoreCreateMutex();
+        prefsMutex = RtosResources::createMutex(MutexId::PREFERENCES);
         if (!prefsMutex) {
             Logger::error("Failed to create preferences mutex");
             return;
         }
         Logger::debug("Created preferences mutex");
     }
-
+    
     // Create preferences storage if it doesn't exist
     if (!prefs) {
         prefs = new ESP32PreferenceStorage();
@@ -27,13 +31,13 @@ void PreferencesManager::init() {
         }
         Logger::debug("Created preferences storage");
     }
-
+    
     // Initialize storage
     if (!prefs->begin("tempmon", false)) {
         Logger::error("Failed to begin preferences storage");
         return;
     }
-
+    
     if (acquireMutex("init")) {
         // Check if this is first run
         if (prefs->getString("initialized", "").length() == 0) {
@@ -80,7 +84,7 @@ bool PreferencesManager::setCredential(const char* key, const char* value) {
         Logger::error("Invalid parameters in setCredential");
         return false;
     }
-
+    
     bool success = false;
     if (acquireMutex("setCredential")) {
         success = prefs->putString(key, value);
@@ -99,7 +103,7 @@ String PreferencesManager::getCredential(const char* key) {
         Logger::error("Invalid parameters in getCredential");
         return "";
     }
-
+    
     String value;
     if (acquireMutex("getCredential")) {
         value = prefs->getString(key, "");
@@ -119,7 +123,7 @@ bool PreferencesManager::removeCredential(const char* key) {
         Logger::error("Invalid parameters in removeCredential");
         return false;
     }
-
+    
     bool success = false;
     if (acquireMutex("removeCredential")) {
         success = prefs->remove(key);
@@ -229,6 +233,7 @@ bool PreferencesManager::setSensorName(const uint8_t* address, const char* name)
         String key = getSensorKey(address);
         success = prefs->putString(key.c_str(), name);
         if (success) {
+            nameGeneration = nameGeneration + 1;
             Logger::info("Saved name '" + String(name) + "' for sensor " + 
                         addressToString(address));
         }
@@ -278,18 +283,18 @@ bool PreferencesManager::isInitialized() {
 }
 
 String PreferencesManager::getSensorKey(const uint8_t* address) {
-    char key[15];
-    snprintf(key, sizeof(key), "s_%02X%02X%02X%02X",
+    return getSensorKey("s_", address);
+}
+
+String PreferencesManager::getSensorKey(const char* prefix, const uint8_t* address) {
+    char key[16];  // NVS keys are limited to 15 characters
+    snprintf(key, sizeof(key), "%s%02X%02X%02X%02X", prefix,
              address[4], address[5], address[6], address[7]);
     return String(key);
 }
 
 String PreferencesManager::addressToString(const uint8_t* address) {
-    char temp[17];
-    snprintf(temp, sizeof(temp), "%02X%02X%02X%02X%02X%02X%02X%02X",
-             address[0], address[1], address[2], address[3],
-             address[4], address[5], address[6], address[7]);
-    return String(temp);
+    return String(formatAddress(address).c_str());
 }
 
 void PreferencesManager::stringToAddress(const String& str, uint8_t* address) {
@@ -357,6 +362,166 @@ void PreferencesManager::getDisplaySensor(uint8_t* address) {
     }
 }
 
+// Playlist record: ROM:label:dwell;ROM:label:dwell;...
+bool PreferencesManager::setDisplayPlaylist(const DisplayPlaylistEntry* entries, uint8_t count) {
+    if (!isInitialized() || count > MAX_PLAYLIST_ENTRIES) return false;
+    
+    String record;
+    for (uint8_t i = 0; i < count; i++) {
+        if (i > 0) record += ";";
+        record += addressToString(entries[i].address) + ":" + entries[i].label + ":" + 
+                  String(entries[i].dwellSeconds);
+    }
+    
+    bool success = false;
+    if (acquireMutex("setDisplayPlaylist")) {
+        success = prefs->putString("dsp_list", record.c_str());
+        releaseMutex();
+        Logger::info("Display playlist " + String(success ? "saved" : "failed"));
+    }
+    return success;
+}
+
+uint8_t PreferencesManager::getDisplayPlaylist(DisplayPlaylistEntry* entries, uint8_t maxCount) {
+    if (!isInitialized()) return 0;
+    
+    String record;
+    if (acquireMutex("getDisplayPlaylist")) {
+        record = prefs->getString("dsp_list", "");
+        releaseMutex();
+    }
+    
+    uint8_t count = 0;
+    const char* cursor = record.c_str();
+    while (*cursor && count < maxCount) {
+        DisplayPlaylistEntry& entry = entries[count];
+        memset(&entry, 0, sizeof(entry));
+        
+        char address[17] = {0};
+        unsigned dwell = 0;
+        int length = 0;
+        // The label may be empty, so it is parsed separately from the dwell time
+        if (sscanf(cursor, "%16[0-9A-Fa-f]:%n", address, &length) != 1 || length == 0) {
+            Logger::error("Invalid display playlist record");
+            return count;
+        }
+        cursor += length;
+        
+        size_t labelLength = strcspn(cursor, ":");
+        strncpy(entry.label, cursor, std::min<size_t>(labelLength, PLAYLIST_LABEL_LENGTH));
+        cursor += labelLength;
+        
+        if (sscanf(cursor, ":%u%n", &dwell, &length) != 1) {
+            Logger::error("Invalid display playlist record");
+            return count;
+        }
+        cursor += length;
+        if (*cursor == ';') cursor++;
+        
+        stringToAddress(String(address), entry.address);
+        entry.dwellSeconds = dwell;
+        count++;
+    }
+    return count;
+}
+
+// Task affinity overrides, stored as core + 1 so 0 can mean "no affinity"
+bool PreferencesManager::setTaskCore(uint8_t taskIndex, int8_t core) {
+    if (!isInitialized() || core < -1 || core > 1) return false;
+    
+    char key[16];
+    snprintf(key, sizeof(key), "core_%u", taskIndex);
+    bool success = false;
+    if (acquireMutex("setTaskCore")) {
+        success = prefs->putUInt(key, static_cast<uint32_t>(core + 1));
+        releaseMutex();
+    }
+    return success;
+}
+
+bool PreferencesManager::clearTaskCore(uint8_t taskIndex) {
+    if (!isInitialized()) return false;
+    
+    char key[16];
+    snprintf(key, sizeof(key), "core_%u", taskIndex);
+    bool success = false;
+    if (acquireMutex("clearTaskCore")) {
+        prefs->remove(key);
+        success = true;
+        releaseMutex();
+    }
+    return success;
+}
+
+int8_t PreferencesManager::getTaskCore(uint8_t taskIndex, int8_t defaultCore) {
+    if (!isInitialized()) return defaultCore;
+    
+    char key[16];
+    snprintf(key, sizeof(key), "core_%u", taskIndex);
+    uint32_t stored = UINT32_MAX;
+    if (acquireMutex("getTaskCore")) {
+        stored = prefs->getUInt(key, UINT32_MAX);
+        releaseMutex();
+    }
+    return stored <= 2 ? static_cast<int8_t>(stored) - 1 : defaultCore;
+}
+
+bool PreferencesManager::setWarmStartRecords(const WarmStartRecord* records, uint8_t count) {
+    if (!isInitialized()) return false;
+    
+    String record;
+    for (uint8_t i = 0; i < count; i++) {
+        if (i > 0) record += ";";
+        record += addressToString(records[i].address) + ":" + String(records[i].resolution) + ":" +
+                  String(records[i].raw) + ":" + String(records[i].valid) + ":" + 
+                  String(records[i].readTime);
+    }
+    
+    bool success = false;
+    if (acquireMutex("setWarmStartRecords")) {
+        success = prefs->putString("ws_list", record.c_str());
+        releaseMutex();
+    }
+    return success;
+}
+
+uint8_t PreferencesManager::getWarmStartRecords(WarmStartRecord* records, uint8_t maxCount) {
+    if (!isInitialized()) return 0;
+    
+    String record;
+    if (acquireMutex("getWarmStartRecords")) {
+        record = prefs->getString("ws_list", "");
+        releaseMutex();
+    }
+    
+    uint8_t count = 0;
+    const char* cursor = record.c_str();
+    while (*cursor && count < maxCount) {
+        char address[17] = {0};
+        unsigned resolution = 0;
+        int raw = 0;
+        unsigned valid = 0;
+        unsigned long readTime = 0;
+        int length = 0;
+        if (sscanf(cursor, "%16[0-9A-Fa-f]:%u:%d:%u:%lu%n", 
+                   address, &resolution, &raw, &valid, &readTime, &length) != 5) {
+            Logger::error("Invalid warm start record");
+            return count;
+        }
+        cursor += length;
+        if (*cursor == ';') cursor++;
+        
+        WarmStartRecord& entry = records[count];
+        stringToAddress(String(address), entry.address);
+        entry.raw = static_cast<int16_t>(raw);
+        entry.resolution = static_cast<uint8_t>(resolution);
+        entry.valid = valid ? 1 : 0;
+        entry.readTime = readTime;
+        count++;
+    }
+    return count;
+}
+
 bool PreferencesManager::setDisplaySensor(const uint8_t* address) {
     if (!isInitialized()) return false;
     
@@ -376,11 +541,16 @@ bool PreferencesManager::setRelayName(uint8_t relayId, const char* name) {
     if (acquireMutex("setRelayName")) {
         String key = "relay_" + String(relayId);
         success = prefs->putString(key.c_str(), name);
+        if (success) nameGeneration = nameGeneration + 1;
         releaseMutex();
     }
     return success;
 }
 
+uint32_t PreferencesManager::getNameGeneration() {
+    return nameGeneration;
+}
+
 String PreferencesManager::getRelayName(uint8_t relayId) {
     if (!isInitialized() || relayId > 1) return "";
     
@@ -391,4 +561,537 @@ String PreferencesManager::getRelayName(uint8_t relayId) {
         releaseMutex();
     }
     return name;
-}
\ No newline at end of file
+}
+
+bool PreferencesManager::setFilterConfig(const FilterConfig& config) {
+    if (!isInitialized()) return false;
+    
+    bool success = false;
+    if (acquireMutex("setFilterConfig")) {
+        success = prefs->putUInt("flt_median", config.medianEnabled ? 1 : 0);
+        success &= prefs->putUInt("flt_mode", static_cast<uint32_t>(config.smoothing));
+        success &= prefs->putUInt("flt_alpha", config.emaAlpha);
+        success &= prefs->putUInt("flt_kq", config.kalmanQ);
+        success &= prefs->putUInt("flt_kr", config.kalmanR);
+        success &= prefs->putUInt("flt_rate", config.maxRatePerSec);
+        releaseMutex();
+        Logger::info("Filter configuration " + String(success ? "saved" : "failed"));
+    }
+    return success;
+}
+
+void PreferencesManager::getFilterConfig(FilterConfig& config) {
+    config = SensorFilter::defaultConfig();
+    if (!isInitialized()) return;
+    
+    if (acquireMutex("getFilterConfig")) {
+        config.medianEnabled = prefs->getUInt("flt_median", config.medianEnabled ? 1 : 0) != 0;
+        uint32_t mode = prefs->getUInt("flt_mode", static_cast<uint32_t>(config.smoothing));
+        if (mode <= static_cast<uint32_t>(SmoothingMode::KALMAN)) {
+            config.smoothing = static_cast<SmoothingMode>(mode);
+        }
+        config.emaAlpha = prefs->getUInt("flt_alpha", config.emaAlpha);
+        config.kalmanQ = prefs->getUInt("flt_kq", config.kalmanQ);
+        config.kalmanR = prefs->getUInt("flt_kr", config.kalmanR);
+        config.maxRatePerSec = prefs->getUInt("flt_rate", config.maxRatePerSec);
+        releaseMutex();
+    }
+}
+
+// Thresholds are stored in hundredths to keep to integer NVS entries
+bool PreferencesManager::setAnomalyConfig(const AnomalyConfig& config) {
+    if (!isInitialized()) return false;
+    
+    bool success = false;
+    if (acquireMutex("setAnomalyConfig")) {
+        success = prefs->putUInt("an_rate", static_cast<uint32_t>(config.maxRatePerMin * 100.0f + 0.5f));
+        success &= prefs->putUInt("an_flat", config.flatlineCycles);
+        success &= prefs->putUInt("an_z", static_cast<uint32_t>(config.zScoreThreshold * 100.0f + 0.5f));
+        success &= prefs->putUInt("an_zwin", config.zScoreWindow);
+        releaseMutex();
+        Logger::info("Anomaly detection configuration " + String(success ? "saved" : "failed"));
+    }
+    return success;
+}
+
+void PreferencesManager::getAnomalyConfig(AnomalyConfig& config) {
+    config = AnomalyDetector::defaultConfig();
+    if (!isInitialized()) return;
+    
+    if (acquireMutex("getAnomalyConfig")) {
+        config.maxRatePerMin = prefs->getUInt("an_rate", 0) / 100.0f;
+        config.flatlineCycles = prefs->getUInt("an_flat", config.flatlineCycles);
+        config.zScoreThreshold = prefs->getUInt("an_z", 0) / 100.0f;
+        config.zScoreWindow = prefs->getUInt("an_zwin", config.zScoreWindow);
+        releaseMutex();
+    }
+}
+
+bool PreferencesManager::setSensorCalibration(const uint8_t* address, 
+                                              const SensorCalibration& calibration) {
+    if (!isInitialized() || !address) return false;
+    
+    bool success = false;
+    if (acquireMutex("setSensorCalibration")) {
+        success = prefs->putUInt(getSensorKey("co_", address).c_str(),
+                                 static_cast<uint32_t>(calibration.offset));
+        success &= prefs->putUInt(getSensorKey("cg_", address).c_str(), calibration.gain);
+        releaseMutex();
+    }
+    return success;
+}
+
+void PreferencesManager::getSensorCalibration(const uint8_t* address, 
+                                              SensorCalibration& calibration) {
+    calibration = SensorFilter::defaultCalibration();
+    if (!isInitialized() || !address) return;
+    
+    if (acquireMutex("getSensorCalibration")) {
+        calibration.offset = static_cast<int32_t>(
+            prefs->getUInt(getSensorKey("co_", address).c_str(), 0));
+        calibration.gain = prefs->getUInt(getSensorKey("cg_", address).c_str(), 
+                                          SensorFilter::GAIN_ONE);
+        releaseMutex();
+    }
+}
+
+bool PreferencesManager::setControlLoop(uint8_t loopId, const ControlLoopConfig& config) {
+    if (!isInitialized() || loopId > 1) return false;
+    
+    // Store the whole loop as one compact record to keep NVS usage low
+    char record[160];
+    snprintf(record, sizeof(record), "%u,%s,%.3f,%.3f,%u,%.6f,%.6f,%.6f,%lu,%lu,%lu",
+             static_cast<unsigned>(config.mode),
+             addressToString(config.sensorAddress).c_str(),
+             config.setpoint, config.hysteresis,
+             config.cooling ? 1u : 0u,
+             config.kp, config.ki, config.kd,
+             static_cast<unsigned long>(config.pidWindowMs),
+             static_cast<unsigned long>(config.minOnMs),
+             static_cast<unsigned long>(config.minOffMs));
+    
+    bool success = false;
+    if (acquireMutex("setControlLoop")) {
+        String key = "ctl_" + String(loopId);
+        success = prefs->putString(key.c_str(), record);
+        releaseMutex();
+        Logger::info("Control loop " + String(loopId) + " configuration " + 
+                    String(success ? "saved" : "failed"));
+    }
+    return success;
+}
+
+void PreferencesManager::getControlLoop(uint8_t loopId, ControlLoopConfig& config) {
+    config = ThermostatController::defaultConfig();
+    if (!isInitialized() || loopId > 1) return;
+    
+    String record;
+    if (acquireMutex("getControlLoop")) {
+        String key = "ctl_" + String(loopId);
+        record = prefs->getString(key.c_str(), "");
+        releaseMutex();
+    }
+    
+    if (record.isEmpty()) return;
+    
+    unsigned mode = 0;
+    unsigned cooling = 0;
+    char address[17] = {0};
+    unsigned long window = 0, minOn = 0, minOff = 0;
+    int fields = sscanf(record.c_str(), "%u,%16[0-9A-Fa-f],%f,%f,%u,%f,%f,%f,%lu,%lu,%lu",
+                        &mode, address, &config.setpoint, &config.hysteresis, &cooling,
+                        &config.kp, &config.ki, &config.kd, &window, &minOn, &minOff);
+    
+    if (fields != 11 || mode > static_cast<unsigned>(ControlMode::PID)) {
+        Logger::error("Invalid control loop record for loop " + String(loopId));
+        config = ThermostatController::defaultConfig();
+        return;
+    }
+    
+    config.mode = static_cast<ControlMode>(mode);
+    config.cooling = cooling != 0;
+    config.pidWindowMs = window;
+    config.minOnMs = minOn;
+    config.minOffMs = minOff;
+    stringToAddress(String(address), config.sensorAddress);
+}
+
+bool PreferencesManager::setRule(uint8_t ruleId, const RuleDefinition& definition) {
+    if (!isInitialized() || ruleId >= RULE_MAX_RULES) return false;
+    
+    // Record layout: enabled,relay,action,holdSeconds,condition
+    char record[RULE_MAX_SOURCE + 32];
+    snprintf(record, sizeof(record), "%u,%u,%u,%lu,%s",
+             definition.enabled ? 1u : 0u,
+             static_cast<unsigned>(definition.relay),
+             definition.action ? 1u : 0u,
+             static_cast<unsigned long>(definition.holdSeconds),
+             definition.condition);
+    
+    bool success = false;
+    if (acquireMutex("setRule")) {
+        String key = "rule_" + String(ruleId);
+        success = prefs->putString(key.c_str(), record);
+        releaseMutex();
+    }
+    return success;
+}
+
+bool PreferencesManager::getRule(uint8_t ruleId, RuleDefinition& definition) {
+    memset(&definition, 0, sizeof(definition));
+    if (!isInitialized() || ruleId >= RULE_MAX_RULES) return false;
+    
+    String record;
+    if (acquireMutex("getRule")) {
+        String key = "rule_" + String(ruleId);
+        record = prefs->getString(key.c_str(), "");
+        releaseMutex();
+    }
+    
+    if (record.isEmpty()) return false;
+    
+    unsigned enabled = 0, relay = 0, action = 0;
+    unsigned long hold = 0;
+    int consumed = 0;
+    if (sscanf(record.c_str(), "%u,%u,%u,%lu,%n", &enabled, &relay, &action, &hold, &consumed) != 4 ||
+        consumed == 0) {
+        Logger::error("Invalid rule record for rule " + String(ruleId));
+        return false;
+    }
+    
+    definition.enabled = enabled != 0;
+    definition.relay = static_cast<uint8_t>(relay);
+    definition.action = action != 0;
+    definition.holdSeconds = hold;
+    strncpy(definition.condition, record.c_str() + consumed, RULE_MAX_SOURCE - 1);
+    definition.condition[RULE_MAX_SOURCE - 1] = '\0';
+    return true;
+}
+
+bool PreferencesManager::setVirtualSensor(uint8_t index, const VirtualSensorDefinition& definition) {
+    if (!isInitialized() || index >= MAX_VIRTUAL_SENSORS || 
+        definition.inputCount > MAX_VIRTUAL_INPUTS) return false;
+    
+    // Record layout: enabled,type,ROM:weight,ROM:weight,...
+    String record = String(definition.enabled ? 1 : 0) + "," + 
+                    String(static_cast<unsigned>(definition.type));
+    for (uint8_t i = 0; i < definition.inputCount; i++) {
+        record += "," + addressToString(definition.inputs[i]) + ":" + String(definition.weights[i], 4);
+    }
+    
+    bool success = false;
+    if (acquireMutex("setVirtualSensor")) {
+        String key = "vs_" + String(index);
+        success = prefs->putString(key.c_str(), record.c_str());
+        releaseMutex();
+    }
+    return success;
+}
+
+bool PreferencesManager::getVirtualSensor(uint8_t index, VirtualSensorDefinition& definition) {
+    memset(&definition, 0, sizeof(definition));
+    if (!isInitialized() || index >= MAX_VIRTUAL_SENSORS) return false;
+    
+    String record;
+    if (acquireMutex("getVirtualSensor")) {
+        String key = "vs_" + String(index);
+        record = prefs->getString(key.c_str(), "");
+        releaseMutex();
+    }
+    
+    if (record.isEmpty()) return false;
+    
+    unsigned enabled = 0, type = 0;
+    int consumed = 0;
+    if (sscanf(record.c_str(), "%u,%u%n", &enabled, &type, &consumed) != 2 ||
+        type > static_cast<unsigned>(VirtualSensorType::WEIGHTED_SUM)) {
+        Logger::error("Invalid virtual sensor record for index " + String(index));
+        return false;
+    }
+    
+    const char* cursor = record.c_str() + consumed;
+    while (*cursor == ',' && definition.inputCount < MAX_VIRTUAL_INPUTS) {
+        char address[17] = {0};
+        float weight = 1.0f;
+        int length = 0;
+        if (sscanf(cursor, ",%16[0-9A-Fa-f]:%f%n", address, &weight, &length) != 2) {
+            Logger::error("Invalid virtual sensor input for index " + String(index));
+            return false;
+        }
+        stringToAddress(String(address), definition.inputs[definition.inputCount]);
+        definition.weights[definition.inputCount] = weight;
+        definition.inputCount++;
+        cursor += length;
+    }
+    
+    definition.enabled = enabled != 0;
+    definition.type = static_cast<VirtualSensorType>(type);
+    return true;
+}
+
+bool PreferencesManager::setModbusConfig(const ModbusConfig& config) {
+    if (!isInitialized() || config.port == 0) return false;
+    
+    bool success = false;
+    if (acquireMutex("setModbusConfig")) {
+        success = prefs->putUInt("mb_on", config.enabled ? 1 : 0);
+        success &= prefs->putUInt("mb_port", config.port);
+        success &= prefs->putUInt("mb_write", config.allowWrites ? 1 : 0);
+        releaseMutex();
+    }
+    return success;
+}
+
+void PreferencesManager::getModbusConfig(ModbusConfig& config) {
+    config.enabled = false;
+    config.port = MODBUS_TCP_PORT;
+    config.allowWrites = false;
+    if (!isInitialized()) return;
+    
+    if (acquireMutex("getModbusConfig")) {
+        config.enabled = prefs->getUInt("mb_on", 0) != 0;
+        config.port = prefs->getUInt("mb_port", MODBUS_TCP_PORT);
+        config.allowWrites = prefs->getUInt("mb_write", 0) != 0;
+        releaseMutex();
+    }
+}
+
+bool PreferencesManager::setBacnetConfig(const BacnetConfig& config) {
+    if (!isInitialized() || config.port == 0) return false;
+    
+    bool success = false;
+    if (acquireMutex("setBacnetConfig")) {
+        success = prefs->putUInt("bn_on", config.enabled ? 1 : 0);
+        success &= prefs->putUInt("bn_port", config.port);
+        success &= prefs->putUInt("bn_inst", config.deviceInstance);
+        success &= prefs->putFloat("bn_cov", config.covIncrement);
+        releaseMutex();
+    }
+    return success;
+}
+
+void PreferencesManager::getBacnetConfig(BacnetConfig& config) {
+    config.enabled = false;
+    config.port = BACNET_UDP_PORT;
+    config.deviceInstance = 0;
+    config.covIncrement = BACNET_COV_INCREMENT;
+    if (!isInitialized()) return;
+    
+    if (acquireMutex("getBacnetConfig")) {
+        config.enabled = prefs->getUInt("bn_on", 0) != 0;
+        config.port = prefs->getUInt("bn_port", BACNET_UDP_PORT);
+        config.deviceInstance = prefs->getUInt("bn_inst", 0);
+        config.covIncrement = prefs->getFloat("bn_cov", BACNET_COV_INCREMENT);
+        releaseMutex();
+    }
+}
+
+bool PreferencesManager::setCoapConfig(const CoapConfig& config) {
+    if (!isInitialized() || config.port == 0) return false;
+    
+    bool success = false;
+    if (acquireMutex("setCoapConfig")) {
+        success = prefs->putUInt("co_on", config.enabled ? 1 : 0);
+        success &= prefs->putUInt("co_port", config.port);
+        releaseMutex();
+    }
+    return success;
+}
+
+void PreferencesManager::getCoapConfig(CoapConfig& config) {
+    config.enabled = false;
+    config.port = COAP_UDP_PORT;
+    if (!isInitialized()) return;
+    
+    if (acquireMutex("getCoapConfig")) {
+        config.enabled = prefs->getUInt("co_on", 0) != 0;
+        config.port = prefs->getUInt("co_port", COAP_UDP_PORT);
+        releaseMutex();
+    }
+}
+
+bool PreferencesManager::setBeaconConfig(const BeaconConfig& config) {
+    if (!isInitialized() || config.port == 0 || config.ttl == 0) return false;
+    
+    bool success = false;
+    if (acquireMutex("setBeaconConfig")) {
+        success = prefs->putUInt("bc_on", config.enabled ? 1 : 0);
+        success &= prefs->putUInt("bc_group", config.group);
+        success &= prefs->putUInt("bc_port", config.port);
+        success &= prefs->putUInt("bc_ttl", config.ttl);
+        releaseMutex();
+    }
+    return success;
+}
+
+void PreferencesManager::getBeaconConfig(BeaconConfig& config) {
+    config.enabled = false;
+    config.group = BEACON_MULTICAST_GROUP;
+    config.port = BEACON_UDP_PORT;
+    config.ttl = BEACON_MULTICAST_TTL;
+    if (!isInitialized()) return;
+    
+    if (acquireMutex("getBeaconConfig")) {
+        config.enabled = prefs->getUInt("bc_on", 0) != 0;
+        config.group = prefs->getUInt("bc_group", BEACON_MULTICAST_GROUP);
+        config.port = prefs->getUInt("bc_port", BEACON_UDP_PORT);
+        config.ttl = prefs->getUInt("bc_ttl", BEACON_MULTICAST_TTL);
+        releaseMutex();
+    }
+}
+
+bool PreferencesManager::setMqttFormatConfig(const MqttFormatConfig& config) {
+    if (!isInitialized()) return false;
+    
+    bool success = false;
+    if (acquireMutex("setMqttFormatConfig")) {
+        success = prefs->putUInt("mf_sensors", static_cast<uint32_t>(config.sensors));
+        success &= prefs->putUInt("mf_relays", static_cast<uint32_t>(config.relays));
+        success &= prefs->putUInt("mf_stats", static_cast<uint32_t>(config.stats));
+        releaseMutex();
+    }
+    return success;
+}
+
+void PreferencesManager::getMqttFormatConfig(MqttFormatConfig& config) {
+    config.sensors = PayloadFormat::TEXT;
+    config.relays = PayloadFormat::TEXT;
+    config.stats = PayloadFormat::TEXT;
+    if (!isInitialized()) return;
+    
+    // Unknown values from a newer firmware fall back to text
+    auto toFormat = [](uint32_t value) {
+        return value <= static_cast<uint32_t>(PayloadFormat::MSGPACK) ? static_cast<PayloadFormat>(value)
+                                                                      : PayloadFormat::TEXT;
+    };
+    if (acquireMutex("getMqttFormatConfig")) {
+        config.sensors = toFormat(prefs->getUInt("mf_sensors", 0));
+        config.relays = toFormat(prefs->getUInt("mf_relays", 0));
+        config.stats = toFormat(prefs->getUInt("mf_stats", 0));
+        releaseMutex();
+    }
+}
+
+bool PreferencesManager::setMqttBackend(MqttBackend backend) {
+    if (!isInitialized()) return false;
+    
+    bool success = false;
+    if (acquireMutex("setMqttBackend")) {
+        success = prefs->putUInt("mq_backend", static_cast<uint32_t>(backend));
+        releaseMutex();
+    }
+    return success;
+}
+
+MqttBackend PreferencesManager::getMqttBackend() {
+    MqttBackend backend = MqttBackend::ESP_MQTT;
+    if (!isInitialized()) return backend;
+    
+    if (acquireMutex("getMqttBackend")) {
+        uint32_t value = prefs->getUInt("mq_backend", 0);
+        if (value <= static_cast<uint32_t>(MqttBackend::PUBSUBCLIENT)) {
+            backend = static_cast<MqttBackend>(value);
+        }
+        releaseMutex();
+    }
+    return backend;
+}
+
+bool PreferencesManager::setMqttProtocol(MqttProtocol protocol) {
+    if (!isInitialized()) return false;
+    
+    bool success = false;
+    if (acquireMutex("setMqttProtocol")) {
+        success = prefs->putUInt("mq_proto", static_cast<uint32_t>(protocol));
+        releaseMutex();
+    }
+    return success;
+}
+
+MqttProtocol PreferencesManager::getMqttProtocol() {
+    MqttProtocol protocol = MqttProtocol::V3_1_1;
+    if (!isInitialized()) return protocol;
+    
+    if (acquireMutex("getMqttProtocol")) {
+        uint32_t value = prefs->getUInt("mq_proto", 0);
+        if (value <= static_cast<uint32_t>(MqttProtocol::V5)) {
+            protocol = static_cast<MqttProtocol>(value);
+        }
+        releaseMutex();
+    }
+    return protocol;
+}
+
+bool PreferencesManager::setSparkplugConfig(const SparkplugConfig& config) {
+    if (!isInitialized()) return false;
+    
+    bool success = false;
+    if (acquireMutex("setSparkplugConfig")) {
+        success = prefs->putUInt("sp_on", config.enabled ? 1 : 0);
+        success &= prefs->putString("sp_group", config.group) > 0;
+        releaseMutex();
+    }
+    return success;
+}
+
+void PreferencesManager::getSparkplugConfig(SparkplugConfig& config) {
+    config.enabled = false;
+    strncpy(config.group, SPARKPLUG_DEFAULT_GROUP, SPARKPLUG_GROUP_LENGTH);
+    config.group[SPARKPLUG_GROUP_LENGTH] = '\0';
+    if (!isInitialized()) return;
+    
+    if (acquireMutex("getSparkplugConfig")) {
+        config.enabled = prefs->getUInt("sp_on", 0) != 0;
+        String group = prefs->getString("sp_group", SPARKPLUG_DEFAULT_GROUP);
+        if (group.length() > 0) {
+            strncpy(config.group, group.c_str(), SPARKPLUG_GROUP_LENGTH);
+            config.group[SPARKPLUG_GROUP_LENGTH] = '\0';
+        }
+        releaseMutex();
+    }
+}
+
+// Slot record: ROM;ROM;... in slot order, all zeros for a free slot
+bool PreferencesManager::setSensorSlots(const char* key, const uint8_t (*addresses)[8], uint8_t count) {
+    if (!isInitialized()) return false;
+    
+    String record;
+    for (uint8_t i = 0; i < count; i++) {
+        if (i > 0) record += ";";
+        record += addressToString(addresses[i]);
+    }
+    
+    bool success = false;
+    if (acquireMutex("setSensorSlots")) {
+        success = prefs->putString(key, record.c_str());
+        releaseMutex();
+    }
+    return success;
+}
+
+uint8_t PreferencesManager::getSensorSlots(const char* key, uint8_t (*addresses)[8], uint8_t maxCount) {
+    if (!isInitialized()) return 0;
+    
+    String record;
+    if (acquireMutex("getSensorSlots")) {
+        record = prefs->getString(key, "");
+        releaseMutex();
+    }
+    
+    uint8_t count = 0;
+    const char* cursor = record.c_str();
+    while (*cursor && count < maxCount) {
+        char address[17] = {0};
+        int length = 0;
+        if (sscanf(cursor, "%16[0-9A-Fa-f]%n", address, &length) != 1 || length != 16) {
+            Logger::error("Invalid sensor slot record: " + String(key));
+            return count;
+        }
+        cursor += length;
+        if (*cursor == ';') cursor++;
+        
+        stringToAddress(String(address), addresses[count]);
+        count++;
+    }
+    return count;
+}
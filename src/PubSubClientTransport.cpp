@@ -0,0 +1,88 @@
+// PubSubClientTransport.cpp
+#include "PubSubClientTransport.h"
+#include "MqttWire.h"
+
+PubSubClientTransport::PubSubClientTransport()
+    : wifiClient()
+    , mqtt(wifiClient)
+    , host()
+    , handler(nullptr)
+    , handlerContext(nullptr)
+    , published(0)
+    , dropped(0)
+    , bytesSent(0)
+    , publishTimeAverage(0) {
+}
+
+void PubSubClientTransport::begin(const char* caCert) {
+    wifiClient.setCACert(caCert);
+    
+    // Allocated here rather than in the constructor, so the unused backend costs nothing
+    mqtt.setBufferSize(BUFFER_SIZE);
+    mqtt.setSocketTimeout(SOCKET_TIMEOUT);
+    mqtt.setCallback([this](char* topic, uint8_t* payload, unsigned int length) {
+        if (handler) {
+            handler(topic, payload, length, handlerContext);
+        }
+    });
+}
+
+void PubSubClientTransport::setServer(const char* host, uint16_t port) {
+    this->host.assign(host);
+    mqtt.setServer(this->host.c_str(), port);
+}
+
+bool PubSubClientTransport::connect(const char* clientId, const char* username, const char* password,
+                                    const Will& will) {
+    return mqtt.connect(clientId, username, password, will.topic, will.qos, will.retain,
+                        reinterpret_cast<const char*>(will.payload));
+}
+
+bool PubSubClientTransport::connected() {
+    return mqtt.connected();
+}
+
+void PubSubClientTransport::loop() {
+    mqtt.loop();
+}
+
+bool PubSubClientTransport::publish(const char* topic, const uint8_t* payload, size_t length,
+                                    uint8_t qos, bool retain, const PublishProperties* properties) {
+    (void)qos;
+    (void)properties;
+    uint32_t start = micros();
+    if (!mqtt.publish(topic, payload, length, retain)) {
+        dropped++;
+        return false;
+    }
+    uint32_t elapsed = micros() - start;
+    publishTimeAverage = published == 0 ? elapsed :
+        publishTimeAverage + (static_cast<int32_t>(elapsed - publishTimeAverage) / 8);
+    published++;
+    bytesSent += MqttWire::publishLength(strlen(topic), length, 0, 0);
+    
+    // Give some time for the message to be processed
+    delay(SETTLE_DELAY);
+    return true;
+}
+
+bool PubSubClientTransport::subscribe(const char* topic, uint8_t qos) {
+    return mqtt.subscribe(topic, qos);
+}
+
+void PubSubClientTransport::setMessageHandler(MessageHandler handler, void* context) {
+    this->handler = handler;
+    handlerContext = context;
+}
+
+int PubSubClientTransport::state() {
+    return mqtt.state();
+}
+
+void PubSubClientTransport::getStats(Stats& stats) {
+    stats = Stats();
+    stats.published = published;
+    stats.dropped = dropped;
+    stats.bytesSent = bytesSent;
+    stats.publishTimeAverage = publishTimeAverage;
+}
@@ -0,0 +1,118 @@
+// RtosResources.cpp
+#include "RtosResources.h"
+#include "Logger.h"
+#include "FixedString.h"
+#include "PreferencesManager.h"
+
+// Backing storage for every RTOS object, reserved in .bss
+alignas(RtosBudget::STACK_ALIGN) static StackType_t taskStacks[RtosBudget::STACK_BYTES];
+static StaticTask_t taskBlocks[TASK_COUNT];
+static uint8_t queueStorage[RtosBudget::QUEUE_BYTES];
+static StaticQueue_t queueBlocks[QUEUE_COUNT];
+static StaticSemaphore_t mutexBlocks[MUTEX_COUNT];
+
+TaskHandle_t RtosResources::taskHandles[TASK_COUNT] = {};
+QueueHandle_t RtosResources::queueHandles[QUEUE_COUNT] = {};
+SemaphoreHandle_t RtosResources::mutexHandles[MUTEX_COUNT] = {};
+
+TaskHandle_t RtosResources::createTask(TaskId id, TaskFunction_t function, void* parameter) {
+    size_t index = static_cast<size_t>(id);
+    if (index >= TASK_COUNT) return nullptr;
+    if (taskHandles[index]) return taskHandles[index];
+
+    const TaskSpec& spec = TASK_TABLE[index];
+    int8_t core = getConfiguredCore(id);
+    taskHandles[index] = xTaskCreateStaticPinnedToCore(function, spec.name, spec.stackBytes, parameter,
+                                                       spec.priority,
+                                                       taskStacks + RtosBudget::stackOffset(index),
+                                                       &taskBlocks[index],
+                                                       core == TASK_CORE_ANY ? tskNO_AFFINITY : core);
+    if (!taskHandles[index]) {
+        Logger::error(makeFixedString<48>("Failed to create task %s", spec.name).c_str());
+    } else {
+        Logger::info(makeFixedString<64>("Task %s started, core %s", spec.name,
+                                         core == TASK_CORE_ANY ? "any" : core == 0 ? "0" : "1").c_str());
+    }
+    return taskHandles[index];
+}
+
+int8_t RtosResources::getConfiguredCore(TaskId id) {
+    size_t index = static_cast<size_t>(id);
+    if (index >= TASK_COUNT) return TASK_CORE_ANY;
+    return PreferencesManager::getTaskCore(static_cast<uint8_t>(index), TASK_TABLE[index].core);
+}
+
+int8_t RtosResources::getPinnedCore(TaskId id) {
+    size_t index = static_cast<size_t>(id);
+    // A task that has deleted itself (NetBoot) is no longer pinned anywhere
+    if (index >= TASK_COUNT || !taskHandles[index] || eTaskGetState(taskHandles[index]) == eDeleted) {
+        return TASK_CORE_ANY;
+    }
+    BaseType_t core = xTaskGetAffinity(taskHandles[index]);
+    return core == tskNO_AFFINITY ? TASK_CORE_ANY : static_cast<int8_t>(core);
+}
+
+TaskId RtosResources::taskIdFromName(const char* name, bool& found) {
+    for (size_t i = 0; i < TASK_COUNT; i++) {
+        if (name && strcmp(name, TASK_TABLE[i].name) == 0) {
+            found = true;
+            return static_cast<TaskId>(i);
+        }
+    }
+    found = false;
+    return TaskId::COUNT;
+}
+
+QueueHandle_t RtosResources::createQueue(QueueId id) {
+    size_t index = static_cast<size_t>(id);
+    if (index >= QUEUE_COUNT) return nullptr;
+    if (queueHandles[index]) return queueHandles[index];
+
+    const QueueSpec& spec = QUEUE_TABLE[index];
+    queueHandles[index] = xQueueCreateStatic(spec.length, spec.itemSize,
+                                             queueStorage + RtosBudget::queueOffset(index),
+                                             &queueBlocks[index]);
+    return queueHandles[index];
+}
+
+SemaphoreHandle_t RtosResources::createMutex(MutexId id) {
+    size_t index = static_cast<size_t>(id);
+    if (index >= MUTEX_COUNT) return nullptr;
+    if (!mutexHandles[index]) {
+        mutexHandles[index] = xSemaphoreCreateMutexStatic(&mutexBlocks[index]);
+    }
+    return mutexHandles[index];
+}
+
+void RtosResources::logBudget() {
+    Logger::info(makeFixedString<128>(
+        "Static RTOS memory: %u of %u bytes (stacks %u, queues %u, control blocks %u)",
+        static_cast<unsigned>(RtosBudget::TOTAL_BYTES),
+        static_cast<unsigned>(RTOS_STATIC_RAM_BUDGET),
+        static_cast<unsigned>(RtosBudget::STACK_BYTES),
+        static_cast<unsigned>(RtosBudget::QUEUE_BYTES),
+        static_cast<unsigned>(RtosBudget::CONTROL_BLOCK_BYTES)).c_str());
+
+    for (size_t i = 0; i < TASK_COUNT; i++) {
+        const TaskSpec& spec = TASK_TABLE[i];
+        // A finished task's TCB is reused memory; only report live tasks
+        if (taskHandles[i] && eTaskGetState(taskHandles[i]) != eDeleted) {
+            Logger::info(makeFixedString<96>(" - task %-12s stack %5u bytes, %5u never used",
+                                             spec.name, static_cast<unsigned>(spec.stackBytes),
+                                             static_cast<unsigned>(uxTaskGetStackHighWaterMark(taskHandles[i]))).c_str());
+        } else {
+            Logger::info(makeFixedString<96>(" - task %-12s stack %5u bytes, not running",
+                                             spec.name, static_cast<unsigned>(spec.stackBytes)).c_str());
+        }
+    }
+    for (size_t i = 0; i < QUEUE_COUNT; i++) {
+        const QueueSpec& spec = QUEUE_TABLE[i];
+        Logger::info(makeFixedString<96>(" - queue %-10s %3u x %4u bytes%s",
+                                         spec.name, spec.length, spec.itemSize,
+                                         queueHandles[i] ? "" : " (not created)").c_str());
+    }
+    Logger::info(makeFixedString<64>(" - %u mutexes", static_cast<unsigned>(MUTEX_COUNT)).c_str());
+    Logger::info(makeFixedString<96>("Heap after init: %u bytes free, largest block %u bytes",
+                                     static_cast<unsigned>(ESP.getFreeHeap()),
+                                     static_cast<unsigned>(ESP.getMaxAllocHeap())).c_str());
+}
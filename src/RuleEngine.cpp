@@ -0,0 +1,449 @@
+// RuleEngine.cpp
+// Compiler and interpreter for automation rule conditions. The compiler is
+// a small recursive descent parser that emits postfix bytecode directly;
+// the interpreter is a fixed-size stack machine.
+
+#include "RuleEngine.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static_assert(RULE_MAX_RULES <= 8, "RuleEngine::releaseMask holds one bit per rule");
+
+namespace {
+
+class Parser {
+public:
+    Parser(const char* source, CompiledRule& out, char* error, size_t errorSize)
+        : start(source), p(source), out(out), error(error), errorSize(errorSize), depth(0), nesting(0) {
+        memset(&out, 0, sizeof(out));
+    }
+
+    bool parse() {
+        if (!parseOr()) return false;
+        skipSpaces();
+        if (*p != '\0') return fail("Unexpected input");
+        if (depth != 1) return fail("Expression must produce a single value");
+        return emit(RuleOp::END, 0);
+    }
+
+private:
+    const char* start;
+    const char* p;
+    CompiledRule& out;
+    char* error;
+    size_t errorSize;
+    uint8_t depth;
+    uint8_t nesting;  // Open parentheses, calls and unary operators, bounds recursion
+
+    bool fail(const char* message) {
+        if (error && errorSize > 0) {
+            snprintf(error, errorSize, "%s at position %d", message, static_cast<int>(p - start));
+        }
+        return false;
+    }
+
+    void skipSpaces() {
+        while (*p && isspace(static_cast<unsigned char>(*p))) p++;
+    }
+
+    bool match(const char* token) {
+        skipSpaces();
+        size_t length = strlen(token);
+        if (strncmp(p, token, length) == 0) {
+            p += length;
+            return true;
+        }
+        return false;
+    }
+
+    bool expect(const char* token) {
+        return match(token) ? true : fail(token[0] == ')' ? "Expected ')'" : "Expected ','");
+    }
+
+    // Every nested construct recurses through the whole precedence chain,
+    // so its depth is bounded to keep the parser off small task stacks
+    bool enter() {
+        if (nesting >= RULE_MAX_NESTING) return fail("Expression too deeply nested");
+        nesting++;
+        return true;
+    }
+
+    bool leave(bool ok) {
+        nesting--;
+        return ok;
+    }
+
+    // Append an opcode and track the resulting stack depth
+    bool emit(RuleOp op, int stackDelta) {
+        if (static_cast<size_t>(out.codeLength) + 1 > RULE_MAX_CODE) return fail("Expression too long");
+        out.code[out.codeLength++] = static_cast<uint8_t>(op);
+        return adjustDepth(stackDelta);
+    }
+
+    bool adjustDepth(int stackDelta) {
+        int newDepth = depth + stackDelta;
+        if (newDepth > static_cast<int>(RULE_MAX_STACK)) return fail("Expression too deeply nested");
+        depth = static_cast<uint8_t>(newDepth);
+        if (depth > out.maxStack) out.maxStack = depth;
+        return true;
+    }
+
+    bool emitConst(float value) {
+        // Keep one byte in reserve for the END opcode
+        if (out.codeLength + 1 + sizeof(float) + 1 > RULE_MAX_CODE) return fail("Expression too long");
+        out.code[out.codeLength++] = static_cast<uint8_t>(RuleOp::CONST);
+        memcpy(&out.code[out.codeLength], &value, sizeof(float));
+        out.codeLength += sizeof(float);
+        return adjustDepth(1);
+    }
+
+    bool emitInput(const uint8_t* address) {
+        uint8_t index = 0;
+        while (index < out.inputCount && memcmp(out.inputs[index], address, 8) != 0) {
+            index++;
+        }
+        if (index == out.inputCount) {
+            if (out.inputCount >= RULE_MAX_INPUTS) return fail("Too many sensors in rule");
+            memcpy(out.inputs[out.inputCount++], address, 8);
+        }
+
+        if (static_cast<size_t>(out.codeLength) + 2 + 1 > RULE_MAX_CODE) return fail("Expression too long");
+        out.code[out.codeLength++] = static_cast<uint8_t>(RuleOp::INPUT);
+        out.code[out.codeLength++] = index;
+        return adjustDepth(1);
+    }
+
+    bool parseOr() {
+        if (!parseAnd()) return false;
+        while (match("||")) {
+            if (!parseAnd() || !emit(RuleOp::OR, -1)) return false;
+        }
+        return true;
+    }
+
+    bool parseAnd() {
+        if (!parseComparison()) return false;
+        while (match("&&")) {
+            if (!parseComparison() || !emit(RuleOp::AND, -1)) return false;
+        }
+        return true;
+    }
+
+    bool parseComparison() {
+        if (!parseAdditive()) return false;
+        while (true) {
+            RuleOp op;
+            if (match(">=")) op = RuleOp::GE;
+            else if (match("<=")) op = RuleOp::LE;
+            else if (match("==")) op = RuleOp::EQ;
+            else if (match("!=")) op = RuleOp::NE;
+            else if (match(">")) op = RuleOp::GT;
+            else if (match("<")) op = RuleOp::LT;
+            else return true;
+
+            if (!parseAdditive() || !emit(op, -1)) return false;
+        }
+    }
+
+    bool parseAdditive() {
+        if (!parseTerm()) return false;
+        while (true) {
+            RuleOp op;
+            if (match("+")) op = RuleOp::ADD;
+            else if (match("-")) op = RuleOp::SUB;
+            else return true;
+
+            if (!parseTerm() || !emit(op, -1)) return false;
+        }
+    }
+
+    bool parseTerm() {
+        if (!parseUnary()) return false;
+        while (true) {
+            RuleOp op;
+            if (match("*")) op = RuleOp::MUL;
+            else if (match("/")) op = RuleOp::DIV;
+            else return true;
+
+            if (!parseUnary() || !emit(op, -1)) return false;
+        }
+    }
+
+    bool parseUnary() {
+        if (match("-")) {
+            return enter() && leave(parseUnary()) && emit(RuleOp::NEG, 0);
+        }
+        if (match("!")) {
+            return enter() && leave(parseUnary()) && emit(RuleOp::NOT, 0);
+        }
+        return parsePrimary();
+    }
+
+    bool parsePrimary() {
+        skipSpaces();
+
+        if (match("(")) {
+            return enter() && leave(parseOr() && expect(")"));
+        }
+
+        if (isdigit(static_cast<unsigned char>(*p)) || *p == '.') {
+            char* end = nullptr;
+            float value = strtof(p, &end);
+            if (end == p) return fail("Invalid number");
+            p = end;
+            return emitConst(value);
+        }
+
+        if (match("T(")) {
+            skipSpaces();
+            uint8_t address[8];
+            for (int i = 0; i < 8; i++) {
+                if (!isxdigit(static_cast<unsigned char>(p[0])) ||
+                    !isxdigit(static_cast<unsigned char>(p[1]))) {
+                    return fail("Expected 16 hex digit sensor address");
+                }
+                char byte[3] = {p[0], p[1], '\0'};
+                address[i] = static_cast<uint8_t>(strtol(byte, nullptr, 16));
+                p += 2;
+            }
+            return emitInput(address) && expect(")");
+        }
+
+        if (match("abs(")) {
+            return enter() && leave(parseOr() && expect(")")) && emit(RuleOp::ABS, 0);
+        }
+
+        bool isMin = match("min(");
+        if (isMin || match("max(")) {
+            return enter() && leave(parseOr() && expect(",") && parseOr() && expect(")")) &&
+                   emit(isMin ? RuleOp::MIN : RuleOp::MAX, -1);
+        }
+
+        return fail("Expected value");
+    }
+};
+
+}  // namespace
+
+bool RuleCompiler::compile(const char* source, CompiledRule& out, char* error, size_t errorSize) {
+    if (!source) {
+        if (error && errorSize > 0) snprintf(error, errorSize, "Empty condition");
+        return false;
+    }
+    Parser parser(source, out, error, errorSize);
+    return parser.parse();
+}
+
+bool RuleCompiler::evaluate(const CompiledRule& rule, const float* inputs, float& result) {
+    float stack[RULE_MAX_STACK];
+    uint8_t sp = 0;
+    uint8_t pc = 0;
+
+    while (pc < rule.codeLength) {
+        RuleOp op = static_cast<RuleOp>(rule.code[pc++]);
+
+        if (op == RuleOp::END) {
+            if (sp != 1) return false;
+            result = stack[0];
+            return true;
+        }
+
+        if (op == RuleOp::CONST || op == RuleOp::INPUT) {
+            if (sp >= RULE_MAX_STACK) return false;
+            if (op == RuleOp::CONST) {
+                memcpy(&stack[sp++], &rule.code[pc], sizeof(float));
+                pc += sizeof(float);
+            } else {
+                uint8_t index = rule.code[pc++];
+                if (index >= rule.inputCount) return false;
+                stack[sp++] = inputs[index];
+            }
+            continue;
+        }
+
+        // Unary operators
+        if (op == RuleOp::NEG || op == RuleOp::NOT || op == RuleOp::ABS) {
+            if (sp < 1) return false;
+            float& a = stack[sp - 1];
+            if (op == RuleOp::NEG) a = -a;
+            else if (op == RuleOp::NOT) a = (a == 0.0f) ? 1.0f : 0.0f;
+            else a = a < 0.0f ? -a : a;
+            continue;
+        }
+
+        // Binary operators
+        if (sp < 2) return false;
+        float b = stack[--sp];
+        float& a = stack[sp - 1];
+        switch (op) {
+            case RuleOp::ADD: a = a + b; break;
+            case RuleOp::SUB: a = a - b; break;
+            case RuleOp::MUL: a = a * b; break;
+            case RuleOp::DIV: a = (b == 0.0f) ? 0.0f : a / b; break;
+            case RuleOp::GT:  a = (a > b) ? 1.0f : 0.0f; break;
+            case RuleOp::GE:  a = (a >= b) ? 1.0f : 0.0f; break;
+            case RuleOp::LT:  a = (a < b) ? 1.0f : 0.0f; break;
+            case RuleOp::LE:  a = (a <= b) ? 1.0f : 0.0f; break;
+            case RuleOp::EQ:  a = (a == b) ? 1.0f : 0.0f; break;
+            case RuleOp::NE:  a = (a != b) ? 1.0f : 0.0f; break;
+            case RuleOp::AND: a = (a != 0.0f && b != 0.0f) ? 1.0f : 0.0f; break;
+            case RuleOp::OR:  a = (a != 0.0f || b != 0.0f) ? 1.0f : 0.0f; break;
+            case RuleOp::MIN: a = (b < a) ? b : a; break;
+            case RuleOp::MAX: a = (b > a) ? b : a; break;
+            default: return false;  // Unknown opcode
+        }
+    }
+
+    return false;  // Missing END
+}
+
+RuleEngine::RuleEngine()
+    : releaseMask(0)
+    , ruleCount(0)
+    , microsClock(nullptr) {
+    clear();
+}
+
+void RuleEngine::clear() {
+    memset(rules, 0, sizeof(rules));
+    memset(releases, 0, sizeof(releases));
+    releaseMask = 0;
+    ruleCount = 0;
+}
+
+bool RuleEngine::setRule(uint8_t ruleId, const RuleDefinition& definition,
+                         char* error, size_t errorSize) {
+    if (ruleId >= RULE_MAX_RULES) {
+        if (error && errorSize > 0) snprintf(error, errorSize, "Invalid rule id");
+        return false;
+    }
+
+    RuleSlot& slot = rules[ruleId];
+    CompiledRule program;
+    bool compiled = false;
+    if (definition.enabled) {
+        if (definition.relay > 1) {
+            if (error && errorSize > 0) snprintf(error, errorSize, "Invalid relay");
+        } else if (definition.holdSeconds > RULE_MAX_HOLD_SECONDS) {
+            if (error && errorSize > 0) snprintf(error, errorSize, "Invalid hold time");
+        } else {
+            compiled = RuleCompiler::compile(definition.condition, program, error, errorSize);
+        }
+    }
+
+    // Reloading an unchanged rule must not lose its hold timer or active state
+    if (compiled && slot.enabled &&
+        memcmp(&program, &slot.program, sizeof(program)) == 0 &&
+        slot.relay == definition.relay &&
+        slot.action == definition.action &&
+        slot.holdMs == definition.holdSeconds * 1000) {
+        return true;
+    }
+
+    // The rule being replaced no longer holds the relay; hand it back
+    if (slot.enabled && slot.stats.active) {
+        releases[ruleId].relay = slot.relay;
+        releases[ruleId].state = !slot.action;
+        releaseMask |= 1 << ruleId;
+    }
+
+    bool wasEnabled = slot.enabled;
+    memset(&slot, 0, sizeof(slot));
+
+    if (compiled) {
+        slot.enabled = true;
+        slot.program = program;
+        slot.relay = definition.relay;
+        slot.action = definition.action;
+        slot.holdMs = definition.holdSeconds * 1000;
+    }
+
+    if (wasEnabled && !slot.enabled) ruleCount--;
+    if (!wasEnabled && slot.enabled) ruleCount++;
+    return slot.enabled || !definition.enabled;
+}
+
+void RuleEngine::updateSensor(const uint8_t* address, float value, bool valid, uint32_t now) {
+    for (auto& slot : rules) {
+        if (!slot.enabled) continue;
+
+        bool changed = false;
+        for (uint8_t i = 0; i < slot.program.inputCount; i++) {
+            if (memcmp(slot.program.inputs[i], address, 8) != 0) continue;
+
+            uint8_t bit = 1 << i;
+            bool wasValid = (slot.validMask & bit) != 0;
+            if (wasValid != valid || (valid && slot.values[i] != value)) {
+                slot.values[i] = value;
+                slot.validMask = valid ? (slot.validMask | bit) : (slot.validMask & ~bit);
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            evaluateRule(slot, now);
+        }
+    }
+}
+
+void RuleEngine::evaluateRule(RuleSlot& slot, uint32_t now) {
+    bool condition = false;
+    uint8_t allInputs = (1 << slot.program.inputCount) - 1;
+
+    // A rule with a missing input is never considered true
+    if (slot.validMask == allInputs) {
+        uint32_t start = microsClock ? microsClock() : 0;
+
+        float result = 0.0f;
+        condition = RuleCompiler::evaluate(slot.program, slot.values, result) && result != 0.0f;
+
+        slot.stats.evaluations++;
+        if (microsClock) {
+            uint32_t duration = microsClock() - start;
+            slot.stats.lastEvalMicros = duration;
+            if (duration > slot.stats.maxEvalMicros) {
+                slot.stats.maxEvalMicros = duration;
+            }
+        }
+    }
+
+    if (condition && !slot.condition) {
+        slot.conditionSince = now;
+    }
+    slot.condition = condition;
+    slot.stats.condition = condition;
+}
+
+void RuleEngine::poll(uint32_t now, ActionHandler handler, void* context) {
+    // Releases go first so a replacement rule acting on the same relay wins
+    for (uint8_t id = 0; releaseMask != 0 && id < RULE_MAX_RULES; id++) {
+        if (!(releaseMask & (1 << id))) continue;
+        releaseMask &= ~(1 << id);
+        if (handler) handler(releases[id].relay, releases[id].state, id, context);
+    }
+
+    for (uint8_t id = 0; id < RULE_MAX_RULES; id++) {
+        RuleSlot& slot = rules[id];
+        if (!slot.enabled) continue;
+
+        if (slot.condition && !slot.stats.active && now - slot.conditionSince >= slot.holdMs) {
+            slot.stats.active = true;
+            slot.stats.triggers++;
+            if (handler) handler(slot.relay, slot.action, id, context);
+        } else if (!slot.condition && slot.stats.active) {
+            slot.stats.active = false;
+            slot.stats.triggers++;
+            if (handler) handler(slot.relay, !slot.action, id, context);
+        }
+    }
+}
+
+bool RuleEngine::getStats(uint8_t ruleId, RuleStats& stats) const {
+    if (ruleId >= RULE_MAX_RULES || !rules[ruleId].enabled) {
+        return false;
+    }
+    stats = rules[ruleId].stats;
+    return true;
+}
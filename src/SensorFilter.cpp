@@ -0,0 +1,138 @@
+// SensorFilter.cpp
+// Fixed-point processing chain for raw DS18B20 readings. Every stage keeps a
+// constant amount of state so the chain can run for each sensor in every
+// read cycle without allocation.
+
+#include "SensorFilter.h"
+
+FilterConfig SensorFilter::defaultConfig() {
+    FilterConfig config;
+    config.medianEnabled = true;
+    config.smoothing = SmoothingMode::NONE;
+    config.emaAlpha = 64;          // 0.25 weight for new samples
+    config.kalmanQ = 4;            // ~0.016 °C process noise
+    config.kalmanR = 64;           // ~0.06 °C measurement noise
+    config.maxRatePerSec = 0;      // Rate limiting disabled
+    return config;
+}
+
+SensorCalibration SensorFilter::defaultCalibration() {
+    SensorCalibration calibration;
+    calibration.offset = 0;
+    calibration.gain = GAIN_ONE;
+    return calibration;
+}
+
+void SensorFilter::reset(FilterState& state) {
+    state.window[0] = state.window[1] = state.window[2] = 0;
+    state.windowCount = 0;
+    state.windowPos = 0;
+    state.primed = false;
+    state.limited = 0;
+    state.lastSampleTime = 0;
+    state.smoothed = 0;
+    state.kalmanP = 0;
+}
+
+int32_t SensorFilter::process(const FilterConfig& config,
+                              const SensorCalibration& calibration,
+                              FilterState& state,
+                              int32_t raw,
+                              uint32_t now) {
+    int32_t value = applyCalibration(calibration, raw);
+
+    if (config.medianEnabled) {
+        value = applyMedian(state, value);
+    }
+
+    value = applyRateLimit(config, state, value, now);
+    value = applySmoothing(config, state, value);
+
+    state.primed = true;
+    state.lastSampleTime = now;
+    return value;
+}
+
+int32_t SensorFilter::applyCalibration(const SensorCalibration& calibration, int32_t raw) {
+    if (calibration.gain == GAIN_ONE) {
+        return raw + calibration.offset;
+    }
+
+    // Round to nearest while scaling back from Q16
+    int64_t scaled = static_cast<int64_t>(raw) * calibration.gain;
+    scaled += (scaled >= 0) ? (GAIN_ONE / 2) : -static_cast<int64_t>(GAIN_ONE / 2);
+    return static_cast<int32_t>(scaled / GAIN_ONE) + calibration.offset;
+}
+
+int32_t SensorFilter::applyMedian(FilterState& state, int32_t value) {
+    state.window[state.windowPos] = value;
+    state.windowPos = (state.windowPos + 1) % 3;
+    if (state.windowCount < 3) {
+        state.windowCount++;
+    }
+    if (state.windowCount < 3) {
+        return value;  // Not enough history yet - pass through
+    }
+
+    int32_t a = state.window[0];
+    int32_t b = state.window[1];
+    int32_t c = state.window[2];
+
+    if ((a <= b && b <= c) || (c <= b && b <= a)) return b;
+    if ((b <= a && a <= c) || (c <= a && a <= b)) return a;
+    return c;
+}
+
+int32_t SensorFilter::applyRateLimit(const FilterConfig& config, FilterState& state,
+                                     int32_t value, uint32_t now) {
+    if (config.maxRatePerSec == 0 || !state.primed) {
+        state.limited = value;
+        return value;
+    }
+
+    uint32_t elapsed = now - state.lastSampleTime;
+    int64_t maxStep = (static_cast<int64_t>(config.maxRatePerSec) * elapsed) / 1000;
+    int64_t delta = static_cast<int64_t>(value) - state.limited;
+
+    if (delta > maxStep) {
+        delta = maxStep;
+    } else if (delta < -maxStep) {
+        delta = -maxStep;
+    }
+
+    state.limited += static_cast<int32_t>(delta);
+    return state.limited;
+}
+
+int32_t SensorFilter::applySmoothing(const FilterConfig& config, FilterState& state, int32_t value) {
+    int64_t sample = static_cast<int64_t>(value) * 256;  // Q8
+
+    if (config.smoothing == SmoothingMode::NONE) {
+        state.smoothed = static_cast<int32_t>(sample);
+        return value;
+    }
+
+    if (!state.primed) {
+        // Seed the filter with the first sample
+        state.smoothed = static_cast<int32_t>(sample);
+        state.kalmanP = config.kalmanR;
+        return value;
+    }
+
+    if (config.smoothing == SmoothingMode::EMA) {
+        int64_t delta = sample - state.smoothed;
+        state.smoothed += static_cast<int32_t>((delta * config.emaAlpha) / 256);
+    } else {
+        // Scalar Kalman filter with a constant-value process model
+        uint64_t p = static_cast<uint64_t>(state.kalmanP) + config.kalmanQ;
+        uint64_t denominator = p + config.kalmanR;
+        uint64_t gain = denominator ? (p << 16) / denominator : GAIN_ONE;  // Q16
+
+        int64_t innovation = sample - state.smoothed;
+        state.smoothed += static_cast<int32_t>((innovation * static_cast<int64_t>(gain)) / 65536);
+        state.kalmanP = static_cast<uint32_t>((p * (GAIN_ONE - gain)) >> 16);
+    }
+
+    // Round back from Q8 to raw units
+    return (state.smoothed + 128) >> 8;
+}
@@ -0,0 +1,83 @@
+// SensorSlots.cpp
+// ROM-to-slot assignment shared by the Modbus and BACnet servers.
+
+#include "SensorSlots.h"
+#include <string.h>
+
+namespace {
+    bool isZeroAddress(const uint8_t* address) {
+        for (uint8_t i = 0; i < 8; i++) {
+            if (address[i]) return false;
+        }
+        return true;
+    }
+}
+
+SensorSlots::SensorSlots()
+    : assigned(false) {
+    memset(slots, 0, sizeof(slots));
+    memset(listed, 0, sizeof(listed));
+}
+
+void SensorSlots::set(const uint8_t (*addresses)[8], size_t count) {
+    memset(slots, 0, sizeof(slots));
+    for (size_t i = 0; i < count && i < CAPACITY; i++) {
+        memcpy(slots[i], addresses[i], 8);
+    }
+}
+
+size_t SensorSlots::get(uint8_t (*addresses)[8], size_t capacity) const {
+    // Trailing free slots are left out; free slots in between keep their place
+    size_t count = 0;
+    for (size_t i = 0; i < CAPACITY && i < capacity; i++) {
+        memcpy(addresses[i], slots[i], 8);
+        if (!isZeroAddress(slots[i])) count = i + 1;
+    }
+    return count;
+}
+
+void SensorSlots::beginUpdate() {
+    memset(listed, 0, sizeof(listed));
+    assigned = false;
+}
+
+// Sensors that already own a slot are marked first, so a new ROM never takes
+// the slot of a sensor that is still listed
+void SensorSlots::markListed(const uint8_t* address) {
+    int slot = find(address);
+    if (slot >= 0) listed[slot] = true;
+}
+
+// A free slot if there is one, otherwise the first slot whose sensor is gone
+int SensorSlots::slotFor(const uint8_t* address) {
+    int slot = find(address);
+    if (slot >= 0) {
+        listed[slot] = true;
+        return slot;
+    }
+
+    for (size_t i = 0; i < CAPACITY && slot < 0; i++) {
+        if (isZeroAddress(slots[i])) slot = static_cast<int>(i);
+    }
+    for (size_t i = 0; i < CAPACITY && slot < 0; i++) {
+        if (!listed[i]) slot = static_cast<int>(i);
+    }
+    if (slot >= 0) {
+        memcpy(slots[slot], address, 8);
+        listed[slot] = true;
+        assigned = true;
+    }
+    return slot;
+}
+
+int SensorSlots::find(const uint8_t* address) const {
+    if (isZeroAddress(address)) return -1;
+    for (size_t i = 0; i < CAPACITY; i++) {
+        if (memcmp(slots[i], address, 8) == 0) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool SensorSlots::isFree(size_t slot) const {
+    return slot >= CAPACITY || isZeroAddress(slots[slot]);
+}
@@ -0,0 +1,79 @@
+// SensorStatistics.cpp
+// Tumbling-window rollups with Welford's online mean/variance.
+
+#include "SensorStatistics.h"
+#include <math.h>
+#include <string.h>
+
+static const uint32_t WINDOW_DURATIONS[STATS_WINDOW_COUNT] = {
+    60UL * 1000UL,          // 1 minute
+    60UL * 60UL * 1000UL,   // 1 hour
+    24UL * 3600UL * 1000UL  // 24 hours
+};
+
+static const char* const WINDOW_NAMES[STATS_WINDOW_COUNT] = {"1m", "1h", "24h"};
+
+static void startWindow(RollupWindow& window, uint32_t startTime) {
+    memset(&window, 0, sizeof(window));
+    window.startTime = startTime;
+}
+
+void RollupStats::reset(SensorStatistics& stats) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint8_t RollupStats::addSample(SensorStatistics& stats, float value, uint32_t now) {
+    uint8_t completedMask = 0;
+
+    for (uint8_t i = 0; i < STATS_WINDOW_COUNT; i++) {
+        RollupWindow& window = stats.current[i];
+        uint32_t duration = WINDOW_DURATIONS[i];
+
+        if (window.count == 0 && window.startTime == 0) {
+            // First sample ever - open the window here
+            startWindow(window, now);
+        } else if (now - window.startTime >= duration) {
+            if (window.count > 0) {
+                stats.completed[i] = window;
+                completedMask |= 1 << i;
+            }
+            // Keep windows aligned to the original grid, skipping empty periods
+            uint32_t elapsed = now - window.startTime;
+            startWindow(window, window.startTime + (elapsed / duration) * duration);
+        }
+
+        // Welford update
+        window.count++;
+        float delta = value - window.mean;
+        window.mean += delta / window.count;
+        window.m2 += delta * (value - window.mean);
+
+        if (window.count == 1 || value < window.min) {
+            window.min = value;
+            window.minTime = now;
+        }
+        if (window.count == 1 || value > window.max) {
+            window.max = value;
+            window.maxTime = now;
+        }
+    }
+
+    stats.pendingMask |= completedMask;
+    return completedMask;
+}
+
+float RollupStats::variance(const RollupWindow& window) {
+    return window.count > 1 ? window.m2 / (window.count - 1) : 0.0f;
+}
+
+float RollupStats::stddev(const RollupWindow& window) {
+    return sqrtf(variance(window));
+}
+
+uint32_t RollupStats::windowDuration(StatsWindow window) {
+    return WINDOW_DURATIONS[static_cast<uint8_t>(window)];
+}
+
+const char* RollupStats::windowName(StatsWindow window) {
+    return WINDOW_NAMES[static_cast<uint8_t>(window)];
+}
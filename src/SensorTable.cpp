@@ -0,0 +1,80 @@
+// SensorTable.cpp
+// Fixed-capacity hot/cold sensor storage. Insertion and removal shift the
+// entries behind them, which only happens when a scan or a configuration
+// change alters the sensor set, never in the read cycle.
+
+#include "SensorTable.h"
+#include <string.h>
+
+SensorTable::SensorTable()
+    : count(0)
+    , physical(0) {
+    memset(hotEntries, 0, sizeof(hotEntries));
+    memset(coldEntries, 0, sizeof(coldEntries));
+}
+
+int SensorTable::find(const uint8_t* address) const {
+    for (size_t i = 0; i < count; i++) {
+        if (memcmp(hotEntries[i].address, address, 8) == 0) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int SensorTable::add(const uint8_t* address, bool isVirtual) {
+    if (isFull()) return -1;
+
+    size_t index = count;
+    if (!isVirtual) {
+        // Make room in front of the virtual entries
+        for (size_t i = count; i > physical; i--) {
+            moveEntry(i - 1, i);
+        }
+        index = physical++;
+    }
+    count++;
+    reset(index, address, isVirtual);
+    return static_cast<int>(index);
+}
+
+void SensorTable::remove(size_t index) {
+    if (index >= count) return;
+
+    if (!isVirtual(hotEntries[index])) physical--;
+    for (size_t i = index + 1; i < count; i++) {
+        moveEntry(i, i - 1);
+    }
+    count--;
+}
+
+void SensorTable::clear() {
+    count = 0;
+    physical = 0;
+}
+
+void SensorTable::reset(size_t index, const uint8_t* address, bool isVirtual) {
+    SensorHot& entry = hotEntries[index];
+    memcpy(entry.address, address, 8);
+    entry.temperature = NO_READING_C;
+    entry.readTime = 0;
+    entry.raw = NO_READING_RAW;
+    entry.flags = static_cast<uint8_t>(SensorHealth::ACTIVE) | (isVirtual ? FLAG_VIRTUAL : 0);
+    entry.consecutiveErrors = 0;
+
+    SensorCold& meta = coldEntries[index];
+    meta.lastValidReading = NO_READING_C;
+    meta.nextProbeTime = 0;
+    meta.offlineSince = 0;
+    meta.resolution = 0;
+    meta.probeFailures = 0;
+    meta.calibration = SensorFilter::defaultCalibration();
+    SensorFilter::reset(meta.filter);
+    AnomalyDetector::reset(meta.anomaly);
+    RollupStats::reset(meta.stats);
+}
+
+void SensorTable::moveEntry(size_t from, size_t to) {
+    hotEntries[to] = hotEntries[from];
+    coldEntries[to] = coldEntries[from];
+}
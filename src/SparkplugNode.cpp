@@ -0,0 +1,307 @@
+// SparkplugNode.cpp
+#include "SparkplugNode.h"
+#include <string.h>
+
+namespace {
+    const char NAMESPACE[] = "spBv1.0";
+
+    // Aliases: 1 is Node Control/Rebirth, relays follow from RELAY_ALIAS_BASE,
+    // and each sensor slot owns DEVICE_ALIAS_STRIDE aliases from DEVICE_ALIAS_BASE
+    constexpr uint64_t RELAY_ALIAS_BASE = 2;
+    constexpr uint64_t DEVICE_ALIAS_BASE = 16;
+    constexpr uint64_t DEVICE_ALIAS_STRIDE = 4;
+    static_assert(RELAY_ALIAS_BASE + SPARKPLUG_MAX_RELAYS <= DEVICE_ALIAS_BASE,
+                  "Relay aliases overlap the device aliases");
+
+    enum DeviceMetric : uint8_t {
+        METRIC_TEMPERATURE = 0,
+        METRIC_RAW_TEMPERATURE,
+        METRIC_STATUS
+    };
+
+    const char* const DEVICE_METRIC_NAMES[] = {"Temperature", "Raw Temperature", "Status"};
+
+    SparkplugMetric makeMetric(const char* name, uint64_t alias, SparkplugType type) {
+        SparkplugMetric metric;
+        memset(&metric, 0, sizeof(metric));
+        metric.name = name;
+        metric.alias = alias;
+        metric.type = type;
+        return metric;
+    }
+
+    SparkplugMetric floatMetric(const char* name, uint64_t alias, float value, bool valid) {
+        SparkplugMetric metric = makeMetric(name, alias, SparkplugType::FLOAT);
+        metric.floatValue = value;
+        metric.isNull = !valid;
+        return metric;
+    }
+
+    SparkplugMetric boolMetric(const char* name, uint64_t alias, bool value) {
+        SparkplugMetric metric = makeMetric(name, alias, SparkplugType::BOOLEAN);
+        metric.boolValue = value;
+        return metric;
+    }
+
+    SparkplugMetric stringMetric(const char* name, uint64_t alias, const char* value) {
+        SparkplugMetric metric = makeMetric(name, alias, SparkplugType::STRING);
+        metric.stringValue = value;
+        return metric;
+    }
+
+    bool sameStatus(const char* a, const char* b) {
+        return a == b || (a && b && strcmp(a, b) == 0);
+    }
+}
+
+SparkplugNode::SparkplugNode()
+    : publisher(nullptr)
+    , context(nullptr)
+    , devices()
+    , relayStates()
+    , relayCount(0)
+    , bdSeq(0)
+    , seq(0)
+    , rebirth(true) {
+}
+
+void SparkplugNode::begin(const char* groupId, const char* nodeId, Publisher publisher, void* context) {
+    this->groupId.assign(groupId);
+    this->nodeId.assign(nodeId);
+    this->publisher = publisher;
+    this->context = context;
+    ndeathTopic = topic("NDEATH", nullptr);
+    ncmdTopic = topic("NCMD", nullptr);
+    rebirth = true;
+}
+
+// spBv1.0/<group>/<type>/<node>[/<ROM>]
+TopicString SparkplugNode::topic(const char* type, const uint8_t* address) const {
+    TopicString result;
+    result.append(NAMESPACE).append('/').append(groupId).append('/').append(type).append('/').append(nodeId);
+    if (address) {
+        result.append('/').appendHex(address, 8);
+    }
+    return result;
+}
+
+size_t SparkplugNode::prepareDeath(const uint8_t*& payload) {
+    bdSeq = bdSeq % 255 + 1;
+
+    // No timestamp: the broker sends the will long after it was encoded
+    SparkplugPayload death(buffer, sizeof(buffer) - 1);
+    SparkplugMetric metric = makeMetric("bdSeq", 0, SparkplugType::INT64);
+    metric.longValue = bdSeq;
+    death.addMetric(metric);
+    buffer[death.size()] = '\0';
+    payload = death.data();
+    return death.size();
+}
+
+void SparkplugNode::handleCommand(const uint8_t* payload, size_t length) {
+    if (SparkplugPayload::requestsRebirth(payload, length, REBIRTH_ALIAS)) {
+        rebirth = true;
+    }
+}
+
+void SparkplugNode::sessionStarted() {
+    rebirth = true;
+}
+
+uint8_t SparkplugNode::nextSeq() {
+    uint8_t current = seq;
+    seq = static_cast<uint8_t>(seq + 1);
+    return current;
+}
+
+bool SparkplugNode::send(const char* type, const uint8_t* address, const SparkplugPayload& payload) {
+    if (payload.overflowed()) {
+        return false;
+    }
+    TopicString messageTopic = topic(type, address);
+    return publisher(messageTopic.c_str(), payload.data(), payload.size(), context);
+}
+
+uint64_t SparkplugNode::deviceAlias(size_t slot, uint8_t metric) {
+    return DEVICE_ALIAS_BASE + slot * DEVICE_ALIAS_STRIDE + metric;
+}
+
+bool SparkplugNode::update(const SparkplugSensorSample* sensors, size_t count,
+                           const bool* relays, uint8_t relayCount, uint64_t timestamp) {
+    if (!publisher) {
+        return false;
+    }
+    if (relayCount > SPARKPLUG_MAX_RELAYS) {
+        relayCount = SPARKPLUG_MAX_RELAYS;
+    }
+
+    bool ok;
+    if (rebirth) {
+        // A new NBIRTH voids every device; all are born again below
+        for (Device& device : devices) {
+            device.born = false;
+        }
+        ok = publishNodeBirth(relays, relayCount, timestamp);
+    } else {
+        ok = publishNodeData(relays, relayCount, timestamp);
+    }
+
+    for (Device& device : devices) {
+        device.seen = false;
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        Device* device = findDevice(sensors[i].address, true);
+        if (!device) continue;
+        device->seen = true;
+        ok = device->born ? publishDeviceData(*device, sensors[i], timestamp)
+                          : publishDeviceBirth(*device, sensors[i], timestamp);
+    }
+
+    // Sensors that went away; one never born since the last NBIRTH needs no DDEATH
+    for (Device& device : devices) {
+        if (!ok) break;
+        if (!device.inUse || device.seen) continue;
+        if (device.born) {
+            ok = publishDeviceDeath(device, timestamp);
+        }
+        device.inUse = false;
+    }
+
+    rebirth = !ok;
+    return ok;
+}
+
+bool SparkplugNode::publishNodeBirth(const bool* relays, uint8_t count, uint64_t timestamp) {
+    seq = 0;
+    SparkplugPayload birth(buffer, sizeof(buffer));
+    birth.addTimestamp(timestamp);
+
+    SparkplugMetric metric = makeMetric("bdSeq", 0, SparkplugType::INT64);
+    metric.longValue = bdSeq;
+    birth.addMetric(metric);
+    birth.addMetric(boolMetric("Node Control/Rebirth", REBIRTH_ALIAS, false));
+
+    for (uint8_t i = 0; i < count; i++) {
+        FixedString<16> name;
+        name.appendf("Relay %u", static_cast<unsigned>(i + 1));
+        birth.addMetric(boolMetric(name.c_str(), RELAY_ALIAS_BASE + i, relays[i]));
+        relayStates[i] = relays[i];
+    }
+    relayCount = count;
+
+    birth.addSeq(nextSeq());
+    return send("NBIRTH", nullptr, birth);
+}
+
+bool SparkplugNode::publishNodeData(const bool* relays, uint8_t count, uint64_t timestamp) {
+    SparkplugPayload data(buffer, sizeof(buffer));
+    data.addTimestamp(timestamp);
+
+    bool changed = false;
+    for (uint8_t i = 0; i < count && i < relayCount; i++) {
+        if (relays[i] == relayStates[i]) continue;
+        data.addMetric(boolMetric(nullptr, RELAY_ALIAS_BASE + i, relays[i]));
+        changed = true;
+    }
+    if (!changed) {
+        return true;
+    }
+
+    data.addSeq(nextSeq());
+    if (!send("NDATA", nullptr, data)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count && i < relayCount; i++) {
+        relayStates[i] = relays[i];
+    }
+    return true;
+}
+
+bool SparkplugNode::publishDeviceBirth(Device& device, const SparkplugSensorSample& sample, uint64_t timestamp) {
+    size_t slot = static_cast<size_t>(&device - devices);
+    SparkplugPayload birth(buffer, sizeof(buffer));
+    birth.addTimestamp(timestamp);
+    birth.addMetric(floatMetric(DEVICE_METRIC_NAMES[METRIC_TEMPERATURE], deviceAlias(slot, METRIC_TEMPERATURE),
+                                sample.temperature, sample.valid));
+    birth.addMetric(floatMetric(DEVICE_METRIC_NAMES[METRIC_RAW_TEMPERATURE],
+                                deviceAlias(slot, METRIC_RAW_TEMPERATURE), sample.rawTemperature, sample.valid));
+    birth.addMetric(stringMetric(DEVICE_METRIC_NAMES[METRIC_STATUS], deviceAlias(slot, METRIC_STATUS),
+                                 sample.status));
+    birth.addSeq(nextSeq());
+    if (!send("DBIRTH", device.address, birth)) {
+        return false;
+    }
+
+    device.born = true;
+    device.valid = sample.valid;
+    device.temperature = sample.temperature;
+    device.rawTemperature = sample.rawTemperature;
+    device.status = sample.status;
+    return true;
+}
+
+bool SparkplugNode::publishDeviceData(Device& device, const SparkplugSensorSample& sample, uint64_t timestamp) {
+    size_t slot = static_cast<size_t>(&device - devices);
+    SparkplugPayload data(buffer, sizeof(buffer));
+    data.addTimestamp(timestamp);
+
+    bool validChanged = sample.valid != device.valid;
+    bool changed = false;
+    if (validChanged || (sample.valid && sample.temperature != device.temperature)) {
+        data.addMetric(floatMetric(nullptr, deviceAlias(slot, METRIC_TEMPERATURE), sample.temperature, sample.valid));
+        changed = true;
+    }
+    if (validChanged || (sample.valid && sample.rawTemperature != device.rawTemperature)) {
+        data.addMetric(floatMetric(nullptr, deviceAlias(slot, METRIC_RAW_TEMPERATURE),
+                                   sample.rawTemperature, sample.valid));
+        changed = true;
+    }
+    if (!sameStatus(sample.status, device.status)) {
+        data.addMetric(stringMetric(nullptr, deviceAlias(slot, METRIC_STATUS), sample.status));
+        changed = true;
+    }
+    if (!changed) {
+        return true;
+    }
+
+    data.addSeq(nextSeq());
+    if (!send("DDATA", device.address, data)) {
+        return false;
+    }
+    device.valid = sample.valid;
+    device.temperature = sample.temperature;
+    device.rawTemperature = sample.rawTemperature;
+    device.status = sample.status;
+    return true;
+}
+
+bool SparkplugNode::publishDeviceDeath(Device& device, uint64_t timestamp) {
+    SparkplugPayload death(buffer, sizeof(buffer));
+    death.addTimestamp(timestamp);
+    death.addSeq(nextSeq());
+    if (!send("DDEATH", device.address, death)) {
+        return false;
+    }
+    device.born = false;
+    return true;
+}
+
+SparkplugNode::Device* SparkplugNode::findDevice(const uint8_t* address, bool allocate) {
+    Device* unused = nullptr;
+    for (Device& device : devices) {
+        if (!device.inUse) {
+            if (!unused) unused = &device;
+        } else if (memcmp(device.address, address, 8) == 0) {
+            return &device;
+        }
+    }
+    if (!allocate || !unused) {
+        return nullptr;
+    }
+
+    // Slots keep their aliases, so a freed slot is only reused by a new DBIRTH
+    memset(unused, 0, sizeof(*unused));
+    memcpy(unused->address, address, 8);
+    unused->inUse = true;
+    return unused;
+}
@@ -0,0 +1,226 @@
+// SparkplugPayload.cpp
+#include "SparkplugPayload.h"
+#include <string.h>
+
+namespace {
+    constexpr uint8_t WIRE_VARINT = 0;
+    constexpr uint8_t WIRE_FIXED64 = 1;
+    constexpr uint8_t WIRE_LENGTH = 2;
+    constexpr uint8_t WIRE_FIXED32 = 5;
+
+    // Payload fields
+    constexpr uint8_t PAYLOAD_TIMESTAMP = 1;
+    constexpr uint8_t PAYLOAD_METRICS = 2;
+    constexpr uint8_t PAYLOAD_SEQ = 3;
+
+    // Metric fields
+    constexpr uint8_t METRIC_NAME = 1;
+    constexpr uint8_t METRIC_ALIAS = 2;
+    constexpr uint8_t METRIC_DATATYPE = 4;
+    constexpr uint8_t METRIC_IS_NULL = 7;
+    constexpr uint8_t METRIC_LONG_VALUE = 11;
+    constexpr uint8_t METRIC_FLOAT_VALUE = 12;
+    constexpr uint8_t METRIC_BOOLEAN_VALUE = 14;
+    constexpr uint8_t METRIC_STRING_VALUE = 15;
+
+    const char REBIRTH_METRIC[] = "Node Control/Rebirth";
+
+    size_t varintSize(uint64_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    // Bounds-checked reader for the command decoder
+    struct Reader {
+        const uint8_t* p;
+        const uint8_t* end;
+
+        bool varint(uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64 && p < end; shift += 7) {
+                uint8_t byte = *p++;
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return true;
+            }
+            return false;
+        }
+
+        // Skips a field of the wire type; false on a malformed or unknown one
+        bool skip(uint8_t wireType) {
+            uint64_t value;
+            switch (wireType) {
+                case WIRE_VARINT:
+                    return varint(value);
+                case WIRE_FIXED64:
+                    if (end - p < 8) return false;
+                    p += 8;
+                    return true;
+                case WIRE_LENGTH:
+                    if (!varint(value) || value > static_cast<uint64_t>(end - p)) return false;
+                    p += value;
+                    return true;
+                case WIRE_FIXED32:
+                    if (end - p < 4) return false;
+                    p += 4;
+                    return true;
+            }
+            return false;
+        }
+    };
+
+    bool metricRequestsRebirth(Reader metric, uint64_t rebirthAlias) {
+        bool isRebirth = false;
+        bool value = false;
+        uint64_t key;
+        while (metric.p < metric.end && metric.varint(key)) {
+            uint8_t field = static_cast<uint8_t>(key >> 3);
+            uint8_t wireType = key & 0x07;
+            uint64_t number;
+            if (field == METRIC_NAME && wireType == WIRE_LENGTH) {
+                if (!metric.varint(number) || number > static_cast<uint64_t>(metric.end - metric.p)) return false;
+                isRebirth = number == sizeof(REBIRTH_METRIC) - 1 &&
+                            memcmp(metric.p, REBIRTH_METRIC, number) == 0;
+                metric.p += number;
+            } else if (field == METRIC_ALIAS && wireType == WIRE_VARINT) {
+                if (!metric.varint(number)) return false;
+                isRebirth = isRebirth || number == rebirthAlias;
+            } else if (field == METRIC_BOOLEAN_VALUE && wireType == WIRE_VARINT) {
+                if (!metric.varint(number)) return false;
+                value = number != 0;
+            } else if (!metric.skip(wireType)) {
+                return false;
+            }
+        }
+        return isRebirth && value;
+    }
+}
+
+SparkplugPayload::SparkplugPayload(uint8_t* buffer, size_t capacity)
+    : buffer(buffer)
+    , capacity(capacity)
+    , length(0)
+    , overflow(false) {
+}
+
+bool SparkplugPayload::reserve(size_t count) {
+    if (overflow || capacity - length < count) {
+        overflow = true;
+        return false;
+    }
+    return true;
+}
+
+void SparkplugPayload::writeVarint(uint64_t value) {
+    if (!reserve(varintSize(value))) return;
+    while (value >= 0x80) {
+        buffer[length++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = static_cast<uint8_t>(value);
+}
+
+void SparkplugPayload::writeTag(uint8_t field, uint8_t wireType) {
+    writeVarint(static_cast<uint64_t>(field) << 3 | wireType);
+}
+
+void SparkplugPayload::writeString(uint8_t field, const char* text) {
+    size_t count = strlen(text);
+    writeTag(field, WIRE_LENGTH);
+    writeVarint(count);
+    if (!reserve(count)) return;
+    memcpy(buffer + length, text, count);
+    length += count;
+}
+
+void SparkplugPayload::addTimestamp(uint64_t milliseconds) {
+    writeTag(PAYLOAD_TIMESTAMP, WIRE_VARINT);
+    writeVarint(milliseconds);
+}
+
+void SparkplugPayload::addSeq(uint64_t seq) {
+    writeTag(PAYLOAD_SEQ, WIRE_VARINT);
+    writeVarint(seq);
+}
+
+void SparkplugPayload::addMetric(const SparkplugMetric& metric) {
+    writeTag(PAYLOAD_METRICS, WIRE_LENGTH);
+    if (!reserve(1)) return;
+    size_t lengthAt = length++;
+    size_t start = length;
+
+    if (metric.name) writeString(METRIC_NAME, metric.name);
+    if (metric.alias) {
+        writeTag(METRIC_ALIAS, WIRE_VARINT);
+        writeVarint(metric.alias);
+    }
+    writeTag(METRIC_DATATYPE, WIRE_VARINT);
+    writeVarint(static_cast<uint8_t>(metric.type));
+    if (metric.isNull) {
+        writeTag(METRIC_IS_NULL, WIRE_VARINT);
+        writeVarint(1);
+    } else {
+        switch (metric.type) {
+            case SparkplugType::INT64:
+                writeTag(METRIC_LONG_VALUE, WIRE_VARINT);
+                writeVarint(static_cast<uint64_t>(metric.longValue));
+                break;
+            case SparkplugType::FLOAT: {
+                uint32_t bits;
+                memcpy(&bits, &metric.floatValue, sizeof(bits));
+                writeTag(METRIC_FLOAT_VALUE, WIRE_FIXED32);
+                if (!reserve(4)) return;
+                for (int shift = 0; shift < 32; shift += 8) {
+                    buffer[length++] = static_cast<uint8_t>(bits >> shift);
+                }
+                break;
+            }
+            case SparkplugType::BOOLEAN:
+                writeTag(METRIC_BOOLEAN_VALUE, WIRE_VARINT);
+                writeVarint(metric.boolValue ? 1 : 0);
+                break;
+            case SparkplugType::STRING:
+                writeString(METRIC_STRING_VALUE, metric.stringValue ? metric.stringValue : "");
+                break;
+        }
+    }
+    if (overflow) return;
+
+    // Widen the length prefix if the metric did not fit in one byte
+    size_t metricLength = length - start;
+    size_t extra = varintSize(metricLength) - 1;
+    if (extra > 0) {
+        if (!reserve(extra)) return;
+        memmove(buffer + start + extra, buffer + start, metricLength);
+        length += extra;
+    }
+    size_t at = lengthAt;
+    uint64_t value = metricLength;
+    while (value >= 0x80) {
+        buffer[at++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    buffer[at] = static_cast<uint8_t>(value);
+}
+
+bool SparkplugPayload::requestsRebirth(const uint8_t* payload, size_t length, uint64_t rebirthAlias) {
+    Reader reader = {payload, payload + length};
+    uint64_t key;
+    while (reader.p < reader.end && reader.varint(key)) {
+        uint8_t field = static_cast<uint8_t>(key >> 3);
+        uint8_t wireType = key & 0x07;
+        if (field == PAYLOAD_METRICS && wireType == WIRE_LENGTH) {
+            uint64_t size;
+            if (!reader.varint(size) || size > static_cast<uint64_t>(reader.end - reader.p)) return false;
+            Reader metric = {reader.p, reader.p + size};
+            if (metricRequestsRebirth(metric, rebirthAlias)) return true;
+            reader.p += size;
+        } else if (!reader.skip(wireType)) {
+            return false;
+        }
+    }
+    return false;
+}
@@ -1,6 +1,7 @@
 // SystemHealth.cpp
 #include "SystemHealth.h"
 #include "Logger.h"
+#include "RtosResources.h"
 #include <esp_heap_caps.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -10,7 +11,7 @@ SemaphoreHandle_t SystemHealth::metricsMutex = nullptr;
 uint32_t SystemHealth::lastUpdateTime = 0;
 
 void SystemHealth::init() {
-    metricsMutex = xSemaphoreCreateMutex();
+    metricsMutex = RtosResources::createMutex(MutexId::SYSTEM_HEALTH);
     metrics.minHeapSeen = ESP.getFreeHeap();
     metrics.watchdogNearMisses = 0;
     metrics.mqttReconnections = 0;
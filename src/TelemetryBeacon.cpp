@@ -0,0 +1,56 @@
+// TelemetryBeacon.cpp
+#include "TelemetryBeacon.h"
+#include <string.h>
+
+namespace {
+    uint8_t* putUint16(uint8_t* out, uint16_t value) {
+        out[0] = static_cast<uint8_t>(value >> 8);
+        out[1] = static_cast<uint8_t>(value);
+        return out + 2;
+    }
+
+    uint8_t* putUint32(uint8_t* out, uint32_t value) {
+        out[0] = static_cast<uint8_t>(value >> 24);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+        return out + 4;
+    }
+
+    // Virtual sensors have no bus reading; they report their computed value
+    int16_t rawValue(const SensorHot& sensor) {
+        if (!SensorTable::isVirtual(sensor)) return sensor.raw;
+        if (sensor.temperature == SensorTable::NO_READING_C) return SensorTable::NO_READING_RAW;
+
+        int32_t raw = SensorFilter::fromCelsius(sensor.temperature);
+        if (raw > INT16_MAX) return INT16_MAX;
+        if (raw < INT16_MIN + 1) return INT16_MIN + 1;
+        return static_cast<int16_t>(raw);
+    }
+}
+
+size_t TelemetryBeacon::encode(const BeaconHeader& header, const SensorHot* sensors, size_t count,
+                               uint8_t* out, size_t capacity) {
+    if (count > 255) count = 255;
+    size_t length = BEACON_HEADER_SIZE + count * BEACON_SENSOR_RECORD_SIZE;
+    if (length > capacity) return 0;
+
+    uint8_t* p = out;
+    *p++ = 'S';
+    *p++ = 'H';
+    *p++ = TELEMETRY_BEACON_VERSION;
+    *p++ = static_cast<uint8_t>(count);
+    p = putUint32(p, header.sequence);
+    p = putUint32(p, header.collectedAt);
+    p = putUint16(p, header.sendDelay);
+    *p++ = header.relayBits;
+    *p++ = header.flags;
+
+    for (size_t i = 0; i < count; i++) {
+        const SensorHot& sensor = sensors[i];
+        memcpy(p, sensor.address, 8);
+        p = putUint16(p + 8, static_cast<uint16_t>(rawValue(sensor)));
+        *p++ = sensor.flags;
+    }
+    return length;
+}
@@ -0,0 +1,144 @@
+// ThermostatController.cpp
+// Hysteresis and PID control loops for the relays. Outputs are recomputed
+// whenever a new reading arrives; the relay demand is derived from the
+// latest output on every control tick so PID time-proportioning and
+// minimum on/off times are honoured between readings.
+
+#include "ThermostatController.h"
+#include <string.h>
+
+ThermostatController::ThermostatController()
+    : config(defaultConfig())
+    , hysteresisState(false)
+    , integral(0.0f)
+    , previousInput(0.0f)
+    , previousTime(0)
+    , havePrevious(false)
+    , output(0.0f)
+    , inputValid(false) {
+}
+
+ControlLoopConfig ThermostatController::defaultConfig() {
+    ControlLoopConfig config;
+    memset(&config, 0, sizeof(config));
+    config.mode = ControlMode::OFF;
+    config.setpoint = 20.0f;
+    config.hysteresis = 0.5f;
+    config.cooling = false;
+    config.kp = 0.5f;
+    config.ki = 0.001f;
+    config.kd = 0.0f;
+    config.pidWindowMs = 60000;
+    config.minOnMs = 30000;
+    config.minOffMs = 30000;
+    return config;
+}
+
+void ThermostatController::configure(const ControlLoopConfig& newConfig) {
+    config = newConfig;
+    if (config.pidWindowMs == 0) {
+        config.pidWindowMs = 1000;
+    }
+
+    // Restart the loop from a clean state
+    hysteresisState = false;
+    integral = 0.0f;
+    havePrevious = false;
+    output = 0.0f;
+    inputValid = false;
+}
+
+bool ThermostatController::hasConfig(const ControlLoopConfig& candidate) const {
+    uint32_t window = candidate.pidWindowMs == 0 ? 1000 : candidate.pidWindowMs;
+    return config.mode == candidate.mode &&
+           memcmp(config.sensorAddress, candidate.sensorAddress, sizeof(config.sensorAddress)) == 0 &&
+           config.setpoint == candidate.setpoint &&
+           config.hysteresis == candidate.hysteresis &&
+           config.cooling == candidate.cooling &&
+           config.kp == candidate.kp &&
+           config.ki == candidate.ki &&
+           config.kd == candidate.kd &&
+           config.pidWindowMs == window &&
+           config.minOnMs == candidate.minOnMs &&
+           config.minOffMs == candidate.minOffMs;
+}
+
+void ThermostatController::updateInput(float input, bool valid, uint32_t now) {
+    inputValid = valid;
+    if (!valid || config.mode == ControlMode::OFF) {
+        output = 0.0f;  // Fail safe: release the relay without a valid input
+        havePrevious = false;
+        return;
+    }
+
+    if (config.mode == ControlMode::HYSTERESIS) {
+        updateHysteresis(input);
+    } else {
+        updatePid(input, now);
+    }
+}
+
+void ThermostatController::updateHysteresis(float input) {
+    float halfBand = config.hysteresis / 2.0f;
+
+    if (config.cooling) {
+        if (input > config.setpoint + halfBand) hysteresisState = true;
+        else if (input < config.setpoint - halfBand) hysteresisState = false;
+    } else {
+        if (input < config.setpoint - halfBand) hysteresisState = true;
+        else if (input > config.setpoint + halfBand) hysteresisState = false;
+    }
+
+    output = hysteresisState ? 1.0f : 0.0f;
+}
+
+void ThermostatController::updatePid(float input, uint32_t now) {
+    float error = config.cooling ? (input - config.setpoint) : (config.setpoint - input);
+    float dt = havePrevious ? (now - previousTime) / 1000.0f : 0.0f;
+
+    // Derivative on measurement avoids kicks on setpoint changes
+    float derivative = 0.0f;
+    if (havePrevious && dt > 0.0f) {
+        float slope = (input - previousInput) / dt;
+        derivative = config.cooling ? slope : -slope;
+    }
+
+    float proportional = config.kp * error;
+    float candidateIntegral = integral + config.ki * error * dt;
+    float result = proportional + candidateIntegral + config.kd * derivative;
+
+    // Anti-windup: only integrate while the output is not saturated further
+    if ((result > 1.0f && error > 0.0f) || (result < 0.0f && error < 0.0f)) {
+        result = proportional + integral + config.kd * derivative;
+    } else {
+        integral = candidateIntegral;
+    }
+
+    output = result < 0.0f ? 0.0f : (result > 1.0f ? 1.0f : result);
+    previousInput = input;
+    previousTime = now;
+    havePrevious = true;
+}
+
+bool ThermostatController::computeDemand(bool relayOn, uint32_t relayChangedAt, uint32_t now) {
+    bool demand;
+    if (!inputValid || config.mode == ControlMode::OFF) {
+        demand = false;
+    } else if (config.mode == ControlMode::HYSTERESIS) {
+        demand = hysteresisState;
+    } else {
+        uint32_t onTime = static_cast<uint32_t>(output * config.pidWindowMs);
+        demand = (now % config.pidWindowMs) < onTime;
+    }
+
+    // Honour minimum on/off times to protect compressors and contactors
+    if (demand != relayOn) {
+        uint32_t elapsed = now - relayChangedAt;
+        uint32_t minimum = relayOn ? config.minOnMs : config.minOffMs;
+        if (elapsed < minimum && inputValid) {
+            return relayOn;
+        }
+    }
+
+    return demand;
+}
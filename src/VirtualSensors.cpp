@@ -0,0 +1,198 @@
+// VirtualSensors.cpp
+// Incremental aggregation for virtual sensors. Sums are adjusted by the
+// difference of the changed input; min/max only rescan the inputs when the
+// current extreme moves away. Sums are periodically recomputed from the
+// stored inputs so floating point drift cannot accumulate.
+
+#include "VirtualSensors.h"
+#include <string.h>
+
+VirtualSensorSet::VirtualSensorSet() {
+    clear();
+}
+
+void VirtualSensorSet::clear() {
+    memset(slots, 0, sizeof(slots));
+}
+
+bool VirtualSensorSet::configure(uint8_t index, const VirtualSensorDefinition& definition) {
+    if (index >= MAX_VIRTUAL_SENSORS || definition.inputCount > MAX_VIRTUAL_INPUTS) {
+        return false;
+    }
+    if (definition.type == VirtualSensorType::DIFFERENCE && definition.inputCount != 2) {
+        return false;
+    }
+
+    Slot& slot = slots[index];
+    memset(&slot, 0, sizeof(slot));
+    slot.definition = definition;
+    return true;
+}
+
+bool VirtualSensorSet::isEnabled(uint8_t index) const {
+    return index < MAX_VIRTUAL_SENSORS && slots[index].definition.enabled &&
+           slots[index].definition.inputCount > 0;
+}
+
+bool VirtualSensorSet::updateInput(const uint8_t* address, float value, bool valid) {
+    bool anyChanged = false;
+
+    for (auto& slot : slots) {
+        if (!slot.definition.enabled) continue;
+
+        bool matched = false;
+        for (uint8_t i = 0; i < slot.definition.inputCount; i++) {
+            if (memcmp(slot.definition.inputs[i], address, 8) != 0) continue;
+
+            bool wasValid = (slot.validMask & (1 << i)) != 0;
+            if (wasValid == valid && (!valid || slot.values[i] == value)) continue;
+
+            applyInput(slot, i, value, valid);
+            matched = true;
+        }
+
+        if (matched) {
+            bool oldValid = slot.valid;
+            float oldValue = slot.value;
+            updateOutput(slot);
+            anyChanged |= (oldValid != slot.valid) || (slot.valid && oldValue != slot.value);
+        }
+    }
+
+    return anyChanged;
+}
+
+void VirtualSensorSet::applyInput(Slot& slot, uint8_t input, float value, bool valid) {
+    const VirtualSensorDefinition& definition = slot.definition;
+    uint8_t bit = 1 << input;
+    bool wasValid = (slot.validMask & bit) != 0;
+    float weight = (definition.type == VirtualSensorType::WEIGHTED_SUM) ? definition.weights[input] : 1.0f;
+
+    // Remove the old contribution and add the new one
+    if (wasValid) {
+        slot.weightedSum -= weight * slot.values[input];
+        slot.weightTotal -= weight;
+        slot.validCount--;
+    }
+    if (valid) {
+        slot.weightedSum += weight * value;
+        slot.weightTotal += weight;
+        slot.validCount++;
+    }
+
+    slot.values[input] = value;
+    slot.validMask = valid ? (slot.validMask | bit) : (slot.validMask & ~bit);
+
+    if (definition.type == VirtualSensorType::MIN || definition.type == VirtualSensorType::MAX) {
+        bool isMax = definition.type == VirtualSensorType::MAX;
+        bool extremeValid = (slot.validMask & (1 << slot.extremeIndex)) != 0;
+
+        if (input == slot.extremeIndex || !extremeValid) {
+            // The current extreme changed or vanished - rescan the inputs
+            recomputeExtreme(slot);
+        } else if (valid) {
+            float current = slot.values[slot.extremeIndex];
+            if (isMax ? value > current : value < current) {
+                slot.extremeIndex = input;
+            }
+        }
+    }
+
+    if (++slot.updatesSinceResync >= RESYNC_INTERVAL) {
+        resync(slot);
+    }
+}
+
+void VirtualSensorSet::recomputeExtreme(Slot& slot) {
+    bool isMax = slot.definition.type == VirtualSensorType::MAX;
+    bool found = false;
+
+    for (uint8_t i = 0; i < slot.definition.inputCount; i++) {
+        if (!(slot.validMask & (1 << i))) continue;
+        if (!found || (isMax ? slot.values[i] > slot.values[slot.extremeIndex]
+                             : slot.values[i] < slot.values[slot.extremeIndex])) {
+            slot.extremeIndex = i;
+            found = true;
+        }
+    }
+}
+
+void VirtualSensorSet::resync(Slot& slot) {
+    slot.weightedSum = 0.0f;
+    slot.weightTotal = 0.0f;
+    for (uint8_t i = 0; i < slot.definition.inputCount; i++) {
+        if (!(slot.validMask & (1 << i))) continue;
+        float weight = (slot.definition.type == VirtualSensorType::WEIGHTED_SUM)
+                       ? slot.definition.weights[i] : 1.0f;
+        slot.weightedSum += weight * slot.values[i];
+        slot.weightTotal += weight;
+    }
+    slot.updatesSinceResync = 0;
+}
+
+void VirtualSensorSet::updateOutput(Slot& slot) {
+    const VirtualSensorDefinition& definition = slot.definition;
+    uint8_t allInputs = (1 << definition.inputCount) - 1;
+
+    switch (definition.type) {
+        case VirtualSensorType::MEAN:
+            slot.valid = slot.validCount > 0;
+            slot.value = slot.valid ? slot.weightedSum / slot.validCount : 0.0f;
+            break;
+        case VirtualSensorType::MIN:
+        case VirtualSensorType::MAX:
+            slot.valid = slot.validCount > 0;
+            slot.value = slot.valid ? slot.values[slot.extremeIndex] : 0.0f;
+            break;
+        case VirtualSensorType::DIFFERENCE:
+            slot.valid = slot.validMask == allInputs;
+            slot.value = slot.valid ? slot.values[0] - slot.values[1] : 0.0f;
+            break;
+        case VirtualSensorType::WEIGHTED_SUM:
+            slot.valid = slot.validMask == allInputs;
+            slot.value = slot.valid ? slot.weightedSum : 0.0f;
+            break;
+    }
+}
+
+bool VirtualSensorSet::getValue(uint8_t index, float& value) const {
+    if (index >= MAX_VIRTUAL_SENSORS || !slots[index].definition.enabled) {
+        return false;
+    }
+    value = slots[index].value;
+    return slots[index].valid;
+}
+
+void VirtualSensorSet::makeAddress(uint8_t index, uint8_t* address) {
+    const uint8_t base[8] = {VIRTUAL_SENSOR_FAMILY, 0x00, 0x00, 0x00, 'V', 'S', 0x00, index};
+    memcpy(address, base, 8);
+}
+
+bool VirtualSensorSet::isVirtualAddress(const uint8_t* address) {
+    return address[0] == VIRTUAL_SENSOR_FAMILY && address[4] == 'V' && address[5] == 'S';
+}
+
+const char* VirtualSensorSet::typeToString(VirtualSensorType type) {
+    switch (type) {
+        case VirtualSensorType::MEAN:         return "mean";
+        case VirtualSensorType::MIN:          return "min";
+        case VirtualSensorType::MAX:          return "max";
+        case VirtualSensorType::DIFFERENCE:   return "difference";
+        case VirtualSensorType::WEIGHTED_SUM: return "weightedSum";
+        default:                              return "unknown";
+    }
+}
+
+bool VirtualSensorSet::typeFromString(const char* name, VirtualSensorType& type) {
+    static const VirtualSensorType types[] = {
+        VirtualSensorType::MEAN, VirtualSensorType::MIN, VirtualSensorType::MAX,
+        VirtualSensorType::DIFFERENCE, VirtualSensorType::WEIGHTED_SUM
+    };
+    for (VirtualSensorType candidate : types) {
+        if (name && strcmp(name, typeToString(candidate)) == 0) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
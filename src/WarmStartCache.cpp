@@ -0,0 +1,92 @@
+// WarmStartCache.cpp
+#include "WarmStartCache.h"
+#include "PreferencesManager.h"
+#include "Logger.h"
+#include <rom/crc.h>
+#include <algorithm>
+#include <stddef.h>
+
+// Not cleared by the startup code, so contents survive any reset that keeps power
+RTC_NOINIT_ATTR WarmStartCache::RtcImage WarmStartCache::rtcImage;
+
+uint32_t WarmStartCache::lastNvsSave = 0;
+uint8_t WarmStartCache::nvsCount = 0;
+uint8_t WarmStartCache::nvsAddresses[MAX_ONEWIRE_SENSORS][8];
+
+uint8_t WarmStartCache::load(WarmStartRecord* records, uint8_t maxCount, Source& source) {
+    source = Source::NONE;
+    uint8_t count = 0;
+
+    const RtcImage& image = rtcImage;
+    if (image.magic == RTC_MAGIC && image.count <= MAX_ONEWIRE_SENSORS &&
+        image.crc == imageCrc(image)) {
+        count = std::min(image.count, maxCount);
+        memcpy(records, image.records, count * sizeof(WarmStartRecord));
+        source = Source::RTC;
+    } else {
+        count = PreferencesManager::getWarmStartRecords(records, maxCount);
+        if (count > 0) {
+            source = Source::NVS;
+        }
+    }
+
+    // What NVS holds is needed to decide when the next flash write is due
+    WarmStartRecord stored[MAX_ONEWIRE_SENSORS];
+    const WarmStartRecord* nvsRecords = records;
+    uint8_t storedCount = count;
+    if (source != Source::NVS) {
+        storedCount = PreferencesManager::getWarmStartRecords(stored, MAX_ONEWIRE_SENSORS);
+        nvsRecords = stored;
+    }
+    nvsCount = storedCount;
+    for (uint8_t i = 0; i < storedCount; i++) {
+        memcpy(nvsAddresses[i], nvsRecords[i].address, 8);
+    }
+
+    return count;
+}
+
+void WarmStartCache::save(const WarmStartRecord* records, uint8_t count, uint32_t now) {
+    count = std::min<uint8_t>(count, MAX_ONEWIRE_SENSORS);
+
+    memset(&rtcImage, 0, sizeof(rtcImage));
+    rtcImage.magic = RTC_MAGIC;
+    rtcImage.count = count;
+    memcpy(rtcImage.records, records, count * sizeof(WarmStartRecord));
+    rtcImage.crc = imageCrc(rtcImage);
+
+    bool setChanged = !sameSensorSet(records, count);
+    if (count == 0 || (!setChanged && now - lastNvsSave < WARM_START_NVS_INTERVAL)) {
+        return;
+    }
+
+    if (PreferencesManager::setWarmStartRecords(records, count)) {
+        lastNvsSave = now;
+        nvsCount = count;
+        for (uint8_t i = 0; i < count; i++) {
+            memcpy(nvsAddresses[i], records[i].address, 8);
+        }
+        Logger::debug("Warm start cache written to NVS (" + String(count) + " sensors" +
+                     (setChanged ? ", sensor set changed)" : ")"));
+    }
+}
+
+const char* WarmStartCache::sourceToString(Source source) {
+    switch (source) {
+        case Source::RTC: return "rtc";
+        case Source::NVS: return "nvs";
+        default:          return "none";
+    }
+}
+
+uint32_t WarmStartCache::imageCrc(const RtcImage& image) {
+    return crc32_le(0, reinterpret_cast<const uint8_t*>(&image), offsetof(RtcImage, crc));
+}
+
+bool WarmStartCache::sameSensorSet(const WarmStartRecord* records, uint8_t count) {
+    if (count != nvsCount) return false;
+    for (uint8_t i = 0; i < count; i++) {
+        if (memcmp(records[i].address, nvsAddresses[i], 8) != 0) return false;
+    }
+    return true;
+}
@@ -1,6 +1,9 @@
 // WebServer.cpp
 #include "WebServer.h"
 #include "AuthManager.h"
+#include "BootProfiler.h"
+#include "OneWireTask.h"
+#include "RtosResources.h"
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
 #include <SPIFFS.h>
@@ -48,6 +51,7 @@ static RateLimiter rateLimiter;
 
 WebServer::WebServer(OneWireManager& owManager) 
     : server(80)
+    , events("/api/events")
     , oneWireManager(owManager)
     , preferencesHandler(owManager) {
 }
@@ -56,11 +60,11 @@ void WebServer::begin() {
     Logger::info("Initializing web server...");
     
     // List all files in SPIFFS for debugging
-    Logger::info("Files in SPIFFS:");
+    Logger::debug("Files in SPIFFS:");
     File root = SPIFFS.open("/");
     File file = root.openNextFile();
     while(file) {
-        Logger::info(" - " + String(file.name()) + " (" + String(file.size()) + " bytes)");
+        Logger::debug(" - " + String(file.name()) + " (" + String(file.size()) + " bytes)");
         file = root.openNextFile();
     }
 
@@ -126,6 +130,149 @@ void WebServer::setupRoutes() {
     relayHandler->setMaxContentLength(1024);
     server.addHandler(relayHandler);
 
+    server.on("/api/control", HTTP_GET, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/control GET request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized control status request");
+                request->send(401);
+                return;
+            }
+            handleControlStatusRequest(request);
+        });
+
+    server.on("/api/boot", HTTP_GET, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/boot GET request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized boot timing request");
+                request->send(401);
+                return;
+            }
+            handleBootRequest(request);
+        });
+
+    server.on("/api/benchmark", HTTP_GET, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/benchmark GET request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized benchmark request");
+                request->send(401);
+                return;
+            }
+            handleBenchmarkRequest(request);
+        });
+
+    AsyncCallbackJsonWebHandler* benchmarkHandler = new AsyncCallbackJsonWebHandler(
+        "/api/benchmark",
+        [this](AsyncWebServerRequest* request, JsonVariant& json) {
+            Logger::debug("Handling /api/benchmark POST request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized benchmark start request");
+                request->send(401);
+                return;
+            }
+            handleBenchmarkStartRequest(request, json);
+        }
+    );
+    benchmarkHandler->setMaxContentLength(128);
+    server.addHandler(benchmarkHandler);
+
+    // On-demand bus commands return a handle; poll /api/command?handle=N for the result
+    server.on("/api/scan", HTTP_POST, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/scan POST request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized scan request");
+                request->send(401);
+                return;
+            }
+            handleScanRequest(request);
+        });
+
+    AsyncCallbackJsonWebHandler* readHandler = new AsyncCallbackJsonWebHandler(
+        "/api/read",
+        [this](AsyncWebServerRequest* request, JsonVariant& json) {
+            Logger::debug("Handling /api/read POST request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized read request");
+                request->send(401);
+                return;
+            }
+            handleReadRequest(request, json);
+        }
+    );
+    readHandler->setMaxContentLength(128);
+    server.addHandler(readHandler);
+
+    server.on("/api/command", HTTP_GET, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/command GET request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized command status request");
+                request->send(401);
+                return;
+            }
+            handleCommandRequest(request);
+        });
+
+    // Needed to apply settings that only take effect at boot, such as task placement
+    server.on("/api/restart", HTTP_POST, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/restart POST request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized restart request");
+                request->send(401);
+                return;
+            }
+            Logger::warning("Restart requested via API");
+            request->onDisconnect([]() { ESP.restart(); });
+            sendJsonResponse(request, "{\"status\":\"restarting\"}");
+        });
+
+    server.on("/api/stats", HTTP_GET, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/stats GET request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized statistics request");
+                request->send(401);
+                return;
+            }
+            handleStatsRequest(request);
+        });
+
+    // Push channel for priority events; only authenticated clients may subscribe
+    events.setFilter([this](AsyncWebServerRequest* request) {
+        return isAuthenticatedRequest(request);
+    });
+    server.addHandler(&events);
+
+    server.on("/api/rules", HTTP_GET, 
+        [this](AsyncWebServerRequest* request) {
+            Logger::debug("Handling /api/rules GET request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized rules request");
+                request->send(401);
+                return;
+            }
+            handleRulesRequest(request);
+        });
+
+    AsyncCallbackJsonWebHandler* rulesHandler = new AsyncCallbackJsonWebHandler(
+        "/api/rules",
+        [this](AsyncWebServerRequest* request, JsonVariant& json) {
+            Logger::debug("Handling /api/rules POST request");
+            if (!isAuthenticatedRequest(request)) {
+                Logger::warning("Unauthorized rules update request");
+                request->send(401);
+                return;
+            }
+            handleRulesUpdateRequest(request, json);
+        }
+    );
+    rulesHandler->setMaxContentLength(2048);
+    server.addHandler(rulesHandler);
+
     server.on("/api/preferences", HTTP_GET,
         [this](AsyncWebServerRequest* request) {
             Logger::debug("Handling /api/preferences GET request");
@@ -171,7 +318,7 @@ void WebServer::setupRoutes() {
             }
         }
     );
-    preferencesHandler->setMaxContentLength(1024);
+    preferencesHandler->setMaxContentLength(4096);
     server.addHandler(preferencesHandler);
 
     // Set up static file handling
@@ -255,6 +402,12 @@ void WebServer::setupStaticFiles() {
 void WebServer::handleSensorsRequest(AsyncWebServerRequest *request) {
     try {
         const auto& sensorList = oneWireManager.getSensorList();
+        PayloadFormat format = acceptedFormat(request);
+        if (format != PayloadFormat::TEXT) {
+            sendEncodedSensors(request, sensorList, format);
+            return;
+        }
+        
         AsyncJsonResponse *response = new AsyncJsonResponse(false, 4096);
         JsonArray array = response->getRoot().to<JsonArray>();
         
@@ -265,6 +418,7 @@ void WebServer::handleSensorsRequest(AsyncWebServerRequest *request) {
         }
         
         response->setLength();
+        response->addHeader("Vary", "Accept");
         request->send(response);
         
     } catch (const std::exception& e) {
@@ -276,8 +430,9 @@ void WebServer::handleSensorsRequest(AsyncWebServerRequest *request) {
 JsonObject WebServer::createSensorJson(JsonArray& array, const TemperatureSensor& sensor) {
     JsonObject obj = array.createNestedObject();
     
-    String addr = addressToString(sensor.address);
-    obj["address"] = addr;
+    // char* (not const char*) so ArduinoJson copies the text into the document
+    AddressString addr = formatAddress(sensor.address);
+    obj["address"] = addr.data();
     
     String name = PreferencesManager::getSensorName(sensor.address);
     if (name.length() > 0) {
@@ -285,8 +440,25 @@ JsonObject WebServer::createSensorJson(JsonArray& array, const TemperatureSensor
     }
     
     obj["temperature"] = sensor.valid ? sensor.temperature : DEVICE_DISCONNECTED_C;
+    obj["rawTemperature"] = sensor.valid ? sensor.rawTemperature : DEVICE_DISCONNECTED_C;
     obj["valid"] = sensor.valid;
     obj["lastReadTime"] = sensor.lastReadTime;
+    if (VirtualSensorSet::isVirtualAddress(sensor.address)) {
+        obj["virtual"] = true;
+    } else {
+        obj["health"] = OneWireManager::healthToString(sensor.health);
+        if (sensor.health == SensorHealth::QUARANTINED) {
+            obj["offlineSince"] = sensor.offlineSince;
+        }
+    }
+    if (sensor.anomalyMask) {
+        JsonArray anomalies = obj.createNestedArray("anomalies");
+        for (uint8_t bit = 1; bit <= static_cast<uint8_t>(AnomalyType::ZSCORE); bit <<= 1) {
+            if (sensor.anomalyMask & bit) {
+                anomalies.add(AnomalyDetector::typeToString(static_cast<AnomalyType>(bit)));
+            }
+        }
+    }
     
     // Check if this sensor is the currently selected BabelSensor
     uint8_t displaySensorAddr[8];
@@ -296,15 +468,80 @@ JsonObject WebServer::createSensorJson(JsonArray& array, const TemperatureSensor
         obj["babelTemperature"] = sensor.temperature;  // Add this alias for compatibility
     }
     
-    Logger::debug("Added sensor: " + addr + 
-                 (name.length() > 0 ? " (" + name + ")" : "") +
-                 ", temp: " + String(sensor.temperature, 2) + 
-                 ", valid: " + String(sensor.valid) +
-                 ", babel: " + String(memcmp(sensor.address, displaySensorAddr, 8) == 0));
+    if (Logger::isEnabled(Logger::Level::DEBUG)) {
+        Logger::debug(makeFixedString<96>("Added sensor: %s%s%s%s, temp: %.2f, valid: %d, babel: %d",
+                                          addr.c_str(),
+                                          name.length() > 0 ? " (" : "", name.c_str(),
+                                          name.length() > 0 ? ")" : "",
+                                          sensor.temperature, sensor.valid,
+                                          memcmp(sensor.address, displaySensorAddr, 8) == 0).c_str());
+    }
                  
     return obj;
 }
 
+PayloadFormat WebServer::acceptedFormat(AsyncWebServerRequest* request) {
+    AsyncWebHeader* accept = request->getHeader("Accept");
+    return accept ? PayloadEncoding::fromAccept(accept->value().c_str()) : PayloadFormat::TEXT;
+}
+
+// Same document as the JSON response, streamed one sensor item at a time
+void WebServer::sendEncodedSensors(AsyncWebServerRequest* request, const std::vector<TemperatureSensor>& sensors,
+                                   PayloadFormat format) {
+    AsyncResponseStream* response = request->beginResponseStream(PayloadEncoding::contentType(format));
+    response->addHeader("Vary", "Accept");
+    
+    uint8_t item[PayloadEncoding::MAX_SENSOR_ITEM];
+    response->write(item, PayloadEncoding::encodeArrayHead(format, sensors.size(), item, sizeof(item)));
+    
+    uint8_t displaySensorAddr[8];
+    PreferencesManager::getDisplaySensor(displaySensorAddr);
+    for (const auto& sensor : sensors) {
+        String name = PreferencesManager::getSensorName(sensor.address);
+        SensorRecord record;
+        memcpy(record.address, sensor.address, 8);
+        record.name = name.c_str();
+        record.temperature = sensor.temperature;
+        record.rawTemperature = sensor.rawTemperature;
+        record.lastReadTime = sensor.lastReadTime;
+        record.offlineSince = sensor.offlineSince;
+        record.health = sensor.health;
+        record.anomalyMask = sensor.anomalyMask;
+        record.valid = sensor.valid;
+        record.isVirtual = VirtualSensorSet::isVirtualAddress(sensor.address);
+        record.displaySensor = memcmp(sensor.address, displaySensorAddr, 8) == 0;
+        
+        size_t length = PayloadEncoding::encodeSensor(format, record, item, sizeof(item));
+        if (length == 0) {
+            delete response;
+            sendErrorResponse(request, 500, "Internal server error");
+            return;
+        }
+        response->write(item, length);
+    }
+    request->send(response);
+}
+
+void WebServer::sendEncodedRelays(AsyncWebServerRequest* request, PayloadFormat format) {
+    AsyncResponseStream* response = request->beginResponseStream(PayloadEncoding::contentType(format));
+    response->addHeader("Vary", "Accept");
+    
+    uint8_t item[PayloadEncoding::MAX_RELAY_ITEM];
+    response->write(item, PayloadEncoding::encodeArrayHead(format, 2, item, sizeof(item)));
+    for (uint8_t i = 0; i < 2; i++) {
+        String name = PreferencesManager::getRelayName(i);
+        size_t length = PayloadEncoding::encodeRelay(format, i, ControlTask::getRelayState(i), name.c_str(),
+                                                     item, sizeof(item));
+        if (length == 0) {
+            delete response;
+            sendErrorResponse(request, 500, "Internal server error");
+            return;
+        }
+        response->write(item, length);
+    }
+    request->send(response);
+}
+
 void WebServer::handleOptionsRequest(AsyncWebServerRequest *request) {
     AsyncWebServerResponse *response = request->beginResponse(204);
     request->send(response);
@@ -335,9 +572,9 @@ void WebServer::handleLoginRequest(AsyncWebServerRequest* request, JsonVariant&
 }
 
 void WebServer::handleLogoutRequest(AsyncWebServerRequest* request) {
-    String token = extractToken(request);
-    if (!token.isEmpty()) {
-        AuthManager::revokeSession(token);
+    AuthManager::SessionToken token = extractToken(request);
+    if (!token.empty()) {
+        AuthManager::revokeSession(token.c_str());
     }
     
     AsyncWebServerResponse* response = request->beginResponse(200, "application/json", 
@@ -352,44 +589,46 @@ void WebServer::handleLogoutRequest(AsyncWebServerRequest* request) {
 }
 
 bool WebServer::isAuthenticatedRequest(AsyncWebServerRequest* request) {
-    String token = extractToken(request);
-    Logger::debug("Checking auth token: " + (token.isEmpty() ? "empty" : token));
+    AuthManager::SessionToken token = extractToken(request);
     
-    if (token.isEmpty()) {
+    if (token.empty()) {
         Logger::warning("No auth token found");
         return false;
     }
     
-    bool valid = AuthManager::validateSession(token);
-    Logger::debug("Token validation result: " + String(valid ? "valid" : "invalid"));
+    bool valid = AuthManager::validateSession(token.c_str());
+    Logger::debug(valid ? "Token validation result: valid" : "Token validation result: invalid");
     return valid;
 }
 
-String WebServer::extractToken(AsyncWebServerRequest* request) {
-    String token;
+// Tokens are copied straight out of the header values; anything longer than a
+// session token cannot be valid and is rejected rather than truncated
+AuthManager::SessionToken WebServer::extractToken(AsyncWebServerRequest* request) {
+    AuthManager::SessionToken token;
     
     // Check Authorization header first
-    if (request->hasHeader("Authorization")) {
-        String auth = request->header("Authorization");
-        Logger::debug("Found Authorization header: " + auth);
-        if (auth.startsWith("Bearer ")) {
-            token = auth.substring(7);
+    AsyncWebHeader* auth = request->getHeader("Authorization");
+    if (auth) {
+        const String& value = auth->value();
+        if (value.startsWith("Bearer ")) {
+            token.append(value.c_str() + 7, value.length() - 7);
         }
     }
     
     // Check cookie if no Authorization header token
-    if (token.isEmpty() && request->hasHeader("Cookie")) {
-        String cookies = request->header("Cookie");
-        Logger::debug("Found Cookie header: " + cookies);
-        int tokenStart = cookies.indexOf("session=");
-        if (tokenStart >= 0) {
-            tokenStart += 8;  // Length of "session="
-            int tokenEnd = cookies.indexOf(";", tokenStart);
-            if (tokenEnd < 0) tokenEnd = cookies.length();
-            token = cookies.substring(tokenStart, tokenEnd);
+    AsyncWebHeader* cookie = token.empty() ? request->getHeader("Cookie") : nullptr;
+    if (cookie) {
+        const char* cookies = cookie->value().c_str();
+        const char* start = strstr(cookies, "session=");
+        if (start) {
+            start += 8;  // Length of "session="
+            token.append(start, strcspn(start, ";"));
         }
     }
     
+    if (token.truncated()) {
+        token.clear();
+    }
     return token;
 }
 
@@ -403,14 +642,6 @@ void WebServer::sendJsonResponse(AsyncWebServerRequest* request, const String& j
     request->send(200, "application/json", json);
 }
 
-String WebServer::addressToString(const uint8_t* address) {
-    char buffer[17];
-    snprintf(buffer, sizeof(buffer), "%02X%02X%02X%02X%02X%02X%02X%02X",
-             address[0], address[1], address[2], address[3],
-             address[4], address[5], address[6], address[7]);
-    return String(buffer);
-}
-
 void WebServer::stringToAddress(const char* str, uint8_t* address) {
     for (int i = 0; i < 8; i++) {
         char byte[3] = {str[i*2], str[i*2 + 1], '\0'};
@@ -420,6 +651,12 @@ void WebServer::stringToAddress(const char* str, uint8_t* address) {
 
 void WebServer::handleRelayRequest(AsyncWebServerRequest* request) {
     try {
+        PayloadFormat format = acceptedFormat(request);
+        if (format != PayloadFormat::TEXT) {
+            sendEncodedRelays(request, format);
+            return;
+        }
+        
         AsyncJsonResponse* response = new AsyncJsonResponse(false, 1024);
         JsonArray array = response->getRoot().to<JsonArray>();
         
@@ -435,6 +672,7 @@ void WebServer::handleRelayRequest(AsyncWebServerRequest* request) {
         }
         
         response->setLength();
+        response->addHeader("Vary", "Accept");
         request->send(response);
         
     } catch (const std::exception& e) {
@@ -468,3 +706,364 @@ void WebServer::handleRelayControlRequest(AsyncWebServerRequest* request, JsonVa
         sendErrorResponse(request, 500, "Internal server error");
     }
 }
+
+void WebServer::handleControlStatusRequest(AsyncWebServerRequest* request) {
+    try {
+        AsyncJsonResponse* response = new AsyncJsonResponse(false, 2048);
+        JsonArray array = response->getRoot().to<JsonArray>();
+        
+        for (uint8_t i = 0; i < 2; i++) {
+            ControlLoopConfig config;
+            ControlLoopStats stats;
+            if (!ControlTask::getControlLoopStatus(i, config, stats)) {
+                continue;
+            }
+            
+            JsonObject loop = array.createNestedObject();
+            loop["loop"] = i;
+            PreferencesApiHandler::addControlLoopToJson(loop, config);
+            
+            JsonObject status = loop.createNestedObject("status");
+            status["relayState"] = ControlTask::getRelayState(i);
+            status["demand"] = stats.demand;
+            status["output"] = stats.output;
+            status["input"] = stats.lastInput;
+            status["inputValid"] = stats.inputValid;
+            status["evaluations"] = stats.evaluations;
+            status["actuations"] = stats.actuations;
+            status["lastEvalMicros"] = stats.lastEvalMicros;
+            status["maxEvalMicros"] = stats.maxEvalMicros;
+            status["lastEvalTime"] = stats.lastEvalTime;
+        }
+        
+        response->setLength();
+        request->send(response);
+        
+    } catch (const std::exception& e) {
+        Logger::error("Exception in control status API: " + String(e.what()));
+        sendErrorResponse(request, 500, "Internal server error");
+    }
+}
+
+void WebServer::pushEvent(const char* event, const char* data) {
+    if (events.count() > 0) {
+        events.send(data, event, millis());
+    }
+}
+
+void WebServer::handleStatsRequest(AsyncWebServerRequest* request) {
+    try {
+        // Copy the statistics out so the sensor mutex is not held while serializing
+        std::vector<TemperatureSensor> sensorList = oneWireManager.getSensorList();
+        SensorStatistics stats;
+        
+        AsyncJsonResponse* response = new AsyncJsonResponse(false, 512 + sensorList.size() * 1024);
+        JsonArray array = response->getRoot().to<JsonArray>();
+        
+        for (const auto& sensor : sensorList) {
+            if (!oneWireManager.getSensorStatistics(sensor.address, stats)) continue;
+            
+            JsonObject obj = array.createNestedObject();
+            obj["address"] = formatAddress(sensor.address).data();
+            
+            JsonObject windows = obj.createNestedObject("windows");
+            for (uint8_t i = 0; i < STATS_WINDOW_COUNT; i++) {
+                StatsWindow window = static_cast<StatsWindow>(i);
+                JsonObject entry = windows.createNestedObject(RollupStats::windowName(window));
+                
+                JsonObject current = entry.createNestedObject("current");
+                addRollupToJson(current, stats.current[i]);
+                
+                if (stats.completed[i].count > 0) {
+                    JsonObject last = entry.createNestedObject("last");
+                    addRollupToJson(last, stats.completed[i]);
+                }
+            }
+        }
+        
+        response->setLength();
+        request->send(response);
+        
+    } catch (const std::exception& e) {
+        Logger::error("Exception in statistics API: " + String(e.what()));
+        sendErrorResponse(request, 500, "Internal server error");
+    }
+}
+
+void WebServer::handleBootRequest(AsyncWebServerRequest* request) {
+    BootProfiler::Phase phases[BootProfiler::MAX_PHASES];
+    uint8_t count = BootProfiler::getPhases(phases, BootProfiler::MAX_PHASES);
+    
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 2048);
+    JsonObject root = response->getRoot().to<JsonObject>();
+    root["localReadyMs"] = BootProfiler::getLocalReadyMs();
+    root["networkReadyMs"] = BootProfiler::getNetworkReadyMs();
+    
+    JsonArray array = root.createNestedArray("phases");
+    for (uint8_t i = 0; i < count; i++) {
+        JsonObject obj = array.createNestedObject();
+        obj["name"] = phases[i].name;
+        obj["startMs"] = phases[i].startUs / 1000.0f;
+        obj["durationMs"] = phases[i].durationUs / 1000.0f;
+        obj["state"] = BootProfiler::stateToString(phases[i].state);
+    }
+    
+    response->setLength();
+    request->send(response);
+}
+
+void WebServer::handleBenchmarkRequest(AsyncWebServerRequest* request) {
+    BusTimingReport report = oneWireManager.getTimingReport();
+    
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 1536);
+    JsonObject root = response->getRoot().to<JsonObject>();
+    
+    JsonObject bus = root.createNestedObject("bus");
+    bus["running"] = report.running;
+    bus["startTime"] = report.startTime;
+    bus["rounds"] = report.rounds;
+    bus["sensors"] = report.sensors;
+    bus["transactions"] = report.transactions;
+    bus["presenceErrors"] = report.presenceErrors;
+    bus["crcErrors"] = report.crcErrors;
+    bus["lateTransactions"] = report.lateTransactions;
+    if (report.transactions > 0) {
+        bus["minUs"] = report.minUs;
+        bus["maxUs"] = report.maxUs;
+        bus["meanUs"] = report.meanUs;
+        bus["stddevUs"] = report.stddevUs;
+    }
+    bus["core"] = report.core;
+    
+    JsonArray tasks = root.createNestedArray("tasks");
+    for (size_t i = 0; i < TASK_COUNT; i++) {
+        TaskId id = static_cast<TaskId>(i);
+        int8_t configured = RtosResources::getConfiguredCore(id);
+        int8_t pinned = RtosResources::getPinnedCore(id);
+        
+        JsonObject task = tasks.createNestedObject();
+        task["name"] = TASK_TABLE[i].name;
+        if (configured == TASK_CORE_ANY) task["core"] = "any";
+        else task["core"] = configured;
+        if (pinned == TASK_CORE_ANY) task["pinned"] = "any";
+        else task["pinned"] = pinned;
+    }
+    root["webCore"] = xPortGetCoreID();
+    
+    response->setLength();
+    request->send(response);
+}
+
+void WebServer::handleBenchmarkStartRequest(AsyncWebServerRequest* request, JsonVariant& json) {
+    int rounds = json["rounds"] | 50;
+    if (rounds < 1 || rounds > BUS_BENCHMARK_MAX_ROUNDS) {
+        sendErrorResponse(request, 400, "rounds must be 1-" + String(BUS_BENCHMARK_MAX_ROUNDS));
+        return;
+    }
+    if (oneWireManager.getTimingReport().running) {
+        sendErrorResponse(request, 409, "Benchmark already running");
+        return;
+    }
+    sendCommandAccepted(request, OneWireTask::requestBenchmark(static_cast<uint16_t>(rounds)));
+}
+
+void WebServer::handleScanRequest(AsyncWebServerRequest* request) {
+    sendCommandAccepted(request, OneWireTask::requestScan(OneWireTask::CommandPriority::URGENT));
+}
+
+void WebServer::handleReadRequest(AsyncWebServerRequest* request, JsonVariant& json) {
+    uint32_t deadlineMs = json["deadlineMs"] | 0;
+    const char* address = json["address"] | "";
+    
+    if (strlen(address) == 0) {
+        sendCommandAccepted(request, OneWireTask::requestRead(OneWireTask::CommandPriority::URGENT, deadlineMs));
+        return;
+    }
+    
+    if (strlen(address) != 16 || strspn(address, "0123456789abcdefABCDEF") != 16) {
+        sendErrorResponse(request, 400, "address must be 16 hex characters");
+        return;
+    }
+    uint8_t rom[8];
+    stringToAddress(address, rom);
+    sendCommandAccepted(request, OneWireTask::requestReadSensor(rom, OneWireTask::CommandPriority::URGENT, deadlineMs));
+}
+
+void WebServer::handleCommandRequest(AsyncWebServerRequest* request) {
+    if (!request->hasParam("handle")) {
+        sendErrorResponse(request, 400, "Missing handle");
+        return;
+    }
+    uint32_t handle = strtoul(request->getParam("handle")->value().c_str(), nullptr, 10);
+    
+    OneWireTask::CommandResult result;
+    if (!OneWireTask::getResult(handle, result)) {
+        sendErrorResponse(request, 404, "Unknown command handle");
+        return;
+    }
+    
+    AsyncJsonResponse* response = new AsyncJsonResponse(false, 512);
+    JsonObject root = response->getRoot().to<JsonObject>();
+    root["handle"] = result.handle;
+    root["type"] = OneWireTask::typeToString(result.type);
+    root["state"] = OneWireTask::stateToString(result.state);
+    root["requests"] = result.requests;
+    root["submitTime"] = result.submitTime;
+    if (OneWireTask::isFinal(result.state)) {
+        root["completeTime"] = result.completeTime;
+        root["count"] = result.count;
+    }
+    if (result.type == OneWireTask::CommandType::READ_ONE) {
+        root["address"] = formatAddress(result.address).data();
+        if (result.state == OneWireTask::CommandState::DONE) {
+            root["temperature"] = result.temperature;
+        }
+    }
+    
+    response->setLength();
+    request->send(response);
+}
+
+void WebServer::sendCommandAccepted(AsyncWebServerRequest* request, uint32_t handle) {
+    if (handle == OneWireTask::INVALID_COMMAND) {
+        request->send(503, "application/json", "{\"error\":\"OneWire command table full\"}");
+        return;
+    }
+    request->send(202, "application/json",
+                  makeFixedString<48>("{\"handle\":%lu,\"state\":\"pending\"}",
+                                      static_cast<unsigned long>(handle)).c_str());
+}
+
+void WebServer::addRollupToJson(JsonObject& obj, const RollupWindow& rollup) {
+    obj["start"] = rollup.startTime;
+    obj["count"] = rollup.count;
+    if (rollup.count == 0) {
+        return;
+    }
+    obj["mean"] = rollup.mean;
+    obj["stddev"] = RollupStats::stddev(rollup);
+    obj["min"] = rollup.min;
+    obj["minTime"] = rollup.minTime;
+    obj["max"] = rollup.max;
+    obj["maxTime"] = rollup.maxTime;
+}
+
+void WebServer::handleRulesRequest(AsyncWebServerRequest* request) {
+    try {
+        AsyncJsonResponse* response = new AsyncJsonResponse(false, 4096);
+        JsonArray array = response->getRoot().to<JsonArray>();
+        
+        for (uint8_t i = 0; i < RULE_MAX_RULES; i++) {
+            RuleDefinition definition;
+            if (!PreferencesManager::getRule(i, definition)) {
+                continue;
+            }
+            
+            JsonObject rule = array.createNestedObject();
+            rule["id"] = i;
+            rule["enabled"] = definition.enabled;
+            rule["condition"] = definition.condition;
+            rule["relay"] = definition.relay;
+            rule["action"] = definition.action ? "on" : "off";
+            rule["for"] = definition.holdSeconds;
+            
+            RuleStats stats;
+            if (ControlTask::getRuleStatus(i, stats)) {
+                JsonObject status = rule.createNestedObject("status");
+                status["condition"] = stats.condition;
+                status["active"] = stats.active;
+                status["evaluations"] = stats.evaluations;
+                status["triggers"] = stats.triggers;
+                status["lastEvalMicros"] = stats.lastEvalMicros;
+                status["maxEvalMicros"] = stats.maxEvalMicros;
+            }
+        }
+        
+        response->setLength();
+        request->send(response);
+        
+    } catch (const std::exception& e) {
+        Logger::error("Exception in rules API: " + String(e.what()));
+        sendErrorResponse(request, 500, "Internal server error");
+    }
+}
+
+void WebServer::handleRulesUpdateRequest(AsyncWebServerRequest* request, JsonVariant& json) {
+    try {
+        if (!json.is<JsonArray>()) {
+            sendErrorResponse(request, 400, "Expected an array of rules");
+            return;
+        }
+        
+        // Compile every rule before storing any, so a bad rule rejects the whole update
+        RuleDefinition definitions[RULE_MAX_RULES];
+        bool present[RULE_MAX_RULES] = {false};
+        
+        for (JsonObject rule : json.as<JsonArray>()) {
+            int id = rule["id"] | -1;
+            if (id < 0 || id >= static_cast<int>(RULE_MAX_RULES)) {
+                sendErrorResponse(request, 400, "Invalid rule id");
+                return;
+            }
+            
+            const char* condition = rule["condition"] | "";
+            if (strlen(condition) >= RULE_MAX_SOURCE) {
+                sendErrorResponse(request, 400, "Rule " + String(id) + ": condition longer than " + 
+                                 String(RULE_MAX_SOURCE - 1) + " characters");
+                return;
+            }
+            
+            JsonVariant hold = rule["for"];
+            if (!hold.isNull() && (!hold.is<long>() || hold.as<long>() < 0 || 
+                                   hold.as<long>() > static_cast<long>(RULE_MAX_HOLD_SECONDS))) {
+                sendErrorResponse(request, 400, "Rule " + String(id) + ": \"for\" must be 0-" + 
+                                 String(RULE_MAX_HOLD_SECONDS) + " seconds");
+                return;
+            }
+            
+            JsonVariant relay = rule["relay"];
+            if (!relay.is<int>() || relay.as<int>() < 0 || relay.as<int>() >= static_cast<int>(RELAY_COUNT)) {
+                sendErrorResponse(request, 400, "Rule " + String(id) + ": \"relay\" must be 0-" + 
+                                 String(RELAY_COUNT - 1));
+                return;
+            }
+            
+            RuleDefinition& definition = definitions[id];
+            memset(&definition, 0, sizeof(definition));
+            definition.enabled = rule["enabled"] | true;
+            strcpy(definition.condition, condition);
+            definition.relay = static_cast<uint8_t>(relay.as<int>());
+            definition.action = strcmp(rule["action"] | "on", "off") != 0;
+            definition.holdSeconds = hold.as<uint32_t>();
+            
+            if (definition.enabled) {
+                CompiledRule compiled;
+                char error[64];
+                if (!RuleCompiler::compile(definition.condition, compiled, error, sizeof(error))) {
+                    sendErrorResponse(request, 400, "Rule " + String(id) + ": " + String(error));
+                    return;
+                }
+            }
+            present[id] = true;
+        }
+        
+        bool success = true;
+        for (uint8_t i = 0; i < RULE_MAX_RULES; i++) {
+            if (present[i]) {
+                success &= PreferencesManager::setRule(i, definitions[i]);
+            }
+        }
+        
+        ControlTask::reloadRules();
+        
+        if (success) {
+            sendJsonResponse(request, "{\"status\":\"success\"}");
+        } else {
+            sendErrorResponse(request, 500, "Failed to store rules");
+        }
+        
+    } catch (const std::exception& e) {
+        Logger::error("Exception in rules update API: " + String(e.what()));
+        sendErrorResponse(request, 500, "Internal server error");
+    }
+}
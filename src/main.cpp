@@ -6,6 +6,10 @@
 #include "OneWireTask.h"
 #include "NetworkTask.h"
 #include "ControlTask.h"
+#include "ModbusTask.h"
+#include "BacnetTask.h"
+#include "CoapTask.h"
+#include "BeaconTask.h"
 #include "Logger.h"
 #include "SystemHealth.h"
 #include <esp_task_wdt.h>
@@ -13,13 +17,15 @@
 #include "PreferencesManager.h"
 #include "SslTest.h"
 #include "AuthManager.h"
+#include "BootProfiler.h"
+#include "RtosResources.h"
 
 void prepareNetworkForSsl() {
     // Wait for stable network connection
     uint8_t timeout = 0;
     while (!ETH.linkUp() && timeout < 30) {  // 30 second timeout
         Logger::info("Waiting for stable network connection...");
-        delay(1000);
+        vTaskDelay(pdMS_TO_TICKS(1000));
         timeout++;
     }
     
@@ -29,7 +35,7 @@ void prepareNetworkForSsl() {
     }
     
     // Give DNS a moment to initialize
-    delay(1000);
+    vTaskDelay(pdMS_TO_TICKS(1000));
     
     IPAddress ip = ETH.localIP();
     Logger::info("Network ready for SSL test");
@@ -49,86 +55,137 @@ bool testSslStack() {
     return true;
 }
 
+// Network-dependent bring-up runs here so sensors and relays do not wait for
+// the Ethernet link, DNS or the TLS handshake
+void networkBootTask(void* parameter) {
+    uint8_t phase = BootProfiler::startPhase("ethernet_link");
+    uint8_t timeout = 0;
+    while (!ETH.linkUp() && timeout < 20) {
+        Logger::info("Waiting for Ethernet (Heap: " + String(ESP.getFreeHeap()) + " bytes)");
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        timeout++;
+    }
+    bool linkUp = ETH.linkUp();
+    BootProfiler::endPhase(phase, linkUp);
+    
+    if (linkUp) {
+        Logger::info("Ethernet connected!");
+        Logger::info("IP address: " + ETH.localIP().toString());
+        
+        phase = BootProfiler::startPhase("ssl_prepare");
+        prepareNetworkForSsl();
+        BootProfiler::endPhase(phase, ETH.linkUp());
+        
+        phase = BootProfiler::startPhase("ssl_test");
+        bool sslOk = testSslStack();
+        BootProfiler::endPhase(phase, sslOk);
+        if (!sslOk) {
+            Logger::error("SSL stack tests failed - MQTT may not connect");
+        }
+    } else {
+        Logger::error("Ethernet connection failed - starting network services anyway");
+    }
+    
+    // The web server and MQTT manager retry on their own once the link comes up
+    phase = BootProfiler::startPhase("network_task");
+    NetworkTask::init();
+    NetworkTask::start();
+    BootProfiler::endPhase(phase);
+    Logger::info("Network task started");
+    
+    phase = BootProfiler::startPhase("modbus");
+    ModbusTask::init();
+    ModbusTask::start();
+    BootProfiler::endPhase(phase);
+    
+    phase = BootProfiler::startPhase("bacnet");
+    BacnetTask::init();
+    BacnetTask::start();
+    BootProfiler::endPhase(phase);
+    
+    phase = BootProfiler::startPhase("coap");
+    CoapTask::init();
+    CoapTask::start();
+    BootProfiler::endPhase(phase);
+    
+    phase = BootProfiler::startPhase("beacon");
+    BeaconTask::init();
+    BeaconTask::start();
+    BootProfiler::endPhase(phase);
+    
+    BootProfiler::markNetworkReady();
+    BootProfiler::logSummary();
+    RtosResources::logBudget();
+    vTaskDelete(nullptr);
+}
+
 void setup() {
     Serial.begin(115200);
     delay(100);
     
     Logger::setLogLevel(Logger::Level::INFO);  // Set debug level
     Logger::info("System starting...");
+    BootProfiler::begin();
     
     // Initialize SPIFFS first
-    if(!SPIFFS.begin(true)) {
-        Logger::error("SPIFFS mount failed");
-        return;
-    }
-    Logger::info("SPIFFS mounted successfully");
-
-    // List all files in SPIFFS
-    File root = SPIFFS.open("/");
-    File file = root.openNextFile();
-    while(file) {
-        Logger::info("Found file: " + String(file.name()) + " (" + String(file.size()) + " bytes)");
-        file = root.openNextFile();
+    uint8_t phase = BootProfiler::startPhase("spiffs");
+    bool spiffsOk = SPIFFS.begin(true);
+    BootProfiler::endPhase(phase, spiffsOk);
+    if (!spiffsOk) {
+        Logger::error("SPIFFS mount failed - web interface files unavailable");
+    } else {
+        Logger::info("SPIFFS mounted successfully");
     }
     
+    // Start the PHY now; link negotiation continues in the background
+    phase = BootProfiler::startPhase("ethernet_start");
     Logger::info("Starting Ethernet initialization...");
-    delay(100);
     ETH.begin(ETH_PHY_ADDR, ETH_PHY_POWER, ETH_PHY_MDC, 
               ETH_PHY_MDIO, ETH_PHY_TYPE, ETH_CLK_MODE);
-    delay(400);
-
-    uint8_t timeout = 0;
-    while (!ETH.linkUp() && timeout < 20) {
-        Logger::info("Waiting for Ethernet (Heap: " + String(ESP.getFreeHeap()) + " bytes)");
-        delay(1000);
-        timeout++;
-    }
-
-    if (!ETH.linkUp()) {
-        Logger::error("Ethernet connection failed!");
-        return;
-    }
-
-    Logger::info("Ethernet connected!");
-    Logger::info("IP address: " + ETH.localIP().toString());    
+    BootProfiler::endPhase(phase);
+    
     Logger::info("Initializing system components...");
-
+    
+    phase = BootProfiler::startPhase("core_dump");
     esp_core_dump_init();
+    BootProfiler::endPhase(phase);
     Logger::info("Core dump initialized");
     
-    Logger::info("Preparing network for SSL test");
-    prepareNetworkForSsl();
-    
-    if (!testSslStack()) {
-        Logger::error("SSL stack tests failed - halting initialization");
-        return;
-    }
-
+    phase = BootProfiler::startPhase("preferences");
     PreferencesManager::init();
+    BootProfiler::endPhase(phase);
     Logger::info("Preferences initialized");
-
-    AuthManager::init();  // Add this line
+    
+    phase = BootProfiler::startPhase("auth");
+    AuthManager::init();
+    BootProfiler::endPhase(phase);
     Logger::info("Auth Manager initialized");
-
+    
     SystemHealth::init();
     Logger::info("System health initialized");
-
+    
+    // Local-only subsystems: relays, display and sensors run without the network
+    phase = BootProfiler::startPhase("control_task");
     ControlTask::init();
     ControlTask::start();  // Make sure to call start!
+    BootProfiler::endPhase(phase);
     Logger::info("Control task started");
-
+    
+    phase = BootProfiler::startPhase("onewire_task");
     OneWireTask::init();
     OneWireTask::start();
+    BootProfiler::endPhase(phase);
     Logger::info("OneWire task started");
-
-    NetworkTask::init();
-    NetworkTask::start();
-    Logger::info("Network task started");
-
+    
+    BootProfiler::markLocalReady();
+    
+    // Link wait, SSL checks and the network task continue asynchronously
+    if (!RtosResources::createTask(TaskId::NETWORK_BOOT, networkBootTask)) {
+        Logger::error("Failed to create network boot task");
+    }
+    
     esp_task_wdt_init(WATCHDOG_TIMEOUT / 3000, true);
     esp_task_wdt_add(nullptr);
-
-    AuthManager::init();
     
     Logger::info("Setup complete - system running");
 }
@@ -137,4 +194,4 @@ void loop() {
     esp_task_wdt_reset();
     SystemHealth::update();
     vTaskDelay(pdMS_TO_TICKS(1000));
-}
\ No newline at end of file
+}
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""
+Compare task core placements on a running hub.
+
+For each placement the script stores the core map through /api/preferences,
+restarts the hub, starts the OneWire bus benchmark and, while it runs, times
+GET /api/sensors from this machine. The bus numbers come from the device
+(/api/benchmark); HTTP latency is measured client-side.
+
+Usage:
+    tools/affinity_benchmark.py --host 192.168.1.50 --user admin --password secret
+"""
+
+import argparse
+import json
+import statistics
+import time
+import urllib.error
+import urllib.request
+
+# OneWireTask, ControlTask, NetworkTask; NetBoot always follows NetworkTask
+PLACEMENTS = {
+    "split (default)": {"OneWireTask": 0, "ControlTask": 0, "NetworkTask": 1},
+    "all on core 1": {"OneWireTask": 1, "ControlTask": 1, "NetworkTask": 1},
+    "bus with network": {"OneWireTask": 1, "ControlTask": 0, "NetworkTask": 1},
+    "unpinned": {"OneWireTask": "any", "ControlTask": "any", "NetworkTask": "any"},
+}
+
+
+class Hub:
+    def __init__(self, host, user, password):
+        self.base = "http://" + host
+        self.user = user
+        self.password = password
+        self.token = None
+
+    def request(self, method, path, body=None, timeout=10):
+        data = json.dumps(body).encode() if body is not None else None
+        req = urllib.request.Request(self.base + path, data=data, method=method)
+        req.add_header("Content-Type", "application/json")
+        if self.token:
+            req.add_header("Authorization", "Bearer " + self.token)
+        with urllib.request.urlopen(req, timeout=timeout) as response:
+            payload = response.read()
+            return json.loads(payload) if payload else {}
+
+    def login(self):
+        self.token = None
+        result = self.request("POST", "/api/login",
+                              {"username": self.user, "password": self.password})
+        self.token = result["token"]
+
+    def wait_until_up(self, timeout=60):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            try:
+                self.login()
+                return
+            except (urllib.error.URLError, OSError, KeyError):
+                time.sleep(2)
+        raise RuntimeError("hub did not come back after restart")
+
+
+def apply_placement(hub, placement):
+    tasks = [{"name": name, "core": core} for name, core in placement.items()]
+    tasks.append({"name": "NetBoot", "core": placement["NetworkTask"]})
+    hub.request("POST", "/api/preferences", {"tasks": tasks})
+    try:
+        hub.request("POST", "/api/restart")
+    except (urllib.error.URLError, OSError):
+        pass  # The connection may drop before the response arrives
+    time.sleep(5)
+    hub.wait_until_up()
+    # Give the network task time to settle (MQTT connect, first publish)
+    time.sleep(10)
+
+
+def run_benchmark(hub, rounds):
+    hub.request("POST", "/api/benchmark", {"rounds": rounds})
+    latencies = []
+    while True:
+        start = time.perf_counter()
+        hub.request("GET", "/api/sensors")
+        latencies.append((time.perf_counter() - start) * 1000.0)
+        report = hub.request("GET", "/api/benchmark")
+        if not report["bus"]["running"] and report["bus"]["transactions"] > 0:
+            return report, latencies
+        time.sleep(0.2)
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--user", required=True)
+    parser.add_argument("--password", required=True)
+    parser.add_argument("--rounds", type=int, default=100)
+    parser.add_argument("--placement", choices=PLACEMENTS.keys(), action="append",
+                        help="Run only the named placement(s)")
+    args = parser.parse_args()
+
+    hub = Hub(args.host, args.user, args.password)
+    hub.login()
+
+    rows = []
+    for name in args.placement or PLACEMENTS.keys():
+        print("Running placement: " + name)
+        apply_placement(hub, PLACEMENTS[name])
+        report, latencies = run_benchmark(hub, args.rounds)
+        bus = report["bus"]
+        rows.append((name, bus["core"], bus["transactions"], bus["lateTransactions"],
+                     bus["crcErrors"], bus.get("meanUs", 0), bus.get("stddevUs", 0),
+                     statistics.median(latencies), percentile(latencies, 0.95)))
+
+    # Leave the hub on its built-in defaults
+    defaults = [{"name": name, "core": "default"}
+                for name in ("OneWireTask", "ControlTask", "NetworkTask", "NetBoot")]
+    hub.request("POST", "/api/preferences", {"tasks": defaults})
+    print("Defaults restored; restart the hub to apply them")
+
+    header = ("placement", "bus core", "txns", "late", "crc", "mean us", "sd us",
+              "http p50 ms", "http p95 ms")
+    print()
+    print("{:<18} {:>8} {:>6} {:>6} {:>5} {:>8} {:>7} {:>11} {:>11}".format(*header))
+    for row in rows:
+        print("{:<18} {:>8} {:>6} {:>6} {:>5} {:>8.0f} {:>7.1f} {:>11.1f} {:>11.1f}".format(*row))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+"""
+Minimal BACnet/IP client for checking the hub's BACnet device from a Linux
+machine. Finds the device with Who-Is, lists its points with
+ReadPropertyMultiple, reads single properties and subscribes to COV
+notifications. Standard library only, so it also works against
+tools/bacnet_host_server.cpp on a development machine.
+
+Usage:
+    tools/bacnet_client.py --host 192.168.1.50 list
+    tools/bacnet_client.py --host 192.168.1.50 read analog-input:0 present-value
+    tools/bacnet_client.py --host 192.168.1.50 read device:260001 object-list --index 0
+    tools/bacnet_client.py --host 127.0.0.1 watch analog-input:0 --seconds 30 --confirmed
+"""
+
+import argparse
+import random
+import socket
+import struct
+import time
+
+OBJECT_TYPES = {"analog-input": 0, "ai": 0, "binary-output": 4, "bo": 4, "device": 8}
+OBJECT_NAMES = {0: "analog-input", 4: "binary-output", 8: "device"}
+PROPERTIES = {
+    "all": 8, "cov-increment": 22, "description": 28, "event-state": 36,
+    "firmware-revision": 44, "model-name": 70, "object-identifier": 75,
+    "object-list": 76, "object-name": 77, "object-type": 79, "out-of-service": 81,
+    "present-value": 85, "priority-array": 87, "protocol-revision": 139,
+    "reliability": 103, "status-flags": 111, "units": 117, "vendor-name": 121,
+    "database-revision": 155, "property-list": 371,
+}
+PROPERTY_NAMES = {v: k for k, v in PROPERTIES.items()}
+RELIABILITY = {0: "ok", 1: "no-sensor", 7: "unreliable", 12: "comm-failure"}
+
+
+class BacnetError(Exception):
+    pass
+
+
+# --- Encoding ---------------------------------------------------------------
+
+def tag(number, context, content):
+    first = (0x08 if context else 0) | (number << 4 if number <= 14 else 0xF0)
+    size = len(content)
+    extra = bytes([number]) if number > 14 else b""
+    if size <= 4:
+        return bytes([first | size]) + extra + content
+    if size <= 253:
+        return bytes([first | 5]) + extra + bytes([size]) + content
+    return bytes([first | 5]) + extra + bytes([254]) + struct.pack(">H", size) + content
+
+
+def unsigned(value):
+    size = 1 if value < 0x100 else 2 if value < 0x10000 else 3 if value < 0x1000000 else 4
+    return value.to_bytes(size, "big")
+
+
+def context_unsigned(number, value):
+    return tag(number, True, unsigned(value))
+
+
+def context_object(number, object_type, instance):
+    return tag(number, True, struct.pack(">I", object_type << 22 | instance))
+
+
+def opening(number):
+    return bytes([(number << 4) | 0x0E])
+
+
+def closing(number):
+    return bytes([(number << 4) | 0x0F])
+
+
+# --- Decoding ---------------------------------------------------------------
+
+def read_tag(data, pos):
+    """Returns (number, context, kind, content, next position); kind is
+    'open', 'close' or 'value'."""
+    first = data[pos]
+    pos += 1
+    number = first >> 4
+    if number == 15:
+        number = data[pos]
+        pos += 1
+    context = bool(first & 0x08)
+    lvt = first & 0x07
+    if context and lvt == 6:
+        return number, context, "open", b"", pos
+    if context and lvt == 7:
+        return number, context, "close", b"", pos
+    if not context and number == 1:
+        return number, context, "value", bytes([lvt]), pos
+    size = lvt
+    if lvt == 5:
+        size = data[pos]
+        pos += 1
+        if size == 254:
+            size = struct.unpack(">H", data[pos:pos + 2])[0]
+            pos += 2
+        elif size == 255:
+            size = struct.unpack(">I", data[pos:pos + 4])[0]
+            pos += 4
+    return number, context, "value", data[pos:pos + size], pos + size
+
+
+def application_value(number, content):
+    if number == 0:
+        return None
+    if number == 1:
+        return bool(content[0])
+    if number in (2, 9):
+        return int.from_bytes(content, "big")
+    if number == 3:
+        return int.from_bytes(content, "big", signed=True)
+    if number == 4:
+        return round(struct.unpack(">f", content)[0], 4)
+    if number == 7:
+        return content[1:].decode("utf-8", "replace")
+    if number == 8:
+        unused = content[0]
+        bits = []
+        for byte in content[1:]:
+            bits += [bool(byte & (0x80 >> i)) for i in range(8)]
+        return bits[:len(bits) - unused] if unused else bits
+    if number == 12:
+        value = int.from_bytes(content, "big")
+        return (OBJECT_NAMES.get(value >> 22, value >> 22), value & 0x3FFFFF)
+    return content.hex()
+
+
+def values_until_close(data, pos, number):
+    """Application values up to the closing tag `number`."""
+    values = []
+    while True:
+        tag_number, context, kind, content, pos = read_tag(data, pos)
+        if context and kind == "close" and tag_number == number:
+            return values, pos
+        if not context:
+            values.append(application_value(tag_number, content))
+
+
+def format_value(values):
+    if len(values) == 1:
+        return values[0]
+    return values
+
+
+# --- Client -----------------------------------------------------------------
+
+class Client:
+    def __init__(self, host, port, timeout=3.0):
+        self.address = (host, port)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+        self.sock.bind(("", 0))
+        self.sock.settimeout(timeout)
+        self.invoke_id = random.randrange(256)
+
+    def send(self, apdu, expecting_reply=False):
+        npdu = bytes([0x01, 0x04 if expecting_reply else 0x00])
+        frame = npdu + apdu
+        self.sock.sendto(bytes([0x81, 0x0A]) + struct.pack(">H", len(frame) + 4) + frame, self.address)
+
+    def receive(self):
+        frame, source = self.sock.recvfrom(1500)
+        if frame[0] != 0x81:
+            raise BacnetError("not a BVLC frame")
+        pos = 4 if frame[1] != 0x04 else 10
+        control = frame[pos + 1]
+        pos += 2
+        if control & 0x20:
+            pos += 3 + frame[pos + 2]
+        if control & 0x08:
+            pos += 3 + frame[pos + 2]
+        if control & 0x20:
+            pos += 1
+        return frame[pos:], source
+
+    def confirmed(self, service, payload):
+        self.invoke_id = (self.invoke_id + 1) & 0xFF
+        self.send(bytes([0x00, 0x05, self.invoke_id, service]) + payload, expecting_reply=True)
+        while True:
+            apdu, _ = self.receive()
+            kind = apdu[0] & 0xF0
+            if kind in (0x00, 0x10):
+                continue   # A notification arriving before the reply
+            if apdu[1] != self.invoke_id:
+                continue
+            if kind == 0x20:
+                return b""
+            if kind == 0x30:
+                return apdu[3:]
+            if kind == 0x50:
+                _, _, _, error_class, pos = read_tag(apdu, 3)
+                _, _, _, error_code, _ = read_tag(apdu, pos)
+                raise BacnetError("error class %d code %d" % (int.from_bytes(error_class, "big"),
+                                                              int.from_bytes(error_code, "big")))
+            if kind == 0x60:
+                raise BacnetError("rejected, reason %d" % apdu[2])
+            raise BacnetError("aborted, reason %d" % apdu[2])
+
+    def who_is(self):
+        self.send(bytes([0x10, 0x08]))
+        apdu, source = self.receive()
+        if apdu[:2] != bytes([0x10, 0x00]):
+            raise BacnetError("unexpected reply to Who-Is")
+        _, _, _, content, pos = read_tag(apdu, 2)
+        _, instance = application_value(12, content)
+        _, _, _, max_apdu, pos = read_tag(apdu, pos)
+        _, _, _, _, pos = read_tag(apdu, pos)
+        _, _, _, vendor, _ = read_tag(apdu, pos)
+        return instance, int.from_bytes(max_apdu, "big"), int.from_bytes(vendor, "big"), source
+
+    def read_property(self, object_type, instance, prop, index=None):
+        payload = context_object(0, object_type, instance) + context_unsigned(1, prop)
+        if index is not None:
+            payload += context_unsigned(2, index)
+        reply = self.confirmed(12, payload)
+        pos = 0
+        while True:
+            number, _, kind, _, pos = read_tag(reply, pos)
+            if kind == "open" and number == 3:
+                values, _ = values_until_close(reply, pos, 3)
+                return format_value(values)
+
+    def read_all(self, object_type, instance):
+        payload = context_object(0, object_type, instance) + opening(1) + context_unsigned(0, 8) + closing(1)
+        reply = self.confirmed(14, payload)
+        results = {}
+        pos = 0
+        prop = None
+        while pos < len(reply):
+            number, context, kind, content, pos = read_tag(reply, pos)
+            if context and kind == "value" and number == 2:
+                prop = int.from_bytes(content, "big")
+            elif context and kind == "open" and number == 4:
+                values, pos = values_until_close(reply, pos, 4)
+                results[prop] = format_value(values)
+            elif context and kind == "open" and number == 5:
+                values, pos = values_until_close(reply, pos, 5)
+                results[prop] = "error %s" % (values,)
+        return results
+
+    def subscribe(self, object_type, instance, process_id, confirmed, lifetime):
+        payload = (context_unsigned(0, process_id) + context_object(1, object_type, instance) +
+                   tag(2, True, bytes([1 if confirmed else 0])) + context_unsigned(3, lifetime))
+        self.confirmed(5, payload)
+
+    def notifications(self, seconds):
+        deadline = time.time() + seconds
+        while time.time() < deadline:
+            try:
+                apdu, source = self.receive()
+            except socket.timeout:
+                continue
+            confirmed = apdu[0] & 0xF0 == 0x00
+            if confirmed and apdu[3] == 1:
+                body = apdu[4:]
+                # Simple-ACK so the device sees the notification acknowledged
+                self.sock.sendto(bytes([0x81, 0x0A, 0x00, 0x09, 0x01, 0x00, 0x20, apdu[2], 0x01]), source)
+            elif apdu[:2] == bytes([0x10, 0x02]):
+                body = apdu[2:]
+            else:
+                continue
+            yield decode_notification(body, confirmed)
+
+
+def decode_notification(body, confirmed):
+    pos = 0
+    fields = {}
+    values = {}
+    prop = None
+    while pos < len(body):
+        number, context, kind, content, pos = read_tag(body, pos)
+        if kind == "value" and context and number in (0, 3) and prop is None and 4 not in fields:
+            fields[number] = int.from_bytes(content, "big")
+        elif kind == "value" and context and number == 2 and 4 not in fields:
+            fields[2] = application_value(12, content)
+        elif kind == "open" and number == 4:
+            fields[4] = True
+        elif kind == "value" and context and number == 0:
+            prop = int.from_bytes(content, "big")
+        elif kind == "open" and number == 2:
+            decoded, pos = values_until_close(body, pos, 2)
+            values[PROPERTY_NAMES.get(prop, prop)] = format_value(decoded)
+    return {"process": fields.get(0), "object": fields.get(2), "remaining": fields.get(3),
+            "confirmed": confirmed, "values": values}
+
+
+def parse_object(text):
+    kind, _, instance = text.partition(":")
+    if kind not in OBJECT_TYPES or not instance.isdigit():
+        raise SystemExit("object must be analog-input:N, binary-output:N or device:N")
+    return OBJECT_TYPES[kind], int(instance)
+
+
+def parse_property(text):
+    return int(text) if text.isdigit() else PROPERTIES[text]
+
+
+def list_points(client):
+    instance, max_apdu, vendor, source = client.who_is()
+    print("device %d at %s:%d, max APDU %d, vendor %d" % (instance, source[0], source[1], max_apdu, vendor))
+    device = client.read_all(8, instance)
+    print("  %s, %s %s, database revision %s" % (device[77], device[121], device[70], device[155]))
+
+    count = client.read_property(8, instance, 76, 0)
+    for index in range(1, count + 1):
+        object_name, object_instance = client.read_property(8, instance, 76, index)
+        object_type = OBJECT_TYPES[object_name]
+        if object_type == 8:
+            continue
+        props = client.read_all(object_type, object_instance)
+        flags = props[111]
+        state = "alarm " if flags[0] else ""
+        state += "fault " if flags[1] else ""
+        if object_type == 0:
+            print("  AI %-3d %-28s %8.2f °C  %-12s %s(%s)" % (
+                object_instance, props[77], props[85], RELIABILITY.get(props[103], props[103]),
+                state, props[28]))
+        else:
+            print("  BO %-3d %-28s %s" % (object_instance, props[77], "on" if props[85] else "off"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=47808)
+    sub = parser.add_subparsers(dest="command", required=True)
+    sub.add_parser("list")
+    read = sub.add_parser("read")
+    read.add_argument("object")
+    read.add_argument("property")
+    read.add_argument("--index", type=int)
+    watch = sub.add_parser("watch")
+    watch.add_argument("object")
+    watch.add_argument("--seconds", type=int, default=60)
+    watch.add_argument("--lifetime", type=int, default=300)
+    watch.add_argument("--confirmed", action="store_true")
+    args = parser.parse_args()
+
+    client = Client(args.host, args.port)
+    try:
+        run(client, args)
+    except BacnetError as error:
+        raise SystemExit("bacnet: %s" % error)
+    except socket.timeout:
+        raise SystemExit("bacnet: no answer from %s:%d" % (args.host, args.port))
+
+
+def run(client, args):
+    if args.command == "list":
+        list_points(client)
+    elif args.command == "read":
+        object_type, instance = parse_object(args.object)
+        print(client.read_property(object_type, instance, parse_property(args.property), args.index))
+    else:
+        object_type, instance = parse_object(args.object)
+        process_id = random.randrange(1, 1 << 16)
+        client.subscribe(object_type, instance, process_id, args.confirmed, args.lifetime)
+        print("subscribed to %s, process %d" % (args.object, process_id))
+        for notification in client.notifications(args.seconds):
+            print("%s  %s" % (time.strftime("%H:%M:%S"), notification))
+        cancel = context_unsigned(0, process_id) + context_object(1, object_type, instance)
+        client.confirmed(5, cancel)
+        print("subscription cancelled")
+
+
+if __name__ == "__main__":
+    main()
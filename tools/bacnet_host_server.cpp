@@ -0,0 +1,137 @@
+// bacnet_host_server.cpp
+// Serves BacnetDevice over BACnet/IP on the host, with a handful of synthetic
+// sensors whose readings drift every second and two relays that toggle every
+// 15 s. Lets the object model, ReadProperty(Multiple) and COV notifications
+// be exercised with any BACnet client (tools/bacnet_client.py, the
+// bacnet-stack demo tools, YABE) without a board. The fourth sensor drops
+// out between 20 and 30 s of every minute to show Reliability no-sensor.
+//
+// Broadcasts (I-Am in answer to Who-Is) are sent to the requester instead,
+// since a client on the same host cannot share the BACnet port.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -Iinclude -o /tmp/bacnet_host_server tools/bacnet_host_server.cpp
+//       src/BacnetDevice.cpp src/SensorSlots.cpp
+//   /tmp/bacnet_host_server [port] [device instance]     (default 47808, 260001)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include "BacnetDevice.h"
+
+static const size_t SENSOR_COUNT = 5;
+static const uint8_t RELAYS = 2;
+
+static int sock = -1;
+
+static uint32_t millisNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint32_t>(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+static void sendFrame(const BacnetAddress& destination, bool broadcast,
+                      const uint8_t* frame, size_t length, void*) {
+    if (broadcast && destination.port == 0) return;   // Startup announcement: nobody to tell
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    memcpy(&address.sin_addr.s_addr, destination.ip, 4);
+    address.sin_port = htons(destination.port);
+    sendto(sock, frame, length, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+}
+
+static size_t fillSamples(BacnetSensorSample* samples, uint32_t uptime) {
+    size_t count = 0;
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        if (i == 3 && uptime % 60 >= 20 && uptime % 60 < 30) continue;
+
+        BacnetSensorSample& s = samples[count++];
+        memset(&s, 0, sizeof(s));
+        s.address[0] = 0x28;
+        s.address[1] = static_cast<uint8_t>(0x10 + i);
+        s.address[7] = static_cast<uint8_t>(0xA0 + i);
+        s.temperature = 20.0f + i + 0.0625f * static_cast<float>(uptime % 16);
+        s.health = SensorHealth::ACTIVE;
+        s.valid = true;
+        if (i == 2 && uptime % 30 >= 25) s.anomalyMask = 0x01;
+    }
+
+    // The last sensor has never answered, as a disconnected probe would
+    BacnetSensorSample& missing = samples[count - 1];
+    missing.temperature = SensorTable::NO_READING_C;
+    missing.health = SensorHealth::QUARANTINED;
+    missing.consecutiveErrors = 3;
+    missing.valid = false;
+    return count;
+}
+
+int main(int argc, char** argv) {
+    int port = argc > 1 ? atoi(argv[1]) : 47808;
+    uint32_t instance = argc > 2 ? strtoul(argv[2], nullptr, 10) : 260001;
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        fprintf(stderr, "bind to port %d failed: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    BacnetDevice device;
+    BacnetIdentity identity = {instance, "SensorHub host", "Chaoticvolt", 0, "SensorHUB host server", "host"};
+    device.configure(identity, 0.1f);
+    device.setSender(sendFrame, nullptr);
+    device.setSensorName(0, "Boiler flow");
+    device.setRelayName(0, "Pump");
+    printf("BACnet/IP host server on 127.0.0.1:%d, device %u, %zu sensors, %u relays\n",
+           port, instance, SENSOR_COUNT, RELAYS);
+    fflush(stdout);
+
+    BacnetSensorSample samples[SENSOR_COUNT];
+    bool relays[RELAYS] = {false, false};
+    uint8_t frame[BACNET_MAX_PACKET];
+    uint32_t start = millisNow();
+    uint32_t lastRefresh = start - 1000;
+
+    while (true) {
+        uint32_t now = millisNow();
+        if (now - lastRefresh >= 1000) {
+            uint32_t uptime = (now - start) / 1000;
+            relays[0] = (uptime / 15) % 2;
+            relays[1] = (uptime / 30) % 2;
+            size_t count = fillSamples(samples, uptime);
+            if (device.refresh(samples, count, relays, RELAYS, now)) {
+                printf("slot assignment changed\n");
+                fflush(stdout);
+            }
+            lastRefresh = now;
+        }
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(sock, &readSet);
+        timeval timeout = {0, 100000};
+        if (select(sock + 1, &readSet, nullptr, nullptr, &timeout) <= 0) continue;
+
+        sockaddr_in peer = {};
+        socklen_t peerLength = sizeof(peer);
+        ssize_t received = recvfrom(sock, frame, sizeof(frame), 0,
+                                    reinterpret_cast<sockaddr*>(&peer), &peerLength);
+        if (received <= 0) continue;
+
+        BacnetAddress source = {};
+        memcpy(source.ip, &peer.sin_addr.s_addr, 4);
+        source.port = ntohs(peer.sin_port);
+        device.handleFrame(frame, static_cast<size_t>(received), source, millisNow());
+    }
+}
@@ -0,0 +1,116 @@
+// beacon_host_sender.cpp
+// Multicasts telemetry beacon datagrams (TelemetryBeacon.h) from the host
+// with synthetic sensors, so tools/beacon_receiver.py and other consumers can
+// be tried without a board. Readings drift every few seconds, the fourth
+// sensor is quarantined between 20 and 30 s of every minute, and the last one
+// is virtual. A drop percentage skips sends while still advancing the
+// sequence, to check loss accounting on the receiving side; the send delay
+// varies between 0 and 20 ms.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -Iinclude -o /tmp/beacon_host_sender tools/beacon_host_sender.cpp
+//       src/TelemetryBeacon.cpp
+//   /tmp/beacon_host_sender [group] [port] [interval ms] [drop %]
+//   (defaults 239.255.72.1 47201 1000 0; loopback delivery is enabled)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "TelemetryBeacon.h"
+
+static const size_t SENSOR_COUNT = 12;
+
+static uint32_t millisNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint32_t>(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+static size_t fillSensors(SensorHot* sensors, uint32_t now, uint32_t uptime) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        SensorHot& s = sensors[i];
+        memset(&s, 0, sizeof(s));
+        s.address[0] = 0x28;
+        s.address[1] = static_cast<uint8_t>(0x10 + i);
+        s.address[7] = static_cast<uint8_t>(0xA0 + i);
+        s.raw = static_cast<int16_t>((20 + i) * 128 + 8 * ((uptime / 5) % 16));
+        s.temperature = s.raw / 128.0f;
+        s.readTime = now;
+        SensorTable::setHealth(s, SensorHealth::ACTIVE);
+        SensorTable::setValid(s, true);
+    }
+
+    SensorHot& missing = sensors[3];
+    if (uptime % 60 >= 20 && uptime % 60 < 30) {
+        missing.raw = SensorTable::NO_READING_RAW;
+        SensorTable::setHealth(missing, SensorHealth::QUARANTINED);
+        SensorTable::setValid(missing, false);
+    }
+
+    // Virtual sensor: mean of the first two, carried as a filtered value
+    SensorHot& average = sensors[SENSOR_COUNT - 1];
+    average.address[0] = 0x00;
+    average.raw = SensorTable::NO_READING_RAW;
+    average.temperature = (sensors[0].temperature + sensors[1].temperature) / 2;
+    average.flags |= SensorTable::FLAG_VIRTUAL;
+    return SENSOR_COUNT;
+}
+
+int main(int argc, char** argv) {
+    const char* group = argc > 1 ? argv[1] : "239.255.72.1";
+    int port = argc > 2 ? atoi(argv[2]) : 47201;
+    int interval = argc > 3 ? atoi(argv[3]) : 1000;
+    int dropPercent = argc > 4 ? atoi(argv[4]) : 0;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    unsigned char ttl = 1;
+    unsigned char loop = 1;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    sockaddr_in destination = {};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, group, &destination.sin_addr) != 1) {
+        fprintf(stderr, "invalid group %s\n", group);
+        return 1;
+    }
+
+    printf("Beacon to %s:%d every %d ms, dropping %d%%\n", group, port, interval, dropPercent);
+    fflush(stdout);
+
+    srand(static_cast<unsigned>(millisNow()));
+    SensorHot sensors[SENSOR_TABLE_CAPACITY];
+    uint8_t datagram[BEACON_MAX_DATAGRAM];
+    uint32_t start = millisNow();
+    uint32_t sequence = 0;
+
+    while (true) {
+        uint32_t collected = millisNow();
+        uint32_t uptime = (collected - start) / 1000;
+        size_t count = fillSensors(sensors, collected, uptime);
+        usleep((rand() % 21) * 1000);
+
+        uint32_t number = sequence++;
+        bool drop = dropPercent > 0 && rand() % 100 < dropPercent;
+        if (!drop) {
+            uint8_t relays = static_cast<uint8_t>(((uptime / 15) % 2) | ((uptime / 30) % 2) << 1);
+            BeaconHeader header = {number, collected, static_cast<uint16_t>(millisNow() - collected),
+                                   relays, static_cast<uint8_t>(number == 0 ? BEACON_FLAG_RESTART : 0)};
+            size_t length = TelemetryBeacon::encode(header, sensors, count, datagram, sizeof(datagram));
+            if (sendto(sock, datagram, length, 0, reinterpret_cast<sockaddr*>(&destination),
+                       sizeof(destination)) < 0) {
+                fprintf(stderr, "send failed: %s\n", strerror(errno));
+            }
+        }
+
+        int32_t remaining = static_cast<int32_t>(interval) - static_cast<int32_t>(millisNow() - collected);
+        if (remaining > 0) usleep(static_cast<useconds_t>(remaining) * 1000);
+    }
+}
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""
+Receives the hub's multicast telemetry beacon and reports loss and latency.
+Standard library only. Decodes the datagram format of include/TelemetryBeacon.h,
+prints readings with --verbose, and summarizes per sender every --report
+seconds and on exit.
+
+Loss is counted from gaps in the sequence number; a datagram that arrives after
+a later one counts as reordered, not lost. Device and host clocks are not
+synchronized, so latency is given in two parts: the send delay the hub measured
+from the end of the read cycle to the send, and the network transit above the
+fastest datagram seen (arrival time minus device send time, less its minimum).
+Jitter is the RFC 3550 interarrival jitter of that transit.
+
+Usage:
+    tools/beacon_receiver.py
+    tools/beacon_receiver.py --group 239.255.72.1 --port 47201 --interface 192.168.1.20
+    tools/beacon_receiver.py --verbose --seconds 60
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+HEADER = struct.Struct(">2sBBIIHBB")
+RECORD = struct.Struct(">8shB")
+VERSION = 1
+FLAG_RESTART = 0x01
+NO_READING_RAW = -7040
+HEALTH = ("active", "suspect", "quarantined", "?")
+MAX_MISSING = 4096
+
+
+class BeaconError(Exception):
+    pass
+
+
+def decode(data):
+    if len(data) < HEADER.size:
+        raise BeaconError("short datagram (%d bytes)" % len(data))
+    magic, version, count, sequence, collected, send_delay, relays, flags = HEADER.unpack_from(data)
+    if magic != b"SH":
+        raise BeaconError("bad magic %r" % magic)
+    if version != VERSION:
+        raise BeaconError("unsupported version %d" % version)
+    if len(data) < HEADER.size + count * RECORD.size:
+        raise BeaconError("truncated: %d sensors in %d bytes" % (count, len(data)))
+
+    sensors = []
+    for i in range(count):
+        rom, raw, status = RECORD.unpack_from(data, HEADER.size + i * RECORD.size)
+        sensors.append({
+            "rom": rom.hex().upper(),
+            "celsius": None if raw == NO_READING_RAW else raw / 128.0,
+            "health": HEALTH[status & 0x03],
+            "valid": bool(status & 0x04),
+            "virtual": bool(status & 0x08),
+        })
+    return {"sequence": sequence, "collected": collected, "send_delay": send_delay,
+            "relays": relays, "flags": flags, "sensors": sensors}
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+class SenderStats:
+    """Sequence and latency bookkeeping for one hub."""
+
+    def __init__(self):
+        self.received = 0
+        self.lost = 0
+        self.duplicates = 0
+        self.reordered = 0
+        self.restarts = 0
+        self.highest = None
+        self.missing = set()
+        self.min_offset = None
+        self.last_transit = None
+        self.jitter = 0.0
+        self.send_delays = []
+        self.transits = []          # Offsets since the last restart
+        self.earlier_transits = []  # Transit above the fastest, earlier boots
+
+    def add(self, beacon, arrival_ms):
+        sequence = beacon["sequence"]
+        restarted = beacon["flags"] & FLAG_RESTART or (
+            self.highest is not None and sequence + 1000 < self.highest)
+        if restarted and self.highest is not None:
+            # Device millis() and the sequence both start over
+            self.restarts += 1
+            self.highest = None
+            self.missing.clear()
+            self.earlier_transits += self.relative_transits()
+            self.transits = []
+            self.min_offset = None
+            self.last_transit = None
+
+        self.received += 1
+        if self.highest is None:
+            self.highest = sequence
+        elif sequence > self.highest:
+            gap = sequence - self.highest - 1
+            self.lost += gap
+            if gap < MAX_MISSING:
+                self.missing.update(range(self.highest + 1, sequence))
+            self.highest = sequence
+        elif sequence in self.missing:
+            self.missing.discard(sequence)
+            self.lost -= 1
+            self.reordered += 1
+        else:
+            self.duplicates += 1
+            return
+        if len(self.missing) > MAX_MISSING:
+            self.missing = set(sorted(self.missing)[-MAX_MISSING:])
+
+        # Offset of the host clock against the device send time, plus transit
+        offset = arrival_ms - (beacon["collected"] + beacon["send_delay"])
+        if self.min_offset is None or offset < self.min_offset:
+            self.min_offset = offset
+        if self.last_transit is not None:
+            self.jitter += (abs(offset - self.last_transit) - self.jitter) / 16
+        self.last_transit = offset
+        self.send_delays.append(beacon["send_delay"])
+        self.transits.append(offset)
+
+    def relative_transits(self):
+        return [value - self.min_offset for value in self.transits]
+
+    def summary(self):
+        expected = self.received - self.duplicates + self.lost
+        loss = 100.0 * self.lost / expected if expected else 0.0
+        transit = self.earlier_transits + self.relative_transits()
+        return ("received %d, lost %d (%.2f%%), reordered %d, duplicates %d, restarts %d\n"
+                "    send delay ms   p50 %.0f  p95 %.0f  max %.0f\n"
+                "    transit ms      p50 %.1f  p95 %.1f  max %.1f  (above fastest)  jitter %.1f"
+                % (self.received, self.lost, loss, self.reordered, self.duplicates, self.restarts,
+                   percentile(self.send_delays, 0.5), percentile(self.send_delays, 0.95),
+                   max(self.send_delays, default=0),
+                   percentile(transit, 0.5), percentile(transit, 0.95), max(transit, default=0),
+                   self.jitter))
+
+
+def open_socket(group, port, interface):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, "SO_REUSEPORT"):
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+    sock.bind(("", port))
+    membership = socket.inet_aton(group) + socket.inet_aton(interface)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    sock.settimeout(0.5)
+    return sock
+
+
+def show(source, beacon):
+    readings = " ".join(
+        "%s=%s%s" % (sensor["rom"][-4:],
+                     "--" if sensor["celsius"] is None else "%.2f" % sensor["celsius"],
+                     "" if sensor["health"] == "active" else "(%s)" % sensor["health"])
+        for sensor in beacon["sensors"])
+    print("%s %s #%d +%dms relays=%02x %s" % (time.strftime("%H:%M:%S"), source, beacon["sequence"],
+                                              beacon["send_delay"], beacon["relays"], readings))
+
+
+def report(stats):
+    for source, sender in sorted(stats.items()):
+        print("%s %s" % (time.strftime("%H:%M:%S"), source))
+        print("    " + sender.summary())
+
+
+def run(args):
+    sock = open_socket(args.group, args.port, args.interface)
+    print("listening on %s:%d" % (args.group, args.port))
+    stats = {}
+    start = time.monotonic()
+    next_report = start + args.report
+    try:
+        while not args.seconds or time.monotonic() - start < args.seconds:
+            if time.monotonic() >= next_report:
+                report(stats)
+                next_report += args.report
+            try:
+                data, (source, _) = sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            arrival_ms = time.monotonic() * 1000
+            try:
+                beacon = decode(data)
+            except BeaconError as error:
+                print("%s: %s" % (source, error))
+                continue
+            stats.setdefault(source, SenderStats()).add(beacon, arrival_ms)
+            if args.verbose:
+                show(source, beacon)
+    except KeyboardInterrupt:
+        pass
+    report(stats)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--group", default="239.255.72.1")
+    parser.add_argument("--port", type=int, default=47201)
+    parser.add_argument("--interface", default="0.0.0.0", help="local address to join the group on")
+    parser.add_argument("--seconds", type=float, default=0, help="stop after this long (default: Ctrl-C)")
+    parser.add_argument("--report", type=float, default=10, help="seconds between summaries")
+    parser.add_argument("--verbose", action="store_true", help="print every datagram")
+    run(parser.parse_args())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""
+Minimal CoAP client for the hub's CoAP endpoint. Fetches resources with
+block-wise transfer, decodes the CBOR payloads and follows Observe
+notifications. Standard library only, so it also works against
+tools/coap_host_server.cpp on a development machine.
+
+Usage:
+    tools/coap_client.py --host 192.168.1.50 discover
+    tools/coap_client.py --host 192.168.1.50 get /sensors
+    tools/coap_client.py --host 192.168.1.50 get /sensors --block-size 64
+    tools/coap_client.py --host 127.0.0.1 observe /sensors/28100000000000A0 --seconds 60
+"""
+
+import argparse
+import json
+import os
+import random
+import socket
+import struct
+import time
+
+CON, NON, ACK, RST = 0, 1, 2, 3
+GET = 0x01
+OPTION_ETAG, OPTION_OBSERVE, OPTION_URI_PATH, OPTION_CONTENT_FORMAT = 4, 6, 11, 12
+OPTION_ACCEPT, OPTION_BLOCK2, OPTION_SIZE2 = 17, 23, 28
+FORMAT_LINK, FORMAT_CBOR = 40, 60
+
+
+class CoapError(Exception):
+    pass
+
+
+def code_text(code):
+    return "%d.%02d" % (code >> 5, code & 0x1F)
+
+
+# --- CBOR -------------------------------------------------------------------
+
+def cbor_decode(data, pos=0):
+    """Decodes one item; returns (value, next position). Covers what the hub sends."""
+    initial = data[pos]
+    major, info = initial >> 5, initial & 0x1F
+    pos += 1
+    if major == 7:
+        if info == 20:
+            return False, pos
+        if info == 21:
+            return True, pos
+        if info == 22:
+            return None, pos
+        if info == 25:
+            return struct.unpack(">e", data[pos:pos + 2])[0], pos + 2
+        if info == 26:
+            return struct.unpack(">f", data[pos:pos + 4])[0], pos + 4
+        if info == 27:
+            return struct.unpack(">d", data[pos:pos + 8])[0], pos + 8
+        raise CoapError("unsupported CBOR simple value %d" % info)
+    if info < 24:
+        value = info
+    else:
+        size = {24: 1, 25: 2, 26: 4, 27: 8}[info]
+        value = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    if major == 0:
+        return value, pos
+    if major == 1:
+        return -1 - value, pos
+    if major == 2:
+        return data[pos:pos + value], pos + value
+    if major == 3:
+        return data[pos:pos + value].decode("utf-8"), pos + value
+    if major == 4:
+        items = []
+        for _ in range(value):
+            item, pos = cbor_decode(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        result = {}
+        for _ in range(value):
+            key, pos = cbor_decode(data, pos)
+            result[key], pos = cbor_decode(data, pos)
+        return result, pos
+    raise CoapError("unsupported CBOR major type %d" % major)
+
+
+# --- CoAP messages ----------------------------------------------------------
+
+def encode_uint(value):
+    return value.to_bytes((value.bit_length() + 7) // 8, "big") if value else b""
+
+
+def encode_message(mtype, code, message_id, token, options):
+    out = bytearray([0x40 | mtype << 4 | len(token), code]) + struct.pack(">H", message_id) + token
+    last = 0
+    for number, value in sorted(options, key=lambda option: option[0]):
+        delta, length = number - last, len(value)
+        head, extra = 0, b""
+        for shift, field in ((4, delta), (0, length)):
+            if field < 13:
+                head |= field << shift
+            elif field < 269:
+                head |= 13 << shift
+                extra += bytes([field - 13])
+            else:
+                head |= 14 << shift
+                extra += struct.pack(">H", field - 269)
+        out += bytes([head]) + extra + value
+        last = number
+    return bytes(out)
+
+
+def decode_message(data):
+    mtype = (data[0] >> 4) & 0x03
+    token_length = data[0] & 0x0F
+    code = data[1]
+    message_id = struct.unpack(">H", data[2:4])[0]
+    token = data[4:4 + token_length]
+    pos = 4 + token_length
+    options = {}
+    number = 0
+    while pos < len(data) and data[pos] != 0xFF:
+        delta, length = data[pos] >> 4, data[pos] & 0x0F
+        pos += 1
+        if delta == 13:
+            delta = 13 + data[pos]
+            pos += 1
+        elif delta == 14:
+            delta = 269 + struct.unpack(">H", data[pos:pos + 2])[0]
+            pos += 2
+        if length == 13:
+            length = 13 + data[pos]
+            pos += 1
+        elif length == 14:
+            length = 269 + struct.unpack(">H", data[pos:pos + 2])[0]
+            pos += 2
+        number += delta
+        options.setdefault(number, []).append(data[pos:pos + length])
+        pos += length
+    payload = data[pos + 1:] if pos < len(data) else b""
+    return {"type": mtype, "code": code, "id": message_id, "token": token,
+            "options": options, "payload": payload}
+
+
+def option_uint(message, number):
+    values = message["options"].get(number)
+    return int.from_bytes(values[0], "big") if values else None
+
+
+def path_options(path):
+    return [(OPTION_URI_PATH, segment.encode()) for segment in path.strip("/").split("/") if segment]
+
+
+# --- Client -----------------------------------------------------------------
+
+class Client:
+    def __init__(self, host, port, timeout=2.0):
+        self.address = (socket.gethostbyname(host), port)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(timeout)
+        self.message_id = random.randrange(1 << 16)
+
+    def next_id(self):
+        self.message_id = (self.message_id + 1) & 0xFFFF
+        return self.message_id
+
+    def receive(self):
+        data, _ = self.sock.recvfrom(1500)
+        return decode_message(data)
+
+    def acknowledge(self, message):
+        if message["type"] == CON:
+            self.sock.sendto(encode_message(ACK, 0, message["id"], b"", []), self.address)
+
+    def request(self, path, token, extra_options=(), attempts=4):
+        """Confirmable GET with retransmission; returns the response."""
+        message_id = self.next_id()
+        packet = encode_message(CON, GET, message_id, token, path_options(path) + list(extra_options))
+        for _ in range(attempts):
+            self.sock.sendto(packet, self.address)
+            deadline = time.time() + self.sock.gettimeout()
+            while time.time() < deadline:
+                try:
+                    reply = self.receive()
+                except socket.timeout:
+                    break
+                if reply["token"] == token and reply["code"] != 0:
+                    self.acknowledge(reply)
+                    return reply
+        raise CoapError("no response from %s:%d" % self.address)
+
+    def fetch(self, path, block_szx=None, first=None, observe=None):
+        """Whole representation, following Block2. Returns (first response, payload)."""
+        token = os.urandom(4)
+        options = []
+        if observe is not None:
+            options.append((OPTION_OBSERVE, encode_uint(observe)))
+        if block_szx is not None:
+            options.append((OPTION_BLOCK2, encode_uint(block_szx)))
+        response = first or self.request(path, token, options)
+        if response["code"] >> 5 != 2:
+            raise CoapError("%s %s" % (code_text(response["code"]), path))
+
+        payload = response["payload"]
+        etag = response["options"].get(OPTION_ETAG)
+        block = option_uint(response, OPTION_BLOCK2)
+        while block is not None and block & 0x08:
+            number, szx = (block >> 4) + 1, block & 0x07
+            reply = self.request(path, os.urandom(4), [(OPTION_BLOCK2, encode_uint(number << 4 | szx))])
+            if reply["code"] >> 5 != 2:
+                raise CoapError("%s %s, block %d" % (code_text(reply["code"]), path, number))
+            if reply["options"].get(OPTION_ETAG) != etag:
+                # Representation changed between blocks: start over
+                return self.fetch(path, block_szx)
+            payload += reply["payload"]
+            block = option_uint(reply, OPTION_BLOCK2)
+        return response, payload
+
+
+def decode_payload(response, payload):
+    if option_uint(response, OPTION_CONTENT_FORMAT) == FORMAT_CBOR:
+        return cbor_decode(payload)[0]
+    return payload.decode("utf-8", "replace")
+
+
+def show(value):
+    return json.dumps(value, ensure_ascii=False) if not isinstance(value, str) else value
+
+
+def observe(client, path, seconds, block_szx):
+    token = os.urandom(4)
+    options = [(OPTION_OBSERVE, b"")]
+    if block_szx is not None:
+        options.append((OPTION_BLOCK2, encode_uint(block_szx)))
+    response = client.request(path, token, options)
+    if OPTION_OBSERVE not in response["options"]:
+        print("not registered (%s) - the observer table may be full" % code_text(response["code"]))
+    _, payload = client.fetch(path, block_szx, first=response)
+    print("%s  %s" % (time.strftime("%H:%M:%S"), show(decode_payload(response, payload))))
+
+    deadline = time.time() + seconds
+    while time.time() < deadline:
+        try:
+            message = client.receive()
+        except socket.timeout:
+            continue
+        if message["token"] != token:
+            continue
+        client.acknowledge(message)
+        if message["code"] >> 5 != 2:
+            print("%s  %s - observation ended" % (time.strftime("%H:%M:%S"), code_text(message["code"])))
+            return
+        # A block-wise notification carries the first block; fetch the rest
+        _, payload = client.fetch(path, block_szx, first=message)
+        kind = "CON" if message["type"] == CON else "NON"
+        print("%s  #%s %s %s" % (time.strftime("%H:%M:%S"), option_uint(message, OPTION_OBSERVE), kind,
+                                 show(decode_payload(message, payload))))
+
+    client.request(path, token, [(OPTION_OBSERVE, encode_uint(1))])
+    print("observation cancelled")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=5683)
+    sub = parser.add_subparsers(dest="command", required=True)
+    sub.add_parser("discover")
+    get = sub.add_parser("get")
+    get.add_argument("path")
+    get.add_argument("--block-size", type=int, choices=[16, 32, 64, 128, 256, 512])
+    watch = sub.add_parser("observe")
+    watch.add_argument("path")
+    watch.add_argument("--seconds", type=int, default=60)
+    watch.add_argument("--block-size", type=int, choices=[16, 32, 64, 128, 256, 512])
+    args = parser.parse_args()
+
+    client = Client(args.host, args.port)
+    szx = None
+    if getattr(args, "block_size", None):
+        szx = args.block_size.bit_length() - 5
+    try:
+        if args.command == "discover":
+            response, payload = client.fetch("/.well-known/core")
+            for link in payload.decode().split(","):
+                print(link)
+        elif args.command == "get":
+            response, payload = client.fetch(args.path, szx)
+            size = option_uint(response, OPTION_SIZE2)
+            value = decode_payload(response, payload)
+            if isinstance(value, list):
+                for item in value:
+                    print(show(item))
+            else:
+                print(show(value))
+            if size is not None:
+                print("(%d bytes in blocks of %d)" % (size, 16 << (option_uint(response, OPTION_BLOCK2) & 7)))
+        else:
+            observe(client, args.path, args.seconds, szx)
+    except CoapError as error:
+        raise SystemExit("coap: %s" % error)
+
+
+if __name__ == "__main__":
+    main()
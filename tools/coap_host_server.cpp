@@ -0,0 +1,123 @@
+// coap_host_server.cpp
+// Serves CoapServer on the host with synthetic sensors whose readings drift
+// every few seconds and two relays that toggle every 15 s. Lets resources,
+// block-wise transfer and Observe be exercised with any CoAP client
+// (tools/coap_client.py, libcoap's coap-client, aiocoap) without a board.
+// Twenty sensors make /sensors span several 512-byte blocks, and the fourth
+// one drops out between 20 and 30 s of every minute, so its observers get the
+// final 4.04.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -Iinclude -o /tmp/coap_host_server tools/coap_host_server.cpp
+//       src/CoapServer.cpp src/CborWriter.cpp src/PayloadWriter.cpp
+//   /tmp/coap_host_server [port]     (default 5683)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include "CoapServer.h"
+
+static const size_t SENSOR_COUNT = 20;
+static const uint8_t RELAYS = 2;
+
+static int sock = -1;
+
+static uint32_t millisNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint32_t>(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+static void sendMessage(const CoapEndpoint& destination, const uint8_t* message, size_t length, void*) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    memcpy(&address.sin_addr.s_addr, destination.ip, 4);
+    address.sin_port = htons(destination.port);
+    sendto(sock, message, length, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+}
+
+static size_t fillSamples(CoapSensorSample* samples, uint32_t uptime) {
+    size_t count = 0;
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        if (i == 3 && uptime % 60 >= 20 && uptime % 60 < 30) continue;
+
+        CoapSensorSample& s = samples[count++];
+        memset(&s, 0, sizeof(s));
+        s.address[0] = 0x28;
+        s.address[1] = static_cast<uint8_t>(0x10 + i);
+        s.address[7] = static_cast<uint8_t>(0xA0 + i);
+        s.temperature = 20.0f + i + 0.0625f * static_cast<float>((uptime / 5) % 16);
+        s.health = SensorHealth::ACTIVE;
+        s.valid = true;
+        if (i == 2 && uptime % 30 >= 25) s.anomalyMask = 0x01;
+    }
+
+    // The last sensor has never answered, as a disconnected probe would
+    CoapSensorSample& missing = samples[count - 1];
+    missing.temperature = SensorTable::NO_READING_C;
+    missing.health = SensorHealth::QUARANTINED;
+    missing.valid = false;
+    return count;
+}
+
+int main(int argc, char** argv) {
+    int port = argc > 1 ? atoi(argv[1]) : 5683;
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        fprintf(stderr, "bind to port %d failed: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    CoapServer server;
+    server.begin(sendMessage, nullptr, static_cast<uint16_t>(millisNow()));
+    printf("CoAP host server on 127.0.0.1:%d, %zu sensors, %u relays\n", port, SENSOR_COUNT, RELAYS);
+    fflush(stdout);
+
+    CoapSensorSample samples[SENSOR_COUNT];
+    bool relays[RELAYS] = {false, false};
+    uint8_t packet[1500];
+    uint32_t start = millisNow();
+    uint32_t lastRefresh = start - 1000;
+
+    while (true) {
+        // Stands in for the new-snapshot event of the OneWire task
+        uint32_t now = millisNow();
+        if (now - lastRefresh >= 1000) {
+            uint32_t uptime = (now - start) / 1000;
+            relays[0] = (uptime / 15) % 2;
+            relays[1] = (uptime / 30) % 2;
+            size_t count = fillSamples(samples, uptime);
+            server.refresh(samples, count, relays, RELAYS);
+            lastRefresh = now;
+        }
+
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(sock, &readSet);
+        timeval timeout = {0, 100000};
+        if (select(sock + 1, &readSet, nullptr, nullptr, &timeout) <= 0) continue;
+
+        sockaddr_in peer = {};
+        socklen_t peerLength = sizeof(peer);
+        ssize_t received = recvfrom(sock, packet, sizeof(packet), 0,
+                                    reinterpret_cast<sockaddr*>(&peer), &peerLength);
+        if (received <= 0) continue;
+
+        CoapEndpoint source = {};
+        memcpy(source.ip, &peer.sin_addr.s_addr, 4);
+        source.port = ntohs(peer.sin_port);
+        server.handleMessage(packet, static_cast<size_t>(received), source);
+    }
+}
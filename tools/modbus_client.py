@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+Minimal Modbus TCP client for the hub's register map (see
+include/ModbusRegisterMap.h). Reads the header and every occupied sensor slot
+and prints them decoded; optionally writes a relay coil. No dependencies
+beyond the standard library, so it also works against
+tools/modbus_host_server.cpp on a development machine.
+
+Usage:
+    tools/modbus_client.py --host 192.168.1.50
+    tools/modbus_client.py --host 127.0.0.1 --port 1502 --coil 0 --state on
+"""
+
+import argparse
+import socket
+import struct
+
+HEADER_REGISTERS = 8
+REGISTERS_PER_SENSOR = 8
+MAX_READ = 125
+HEALTH = {0: "active", 1: "suspect", 2: "quarantined"}
+
+
+class ModbusError(Exception):
+    pass
+
+
+class Client:
+    def __init__(self, host, port, unit=1, timeout=3.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.unit = unit
+        self.transaction = 0
+
+    def request(self, pdu):
+        self.transaction = (self.transaction + 1) & 0xFFFF
+        self.sock.sendall(struct.pack(">HHHB", self.transaction, 0, len(pdu) + 1, self.unit) + pdu)
+        header = self.recv_exact(7)
+        transaction, _, length, _ = struct.unpack(">HHHB", header)
+        body = self.recv_exact(length - 1)
+        if transaction != self.transaction:
+            raise ModbusError("transaction id mismatch")
+        if body[0] & 0x80:
+            raise ModbusError("exception %d for function %d" % (body[1], body[0] & 0x7F))
+        return body
+
+    def recv_exact(self, count):
+        data = b""
+        while len(data) < count:
+            chunk = self.sock.recv(count - len(data))
+            if not chunk:
+                raise ModbusError("connection closed")
+            data += chunk
+        return data
+
+    def read_input_registers(self, start, count):
+        values = []
+        while count > 0:
+            n = min(count, MAX_READ)
+            body = self.request(struct.pack(">BHH", 0x04, start, n))
+            values += struct.unpack(">%dH" % n, body[2:2 + 2 * n])
+            start += n
+            count -= n
+        return values
+
+    def read_coils(self, count):
+        body = self.request(struct.pack(">BHH", 0x01, 0, count))
+        return [bool(body[2 + i // 8] & (1 << (i % 8))) for i in range(count)]
+
+    def write_coil(self, coil, state):
+        self.request(struct.pack(">BHH", 0x05, coil, 0xFF00 if state else 0x0000))
+
+
+def signed(value):
+    return value - 0x10000 if value & 0x8000 else value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=502)
+    parser.add_argument("--unit", type=int, default=1)
+    parser.add_argument("--coil", type=int, help="relay coil to write")
+    parser.add_argument("--state", choices=["on", "off"], default="on")
+    args = parser.parse_args()
+
+    client = Client(args.host, args.port, args.unit)
+    if args.coil is not None:
+        client.write_coil(args.coil, args.state == "on")
+        print("coil %d set %s" % (args.coil, args.state))
+
+    version, slots, present, relays, up_hi, up_lo, sequence, _ = client.read_input_registers(0, HEADER_REGISTERS)
+    print("layout v%d, %d slots, %d sensors present, %d relays, uptime %ds, image #%d"
+          % (version, slots, present, relays, (up_hi << 16) | up_lo, sequence))
+
+    block = client.read_input_registers(HEADER_REGISTERS, slots * REGISTERS_PER_SENSOR)
+    for slot in range(slots):
+        status, raw, temperature, age, *rom = block[slot * REGISTERS_PER_SENSOR:(slot + 1) * REGISTERS_PER_SENSOR]
+        if not any(rom):
+            continue
+        address = "".join("%04X" % word for word in rom)
+        if not status & 0x01:
+            print("slot %2d  %s  absent" % (slot, address))
+            continue
+        flags = [HEALTH.get((status >> 2) & 0x03, "?")]
+        if status & 0x02:
+            flags.append("valid")
+        if status & 0x10:
+            flags.append("virtual")
+        if status >> 8:
+            flags.append("anomalies 0x%X" % (status >> 8))
+        age_text = "never" if age == 0xFFFF else "%ds ago" % age
+        print("slot %2d  %s  %7.2f °C  raw %8.4f °C  %s  %s"
+              % (slot, address, signed(temperature) / 100.0, signed(raw) / 128.0, age_text, ", ".join(flags)))
+
+    if relays:
+        states = client.read_coils(relays)
+        print("relays: " + ", ".join("%d=%s" % (i, "on" if s else "off") for i, s in enumerate(states)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,171 @@
+// modbus_host_server.cpp
+// Serves ModbusRegisterMap over Modbus TCP on the host, with a handful of
+// synthetic sensors whose readings drift every second and two relay coils.
+// Lets the register layout and protocol handling be exercised with any
+// Modbus client (tools/modbus_client.py, mbpoll, a PLC simulator) without a
+// board. Sensors 3 and 4 swap places every 10 s to check slot stability.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -Iinclude -o /tmp/modbus_host_server tools/modbus_host_server.cpp
+//       src/ModbusRegisterMap.cpp src/SensorSlots.cpp
+//   /tmp/modbus_host_server [port]     (default 1502)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include "ModbusRegisterMap.h"
+
+static const size_t SENSOR_COUNT = 5;
+static const size_t MAX_CLIENTS = 4;
+static const uint8_t RELAYS = 2;
+
+struct Client {
+    int socket;
+    size_t length;
+    uint8_t buffer[MODBUS_MAX_ADU];
+};
+
+static bool relayStates[RELAYS] = {false, false};
+
+static bool writeCoil(uint16_t coil, bool state, void*) {
+    if (coil >= RELAYS) return false;
+    relayStates[coil] = state;
+    printf("relay %u -> %s\n", coil, state ? "on" : "off");
+    return true;
+}
+
+static void fillSamples(ModbusSensorSample* samples, uint32_t uptime) {
+    for (size_t i = 0; i < SENSOR_COUNT; i++) {
+        ModbusSensorSample& s = samples[i];
+        memset(&s, 0, sizeof(s));
+        s.address[0] = 0x28;
+        s.address[1] = static_cast<uint8_t>(0x10 + i);
+        s.address[7] = static_cast<uint8_t>(0xA0 + i);
+        float celsius = 20.0f + i + 0.0625f * static_cast<float>(uptime % 16);
+        s.raw = static_cast<int16_t>(celsius * 128.0f);
+        s.temperature = celsius;
+        s.ageSeconds = 0;
+        s.health = SensorHealth::ACTIVE;
+        s.valid = true;
+    }
+    
+    // The last sensor reads nothing, as a disconnected probe would
+    ModbusSensorSample& missing = samples[SENSOR_COUNT - 1];
+    missing.raw = SensorTable::NO_READING_RAW;
+    missing.temperature = SensorTable::NO_READING_C;
+    missing.ageSeconds = UINT32_MAX;
+    missing.health = SensorHealth::QUARANTINED;
+    missing.valid = false;
+    
+    if ((uptime / 10) % 2) {
+        ModbusSensorSample swap = samples[2];
+        samples[2] = samples[3];
+        samples[3] = swap;
+    }
+}
+
+int main(int argc, char** argv) {
+    int port = argc > 1 ? atoi(argv[1]) : 1502;
+    
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, MAX_CLIENTS) != 0) {
+        fprintf(stderr, "listen on port %d failed: %s\n", port, strerror(errno));
+        return 1;
+    }
+    printf("Modbus TCP host server on 127.0.0.1:%d, %zu sensors, %u coils\n",
+           port, SENSOR_COUNT, RELAYS);
+    fflush(stdout);
+    
+    ModbusRegisterMap map;
+    ModbusSensorSample samples[SENSOR_COUNT];
+    Client clients[MAX_CLIENTS];
+    for (auto& client : clients) client.socket = -1;
+    uint8_t response[MODBUS_MAX_ADU];
+    time_t start = time(nullptr);
+    time_t lastRefresh = -1;
+    
+    while (true) {
+        time_t now = time(nullptr);
+        if (now != lastRefresh) {
+            uint32_t uptime = static_cast<uint32_t>(now - start);
+            fillSamples(samples, uptime);
+            if (map.refresh(samples, SENSOR_COUNT, relayStates, RELAYS, uptime)) {
+                printf("slot assignment changed\n");
+                fflush(stdout);
+            }
+            lastRefresh = now;
+        }
+        
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(listener, &readSet);
+        int maxSocket = listener;
+        for (auto& client : clients) {
+            if (client.socket < 0) continue;
+            FD_SET(client.socket, &readSet);
+            if (client.socket > maxSocket) maxSocket = client.socket;
+        }
+        
+        timeval timeout = {0, 250000};
+        if (select(maxSocket + 1, &readSet, nullptr, nullptr, &timeout) <= 0) continue;
+        
+        if (FD_ISSET(listener, &readSet)) {
+            int sock = accept(listener, nullptr, nullptr);
+            Client* slot = nullptr;
+            for (auto& client : clients) {
+                if (client.socket < 0) { slot = &client; break; }
+            }
+            if (sock >= 0 && slot) {
+                int noDelay = 1;
+                setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                slot->socket = sock;
+                slot->length = 0;
+            } else if (sock >= 0) {
+                close(sock);
+            }
+        }
+        
+        for (auto& client : clients) {
+            if (client.socket < 0 || !FD_ISSET(client.socket, &readSet)) continue;
+            ssize_t received = recv(client.socket, client.buffer + client.length,
+                                    sizeof(client.buffer) - client.length, 0);
+            if (received <= 0) {
+                close(client.socket);
+                client.socket = -1;
+                continue;
+            }
+            client.length += static_cast<size_t>(received);
+            
+            while (client.socket >= 0) {
+                size_t frame = ModbusRegisterMap::frameLength(client.buffer, client.length);
+                if (frame == ModbusRegisterMap::INVALID_FRAME) {
+                    printf("malformed frame - closing connection\n");
+                    close(client.socket);
+                    client.socket = -1;
+                    break;
+                }
+                if (frame == 0) break;
+                
+                size_t length = map.handleRequest(client.buffer, frame, response, true, writeCoil, nullptr);
+                if (length > 0) send(client.socket, response, length, 0);
+                memmove(client.buffer, client.buffer + frame, client.length - frame);
+                client.length -= frame;
+            }
+        }
+    }
+}
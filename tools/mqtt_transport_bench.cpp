@@ -0,0 +1,391 @@
+// mqtt_transport_bench.cpp
+// Host benchmark of the two MQTT publish disciplines behind MqttTransport,
+// against a stand-in broker on the loopback interface. The broker accepts
+// MQTT 3.1.1 CONNECT and PUBLISH and answers QoS 1 publishes with PUBACK.
+// The link is simulated: a publish counts as delivered half a round trip
+// after it reaches the broker, and its PUBACK is sent a full round trip after.
+//
+//   pubsubclient            QoS 0, blocking write, then the 50 ms settle delay
+//                           PubSubClientTransport keeps from the old publish()
+//   pubsubclient, no settle the same without the delay: the floor of QoS 0,
+//                           with no acknowledgement
+//   qos1 window 1           stop-and-wait: each publish waits for its PUBACK
+//   qos1 window 8           EspMqttTransport: publish() returns once the
+//                           message is queued and a slot is free, PUBACKs are
+//                           read on another thread and free their slot
+//
+// The client side models the backends' publish paths, not the libraries
+// themselves; neither PubSubClient nor esp-mqtt builds on the host. The
+// workload is the hub's publication cycle: four topics per sensor, 16 sensors.
+// "blocked" is the time the caller, the network task on the device, spends
+// inside publish(); "latency" runs from the publish() call to delivery (QoS 0)
+// or to the PUBACK (QoS 1).
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -pthread -o /tmp/mqtt_transport_bench tools/mqtt_transport_bench.cpp
+//   /tmp/mqtt_transport_bench [round trip ms] [cycles]     (default 20 ms, 2 cycles)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* const LEAVES[] = {"temperature", "raw", "status", "last_update"};
+static const size_t SENSORS = 16;
+
+struct Message {
+    std::string topic;
+    std::string payload;
+};
+
+struct Mode {
+    const char* name;
+    uint8_t qos;
+    size_t window;
+    uint32_t settleMs;
+};
+
+static const Mode MODES[] = {
+    {"pubsubclient", 0, 1, 50},
+    {"pubsubclient, no settle", 0, 1, 0},
+    {"qos1 window 1", 1, 1, 0},
+    {"qos1 window 8", 1, 8, 0},
+};
+
+static double msSince(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static bool writeAll(int fd, const std::vector<uint8_t>& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool readAll(int fd, uint8_t* data, size_t length) {
+    size_t received = 0;
+    while (received < length) {
+        ssize_t n = recv(fd, data + received, length - received, 0);
+        if (n <= 0) return false;
+        received += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Fixed header byte and body of the next packet
+static bool readPacket(int fd, uint8_t& header, std::vector<uint8_t>& body) {
+    if (!readAll(fd, &header, 1)) return false;
+    size_t length = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        uint8_t byte;
+        if (!readAll(fd, &byte, 1)) return false;
+        length |= static_cast<size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    body.resize(length);
+    return length == 0 || readAll(fd, body.data(), length);
+}
+
+static void appendLength(std::vector<uint8_t>& out, size_t length) {
+    do {
+        uint8_t byte = length & 0x7F;
+        length >>= 7;
+        out.push_back(length ? byte | 0x80 : byte);
+    } while (length);
+}
+
+static void appendString(std::vector<uint8_t>& out, const std::string& text) {
+    out.push_back(static_cast<uint8_t>(text.size() >> 8));
+    out.push_back(static_cast<uint8_t>(text.size()));
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+static std::vector<uint8_t> connectPacket() {
+    std::vector<uint8_t> body;
+    appendString(body, "MQTT");
+    body.push_back(4);          // 3.1.1
+    body.push_back(0x02);       // Clean session
+    body.push_back(0);
+    body.push_back(15);         // Keepalive
+    appendString(body, "ESP32-bench");
+    std::vector<uint8_t> packet = {0x10};
+    appendLength(packet, body.size());
+    packet.insert(packet.end(), body.begin(), body.end());
+    return packet;
+}
+
+static std::vector<uint8_t> publishPacket(const Message& message, uint8_t qos, uint16_t packetId) {
+    std::vector<uint8_t> body;
+    appendString(body, message.topic);
+    if (qos > 0) {
+        body.push_back(static_cast<uint8_t>(packetId >> 8));
+        body.push_back(static_cast<uint8_t>(packetId));
+    }
+    body.insert(body.end(), message.payload.begin(), message.payload.end());
+    std::vector<uint8_t> packet = {static_cast<uint8_t>(0x30 | qos << 1 | 1)};
+    appendLength(packet, body.size());
+    packet.insert(packet.end(), body.begin(), body.end());
+    return packet;
+}
+
+// One connection of the stand-in broker
+class Broker {
+public:
+    explicit Broker(uint32_t roundTripMs) : roundTrip(std::chrono::milliseconds(roundTripMs)) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listener, 1) != 0) {
+            perror("broker");
+            exit(1);
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+        reader = std::thread(&Broker::readLoop, this);
+        acker = std::thread(&Broker::ackLoop, this);
+    }
+
+    ~Broker() {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        reader.join();
+        acker.join();
+        close(listener);
+    }
+
+    uint16_t getPort() const { return port; }
+
+    // Delivery times in arrival order
+    std::vector<Clock::time_point> deliveries() {
+        std::lock_guard<std::mutex> guard(mutex);
+        return delivered;
+    }
+
+private:
+    void readLoop() {
+        connection = accept(listener, nullptr, nullptr);
+        int one = 1;
+        setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        uint8_t header;
+        std::vector<uint8_t> body;
+        while (readPacket(connection, header, body)) {
+            uint8_t type = header >> 4;
+            if (type == 1) {
+                writeAll(connection, {0x20, 0x02, 0x00, 0x00});
+            } else if (type == 3) {
+                Clock::time_point arrival = Clock::now();
+                uint8_t qos = (header >> 1) & 0x03;
+                std::lock_guard<std::mutex> guard(mutex);
+                delivered.push_back(arrival + roundTrip / 2);
+                if (qos > 0) {
+                    size_t topicLength = static_cast<size_t>(body[0]) << 8 | body[1];
+                    uint16_t packetId = static_cast<uint16_t>(body[2 + topicLength] << 8 | body[3 + topicLength]);
+                    acks.push_back(PendingAck{arrival + roundTrip, packetId});
+                    wake.notify_all();
+                }
+            } else if (type == 14) {
+                break;
+            }
+        }
+        close(connection);
+        std::lock_guard<std::mutex> guard(mutex);
+        connectionClosed = true;
+        wake.notify_all();
+    }
+
+    // PUBACKs go out a round trip after their publish arrived
+    void ackLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || connectionClosed || !acks.empty(); });
+            if (acks.empty()) {
+                if (stopping || connectionClosed) return;
+                continue;
+            }
+            PendingAck ack = acks.front();
+            if (Clock::now() < ack.due) {
+                wake.wait_until(lock, ack.due);
+                continue;
+            }
+            acks.pop_front();
+            lock.unlock();
+            writeAll(connection, {0x40, 0x02, static_cast<uint8_t>(ack.packetId >> 8),
+                                  static_cast<uint8_t>(ack.packetId)});
+            lock.lock();
+        }
+    }
+
+    struct PendingAck {
+        Clock::time_point due;
+        uint16_t packetId;
+    };
+
+    Clock::duration roundTrip;
+    int listener = -1;
+    int connection = -1;
+    uint16_t port = 0;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<PendingAck> acks;
+    std::vector<Clock::time_point> delivered;
+    bool stopping = false;
+    bool connectionClosed = false;
+    std::thread reader;
+    std::thread acker;
+};
+
+struct Result {
+    double totalMs;
+    double blockedMs;
+    std::vector<double> latencies;
+};
+
+static int connectClient(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        perror("connect");
+        exit(1);
+    }
+    writeAll(fd, connectPacket());
+    uint8_t header;
+    std::vector<uint8_t> body;
+    if (!readPacket(fd, header, body) || header != 0x20) {
+        fprintf(stderr, "no CONNACK\n");
+        exit(1);
+    }
+    return fd;
+}
+
+static Result run(const Mode& mode, const std::vector<Message>& messages, uint32_t roundTripMs) {
+    Broker broker(roundTripMs);
+    int fd = connectClient(broker.getPort());
+    Result result = {0, 0, {}};
+    std::vector<Clock::time_point> calls(messages.size());
+    std::vector<Clock::time_point> acked(messages.size());
+
+    // Acknowledgements free window slots from their own thread, as esp-mqtt's task does
+    std::mutex mutex;
+    std::condition_variable slotFreed;
+    size_t inFlight = 0;
+    std::thread ackReader;
+    if (mode.qos > 0) {
+        ackReader = std::thread([&] {
+            uint8_t header;
+            std::vector<uint8_t> body;
+            for (size_t received = 0; received < messages.size(); received++) {
+                if (!readPacket(fd, header, body) || header >> 4 != 4) return;
+                uint16_t packetId = static_cast<uint16_t>(body[0] << 8 | body[1]);
+                std::lock_guard<std::mutex> guard(mutex);
+                acked[packetId - 1] = Clock::now();
+                inFlight--;
+                slotFreed.notify_all();
+            }
+        });
+    }
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < messages.size(); i++) {
+        calls[i] = Clock::now();
+        if (mode.qos > 0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            slotFreed.wait(lock, [&] { return inFlight < mode.window; });
+            inFlight++;
+        }
+        writeAll(fd, publishPacket(messages[i], mode.qos, static_cast<uint16_t>(i + 1)));
+        if (mode.settleMs) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(mode.settleMs));
+        }
+        result.blockedMs += msSince(calls[i], Clock::now());
+    }
+
+    if (mode.qos > 0) {
+        ackReader.join();
+    } else {
+        // Until the broker has seen everything
+        while (broker.deliveries().size() < messages.size()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    Clock::time_point end = Clock::now();
+    writeAll(fd, {0xE0, 0x00});
+    close(fd);
+
+    std::vector<Clock::time_point> delivered = broker.deliveries();
+    result.totalMs = msSince(start, std::max(end, delivered.back()));
+    for (size_t i = 0; i < messages.size(); i++) {
+        result.latencies.push_back(msSince(calls[i], mode.qos > 0 ? acked[i] : delivered[i]));
+    }
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+int main(int argc, char** argv) {
+    uint32_t roundTripMs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20;
+    size_t cycles = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2;
+    if (cycles == 0) cycles = 2;
+
+    std::vector<Message> messages;
+    for (size_t cycle = 0; cycle < cycles; cycle++) {
+        for (size_t sensor = 0; sensor < SENSORS; sensor++) {
+            char rom[17];
+            snprintf(rom, sizeof(rom), "28AA1000304%02zX5C", sensor);
+            for (const char* leaf : LEAVES) {
+                Message message;
+                message.topic = std::string("chaoticvolt/sensorhub1/sensors/") + rom + "/" + leaf;
+                message.payload = strcmp(leaf, "status") == 0 ? "online" :
+                                  strcmp(leaf, "last_update") == 0 ? "86400012" : "21.53";
+                messages.push_back(message);
+            }
+        }
+    }
+
+    printf("%zu publishes (%zu cycles of %zu sensors x 4 topics), round trip %u ms\n\n",
+           messages.size(), cycles, SENSORS, roundTripMs);
+    printf("%-24s %10s %10s %12s %12s %12s\n", "", "msg/s", "total ms", "blocked ms", "latency p50",
+           "latency p95");
+    for (const Mode& mode : MODES) {
+        Result result = run(mode, messages, roundTripMs);
+        printf("%-24s %10.0f %10.0f %12.2f %12.1f %12.1f\n", mode.name,
+               messages.size() * 1000.0 / result.totalMs, result.totalMs,
+               result.blockedMs / messages.size(), percentile(result.latencies, 0.5),
+               percentile(result.latencies, 0.95));
+    }
+    printf("\nblocked: average time per publish() call\n");
+    return 0;
+}
@@ -0,0 +1,231 @@
+// payload_encoding_bench.cpp
+// Host benchmark for PayloadEncoding. Compares size and encode time of CBOR
+// and MessagePack against the text payloads for 16 and 128 sensors:
+//
+//   /api/sensors   the whole sensor list as one document
+//   MQTT           the four per-sensor topics (temperature, raw, status,
+//                  last_update), payloads only
+//
+// The JSON column is the document WebServer::createSensorJson() produces, in
+// the same member order and float precision, written here with snprintf
+// since ArduinoJson is not available on the host. On the device ArduinoJson
+// also builds the document in memory before serializing it, so its real cost
+// is above the figure shown. Readings are 12-bit DS18B20 values; filtered
+// temperatures are not multiples of 1/16 °C, as after the EMA filter.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -Iinclude -o /tmp/payload_encoding_bench tools/payload_encoding_bench.cpp
+//       src/PayloadEncoding.cpp src/PayloadWriter.cpp src/CborWriter.cpp src/MsgPackWriter.cpp
+//       src/SensorStatistics.cpp src/AnomalyDetector.cpp src/SensorFilter.cpp
+//   /tmp/payload_encoding_bench [iterations]     (default 20000)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "PayloadEncoding.h"
+
+static const size_t SENSOR_COUNTS[] = {16, 128};
+
+struct SensorFixture {
+    std::vector<SensorRecord> records;
+    std::vector<std::vector<char>> names;
+};
+
+// Every third sensor named, every fifth with an anomaly, one quarantined, one
+// virtual, the first one on the display
+static void makeSensors(size_t count, SensorFixture& fixture) {
+    fixture.records.resize(count);
+    fixture.names.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        SensorRecord& s = fixture.records[i];
+        memset(&s, 0, sizeof(s));
+        const uint8_t address[8] = {0x28, 0xAA, 0x10, static_cast<uint8_t>(i >> 8), 0x30,
+                                    0x40, static_cast<uint8_t>(i), 0x5C};
+        memcpy(s.address, address, 8);
+        int32_t raw = 2560 + static_cast<int32_t>((i * 97) % 1280);
+        s.rawTemperature = raw / 128.0f;
+        s.temperature = s.rawTemperature + 0.0137f * (i % 7 + 1);
+        s.lastReadTime = 86400000u + static_cast<uint32_t>(i) * 12;
+        s.health = SensorHealth::ACTIVE;
+        s.valid = true;
+        if (i % 3 == 0) {
+            fixture.names[i].resize(24);
+            snprintf(fixture.names[i].data(), 24, "Zone %u flow", static_cast<unsigned>(i));
+            s.name = fixture.names[i].data();
+        }
+        if (i % 5 == 4) s.anomalyMask = static_cast<uint8_t>(AnomalyType::RATE);
+    }
+    SensorRecord& offline = fixture.records[count / 2];
+    offline.health = SensorHealth::QUARANTINED;
+    offline.valid = false;
+    offline.offlineSince = 86000000u;
+    fixture.records[count - 1].isVirtual = true;
+    fixture.records[0].displaySensor = true;
+}
+
+// Appends like ArduinoJson's serializer: up to 9 significant digits
+static void appendFloat(std::vector<char>& out, float value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%.9g", static_cast<double>(value));
+    out.insert(out.end(), text, text + strlen(text));
+}
+
+static void append(std::vector<char>& out, const char* text) {
+    out.insert(out.end(), text, text + strlen(text));
+}
+
+static void appendUnsigned(std::vector<char>& out, uint32_t value) {
+    char text[12];
+    snprintf(text, sizeof(text), "%lu", static_cast<unsigned long>(value));
+    append(out, text);
+}
+
+// The /api/sensors JSON document
+static size_t encodeJson(const SensorFixture& fixture, std::vector<char>& out) {
+    static const char* HEALTH[] = {"active", "suspect", "offline"};
+    out.clear();
+    out.push_back('[');
+    for (size_t i = 0; i < fixture.records.size(); i++) {
+        const SensorRecord& s = fixture.records[i];
+        if (i > 0) out.push_back(',');
+        char address[17];
+        for (int b = 0; b < 8; b++) snprintf(address + 2 * b, 3, "%02X", s.address[b]);
+        append(out, "{\"address\":\"");
+        append(out, address);
+        out.push_back('"');
+        if (s.name) {
+            append(out, ",\"name\":\"");
+            append(out, s.name);
+            out.push_back('"');
+        }
+        append(out, ",\"temperature\":");
+        appendFloat(out, s.valid ? s.temperature : -127.0f);
+        append(out, ",\"rawTemperature\":");
+        appendFloat(out, s.valid ? s.rawTemperature : -127.0f);
+        append(out, s.valid ? ",\"valid\":true" : ",\"valid\":false");
+        append(out, ",\"lastReadTime\":");
+        appendUnsigned(out, s.lastReadTime);
+        if (s.isVirtual) {
+            append(out, ",\"virtual\":true");
+        } else {
+            append(out, ",\"health\":\"");
+            append(out, HEALTH[static_cast<int>(s.health)]);
+            out.push_back('"');
+            if (s.health == SensorHealth::QUARANTINED) {
+                append(out, ",\"offlineSince\":");
+                appendUnsigned(out, s.offlineSince);
+            }
+        }
+        if (s.anomalyMask) append(out, ",\"anomalies\":[\"rate\"]");
+        if (s.displaySensor) {
+            append(out, ",\"isBabelSensor\":true,\"babelTemperature\":");
+            appendFloat(out, s.temperature);
+        }
+        out.push_back('}');
+    }
+    out.push_back(']');
+    return out.size();
+}
+
+// The document as WebServer streams it: array head, then item by item
+static size_t encodeBinary(PayloadFormat format, const SensorFixture& fixture, std::vector<uint8_t>& out) {
+    uint8_t item[PayloadEncoding::MAX_SENSOR_ITEM];
+    out.clear();
+    size_t length = PayloadEncoding::encodeArrayHead(format, fixture.records.size(), item, sizeof(item));
+    out.insert(out.end(), item, item + length);
+    for (const SensorRecord& sensor : fixture.records) {
+        length = PayloadEncoding::encodeSensor(format, sensor, item, sizeof(item));
+        if (length == 0) {
+            fprintf(stderr, "sensor item does not fit\n");
+            exit(1);
+        }
+        out.insert(out.end(), item, item + length);
+    }
+    return out.size();
+}
+
+static const char* statusText(const SensorRecord& s) {
+    return s.health == SensorHealth::QUARANTINED ? "offline" : s.valid ? "online" : "error";
+}
+
+// Payload bytes of the four per-sensor MQTT topics, as MqttManager::publishSensorData() sends them
+static size_t mqttText(const SensorFixture& fixture) {
+    size_t total = 0;
+    char text[24];
+    for (const SensorRecord& s : fixture.records) {
+        total += snprintf(text, sizeof(text), "%.2f", s.temperature);
+        total += snprintf(text, sizeof(text), "%.2f", s.rawTemperature);
+        total += strlen(statusText(s));
+        total += snprintf(text, sizeof(text), "%lu", static_cast<unsigned long>(s.lastReadTime));
+    }
+    return total;
+}
+
+static size_t mqttBinary(PayloadFormat format, const SensorFixture& fixture) {
+    size_t total = 0;
+    uint8_t payload[16];
+    for (const SensorRecord& s : fixture.records) {
+        total += PayloadEncoding::encodeFloat(format, s.temperature, payload, sizeof(payload));
+        total += PayloadEncoding::encodeFloat(format, s.rawTemperature, payload, sizeof(payload));
+        total += PayloadEncoding::encodeText(format, statusText(s), payload, sizeof(payload));
+        total += PayloadEncoding::encodeUnsigned(format, s.lastReadTime, payload, sizeof(payload));
+    }
+    return total;
+}
+
+template <typename F>
+static double nsPerCall(F fn, uint32_t calls) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++) fn(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+int main(int argc, char** argv) {
+    uint32_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+    if (iterations == 0) iterations = 20000;
+
+    std::vector<char> json;
+    std::vector<uint8_t> binary;
+    volatile size_t sink = 0;
+    json.reserve(32768);
+    binary.reserve(32768);
+
+    for (size_t count : SENSOR_COUNTS) {
+        SensorFixture fixture;
+        makeSensors(count, fixture);
+        uint32_t calls = static_cast<uint32_t>(iterations * 16 / count);
+
+        size_t jsonBytes = encodeJson(fixture, json);
+        size_t cborBytes = encodeBinary(PayloadFormat::CBOR, fixture, binary);
+        size_t msgpackBytes = encodeBinary(PayloadFormat::MSGPACK, fixture, binary);
+        double jsonNs = nsPerCall([&](uint32_t) { sink = sink + encodeJson(fixture, json); }, calls);
+        double cborNs = nsPerCall([&](uint32_t) {
+            sink = sink + encodeBinary(PayloadFormat::CBOR, fixture, binary);
+        }, calls);
+        double msgpackNs = nsPerCall([&](uint32_t) {
+            sink = sink + encodeBinary(PayloadFormat::MSGPACK, fixture, binary);
+        }, calls);
+
+        size_t textMqtt = mqttText(fixture);
+        size_t cborMqtt = mqttBinary(PayloadFormat::CBOR, fixture);
+        size_t msgpackMqtt = mqttBinary(PayloadFormat::MSGPACK, fixture);
+        double textMqttNs = nsPerCall([&](uint32_t) { sink = sink + mqttText(fixture); }, calls);
+        double cborMqttNs = nsPerCall([&](uint32_t) {
+            sink = sink + mqttBinary(PayloadFormat::CBOR, fixture);
+        }, calls);
+        double msgpackMqttNs = nsPerCall([&](uint32_t) {
+            sink = sink + mqttBinary(PayloadFormat::MSGPACK, fixture);
+        }, calls);
+
+        printf("%zu sensors, %u runs\n", count, calls);
+        printf("%-26s %12s %12s %12s\n", "", "JSON/text", "CBOR", "MessagePack");
+        printf("%-26s %12zu %12zu %12zu\n", "/api/sensors bytes", jsonBytes, cborBytes, msgpackBytes);
+        printf("%-26s %12.0f %12.0f %12.0f\n", "/api/sensors ns", jsonNs, cborNs, msgpackNs);
+        printf("%-26s %12zu %12zu %12zu\n", "MQTT payload bytes", textMqtt, cborMqtt, msgpackMqtt);
+        printf("%-26s %12.0f %12.0f %12.0f\n\n", "MQTT encode ns", textMqttNs, cborMqttNs, msgpackMqttNs);
+    }
+    return 0;
+}
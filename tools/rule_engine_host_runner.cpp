@@ -0,0 +1,120 @@
+// rule_engine_host_runner.cpp
+// Runs the automation rule engine (RuleEngine.h) on the host against a
+// scripted feed of two sensors, and prints every relay action it reports.
+// The feed samples every 10 s for ten minutes: sensor A warms from 20 to
+// 35 °C and cools again, sensor B stays near 22 °C and drops out between
+// 400 and 450 s. Midway the rules are reloaded the way ControlTask does
+// after POST /api/rules: rule 0 is stored again unchanged and must keep its
+// state, rule 1 is disabled while active and must hand its relay back.
+// Rules with invalid hold times or too deep nesting must be rejected.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -Iinclude -o /tmp/rule_engine_host_runner
+//       tools/rule_engine_host_runner.cpp src/RuleEngine.cpp
+//   /tmp/rule_engine_host_runner ["condition for rule 0"]
+//   (sensors are T(28AA000000000001) and T(28BB000000000002))
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "RuleEngine.h"
+
+static const uint8_t SENSOR_A[8] = {0x28, 0xAA, 0, 0, 0, 0, 0, 0x01};
+static const uint8_t SENSOR_B[8] = {0x28, 0xBB, 0, 0, 0, 0, 0, 0x02};
+static const uint32_t STEP_SECONDS = 10;
+static const uint32_t RUN_SECONDS = 600;
+static const uint32_t RELOAD_AT = 300;
+
+static uint32_t microsNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint32_t>(now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
+static void onAction(uint8_t relay, bool state, uint8_t ruleId, void* context) {
+    uint32_t seconds = *static_cast<uint32_t*>(context);
+    printf("%5u s  rule %u -> relay %u %s\n", seconds, ruleId, relay, state ? "ON" : "OFF");
+}
+
+static RuleDefinition makeRule(const char* condition, uint8_t relay, bool action, uint32_t hold) {
+    RuleDefinition definition;
+    memset(&definition, 0, sizeof(definition));
+    definition.enabled = true;
+    snprintf(definition.condition, sizeof(definition.condition), "%s", condition);
+    definition.relay = relay;
+    definition.action = action;
+    definition.holdSeconds = hold;
+    return definition;
+}
+
+static bool load(RuleEngine& engine, uint8_t id, const RuleDefinition& definition) {
+    char error[64] = "";
+    if (!engine.setRule(id, definition, error, sizeof(error))) {
+        printf("rule %u rejected: %s\n", id, error);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* condition0 = argc > 1 ? argv[1] : "T(28AA000000000001) - T(28BB000000000002) > 5";
+    RuleDefinition rule0 = makeRule(condition0, 1, true, 60);
+    RuleDefinition rule1 = makeRule("T(28AA000000000001) > 30", 0, true, 0);
+
+    RuleEngine engine;
+    engine.setClock(microsNow);
+    if (!load(engine, 0, rule0) || !load(engine, 1, rule1)) {
+        return 1;
+    }
+
+    printf("rule 0: %s, relay 1 on for 60 s\n", condition0);
+    printf("rule 1: %s, relay 0 on\n", rule1.condition);
+
+    // Rejected like the API does: hold times above RULE_MAX_HOLD_SECONDS and
+    // conditions nested deeper than RULE_MAX_NESTING; the limit itself compiles
+    load(engine, 2, makeRule("T(28AA000000000001) > 0", 0, true, RULE_MAX_HOLD_SECONDS + 1));
+    char nested[RULE_MAX_SOURCE];
+    for (size_t levels = RULE_MAX_NESTING; levels <= RULE_MAX_NESTING + 1; levels++) {
+        size_t length = 0;
+        for (size_t i = 0; i < levels; i++) nested[length++] = '(';
+        length += snprintf(nested + length, sizeof(nested) - length, "T(28AA000000000001)");
+        for (size_t i = 0; i < levels; i++) nested[length++] = ')';
+        snprintf(nested + length, sizeof(nested) - length, " > 0");
+        if (load(engine, 3, makeRule(nested, 0, false, 0))) {
+            printf("rule 3 accepted: %zu levels of nesting\n", levels);
+        }
+    }
+    load(engine, 3, makeRule("!!!!!!!!!T(28AA000000000001)", 0, false, 0));
+    printf("\n");
+
+    for (uint32_t seconds = 0; seconds <= RUN_SECONDS; seconds += STEP_SECONDS) {
+        // Triangle ramp 20 -> 35 -> 20 °C over the run
+        uint32_t half = RUN_SECONDS / 2;
+        uint32_t phase = seconds <= half ? seconds : RUN_SECONDS - seconds;
+        float a = 20.0f + 15.0f * phase / half;
+        float b = 22.0f + ((seconds / STEP_SECONDS) % 3) * 0.1f;
+        bool bValid = seconds < 400 || seconds >= 450;
+
+        if (seconds == RELOAD_AT) {
+            printf("%5u s  reload: rule 0 unchanged, rule 1 disabled\n", seconds);
+            RuleDefinition disabled = rule1;
+            disabled.enabled = false;
+            load(engine, 0, rule0);
+            load(engine, 1, disabled);
+        }
+
+        uint32_t now = seconds * 1000;
+        engine.updateSensor(SENSOR_A, a, true, now);
+        engine.updateSensor(SENSOR_B, b, bValid, now);
+        engine.poll(now, onAction, &seconds);
+    }
+
+    printf("\n");
+    for (uint8_t id = 0; id < RULE_MAX_RULES; id++) {
+        RuleStats stats;
+        if (!engine.getStats(id, stats)) continue;
+        printf("rule %u: %u evaluations, %u triggers, max %u us, %s\n", id, stats.evaluations,
+               stats.triggers, stats.maxEvalMicros, stats.active ? "active" : "idle");
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+// sensor_layout_bench.cpp
+// Host benchmark for the OneWireManager sensor storage. Compares the former
+// layout (one vector of full TemperatureSensor structs, copied into a freshly
+// allocated vector on every read cycle) with SensorTable (hot/cold arrays
+// updated in place). Both run the same filter, rollup and anomaly code, so the
+// difference is the storage alone.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -O2 -Iinclude -o /tmp/sensor_layout_bench tools/sensor_layout_bench.cpp
+//       src/SensorTable.cpp src/SensorFilter.cpp src/SensorStatistics.cpp src/AnomalyDetector.cpp
+//   /tmp/sensor_layout_bench [sensors] [cycles]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <vector>
+#include "SensorTable.h"
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// TemperatureSensor as it was before the split
+struct LegacySensor {
+    uint8_t address[8];
+    char friendlyName[32];
+    float temperature;
+    float rawTemperature;
+    float lastValidReading;
+    uint32_t lastReadTime;
+    uint8_t consecutiveErrors;
+    SensorHealth health;
+    uint8_t probeFailures;
+    uint32_t nextProbeTime;
+    uint32_t offlineSince;
+    bool valid;
+    uint8_t resolution;
+    SensorCalibration calibration;
+    FilterState filter;
+    SensorStatistics stats;
+    AnomalyState anomaly;
+};
+
+static const FilterConfig filterConfig = SensorFilter::defaultConfig();
+static const AnomalyConfig anomalyConfig = AnomalyDetector::defaultConfig();
+
+// Deterministic bus value for a sensor in a cycle, 20-30 °C with some noise
+static int32_t busValue(size_t sensor, uint32_t cycle) {
+    return 2560 + static_cast<int32_t>((sensor * 97 + cycle * 13) % 1280);
+}
+
+static void makeAddress(size_t index, uint8_t* address) {
+    const uint8_t base[8] = {0x28, 0xAA, 0x10, 0x20, 0x30, 0x40, static_cast<uint8_t>(index), 0x5C};
+    memcpy(address, base, 8);
+}
+
+static void legacyCycle(std::vector<LegacySensor>& list, uint32_t cycle, uint32_t now) {
+    std::vector<LegacySensor> updatedList;
+    updatedList.reserve(list.size());
+    for (size_t i = 0; i < list.size(); i++) {
+        LegacySensor updated = list[i];
+        int32_t raw = busValue(i, cycle);
+        int32_t filtered = SensorFilter::process(filterConfig, updated.calibration, updated.filter, raw, now);
+        updated.rawTemperature = SensorFilter::toCelsius(raw);
+        updated.temperature = SensorFilter::toCelsius(filtered);
+        updated.lastValidReading = updated.temperature;
+        updated.lastReadTime = now;
+        updated.valid = true;
+        updated.consecutiveErrors = 0;
+        updated.health = SensorHealth::ACTIVE;
+        RollupStats::addSample(updated.stats, updated.temperature, now);
+        AnomalyEvent events[ANOMALY_TYPE_COUNT];
+        AnomalyDetector::process(anomalyConfig, updated.anomaly, updated.temperature, raw, now, events);
+        updatedList.push_back(updated);
+    }
+    list = std::move(updatedList);
+}
+
+static void tableCycle(SensorTable& table, uint32_t cycle, uint32_t now) {
+    for (size_t i = 0; i < table.physicalCount(); i++) {
+        SensorHot& sensor = table.hot(i);
+        SensorCold& meta = table.cold(i);
+        int32_t raw = busValue(i, cycle);
+        int32_t filtered = SensorFilter::process(filterConfig, meta.calibration, meta.filter, raw, now);
+        sensor.raw = static_cast<int16_t>(raw);
+        sensor.temperature = SensorFilter::toCelsius(filtered);
+        sensor.readTime = now;
+        sensor.consecutiveErrors = 0;
+        SensorTable::setValid(sensor, true);
+        SensorTable::setHealth(sensor, SensorHealth::ACTIVE);
+        meta.lastValidReading = sensor.temperature;
+        RollupStats::addSample(meta.stats, sensor.temperature, now);
+        AnomalyEvent events[ANOMALY_TYPE_COUNT];
+        AnomalyDetector::process(anomalyConfig, meta.anomaly, sensor.temperature, raw, now, events);
+    }
+}
+
+// Lookup by ROM as done by getCachedTemperature() and readTemperature()
+static float legacyLookups(const std::vector<LegacySensor>& list) {
+    float sum = 0;
+    for (size_t n = 0; n < list.size(); n++) {
+        uint8_t address[8];
+        makeAddress(list.size() - 1 - n, address);
+        for (const auto& sensor : list) {
+            if (memcmp(sensor.address, address, 8) == 0) {
+                sum += sensor.temperature;
+                break;
+            }
+        }
+    }
+    return sum;
+}
+
+static float tableLookups(const SensorTable& table) {
+    float sum = 0;
+    for (size_t n = 0; n < table.size(); n++) {
+        uint8_t address[8];
+        makeAddress(table.size() - 1 - n, address);
+        int index = table.find(address);
+        if (index >= 0) sum += table.hot(index).temperature;
+    }
+    return sum;
+}
+
+template <typename F>
+static double nsPerCall(F fn, uint32_t calls) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++) fn(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / calls;
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 16;
+    uint32_t cycles = argc > 2 ? strtoul(argv[2], nullptr, 10) : 200000;
+    if (count == 0 || count > SENSOR_TABLE_CAPACITY) count = 16;
+
+    std::vector<LegacySensor> legacy(count);
+    static SensorTable table;
+    for (size_t i = 0; i < count; i++) {
+        LegacySensor& sensor = legacy[i];
+        memset(&sensor, 0, sizeof(sensor));
+        makeAddress(i, sensor.address);
+        sensor.calibration = SensorFilter::defaultCalibration();
+        SensorFilter::reset(sensor.filter);
+        RollupStats::reset(sensor.stats);
+        AnomalyDetector::reset(sensor.anomaly);
+
+        uint8_t address[8];
+        makeAddress(i, address);
+        table.add(address, false);
+    }
+
+    volatile float sink = 0;
+    size_t before = allocations;
+    double legacyCycleNs = nsPerCall([&](uint32_t c) { legacyCycle(legacy, c, c * 10000); }, cycles);
+    double legacyAllocs = static_cast<double>(allocations - before) / cycles;
+
+    before = allocations;
+    double tableCycleNs = nsPerCall([&](uint32_t c) { tableCycle(table, c, c * 10000); }, cycles);
+    double tableAllocs = static_cast<double>(allocations - before) / cycles;
+
+    double legacyLookupNs = nsPerCall([&](uint32_t) { sink = sink + legacyLookups(legacy); }, cycles);
+    double tableLookupNs = nsPerCall([&](uint32_t) { sink = sink + tableLookups(table); }, cycles);
+
+    // The legacy cycle holds the old and the new vector at its peak
+    size_t legacyBytes = legacy.capacity() * sizeof(LegacySensor);
+    printf("%zu sensors, %u cycles\n\n", count, cycles);
+    printf("%-22s %14s %14s\n", "", "legacy vector", "SensorTable");
+    printf("%-22s %14zu %14zu\n", "bytes per sensor", sizeof(LegacySensor),
+           sizeof(SensorHot) + sizeof(SensorCold));
+    printf("%-22s %14zu %14zu\n", "  walked by the sweep", sizeof(LegacySensor), sizeof(SensorHot));
+    printf("%-22s %14zu %14zu\n", "storage bytes", legacyBytes, sizeof(SensorTable));
+    printf("%-22s %14zu %14zu\n", "peak bytes in cycle", 2 * legacyBytes, sizeof(SensorTable));
+    printf("%-22s %14.2f %14.2f\n", "allocations / cycle", legacyAllocs, tableAllocs);
+    printf("%-22s %14.0f %14.0f\n", "ns / read cycle", legacyCycleNs, tableCycleNs);
+    printf("%-22s %14.0f %14.0f\n", "ns / lookup sweep", legacyLookupNs, tableLookupNs);
+    return 0;
+}
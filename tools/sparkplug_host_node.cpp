@@ -0,0 +1,94 @@
+// sparkplug_host_node.cpp
+// Runs SparkplugNode on the host through a short session and prints every
+// message it publishes, topic and payload in hex, so the encoding can be
+// checked against a Sparkplug B decoder (e.g. protoc --decode or the Eclipse
+// Tahu tools with the hex fed back through xxd -r -p). The session:
+//
+//   1  will: NDEATH with bdSeq
+//   2  NBIRTH and a DBIRTH per sensor
+//   3  one sensor changes, a relay switches          NDATA, DDATA
+//   4  nothing changes                               nothing
+//   5  a sensor loses its reading, one is added      DDATA with null, DBIRTH
+//   6  a sensor is removed                           DDEATH
+//   7  NCMD Node Control/Rebirth                     NBIRTH, DBIRTHs
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++11 -Wall -Iinclude -o /tmp/sparkplug_host_node tools/sparkplug_host_node.cpp
+//       src/SparkplugNode.cpp src/SparkplugPayload.cpp
+//   /tmp/sparkplug_host_node
+
+#include <stdio.h>
+#include <string.h>
+#include "SparkplugNode.h"
+
+static size_t messages = 0;
+static size_t payloadBytes = 0;
+
+static void printHex(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) printf("%02x", data[i]);
+    printf("\n");
+}
+
+static bool capture(const char* topic, const uint8_t* payload, size_t length, void*) {
+    printf("%s (%zu bytes)\n    ", topic, length);
+    printHex(payload, length);
+    messages++;
+    payloadBytes += length;
+    return true;
+}
+
+static void step(SparkplugNode& node, const char* label, const SparkplugSensorSample* sensors, size_t count,
+                 const bool* relays, uint64_t timestamp) {
+    printf("-- %s\n", label);
+    if (!node.update(sensors, count, relays, 2, timestamp)) {
+        printf("update failed\n");
+    }
+}
+
+int main() {
+    SparkplugNode node;
+    node.begin("SensorHUB", "hub-01", capture, nullptr);
+
+    const uint8_t* death;
+    size_t deathLength = node.prepareDeath(death);
+    printf("-- will\n%s (%zu bytes)\n    ", node.deathTopic(), deathLength);
+    printHex(death, deathLength);
+    if (memchr(death, 0, deathLength)) {
+        printf("NDEATH payload contains a NUL byte\n");
+        return 1;
+    }
+
+    SparkplugSensorSample sensors[3] = {
+        {{0x28, 0xAA, 0x10, 0x00, 0x30, 0x40, 0x01, 0x5C}, 21.53f, 21.5625f, "online", true},
+        {{0x28, 0xAA, 0x10, 0x00, 0x30, 0x40, 0x02, 0x5C}, 48.20f, 48.1875f, "online", true},
+        {{0x28, 0xAA, 0x10, 0x00, 0x30, 0x40, 0x03, 0x5C}, 6.75f, 6.75f, "online", true},
+    };
+    bool relays[2] = {false, true};
+    uint64_t timestamp = 1760000000000ull;
+
+    node.sessionStarted();
+    step(node, "session start", sensors, 2, relays, timestamp);
+
+    sensors[0].temperature = 21.61f;
+    sensors[0].rawTemperature = 21.625f;
+    relays[0] = true;
+    step(node, "sensor and relay change", sensors, 2, relays, timestamp += 10000);
+    step(node, "no change", sensors, 2, relays, timestamp += 10000);
+
+    sensors[1].valid = false;
+    sensors[1].status = "error";
+    step(node, "reading lost, sensor added", sensors, 3, relays, timestamp += 10000);
+
+    sensors[1] = sensors[2];
+    step(node, "sensor removed", sensors, 2, relays, timestamp += 10000);
+
+    // NCMD as a host application sends it: metric by name, Boolean true
+    const uint8_t rebirth[] = {0x12, 0x1a, 0x0a, 0x14, 'N', 'o', 'd', 'e', ' ', 'C', 'o', 'n', 't', 'r', 'o', 'l',
+                               '/', 'R', 'e', 'b', 'i', 'r', 't', 'h', 0x20, 0x0b, 0x70, 0x01};
+    node.handleCommand(rebirth, sizeof(rebirth));
+    step(node, "rebirth command", sensors, 2, relays, timestamp += 1000);
+
+    printf("-- %zu messages, %zu payload bytes, bdSeq %u\n", messages, payloadBytes,
+           static_cast<unsigned>(node.getBdSeq()));
+    return 0;
+}